@@ -0,0 +1,21 @@
+// Uniform blocks shared by every shader, bound by render.h's
+// UBO_BINDING_* slots. Unused ones are dropped by the linker.
+
+layout(std140) uniform camera_block {
+	mat4 proj;
+	mat4 view;
+};
+
+layout(std140) uniform object_block {
+	mat4 model;
+	vec4 object_color;
+	vec4 object_uv_rect; // into the bound texture page
+	float object_layer;
+};
+
+layout(std140) uniform frame_block {
+	vec4 view_pos;
+	vec4 ambient;
+	vec4 cluster_scale; // clusters per pixel, depth slice scale and bias
+	uvec4 cluster_dims; // clusters in x, y, z and the light count
+};
@@ -0,0 +1,55 @@
+// Clustered point lights, see light_system.h. Each cluster lists the
+// lights whose sphere touches it, a fragment only shades those.
+// LIGHT_SPECULAR adds the Phong highlight.
+
+#include "blocks.glsl"
+
+// units set by the shader system, see render.h's TEX_UNIT_LIGHT_*
+uniform samplerBuffer light_data; // per light: position and radius, color
+uniform usamplerBuffer light_clusters; // offset and count in light_indices
+uniform usamplerBuffer light_indices;
+
+int light_cluster(vec3 frag) {
+	float depth = -(view * vec4(frag, 1.0)).z;
+	uvec2 tile = uvec2(gl_FragCoord.xy * cluster_scale.xy);
+	float slice = log(max(depth, 1e-4)) * cluster_scale.z + cluster_scale.w;
+	uvec3 cell = min(uvec3(tile, uint(max(slice, 0.0))), cluster_dims.xyz - 1u);
+	return int((cell.z * cluster_dims.y + cell.y) * cluster_dims.x + cell.x);
+}
+
+vec3 light_phong(vec3 frag, vec3 normal, vec3 albedo) {
+	vec3 norm = normalize(normal);
+#ifdef LIGHT_SPECULAR
+	vec3 view_dir = normalize(view_pos.xyz - frag);
+#endif
+	vec3 result = ambient.rgb;
+
+	uvec2 range = texelFetch(light_clusters, light_cluster(frag)).xy;
+	for (uint i = 0u; i < range.y; i++) {
+		int light = int(texelFetch(light_indices, int(range.x + i)).x);
+		vec4 pos_radius = texelFetch(light_data, light * 2);
+		vec3 color = texelFetch(light_data, light * 2 + 1).rgb;
+
+		// inverse square, windowed down to 0 at the radius
+		vec3 to_light = pos_radius.xyz - frag;
+		float dist_sq = dot(to_light, to_light);
+		float ratio = dist_sq / (pos_radius.w * pos_radius.w);
+		float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float atten = window * window / (dist_sq + 1.0);
+
+		vec3 light_dir = to_light * inversesqrt(max(dist_sq, 1e-8));
+		float diff = max(dot(norm, light_dir), 0.0);
+		vec3 lit = diff * color;
+
+#ifdef LIGHT_SPECULAR
+		float spec_str = 0.5;
+		vec3 reflect_dir = reflect(-light_dir, norm);
+		float spec = pow(max(dot(view_dir, reflect_dir), 0.0), 64);
+		lit += spec_str * spec * color;
+#endif
+
+		result += lit * atten;
+	}
+
+	return result * albedo;
+}
@@ -0,0 +1,68 @@
+// COMPUTE SHADER
+#version 430 core
+
+// Frustum culls one object per invocation. Survivors bump their mesh's
+// indirect command and copy their instance into that command's range.
+
+layout (local_size_x = 64) in;
+
+// render_instance_t
+struct instance {
+	mat4 model;
+	vec4 color;
+	vec4 uv_rect;
+	float layer;
+	float pad0;
+	float pad1;
+	float pad2;
+};
+
+struct object {
+	vec4 sphere; // xyz center, w radius
+	uint cmd;
+	uint pad0;
+	uint pad1;
+	uint pad2;
+};
+
+// DrawElementsIndirectCommand
+struct draw_cmd {
+	uint count;
+	uint instance_count;
+	uint first_index;
+	int base_vertex;
+	uint base_instance;
+};
+
+layout (std430, binding = 0) readonly buffer object_block {
+	object objects[];
+};
+
+layout (std430, binding = 1) readonly buffer instance_block {
+	instance instances[];
+};
+
+layout (std430, binding = 2) buffer command_block {
+	draw_cmd cmds[];
+};
+
+layout (std430, binding = 3) writeonly buffer visible_block {
+	instance visible[];
+};
+
+uniform vec4 planes[6];
+uniform uint object_count;
+
+void main() {
+	uint id = gl_GlobalInvocationID.x;
+	if (id >= object_count) return;
+
+	vec4 s = objects[id].sphere;
+	for (int i = 0; i < 6; i++) {
+		if (dot(planes[i].xyz, s.xyz) + planes[i].w < -s.w) return;
+	}
+
+	uint c = objects[id].cmd;
+	uint slot = atomicAdd(cmds[c].instance_count, 1u);
+	visible[cmds[c].base_instance + slot] = instances[id];
+}
@@ -0,0 +1,15 @@
+// VERTEX SHADER
+#version 330 core
+
+// debug_draw lines, world space
+layout (location = 0) in vec3 a_pos;
+layout (location = 1) in vec4 a_color;
+
+#include "common/blocks.glsl"
+
+out vec4 out_color;
+
+void main() {
+	out_color = a_color;
+	gl_Position = proj * view * vec4(a_pos, 1.0);
+}
@@ -0,0 +1,10 @@
+// FRAGMENT SHADER
+#version 330 core
+
+#include "common/blocks.glsl"
+
+out vec4 frag_color;
+
+void main() {
+	frag_color = vec4(object_color.rgb, 1.0);
+}
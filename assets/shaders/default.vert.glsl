@@ -0,0 +1,12 @@
+// VERTEX SHADER
+#version 330 core
+
+// Stand-in while a shader compiles, plain draws only
+
+layout (location = 0) in vec3 a_pos;
+
+#include "common/blocks.glsl"
+
+void main() {
+	gl_Position = proj * view * model * vec4(a_pos, 1.0);
+}
@@ -0,0 +1,20 @@
+// FRAGMENT SHADER
+#version 330 core
+
+#include "common/lighting.glsl"
+
+// texture page on TEX_UNIT_ALBEDO, set by the shader system
+uniform sampler2DArray albedo_map;
+
+out vec4 frag_color;
+
+in vec3 out_frag;
+in vec3 out_normal;
+in vec3 out_color;
+in vec2 out_uv;
+flat in float out_layer;
+
+void main() {
+	vec3 albedo = out_color * texture(albedo_map, vec3(out_uv, out_layer)).rgb;
+	frag_color = vec4(light_phong(out_frag, out_normal, albedo), 1.0);
+}
@@ -0,0 +1,31 @@
+// VERTEX SHADER
+#version 330 core
+
+layout (location = 0) in vec3 a_pos;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_uv;
+
+// per instance, mat4 takes locations 3..6
+layout (location = 3) in mat4 a_model;
+layout (location = 7) in vec4 a_color;
+layout (location = 8) in vec4 a_uv_rect; // into the bound texture page
+layout (location = 9) in float a_layer;
+
+#include "common/blocks.glsl"
+
+out vec3 out_frag;
+out vec3 out_normal;
+out vec3 out_color;
+out vec2 out_uv;
+flat out float out_layer;
+
+void main() {
+	out_frag = vec3(a_model * vec4(a_pos, 1.0));
+	// instances are rotation + uniform scale, no inverse-transpose needed
+	out_normal = mat3(a_model) * a_normal;
+	out_color = a_color.rgb;
+	out_uv = a_uv_rect.xy + a_uv * a_uv_rect.zw;
+	out_layer = a_layer;
+
+	gl_Position = proj * view * vec4(out_frag, 1.0);
+}
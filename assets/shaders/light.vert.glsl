@@ -3,12 +3,7 @@
 
 layout (location = 0) in vec3 a_pos;
 
-uniform mat4 model;
-
-layout(std140) uniform camera_block {
-	mat4 proj;
-	mat4 view;
-};
+#include "common/blocks.glsl"
 
 //uniform mat4 proj;
 //uniform mat4 view;
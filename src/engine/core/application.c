@@ -1,6 +1,265 @@
 #include "application.h"
 #include "engine/core/memory/memory.h"
 #include "engine/core/math/maths.h"
+#include "engine/core/math/math_dispatch.h"
+#include "engine/core/math/math_fast.h"
+#include "engine/rendering/culling.h"
+#include "engine/rendering/gl_state.h"
+#include "engine/rendering/gpu_cull.h"
+#include "engine/rendering/render_queue.h"
+#include "engine/resource/image_ops.h"
+
+// std
+#include <stdio.h>
+#include <stdlib.h>
+
+// TODO: temp cube field, frustum culled on the CPU each frame. Rows swap
+// between two cube meshes to exercise the multi draw path.
+#define CUBE_FIELD_DIM 224 // ~50k cubes
+#define CUBE_FIELD_SPACING 2.0f
+
+typedef struct {
+    cull_spheres_t bounds;
+    render_instance_t *instances;
+    mesh_handle_t *meshes;
+    render_instance_t *visible;
+    mesh_handle_t *visible_meshes;
+    u32 *indices;
+    u32 count;
+
+    gpu_cull_t gpu; // used instead of the CPU path when linked
+} cube_field_t;
+
+static cube_field_t g_field;
+
+// shaders/instanced permutation bits, see common/lighting.glsl
+enum {
+    LIT_SPECULAR = 1 << 0,
+};
+
+static const char *const g_lit_features[] = {"LIGHT_SPECULAR"};
+
+// TODO: temp lights, one orbiting the origin and a grid of coloured ones
+// just above the cube field
+#define LIGHT_FIELD_DIM 16
+
+static light_handle_t g_orbit_light = INVALID_32;
+
+static void light_field_init(light_system_t *ls)
+{
+    static const vec3 palette[] = {
+        {{1.0f, 0.3f, 0.2f}}, {{0.2f, 1.0f, 0.3f}}, {{0.3f, 0.4f, 1.0f}},
+        {{1.0f, 0.9f, 0.3f}}, {{0.9f, 0.3f, 1.0f}}, {{0.3f, 1.0f, 1.0f}}};
+
+    g_orbit_light = light_sys_add(
+        ls, (point_light_t){.color = {{1.0f, 1.0f, 1.0f}},
+                            .radius = 30.0f,
+                            .intensity = 40.0f});
+
+    f32 extent = (f32)(CUBE_FIELD_DIM - 1) * CUBE_FIELD_SPACING;
+    f32 step = extent / (f32)(LIGHT_FIELD_DIM - 1);
+    for (u32 z = 0; z < LIGHT_FIELD_DIM; z++)
+    {
+        for (u32 x = 0; x < LIGHT_FIELD_DIM; x++)
+        {
+            point_light_t light = {
+                .position = vec3_create((f32)x * step - extent * 0.5f, -1.5f,
+                                        (f32)z * step - extent * 0.5f),
+                .radius = step,
+                .color = palette[(x + z * 5) % ARRAY_SIZE(palette)],
+                .intensity = 15.0f};
+            light_sys_add(ls, light);
+        }
+    }
+}
+
+// TODO: temp, F3 shows the light volumes over a grid under the cube field
+static b8 g_debug_view = false;
+
+static void debug_view_submit(application_t *app)
+{
+    debug_draw_t *dd = app->dd;
+    f32 half = (f32)CUBE_FIELD_DIM * CUBE_FIELD_SPACING * 0.5f;
+    debug_draw_grid(dd, vec3_create(0.0f, -3.5f, 0.0f), CUBE_FIELD_SPACING,
+                    CUBE_FIELD_DIM + 1, DEBUG_GRAY, DEBUG_DRAW_DEPTH);
+    debug_draw_aabb(dd,
+                    (aabb){.min = vec3_create(-half, -3.5f, -half),
+                           .max = vec3_create(half, -2.5f, half)},
+                    DEBUG_YELLOW, DEBUG_DRAW_DEPTH);
+    debug_draw_axes(dd, mat4_identity(), 2.0f, DEBUG_DRAW_OVERLAY);
+
+    light_system_t *ls = app->ls;
+    for (u32 i = 0; i < ls->slot_count; i++)
+    {
+        const point_light_t *light = light_sys_get(ls, i);
+        if (!light) continue;
+        vec3 c = vec3_scale(light->color, 255.0f);
+        u32 color = DEBUG_RGBA((u8)c.x, (u8)c.y, (u8)c.z, 255);
+        debug_draw_sphere(dd, light->position, light->radius, color,
+                          DEBUG_DRAW_DEPTH);
+    }
+}
+
+static void cube_field_init(render_system_t *rs)
+{
+    u32 count = CUBE_FIELD_DIM * CUBE_FIELD_DIM;
+    g_field.count = count;
+    g_field.instances = ALLOC(sizeof(render_instance_t) * count, MEM_RENDER);
+    g_field.meshes = ALLOC(sizeof(mesh_handle_t) * count, MEM_RENDER);
+    g_field.visible = ALLOC(sizeof(render_instance_t) * count, MEM_RENDER);
+    g_field.visible_meshes = ALLOC(sizeof(mesh_handle_t) * count, MEM_RENDER);
+    g_field.indices = ALLOC(sizeof(u32) * count, MEM_RENDER);
+    cull_spheres_create(&g_field.bounds, count);
+
+    f32 half = (f32)(CUBE_FIELD_DIM - 1) * CUBE_FIELD_SPACING * 0.5f;
+    f32 inv_dim = 1.0f / (f32)CUBE_FIELD_DIM;
+    for (u32 z = 0; z < CUBE_FIELD_DIM; z++)
+    {
+        for (u32 x = 0; x < CUBE_FIELD_DIM; x++)
+        {
+            u32 i = z * CUBE_FIELD_DIM + x;
+            f32 scale = 0.5f + 0.5f * (f32)((x ^ z) & 3) / 3.0f;
+            vec3 pos = vec3_create((f32)x * CUBE_FIELD_SPACING - half, -3.0f,
+                                   (f32)z * CUBE_FIELD_SPACING - half);
+
+            render_instance_t *inst = &g_field.instances[i];
+            inst->model = mat4_scaling(vec3_create(scale, scale, scale));
+            inst->model.data[12] = pos.x;
+            inst->model.data[13] = pos.y;
+            inst->model.data[14] = pos.z;
+            inst->color = vec4_create((f32)x * inv_dim, 0.6f,
+                                      (f32)z * inv_dim, 1.0f);
+            // untextured, white in the placeholder page
+            inst->uv_rect = vec4_create(0.0f, 0.0f, 1.0f, 1.0f);
+            inst->layer = 0.0f;
+            g_field.meshes[i] = (z & 1) ? rs->rs_light : rs->rs_mesh;
+
+            // unit cube, half diagonal is sqrt(3) / 2
+            cull_spheres_push(&g_field.bounds, pos, 0.8661f * scale);
+        }
+    }
+
+    if (gpu_cull_supported())
+    {
+        gpu_cull_create(&g_field.gpu, rs->meshes, &g_field.bounds,
+                        g_field.instances, g_field.meshes);
+    }
+}
+
+static void cube_field_kill(void)
+{
+    gpu_cull_destroy(&g_field.gpu);
+    cull_spheres_destroy(&g_field.bounds);
+    FREE(g_field.instances, sizeof(render_instance_t) * g_field.count,
+         MEM_RENDER);
+    FREE(g_field.meshes, sizeof(mesh_handle_t) * g_field.count, MEM_RENDER);
+    FREE(g_field.visible, sizeof(render_instance_t) * g_field.count,
+         MEM_RENDER);
+    FREE(g_field.visible_meshes, sizeof(mesh_handle_t) * g_field.count,
+         MEM_RENDER);
+    FREE(g_field.indices, sizeof(u32) * g_field.count, MEM_RENDER);
+    g_field = (cube_field_t){0};
+}
+
+static void cube_field_submit(application_t *app)
+{
+    shader_t *shader =
+        shader_sys_permutation(&app->sh->instanced, LIT_SPECULAR);
+    if (!shader) return;
+
+    u64 key = render_key_opaque(WORLD_PASS, shader->program, 0,
+                                app->rs->rs_mesh, 0);
+
+    if (g_field.gpu.shader.program)
+    {
+        gpu_cull_dispatch(&g_field.gpu, &app->cs->world.frustum);
+        render_cmd_t cmd = {.shader = shader,
+                            .indirect_buffer = g_field.gpu.commands,
+                            .indirect_count = g_field.gpu.cmd_count,
+                            .instance_buffer = g_field.gpu.visible};
+        render_queue_submit(app->rq, key, &cmd);
+        return;
+    }
+
+    u32 visible = cull_spheres_frustum(&app->cs->world.frustum,
+                                       &g_field.bounds, g_field.indices);
+    for (u32 i = 0; i < visible; i++)
+    {
+        g_field.visible[i] = g_field.instances[g_field.indices[i]];
+        g_field.visible_meshes[i] = g_field.meshes[g_field.indices[i]];
+    }
+
+    render_cmd_t cmd = {.shader = shader,
+                        .mesh = app->rs->rs_mesh,
+                        .meshes = g_field.visible_meshes,
+                        .instances = g_field.visible,
+                        .instance_count = visible};
+    render_queue_submit(app->rq, key, &cmd);
+}
+
+static void submit_mesh(application_t *app, shader_t *shader,
+                        mesh_handle_t mesh, const render_material_t *mat,
+                        mat4 model, vec3 position)
+{
+    camera_t *cam = &app->cs->world;
+    f32 dist = vec3_length(vec3_sub(position, cam->position));
+    u64 key = render_key_opaque(WORLD_PASS, shader->program,
+                                mat ? mat->id : 0, mesh,
+                                render_key_depth(dist, cam->far));
+
+    render_cmd_t cmd = {
+        .shader = shader, .mesh = mesh, .material = mat, .model = model};
+    render_queue_submit(app->rq, key, &cmd);
+}
+
+static void world_pass(render_graph_t *rg, void *user)
+{
+    (void)rg;
+    application_t *app = user;
+    light_sys_bind(app->ls);
+    render_queue_execute_pass(app->rq, app->rs, WORLD_PASS);
+}
+
+static void debug_ui_pass(render_graph_t *rg, void *user)
+{
+    (void)rg;
+    application_t *app = user;
+    render_queue_execute_pass(app->rq, app->rs, DEBUG_UI_PASS);
+    debug_draw_render(app->dd, &app->sh->debug_shader);
+}
+
+// The world renders offscreen, the debug UI goes on top of it, depth
+// tested against the world's depth, and the result is blitted to the
+// window, then captured if asked
+static void render_frame_graph(application_t *app)
+{
+    render_graph_t *rg = app->rs->graph;
+    i32 width = 0, height = 0;
+    window_sys_get_framebuffer_size(&width, &height);
+    if (width <= 0 || height <= 0) return; // minimized
+
+    render_graph_begin(rg, (u32)width, (u32)height);
+    rg_handle_t color = render_graph_texture(
+        rg, "scene_color", (rg_texture_desc_t){.format = RG_FORMAT_RGBA8});
+    rg_handle_t depth = render_graph_texture(
+        rg, "scene_depth",
+        (rg_texture_desc_t){.format = RG_FORMAT_DEPTH24_STENCIL8});
+
+    rg_handle_t world = render_graph_add_pass(rg, "world", world_pass, app);
+    render_graph_write_color(rg, world, color);
+    render_graph_write_depth(rg, world, depth);
+    render_graph_clear(rg, world, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT,
+                       app->rs->clear_color);
+
+    rg_handle_t ui = render_graph_add_pass(rg, "debug_ui", debug_ui_pass, app);
+    render_graph_write_color(rg, ui, color);
+    render_graph_write_depth(rg, ui, depth);
+
+    render_graph_add_blit(rg, "present", color);
+
+    if (render_graph_compile(rg)) render_graph_execute(rg);
+    capture_sys_end_frame(app->cap, 0, (u32)width, (u32)height);
+}
 
 b8 application_init(application_t *app)
 {
@@ -13,6 +272,8 @@ b8 application_init(application_t *app)
     }
 
     arena_create(128 * 1024, &app->arena, NULL);
+    math_dispatch_init();
+    image_ops_init();
 
     app->fs = file_system_init(&app->arena);
     app->ws = window_sys_init(&app->arena, 1280, 720, "Kerfuffle");
@@ -20,13 +281,37 @@ b8 application_init(application_t *app)
     app->cs = camera_sys_init(&app->arena);
     app->rs = render_sys_init(&app->arena);
     app->sh = shader_sys_init(&app->arena);
+    app->ts = texture_sys_init(&app->arena);
+    app->rq = render_queue_init(&app->arena, 256);
+    app->cap = capture_sys_init(&app->arena);
+    app->ls = light_sys_init(&app->arena);
+    app->dd = debug_draw_init(&app->arena);
     app->game = game_init();
 
-    // TODO: temp
+    // TODO: temp. Compiled in the background, instanced draws wait for
+    // theirs since the default shader has no instance attributes.
+    app->sh->object_shader.fallback = &app->sh->default_shader;
+    app->sh->light_shader.fallback = &app->sh->default_shader;
     shader_sys_set(&app->sh->object_shader, "shaders/test");
     shader_sys_set(&app->sh->light_shader, "shaders/light");
+    shader_sys_set(&app->sh->debug_shader, "shaders/debug");
+    shader_sys_family_init(&app->sh->instanced, "shaders/instanced",
+                           g_lit_features, ARRAY_SIZE(g_lit_features), NULL);
+    cube_field_init(app->rs);
+    light_field_init(app->ls);
     // shader_sys_bind(app->sh);
 
+    // KERFUFFLE_CAPTURE_FRAMES=n records the first n frames, for benchmark
+    // runs and golden images
+    const char *record = getenv("KERFUFFLE_CAPTURE_FRAMES");
+    u32 record_frames = record ? (u32)strtoul(record, NULL, 10) : 0;
+    if (record_frames)
+    {
+        capture_sys_record(app->cap, CAPTURE_DIR "/frame", record_frames,
+                           CAPTURE_FORMAT_PNG);
+        LOG_INFO("Recording %u frames into %s", record_frames, CAPTURE_DIR);
+    }
+
 #if DEBUG
     LOG_DEBUG("--- Memory Addresses ---");
     LOG_DEBUG("Filesystem: %p", app->fs);
@@ -35,6 +320,11 @@ b8 application_init(application_t *app)
     LOG_DEBUG("Camera:     %p", app->cs);
     LOG_DEBUG("Render:     %p", app->rs);
     LOG_DEBUG("Shader:     %p", app->sh);
+    LOG_DEBUG("Texture:    %p", app->ts);
+    LOG_DEBUG("Queue:      %p", app->rq);
+    LOG_DEBUG("Capture:    %p", app->cap);
+    LOG_DEBUG("Light:      %p", app->ls);
+    LOG_DEBUG("Debug Draw: %p", app->dd);
     // LOG_DEBUG("Mesh:       %p", app->mesh);
 
     u64 used = arena_used(&app->arena);
@@ -66,6 +356,7 @@ b8 application_run(application_t *app)
     u32 benchmark_frames = 0;
     const u32 MAX_BENCHMARK_FRAMES = 1000;
 
+    gl_state_stats_t gl_stats = {0};
     f64 fps_timer = 0.0;
     u32 fps_counter = 0;
     f64 math_total_time = 0.0;
@@ -104,7 +395,16 @@ b8 application_run(application_t *app)
             f64 ms = avg_delta * 1000.0;
             f64 fps = fps_counter / fps_timer;
 
-            LOG_INFO("FPS: %.0f | Frame: %.2f ms", fps, ms);
+            const rg_stats_t *rg_stats = &app->rs->graph->stats;
+            const light_stats_t *light_stats = &app->ls->stats;
+            LOG_INFO("FPS: %.0f | Frame: %.2f ms | GL calls: %u (%u elided)"
+                     " | Targets: %u for %u (%.1f MiB)"
+                     " | Lights: %u of %u (%u refs)",
+                     fps, ms, gl_stats.issued, gl_stats.elided,
+                     rg_stats->targets, rg_stats->textures,
+                     (f64)rg_stats->target_bytes / (1024.0 * 1024.0),
+                     light_stats->visible, light_stats->lights,
+                     light_stats->references);
 
             /*
             if (benchmark_mode && benchmark_frames >= MAX_BENCHMARK_FRAMES)
@@ -124,49 +424,65 @@ b8 application_run(application_t *app)
         window_sys_poll(app->ws);
         input_sys_update(app->ip, delta);
 
+        if (key_once_pressed(GLFW_KEY_F12))
+        {
+            char path[CAPTURE_PATH_SIZE];
+            snprintf(path, sizeof(path), CAPTURE_DIR "/screenshot_%05u.png",
+                     app->cap->stats.requested);
+            capture_sys_screenshot(app->cap, path, CAPTURE_FORMAT_PNG);
+        }
+        if (key_once_pressed(GLFW_KEY_F3)) g_debug_view = !g_debug_view;
+
         game_update(app->game, delta);
         game_render(app->game, delta);
         camera_update(app->cs);
 
-        render_sys_begin(app->rs, WORLD_PASS);
-
         // TODO: temp code
         static f32 orbit_angle = 0.0f;
         orbit_angle += (f32)delta * 1.0f;
         float radius = 10.0f;
 
         // orbiting around origin (Y axis)
-        vec3 light_pos = {
-            {m_cos(orbit_angle) * radius, 0.0f, m_sin(orbit_angle) * radius}};
+        f32 orbit_sin, orbit_cos;
+        m_fast_sincos(orbit_angle, &orbit_sin, &orbit_cos);
+        vec3 light_pos = {{orbit_cos * radius, 0.0f, orbit_sin * radius}};
         mat4 light_model = mat4_translation(light_pos);
         mat4 scale_mat = mat4_scaling((vec3){{0.2f, 0.2f, 0.2f}});
         light_model = mat4_mul(light_model, scale_mat);
 
-        vec3 view_pos = app->cs->world.position;
-        vec3 obj_color = (vec3){{0.0f, 1.0f, 0.0f}};
-        vec3 light_color = (vec3){{1.0f, 1.0f, 1.0f}};
-
-        shader_sys_bind(&app->sh->object_shader);
-        shader_sys_set_uniform_mat4(&app->sh->object_shader, mat4_identity());
-
-        shader_sys_set_vec3(&app->sh->object_shader,
-                            app->sh->object_shader.light_pos, light_pos);
-        shader_sys_set_vec3(&app->sh->object_shader,
-                            app->sh->object_shader.view_pos, view_pos);
-        shader_sys_set_vec3(&app->sh->object_shader,
-                            app->sh->object_shader.object_color, obj_color);
-        shader_sys_set_vec3(&app->sh->object_shader,
-                            app->sh->object_shader.light_color, light_color);
-
-        render_draw(app->rs);
-
-        shader_sys_bind(&app->sh->light_shader);
-        shader_sys_set_uniform_mat4(&app->sh->light_shader, light_model);
-        render_light(app->rs);
-
-        render_sys_end(app->rs, WORLD_PASS);
+        static const render_material_t green = {.id = 1,
+                                                .color = {{0.0f, 1.0f, 0.0f}},
+                                                .texture = INVALID_32};
+        point_light_t *orbit = light_sys_get(app->ls, g_orbit_light);
+        if (orbit) orbit->position = light_pos;
+
+        i32 fb_width = 0, fb_height = 0;
+        window_sys_get_framebuffer_size(&fb_width, &fb_height);
+        light_sys_update(app->ls, &app->cs->world, (u32)MAX(fb_width, 0),
+                         (u32)MAX(fb_height, 0));
+        render_frame_t frame = {.view_pos = app->cs->world.position};
+        light_sys_frame(app->ls, &frame);
+
+        shader_sys_poll(app->sh, false);
+        texture_sys_update(app->ts);
+        render_queue_reset(app->rq);
+        if (g_debug_view) debug_view_submit(app);
+        submit_mesh(app, &app->sh->object_shader, app->rs->rs_mesh, &green,
+                    mat4_identity(), vec3_zero());
+        submit_mesh(app, &app->sh->object_shader, app->rs->rs_quad, &green,
+                    mat4_identity(), vec3_zero());
+        submit_mesh(app, &app->sh->light_shader, app->rs->rs_light, NULL,
+                    light_model, light_pos);
+        cube_field_submit(app);
+
+        render_sys_frame_begin(app->rs);
+        render_queue_prepare(app->rq, app->rs, &frame);
+        render_frame_graph(app);
+        render_sys_frame_end(app->rs);
+        debug_draw_reset(app->dd);
 
         window_sys_swapbuffer(app->ws);
+        gl_stats = gl_state_end_frame();
 
         // frame limiting
         if (cap_fps)
@@ -183,7 +499,13 @@ b8 application_run(application_t *app)
     }
 
     game_kill(app->game);
+    cube_field_kill();
 
+    capture_sys_kill(app->cap);
+    light_sys_kill(app->ls);
+    debug_draw_kill(app->dd);
+    render_queue_kill(app->rq);
+    texture_sys_kill(app->ts);
     shader_sys_kill(app->sh);
     render_sys_kill(app->rs);
     camera_sys_kill(app->cs);
@@ -9,8 +9,13 @@
 #include "engine/platform/window.h"
 #include "engine/platform/input.h"
 #include "engine/rendering/camera_system.h"
+#include "engine/rendering/capture_system.h"
+#include "engine/rendering/debug_draw.h"
+#include "engine/rendering/light_system.h"
 #include "engine/rendering/render.h"
+#include "engine/rendering/render_queue.h"
 #include "engine/rendering/shader_system.h"
+#include "engine/rendering/texture_system.h"
 
 #include "game/game.h"
 
@@ -27,6 +32,11 @@ typedef struct {
     camera_system_t *cs;
     render_system_t *rs;
     shader_system_t *sh;
+    texture_system_t *ts;
+    render_queue_t *rq;
+    capture_system_t *cap;
+    light_system_t *ls;
+    debug_draw_t *dd;
 
     game_t *game;
 } application_t;
@@ -0,0 +1,33 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include "define.h" // IWYU pragma: keep
+
+// 64-bit FNV-1a, chain calls by passing the previous result as seed
+#define HASH_FNV1A_SEED 0xcbf29ce484222325ull
+#define HASH_FNV1A_PRIME 0x100000001b3ull
+
+INL u64 hash_fnv1a(u64 seed, const void *data, u64 size)
+{
+    const u8 *bytes = (const u8 *)data;
+    u64 h = seed;
+    for (u64 i = 0; i < size; i++)
+    {
+        h ^= bytes[i];
+        h *= HASH_FNV1A_PRIME;
+    }
+    return h;
+}
+
+INL u64 hash_fnv1a_str(u64 seed, const char *str)
+{
+    u64 h = seed;
+    for (; *str; str++)
+    {
+        h ^= (u8)*str;
+        h *= HASH_FNV1A_PRIME;
+    }
+    return h;
+}
+
+#endif // HASH_H
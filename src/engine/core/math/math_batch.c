@@ -0,0 +1,390 @@
+#include "math_batch.h"
+#include "math_dispatch.h"
+#include "maths.h"
+
+/*************************
+ * SCALAR
+ *************************/
+void mat4_mul_vec3_n_scalar(vec3 *restrict out, const vec3 *restrict in,
+                            const mat4 *m, u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = mat4_mul_vec3(*m, in[i]);
+}
+
+void mat4_mul_n_scalar(mat4 *restrict out, const mat4 *restrict models,
+                       const mat4 *vp, u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = mat4_mul(models[i], *vp);
+}
+
+void aabb_transform_n_scalar(aabb *restrict out, const aabb *restrict in,
+                             const mat4 *m, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        vec3 center = vec3_scale(vec3_add(in[i].min, in[i].max), 0.5f);
+        vec3 extent = vec3_scale(vec3_sub(in[i].max, in[i].min), 0.5f);
+
+        vec3 c = mat4_mul_vec3(*m, center);
+        vec3 e = vec3_create(m_abs(m->m00) * extent.x +
+                                 m_abs(m->m01) * extent.y +
+                                 m_abs(m->m02) * extent.z,
+                             m_abs(m->m10) * extent.x +
+                                 m_abs(m->m11) * extent.y +
+                                 m_abs(m->m12) * extent.z,
+                             m_abs(m->m20) * extent.x +
+                                 m_abs(m->m21) * extent.y +
+                                 m_abs(m->m22) * extent.z);
+
+        out[i].min = vec3_sub(c, e);
+        out[i].max = vec3_add(c, e);
+    }
+}
+
+#if MATH_DISPATCH
+/*************************
+ * SSE2
+ *************************/
+#    define SPLAT4(v, i) _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i))
+
+void mat4_mul_vec3_n_sse2(vec3 *restrict out, const vec3 *restrict in,
+                          const mat4 *m, u32 count)
+{
+    __m128 c0 = _mm_load_ps(&m->data[0]);
+    __m128 c1 = _mm_load_ps(&m->data[4]);
+    __m128 c2 = _mm_load_ps(&m->data[8]);
+    __m128 c3 = _mm_load_ps(&m->data[12]);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        __m128 p = _mm_load_ps(in[i].elements);
+        __m128 r = _mm_add_ps(_mm_mul_ps(c0, SPLAT4(p, 0)), c3);
+        r = _mm_add_ps(r, _mm_mul_ps(c1, SPLAT4(p, 1)));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, SPLAT4(p, 2)));
+        _mm_store_ps(out[i].elements, r);
+    }
+}
+
+void mat4_mul_n_sse2(mat4 *restrict out, const mat4 *restrict models,
+                     const mat4 *vp, u32 count)
+{
+    __m128 c0 = _mm_load_ps(&vp->data[0]);
+    __m128 c1 = _mm_load_ps(&vp->data[4]);
+    __m128 c2 = _mm_load_ps(&vp->data[8]);
+    __m128 c3 = _mm_load_ps(&vp->data[12]);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        for (u32 col = 0; col < 4; col++)
+        {
+            __m128 mc = _mm_load_ps(&models[i].data[col * 4]);
+            __m128 r = _mm_mul_ps(c0, SPLAT4(mc, 0));
+            r = _mm_add_ps(r, _mm_mul_ps(c1, SPLAT4(mc, 1)));
+            r = _mm_add_ps(r, _mm_mul_ps(c2, SPLAT4(mc, 2)));
+            r = _mm_add_ps(r, _mm_mul_ps(c3, SPLAT4(mc, 3)));
+            _mm_store_ps(&out[i].data[col * 4], r);
+        }
+    }
+}
+
+void aabb_transform_n_sse2(aabb *restrict out, const aabb *restrict in,
+                           const mat4 *m, u32 count)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+
+    __m128 c0 = _mm_load_ps(&m->data[0]);
+    __m128 c1 = _mm_load_ps(&m->data[4]);
+    __m128 c2 = _mm_load_ps(&m->data[8]);
+    __m128 c3 = _mm_load_ps(&m->data[12]);
+    __m128 a0 = _mm_andnot_ps(sign, c0);
+    __m128 a1 = _mm_andnot_ps(sign, c1);
+    __m128 a2 = _mm_andnot_ps(sign, c2);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        __m128 mn = _mm_load_ps(in[i].min.elements);
+        __m128 mx = _mm_load_ps(in[i].max.elements);
+        __m128 center = _mm_mul_ps(_mm_add_ps(mn, mx), half);
+        __m128 extent = _mm_mul_ps(_mm_sub_ps(mx, mn), half);
+
+        __m128 c = _mm_add_ps(_mm_mul_ps(c0, SPLAT4(center, 0)), c3);
+        c = _mm_add_ps(c, _mm_mul_ps(c1, SPLAT4(center, 1)));
+        c = _mm_add_ps(c, _mm_mul_ps(c2, SPLAT4(center, 2)));
+
+        __m128 e = _mm_mul_ps(a0, SPLAT4(extent, 0));
+        e = _mm_add_ps(e, _mm_mul_ps(a1, SPLAT4(extent, 1)));
+        e = _mm_add_ps(e, _mm_mul_ps(a2, SPLAT4(extent, 2)));
+
+        _mm_store_ps(out[i].min.elements, _mm_sub_ps(c, e));
+        _mm_store_ps(out[i].max.elements, _mm_add_ps(c, e));
+    }
+}
+
+/*************************
+ * AVX / AVX2+FMA
+ *
+ * 256-bit paths keep one item per 128-bit lane (two points, two columns,
+ * or center|extent of one box), so all swizzles stay in-lane. The FMA
+ * variants are the same kernels with fused multiply-add.
+ *************************/
+#    define SPLAT8(v, i) _mm256_permute_ps(v, _MM_SHUFFLE(i, i, i, i))
+#    define BCAST8(p) _mm256_broadcast_ps((const __m128 *)(p))
+
+MATH_TARGET("avx")
+static INL __m256 load_x2(const f32 *lo, const f32 *hi)
+{
+    __m256 r = _mm256_castps128_ps256(_mm_load_ps(lo));
+    return _mm256_insertf128_ps(r, _mm_load_ps(hi), 1);
+}
+
+MATH_TARGET("avx")
+static INL void store_x2(f32 *lo, f32 *hi, __m256 v)
+{
+    _mm_store_ps(lo, _mm256_castps256_ps128(v));
+    _mm_store_ps(hi, _mm256_extractf128_ps(v, 1));
+}
+
+MATH_TARGET("avx")
+static INL __m256 madd_avx(__m256 a, __m256 b, __m256 c)
+{
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+
+// lane 0 transforms the center with M, lane 1 the extent with |M|
+MATH_TARGET("avx")
+static INL void aabb_columns_x2(const mat4 *m, __m256 c[4])
+{
+    const __m256 sign = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, -0.0f, -0.0f,
+                                       -0.0f, -0.0f);
+    c[0] = _mm256_andnot_ps(sign, BCAST8(&m->data[0]));
+    c[1] = _mm256_andnot_ps(sign, BCAST8(&m->data[4]));
+    c[2] = _mm256_andnot_ps(sign, BCAST8(&m->data[8]));
+    c[3] = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_load_ps(&m->data[12])), _mm_setzero_ps(),
+        1);
+}
+
+MATH_TARGET("avx")
+static INL __m256 aabb_center_extent(const aabb *box)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 mn = _mm_load_ps(box->min.elements);
+    __m128 mx = _mm_load_ps(box->max.elements);
+    __m256 ce = _mm256_castps128_ps256(_mm_mul_ps(_mm_add_ps(mn, mx), half));
+    return _mm256_insertf128_ps(ce, _mm_mul_ps(_mm_sub_ps(mx, mn), half), 1);
+}
+
+MATH_TARGET("avx")
+static INL void aabb_store(aabb *box, __m256 r)
+{
+    __m128 c = _mm256_castps256_ps128(r);
+    __m128 e = _mm256_extractf128_ps(r, 1);
+    _mm_store_ps(box->min.elements, _mm_sub_ps(c, e));
+    _mm_store_ps(box->max.elements, _mm_add_ps(c, e));
+}
+
+MATH_TARGET("avx")
+void mat4_mul_vec3_n_avx(vec3 *restrict out, const vec3 *restrict in,
+                         const mat4 *m, u32 count)
+{
+    __m256 c0 = BCAST8(&m->data[0]);
+    __m256 c1 = BCAST8(&m->data[4]);
+    __m256 c2 = BCAST8(&m->data[8]);
+    __m256 c3 = BCAST8(&m->data[12]);
+
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m256 p = load_x2(in[i].elements, in[i + 1].elements);
+        __m256 r = madd_avx(c0, SPLAT8(p, 0), c3);
+        r = madd_avx(c1, SPLAT8(p, 1), r);
+        r = madd_avx(c2, SPLAT8(p, 2), r);
+        store_x2(out[i].elements, out[i + 1].elements, r);
+    }
+    if (i < count) mat4_mul_vec3_n_sse2(&out[i], &in[i], m, count - i);
+}
+
+MATH_TARGET("avx")
+void mat4_mul_n_avx(mat4 *restrict out, const mat4 *restrict models,
+                    const mat4 *vp, u32 count)
+{
+    __m256 c0 = BCAST8(&vp->data[0]);
+    __m256 c1 = BCAST8(&vp->data[4]);
+    __m256 c2 = BCAST8(&vp->data[8]);
+    __m256 c3 = BCAST8(&vp->data[12]);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        // columns 0|1 and 2|3 of the model matrix
+        __m256 m01 = _mm256_loadu_ps(&models[i].data[0]);
+        __m256 m23 = _mm256_loadu_ps(&models[i].data[8]);
+
+        __m256 r01 = _mm256_mul_ps(c0, SPLAT8(m01, 0));
+        __m256 r23 = _mm256_mul_ps(c0, SPLAT8(m23, 0));
+        r01 = madd_avx(c1, SPLAT8(m01, 1), r01);
+        r23 = madd_avx(c1, SPLAT8(m23, 1), r23);
+        r01 = madd_avx(c2, SPLAT8(m01, 2), r01);
+        r23 = madd_avx(c2, SPLAT8(m23, 2), r23);
+        r01 = madd_avx(c3, SPLAT8(m01, 3), r01);
+        r23 = madd_avx(c3, SPLAT8(m23, 3), r23);
+
+        _mm256_storeu_ps(&out[i].data[0], r01);
+        _mm256_storeu_ps(&out[i].data[8], r23);
+    }
+}
+
+MATH_TARGET("avx")
+void aabb_transform_n_avx(aabb *restrict out, const aabb *restrict in,
+                          const mat4 *m, u32 count)
+{
+    __m256 c[4];
+    aabb_columns_x2(m, c);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        __m256 ce = aabb_center_extent(&in[i]);
+        __m256 r = madd_avx(c[0], SPLAT8(ce, 0), c[3]);
+        r = madd_avx(c[1], SPLAT8(ce, 1), r);
+        r = madd_avx(c[2], SPLAT8(ce, 2), r);
+        aabb_store(&out[i], r);
+    }
+}
+
+MATH_TARGET("avx2,fma")
+void mat4_mul_vec3_n_fma(vec3 *restrict out, const vec3 *restrict in,
+                         const mat4 *m, u32 count)
+{
+    __m256 c0 = BCAST8(&m->data[0]);
+    __m256 c1 = BCAST8(&m->data[4]);
+    __m256 c2 = BCAST8(&m->data[8]);
+    __m256 c3 = BCAST8(&m->data[12]);
+
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m256 p = load_x2(in[i].elements, in[i + 1].elements);
+        __m256 r = _mm256_fmadd_ps(c0, SPLAT8(p, 0), c3);
+        r = _mm256_fmadd_ps(c1, SPLAT8(p, 1), r);
+        r = _mm256_fmadd_ps(c2, SPLAT8(p, 2), r);
+        store_x2(out[i].elements, out[i + 1].elements, r);
+    }
+    if (i < count) mat4_mul_vec3_n_sse2(&out[i], &in[i], m, count - i);
+}
+
+MATH_TARGET("avx2,fma")
+void mat4_mul_n_fma(mat4 *restrict out, const mat4 *restrict models,
+                    const mat4 *vp, u32 count)
+{
+    __m256 c0 = BCAST8(&vp->data[0]);
+    __m256 c1 = BCAST8(&vp->data[4]);
+    __m256 c2 = BCAST8(&vp->data[8]);
+    __m256 c3 = BCAST8(&vp->data[12]);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        __m256 m01 = _mm256_loadu_ps(&models[i].data[0]);
+        __m256 m23 = _mm256_loadu_ps(&models[i].data[8]);
+
+        __m256 r01 = _mm256_mul_ps(c0, SPLAT8(m01, 0));
+        __m256 r23 = _mm256_mul_ps(c0, SPLAT8(m23, 0));
+        r01 = _mm256_fmadd_ps(c1, SPLAT8(m01, 1), r01);
+        r23 = _mm256_fmadd_ps(c1, SPLAT8(m23, 1), r23);
+        r01 = _mm256_fmadd_ps(c2, SPLAT8(m01, 2), r01);
+        r23 = _mm256_fmadd_ps(c2, SPLAT8(m23, 2), r23);
+        r01 = _mm256_fmadd_ps(c3, SPLAT8(m01, 3), r01);
+        r23 = _mm256_fmadd_ps(c3, SPLAT8(m23, 3), r23);
+
+        _mm256_storeu_ps(&out[i].data[0], r01);
+        _mm256_storeu_ps(&out[i].data[8], r23);
+    }
+}
+
+MATH_TARGET("avx2,fma")
+void aabb_transform_n_fma(aabb *restrict out, const aabb *restrict in,
+                          const mat4 *m, u32 count)
+{
+    __m256 c[4];
+    aabb_columns_x2(m, c);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        __m256 ce = aabb_center_extent(&in[i]);
+        __m256 r = _mm256_fmadd_ps(c[0], SPLAT8(ce, 0), c[3]);
+        r = _mm256_fmadd_ps(c[1], SPLAT8(ce, 1), r);
+        r = _mm256_fmadd_ps(c[2], SPLAT8(ce, 2), r);
+        aabb_store(&out[i], r);
+    }
+}
+
+/*************************
+ * AVX-512
+ *
+ * Four 128-bit lanes: four points, or the four columns of one matrix.
+ *************************/
+#    define SPLAT16(v, i) _mm512_permute_ps(v, _MM_SHUFFLE(i, i, i, i))
+#    define BCAST16(p) _mm512_broadcast_f32x4(_mm_load_ps(p))
+
+MATH_TARGET("avx512f")
+void mat4_mul_vec3_n_avx512(vec3 *restrict out, const vec3 *restrict in,
+                            const mat4 *m, u32 count)
+{
+    __m512 c0 = BCAST16(&m->data[0]);
+    __m512 c1 = BCAST16(&m->data[4]);
+    __m512 c2 = BCAST16(&m->data[8]);
+    __m512 c3 = BCAST16(&m->data[12]);
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // vec3 is padded to 16 bytes, so four of them are contiguous
+        __m512 p = _mm512_loadu_ps(in[i].elements);
+        __m512 r = _mm512_fmadd_ps(c0, SPLAT16(p, 0), c3);
+        r = _mm512_fmadd_ps(c1, SPLAT16(p, 1), r);
+        r = _mm512_fmadd_ps(c2, SPLAT16(p, 2), r);
+        _mm512_storeu_ps(out[i].elements, r);
+    }
+    if (i < count) mat4_mul_vec3_n_sse2(&out[i], &in[i], m, count - i);
+}
+
+MATH_TARGET("avx512f")
+void mat4_mul_n_avx512(mat4 *restrict out, const mat4 *restrict models,
+                       const mat4 *vp, u32 count)
+{
+    __m512 c0 = BCAST16(&vp->data[0]);
+    __m512 c1 = BCAST16(&vp->data[4]);
+    __m512 c2 = BCAST16(&vp->data[8]);
+    __m512 c3 = BCAST16(&vp->data[12]);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        __m512 mc = _mm512_loadu_ps(models[i].data);
+        __m512 r = _mm512_mul_ps(c0, SPLAT16(mc, 0));
+        r = _mm512_fmadd_ps(c1, SPLAT16(mc, 1), r);
+        r = _mm512_fmadd_ps(c2, SPLAT16(mc, 2), r);
+        r = _mm512_fmadd_ps(c3, SPLAT16(mc, 3), r);
+        _mm512_storeu_ps(out[i].data, r);
+    }
+}
+#endif // MATH_DISPATCH
+
+/*************************
+ * PUBLIC
+ *************************/
+void mat4_mul_vec3_n(vec3 *restrict out, const vec3 *restrict in,
+                     const mat4 *m, u32 count)
+{
+    g_math_kernels.mat4_mul_vec3_n(out, in, m, count);
+}
+
+void mat4_mul_n(mat4 *restrict out, const mat4 *restrict models,
+                const mat4 *vp, u32 count)
+{
+    g_math_kernels.mat4_mul_n(out, models, vp, count);
+}
+
+void aabb_transform_n(aabb *restrict out, const aabb *restrict in,
+                      const mat4 *m, u32 count)
+{
+    g_math_kernels.aabb_transform_n(out, in, m, count);
+}
@@ -0,0 +1,24 @@
+#ifndef MATH_BATCH_H
+#define MATH_BATCH_H
+
+#include "math_types.h"
+
+/*
+ * Batch kernels over arrays. Matrices are passed by pointer, arrays must
+ * not overlap (restrict). Each kernel has scalar, SSE2, AVX and AVX2+FMA
+ * variants (some also AVX-512), selected at runtime by math_dispatch.
+ */
+
+// out[i] = mat4_mul_vec3(*m, in[i]), points (w = 1)
+void mat4_mul_vec3_n(vec3 *restrict out, const vec3 *restrict in,
+                     const mat4 *m, u32 count);
+
+// out[i] = mat4_mul(models[i], *vp)
+void mat4_mul_n(mat4 *restrict out, const mat4 *restrict models,
+                const mat4 *vp, u32 count);
+
+// out[i] = world space bounds of in[i] transformed by *m
+void aabb_transform_n(aabb *restrict out, const aabb *restrict in,
+                      const mat4 *m, u32 count);
+
+#endif // MATH_BATCH_H
@@ -0,0 +1,127 @@
+#include "math_dispatch.h"
+
+#include "engine/platform/cpu.h"
+
+#if MATH_DISPATCH
+math_kernels_t g_math_kernels = {
+    .level = MATH_SIMD_SSE2,
+    .mat4_inverse_n = mat4_inverse_n_sse2,
+    .mat4_mul_vec3_n = mat4_mul_vec3_n_sse2,
+    .mat4_mul_n = mat4_mul_n_sse2,
+    .aabb_transform_n = aabb_transform_n_sse2,
+    .sincos_n = m_fast_sincos_n_sse2,
+    .rsqrt_n = m_fast_rsqrt_n_sse2,
+    .exp_n = m_fast_exp_n_sse2,
+    .log_n = m_fast_log_n_sse2,
+    .atan2_n = m_fast_atan2_n_sse2,
+    .acos_n = m_fast_acos_n_sse2,
+};
+#else
+math_kernels_t g_math_kernels = {
+    .level = MATH_SIMD_SCALAR,
+    .mat4_inverse_n = mat4_inverse_n_scalar,
+    .mat4_mul_vec3_n = mat4_mul_vec3_n_scalar,
+    .mat4_mul_n = mat4_mul_n_scalar,
+    .aabb_transform_n = aabb_transform_n_scalar,
+    .sincos_n = m_fast_sincos_n_scalar,
+    .rsqrt_n = m_fast_rsqrt_n_scalar,
+    .exp_n = m_fast_exp_n_scalar,
+    .log_n = m_fast_log_n_scalar,
+    .atan2_n = m_fast_atan2_n_scalar,
+    .acos_n = m_fast_acos_n_scalar,
+};
+#endif
+
+static const char *g_simd_names[MATH_SIMD_MAX] = {
+    "scalar", "sse2", "avx", "avx2+fma", "avx512"};
+
+math_simd_t math_simd_supported(void)
+{
+#if MATH_DISPATCH
+    if (cpu_has(CPU_AVX512F | CPU_AVX2 | CPU_FMA)) return MATH_SIMD_AVX512;
+    if (cpu_has(CPU_AVX2 | CPU_FMA)) return MATH_SIMD_FMA;
+    if (cpu_has(CPU_AVX)) return MATH_SIMD_AVX;
+    return MATH_SIMD_SSE2;
+#else
+    return MATH_SIMD_SCALAR;
+#endif
+}
+
+math_simd_t math_dispatch_select(math_simd_t level)
+{
+    math_simd_t max = math_simd_supported();
+    if (level > max) level = max;
+
+    math_kernels_t k = {0};
+    k.level = level;
+    k.mat4_inverse_n = mat4_inverse_n_scalar;
+    k.mat4_mul_vec3_n = mat4_mul_vec3_n_scalar;
+    k.mat4_mul_n = mat4_mul_n_scalar;
+    k.aabb_transform_n = aabb_transform_n_scalar;
+    k.sincos_n = m_fast_sincos_n_scalar;
+    k.rsqrt_n = m_fast_rsqrt_n_scalar;
+    k.exp_n = m_fast_exp_n_scalar;
+    k.log_n = m_fast_log_n_scalar;
+    k.atan2_n = m_fast_atan2_n_scalar;
+    k.acos_n = m_fast_acos_n_scalar;
+
+#if MATH_DISPATCH
+    // each kernel takes the widest variant at or below the level
+    if (level >= MATH_SIMD_SSE2)
+    {
+        k.mat4_inverse_n = mat4_inverse_n_sse2;
+        k.mat4_mul_vec3_n = mat4_mul_vec3_n_sse2;
+        k.mat4_mul_n = mat4_mul_n_sse2;
+        k.aabb_transform_n = aabb_transform_n_sse2;
+        k.sincos_n = m_fast_sincos_n_sse2;
+        k.rsqrt_n = m_fast_rsqrt_n_sse2;
+        k.exp_n = m_fast_exp_n_sse2;
+        k.log_n = m_fast_log_n_sse2;
+        k.atan2_n = m_fast_atan2_n_sse2;
+        k.acos_n = m_fast_acos_n_sse2;
+    }
+    if (level >= MATH_SIMD_AVX)
+    {
+        k.mat4_inverse_n = mat4_inverse_n_avx;
+        k.mat4_mul_vec3_n = mat4_mul_vec3_n_avx;
+        k.mat4_mul_n = mat4_mul_n_avx;
+        k.aabb_transform_n = aabb_transform_n_avx;
+    }
+    if (level >= MATH_SIMD_FMA)
+    {
+        k.mat4_mul_vec3_n = mat4_mul_vec3_n_fma;
+        k.mat4_mul_n = mat4_mul_n_fma;
+        k.aabb_transform_n = aabb_transform_n_fma;
+        k.sincos_n = m_fast_sincos_n_fma;
+        k.rsqrt_n = m_fast_rsqrt_n_fma;
+        k.exp_n = m_fast_exp_n_fma;
+        k.log_n = m_fast_log_n_fma;
+        k.atan2_n = m_fast_atan2_n_fma;
+        k.acos_n = m_fast_acos_n_fma;
+    }
+    if (level >= MATH_SIMD_AVX512)
+    {
+        k.mat4_mul_vec3_n = mat4_mul_vec3_n_avx512;
+        k.mat4_mul_n = mat4_mul_n_avx512;
+    }
+#endif
+
+    g_math_kernels = k;
+    return level;
+}
+
+void math_dispatch_init(void)
+{
+    const cpu_info_t *cpu = cpu_probe();
+    math_simd_t level = math_dispatch_select(MATH_SIMD_MAX);
+    LOG_INFO("Math SIMD: %s (%s)", math_simd_name(level),
+             cpu->brand[0] ? cpu->brand : cpu->vendor);
+}
+
+math_simd_t math_simd_level(void) { return g_math_kernels.level; }
+
+const char *math_simd_name(math_simd_t level)
+{
+    if (level >= MATH_SIMD_MAX) return "unknown";
+    return g_simd_names[level];
+}
@@ -0,0 +1,119 @@
+#ifndef MATH_DISPATCH_H
+#define MATH_DISPATCH_H
+
+#include "math_types.h"
+
+typedef enum {
+    MATH_SIMD_SCALAR = 0,
+    MATH_SIMD_SSE2,
+    MATH_SIMD_AVX,
+    MATH_SIMD_FMA, // AVX2 + FMA
+    MATH_SIMD_AVX512,
+    MATH_SIMD_MAX
+} math_simd_t;
+
+// Hot math kernels, filled by math_dispatch_init with the widest variant
+// the host supports. Before init it holds the compile time baseline, so
+// calling the batch API early is still valid.
+typedef struct {
+    math_simd_t level;
+    void (*mat4_inverse_n)(mat4 *restrict out, const mat4 *restrict in,
+                           u32 count);
+    void (*mat4_mul_vec3_n)(vec3 *restrict out, const vec3 *restrict in,
+                            const mat4 *m, u32 count);
+    void (*mat4_mul_n)(mat4 *restrict out, const mat4 *restrict models,
+                       const mat4 *vp, u32 count);
+    void (*aabb_transform_n)(aabb *restrict out, const aabb *restrict in,
+                             const mat4 *m, u32 count);
+
+    // math_fast.h
+    void (*sincos_n)(f32 *restrict s, f32 *restrict c, const f32 *restrict x,
+                     u32 count);
+    void (*rsqrt_n)(f32 *restrict out, const f32 *restrict in, u32 count);
+    void (*exp_n)(f32 *restrict out, const f32 *restrict in, u32 count);
+    void (*log_n)(f32 *restrict out, const f32 *restrict in, u32 count);
+    void (*atan2_n)(f32 *restrict out, const f32 *restrict y,
+                    const f32 *restrict x, u32 count);
+    void (*acos_n)(f32 *restrict out, const f32 *restrict in, u32 count);
+} math_kernels_t;
+
+extern math_kernels_t g_math_kernels;
+
+// Probe the cpu and select kernels. Call once at startup before any worker
+// thread uses the math library.
+void math_dispatch_init(void);
+
+// Select a lower level (benchmarks, tests). Clamped to what the host
+// supports, returns the level actually selected.
+math_simd_t math_dispatch_select(math_simd_t level);
+
+math_simd_t math_simd_supported(void);
+
+math_simd_t math_simd_level(void);
+
+const char *math_simd_name(math_simd_t level);
+
+/*************************
+ * Kernel variants
+ *************************/
+void mat4_inverse_n_scalar(mat4 *restrict out, const mat4 *restrict in,
+                           u32 count);
+void mat4_mul_vec3_n_scalar(vec3 *restrict out, const vec3 *restrict in,
+                            const mat4 *m, u32 count);
+void mat4_mul_n_scalar(mat4 *restrict out, const mat4 *restrict models,
+                       const mat4 *vp, u32 count);
+void aabb_transform_n_scalar(aabb *restrict out, const aabb *restrict in,
+                             const mat4 *m, u32 count);
+
+#define MATH_FAST_VARIANTS(suffix)                                            \
+    void m_fast_sincos_n_##suffix(f32 *restrict s, f32 *restrict c,          \
+                                  const f32 *restrict x, u32 count);          \
+    void m_fast_rsqrt_n_##suffix(f32 *restrict out, const f32 *restrict in,   \
+                                 u32 count);                                  \
+    void m_fast_exp_n_##suffix(f32 *restrict out, const f32 *restrict in,     \
+                               u32 count);                                    \
+    void m_fast_log_n_##suffix(f32 *restrict out, const f32 *restrict in,     \
+                               u32 count);                                    \
+    void m_fast_atan2_n_##suffix(f32 *restrict out, const f32 *restrict y,    \
+                                 const f32 *restrict x, u32 count);           \
+    void m_fast_acos_n_##suffix(f32 *restrict out, const f32 *restrict in,    \
+                                u32 count);
+
+MATH_FAST_VARIANTS(scalar)
+
+#if MATH_DISPATCH
+void mat4_inverse_n_sse2(mat4 *restrict out, const mat4 *restrict in,
+                         u32 count);
+void mat4_inverse_n_avx(mat4 *restrict out, const mat4 *restrict in,
+                        u32 count);
+
+void mat4_mul_vec3_n_sse2(vec3 *restrict out, const vec3 *restrict in,
+                          const mat4 *m, u32 count);
+void mat4_mul_vec3_n_avx(vec3 *restrict out, const vec3 *restrict in,
+                         const mat4 *m, u32 count);
+void mat4_mul_vec3_n_fma(vec3 *restrict out, const vec3 *restrict in,
+                         const mat4 *m, u32 count);
+void mat4_mul_vec3_n_avx512(vec3 *restrict out, const vec3 *restrict in,
+                            const mat4 *m, u32 count);
+
+void mat4_mul_n_sse2(mat4 *restrict out, const mat4 *restrict models,
+                     const mat4 *vp, u32 count);
+void mat4_mul_n_avx(mat4 *restrict out, const mat4 *restrict models,
+                    const mat4 *vp, u32 count);
+void mat4_mul_n_fma(mat4 *restrict out, const mat4 *restrict models,
+                    const mat4 *vp, u32 count);
+void mat4_mul_n_avx512(mat4 *restrict out, const mat4 *restrict models,
+                       const mat4 *vp, u32 count);
+
+void aabb_transform_n_sse2(aabb *restrict out, const aabb *restrict in,
+                           const mat4 *m, u32 count);
+void aabb_transform_n_avx(aabb *restrict out, const aabb *restrict in,
+                          const mat4 *m, u32 count);
+void aabb_transform_n_fma(aabb *restrict out, const aabb *restrict in,
+                          const mat4 *m, u32 count);
+
+MATH_FAST_VARIANTS(sse2)
+MATH_FAST_VARIANTS(fma)
+#endif // MATH_DISPATCH
+
+#endif // MATH_DISPATCH_H
@@ -0,0 +1,395 @@
+#include "math_fast.h"
+#include "math_dispatch.h"
+
+/*************************
+ * SCALAR (libm reference)
+ *************************/
+void m_fast_sincos_n_scalar(f32 *restrict s, f32 *restrict c,
+                            const f32 *restrict x, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        s[i] = m_sin(x[i]);
+        c[i] = m_cos(x[i]);
+    }
+}
+
+void m_fast_rsqrt_n_scalar(f32 *restrict out, const f32 *restrict in,
+                           u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = 1.0f / m_sqrt(in[i]);
+}
+
+void m_fast_exp_n_scalar(f32 *restrict out, const f32 *restrict in,
+                         u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = m_exp(in[i]);
+}
+
+void m_fast_log_n_scalar(f32 *restrict out, const f32 *restrict in,
+                         u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = m_log(in[i]);
+}
+
+void m_fast_atan2_n_scalar(f32 *restrict out, const f32 *restrict y,
+                           const f32 *restrict x, u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = m_atan2(y[i], x[i]);
+}
+
+void m_fast_acos_n_scalar(f32 *restrict out, const f32 *restrict in,
+                          u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+        out[i] = m_acos(CLAMP(in[i], -1.0f, 1.0f));
+}
+
+#if MATH_DISPATCH
+/*************************
+ * SSE2
+ *************************/
+// Tails go through a padded copy so every lane the kernel sees is valid
+#    define FAST_TAIL_LOAD(tmp, src, i, n)                                    \
+        ALIGN(16) f32 tmp[4] = {1.0f, 1.0f, 1.0f, 1.0f};                      \
+        for (u32 k = 0; k < (n) - (i); k++) tmp[k] = (src)[(i) + k]
+
+#    define FAST_TAIL_STORE(dst, tmp, i, n)                                   \
+        for (u32 k = 0; k < (n) - (i); k++) (dst)[(i) + k] = tmp[k]
+
+#    define FAST_UNARY_SSE2(name, kernel)                                     \
+        void m_fast_##name##_n_sse2(f32 *restrict out,                        \
+                                    const f32 *restrict in, u32 count)        \
+        {                                                                     \
+            u32 i = 0;                                                        \
+            for (; i + 4 <= count; i += 4)                                    \
+                _mm_storeu_ps(out + i, kernel(_mm_loadu_ps(in + i)));         \
+            if (i < count)                                                    \
+            {                                                                 \
+                FAST_TAIL_LOAD(tmp, in, i, count);                            \
+                _mm_store_ps(tmp, kernel(_mm_load_ps(tmp)));                  \
+                FAST_TAIL_STORE(out, tmp, i, count);                          \
+            }                                                                 \
+        }
+
+FAST_UNARY_SSE2(rsqrt, m_fast_rsqrt_x4)
+FAST_UNARY_SSE2(exp, m_fast_exp_x4)
+FAST_UNARY_SSE2(log, m_fast_log_x4)
+FAST_UNARY_SSE2(acos, m_fast_acos_x4)
+
+void m_fast_sincos_n_sse2(f32 *restrict s, f32 *restrict c,
+                          const f32 *restrict x, u32 count)
+{
+    f32x4 vs, vc;
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        m_fast_sincos_x4(_mm_loadu_ps(x + i), &vs, &vc);
+        _mm_storeu_ps(s + i, vs);
+        _mm_storeu_ps(c + i, vc);
+    }
+    if (i < count)
+    {
+        FAST_TAIL_LOAD(tmp, x, i, count);
+        m_fast_sincos_x4(_mm_load_ps(tmp), &vs, &vc);
+        _mm_store_ps(tmp, vs);
+        FAST_TAIL_STORE(s, tmp, i, count);
+        _mm_store_ps(tmp, vc);
+        FAST_TAIL_STORE(c, tmp, i, count);
+    }
+}
+
+void m_fast_atan2_n_sse2(f32 *restrict out, const f32 *restrict y,
+                         const f32 *restrict x, u32 count)
+{
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(out + i, m_fast_atan2_x4(_mm_loadu_ps(y + i),
+                                               _mm_loadu_ps(x + i)));
+    }
+    if (i < count)
+    {
+        FAST_TAIL_LOAD(ty, y, i, count);
+        FAST_TAIL_LOAD(tx, x, i, count);
+        _mm_store_ps(ty, m_fast_atan2_x4(_mm_load_ps(ty), _mm_load_ps(tx)));
+        FAST_TAIL_STORE(out, ty, i, count);
+    }
+}
+
+/*************************
+ * AVX2 + FMA
+ *************************/
+// 8 wide ports of the _x4 kernels in math_fast.h, same constants
+#    define F8(c) _mm256_set1_ps(c)
+#    define I8(c) _mm256_set1_epi32(c)
+#    define POLY8(p, z, c) _mm256_fmadd_ps(p, z, F8(c))
+
+MATH_TARGET("avx2,fma")
+static INL __m256 select8(__m256 mask, __m256 a, __m256 b)
+{
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+MATH_TARGET("avx2,fma")
+static INL void sincos_x8(__m256 x, __m256 *s, __m256 *c)
+{
+    const __m256 sign = F8(-0.0f);
+    __m256 sign_sin = _mm256_and_ps(x, sign);
+    x = _mm256_andnot_ps(sign, x);
+
+    __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, F8(M_FAST_4_OVER_PI)));
+    j = _mm256_and_si256(_mm256_add_epi32(j, I8(1)), I8(~1));
+    __m256 y = _mm256_cvtepi32_ps(j);
+
+    __m256i j_cos = _mm256_sub_epi32(j, I8(2));
+    __m256 swap_sin =
+        _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, I8(4)), 29));
+    __m256 sign_cos = _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_andnot_si256(j_cos, I8(4)), 29));
+    __m256 poly_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(j, I8(2)), _mm256_setzero_si256()));
+    sign_sin = _mm256_xor_ps(sign_sin, swap_sin);
+
+    x = _mm256_fnmadd_ps(y, F8(M_FAST_PI4_A), x);
+    x = _mm256_fnmadd_ps(y, F8(M_FAST_PI4_B), x);
+    x = _mm256_fnmadd_ps(y, F8(M_FAST_PI4_C), x);
+    __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 pc = F8(2.443315711809948e-5f);
+    pc = POLY8(pc, z, -1.388731625493765e-3f);
+    pc = POLY8(pc, z, 4.166664568298827e-2f);
+    pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+    pc = _mm256_fnmadd_ps(z, F8(0.5f), pc);
+    pc = _mm256_add_ps(pc, F8(1.0f));
+
+    __m256 ps = F8(-1.9515295891e-4f);
+    ps = POLY8(ps, z, 8.3321608736e-3f);
+    ps = POLY8(ps, z, -1.6666654611e-1f);
+    ps = _mm256_fmadd_ps(_mm256_mul_ps(ps, z), x, x);
+
+    *s = _mm256_xor_ps(select8(poly_mask, ps, pc), sign_sin);
+    *c = _mm256_xor_ps(select8(poly_mask, pc, ps), sign_cos);
+}
+
+MATH_TARGET("avx2,fma")
+static INL __m256 rsqrt_x8(__m256 x)
+{
+    __m256 r = _mm256_rsqrt_ps(x);
+    __m256 hx = _mm256_mul_ps(x, F8(0.5f));
+    return _mm256_mul_ps(r,
+                         _mm256_fnmadd_ps(hx, _mm256_mul_ps(r, r), F8(1.5f)));
+}
+
+MATH_TARGET("avx2,fma")
+static INL __m256 exp_x8(__m256 x)
+{
+    x = _mm256_min_ps(x, F8(M_FAST_EXP_MAX));
+    x = _mm256_max_ps(x, F8(-M_FAST_EXP_MAX));
+
+    __m256 fx =
+        _mm256_floor_ps(_mm256_fmadd_ps(x, F8(M_FAST_LOG2E), F8(0.5f)));
+    x = _mm256_fnmadd_ps(fx, F8(M_FAST_LN2_HI), x);
+    x = _mm256_fnmadd_ps(fx, F8(M_FAST_LN2_LO), x);
+    __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 y = F8(1.9875691500e-4f);
+    y = POLY8(y, x, 1.3981999507e-3f);
+    y = POLY8(y, x, 8.3334519073e-3f);
+    y = POLY8(y, x, 4.1665795894e-2f);
+    y = POLY8(y, x, 1.6666665459e-1f);
+    y = POLY8(y, x, 5.0000001201e-1f);
+    y = _mm256_add_ps(_mm256_fmadd_ps(y, z, x), F8(1.0f));
+
+    __m256i n = _mm256_add_epi32(_mm256_cvttps_epi32(fx), I8(0x7f));
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(n, 23)));
+}
+
+MATH_TARGET("avx2,fma")
+static INL __m256 log_x8(__m256 x)
+{
+    const __m256 one = F8(1.0f);
+    __m256 invalid = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OQ);
+    x = _mm256_max_ps(x, _mm256_castsi256_ps(I8(0x00800000)));
+
+    __m256i ei = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+    ei = _mm256_sub_epi32(ei, I8(0x7f));
+    x = _mm256_and_ps(x, _mm256_castsi256_ps(I8(~0x7f800000)));
+    x = _mm256_or_ps(x, F8(0.5f));
+    __m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(ei), one);
+
+    __m256 mask = _mm256_cmp_ps(x, F8(M_FAST_SQRTHF), _CMP_LT_OQ);
+    __m256 tmp = _mm256_and_ps(x, mask);
+    x = _mm256_sub_ps(x, one);
+    e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+    x = _mm256_add_ps(x, tmp);
+    __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 y = F8(7.0376836292e-2f);
+    y = POLY8(y, x, -1.1514610310e-1f);
+    y = POLY8(y, x, 1.1676998740e-1f);
+    y = POLY8(y, x, -1.2420140846e-1f);
+    y = POLY8(y, x, 1.4249322787e-1f);
+    y = POLY8(y, x, -1.6668057665e-1f);
+    y = POLY8(y, x, 2.0000714765e-1f);
+    y = POLY8(y, x, -2.4999993993e-1f);
+    y = POLY8(y, x, 3.3333331174e-1f);
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+    y = _mm256_fmadd_ps(e, F8(M_FAST_LN2_LO), y);
+    y = _mm256_fnmadd_ps(z, F8(0.5f), y);
+    x = _mm256_add_ps(x, y);
+    x = _mm256_fmadd_ps(e, F8(M_FAST_LN2_HI), x);
+    return _mm256_or_ps(x, invalid);
+}
+
+MATH_TARGET("avx2,fma")
+static INL __m256 atan_x8(__m256 x)
+{
+    const __m256 sign = F8(-0.0f);
+    const __m256 one = F8(1.0f);
+    __m256 sx = _mm256_and_ps(x, sign);
+    x = _mm256_andnot_ps(sign, x);
+
+    __m256 big = _mm256_cmp_ps(x, F8(M_FAST_TAN_3PI_8), _CMP_GT_OQ);
+    __m256 mid = _mm256_cmp_ps(x, F8(M_FAST_TAN_PI_8), _CMP_GT_OQ);
+    __m256 xb = _mm256_div_ps(F8(-1.0f), x);
+    __m256 xm = _mm256_div_ps(_mm256_sub_ps(x, one), _mm256_add_ps(x, one));
+    x = select8(big, xb, select8(mid, xm, x));
+    __m256 y0 = select8(big, F8(M_HALF_PI),
+                        _mm256_and_ps(mid, F8(M_QUARTER_PI)));
+    __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 p = F8(8.05374449538e-2f);
+    p = POLY8(p, z, -1.38776856032e-1f);
+    p = POLY8(p, z, 1.99777106478e-1f);
+    p = POLY8(p, z, -3.33329491539e-1f);
+    p = _mm256_fmadd_ps(_mm256_mul_ps(p, z), x, x);
+
+    return _mm256_xor_ps(_mm256_add_ps(y0, p), sx);
+}
+
+MATH_TARGET("avx2,fma")
+static INL __m256 atan2_x8(__m256 y, __m256 x)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 r = atan_x8(_mm256_div_ps(y, x));
+
+    __m256 pi = _mm256_or_ps(F8(M_PI), _mm256_and_ps(y, F8(-0.0f)));
+    __m256 neg_x = _mm256_cmp_ps(x, zero, _CMP_LT_OQ);
+    r = _mm256_add_ps(r, _mm256_and_ps(neg_x, pi));
+
+    __m256 origin = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_EQ_OQ),
+                                  _mm256_cmp_ps(y, zero, _CMP_EQ_OQ));
+    return _mm256_andnot_ps(origin, r);
+}
+
+MATH_TARGET("avx2,fma")
+static INL __m256 acos_x8(__m256 x)
+{
+    const __m256 one = F8(1.0f);
+    const __m256 sign = F8(-0.0f);
+    x = _mm256_min_ps(_mm256_max_ps(x, F8(-1.0f)), one);
+    __m256 sx = _mm256_and_ps(x, sign);
+    __m256 a = _mm256_andnot_ps(sign, x);
+
+    __m256 big = _mm256_cmp_ps(a, F8(0.5f), _CMP_GT_OQ);
+    __m256 zb = _mm256_mul_ps(F8(0.5f), _mm256_sub_ps(one, a));
+    __m256 z = select8(big, zb, _mm256_mul_ps(a, a));
+    __m256 t = select8(big, _mm256_sqrt_ps(zb), a);
+
+    __m256 p = F8(4.2163199048e-2f);
+    p = POLY8(p, z, 2.4181311049e-2f);
+    p = POLY8(p, z, 4.5470025998e-2f);
+    p = POLY8(p, z, 7.4953002686e-2f);
+    p = POLY8(p, z, 1.6666752422e-1f);
+    p = _mm256_fmadd_ps(_mm256_mul_ps(p, z), t, t);
+
+    __m256 rb = _mm256_add_ps(p, p);
+    rb = select8(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ),
+                 _mm256_sub_ps(F8(M_PI), rb), rb);
+    __m256 rs = _mm256_sub_ps(F8(M_HALF_PI), _mm256_xor_ps(p, sx));
+    return select8(big, rb, rs);
+}
+
+// Remainders (< 8) reuse the SSE2 entry points
+#    define FAST_UNARY_FMA(name, kernel)                                      \
+        MATH_TARGET("avx2,fma")                                               \
+        void m_fast_##name##_n_fma(f32 *restrict out,                         \
+                                   const f32 *restrict in, u32 count)         \
+        {                                                                     \
+            u32 i = 0;                                                        \
+            for (; i + 8 <= count; i += 8)                                    \
+                _mm256_storeu_ps(out + i, kernel(_mm256_loadu_ps(in + i)));   \
+            if (i < count)                                                    \
+                m_fast_##name##_n_sse2(out + i, in + i, count - i);           \
+        }
+
+FAST_UNARY_FMA(rsqrt, rsqrt_x8)
+FAST_UNARY_FMA(exp, exp_x8)
+FAST_UNARY_FMA(log, log_x8)
+FAST_UNARY_FMA(acos, acos_x8)
+
+MATH_TARGET("avx2,fma")
+void m_fast_sincos_n_fma(f32 *restrict s, f32 *restrict c,
+                         const f32 *restrict x, u32 count)
+{
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vs, vc;
+        sincos_x8(_mm256_loadu_ps(x + i), &vs, &vc);
+        _mm256_storeu_ps(s + i, vs);
+        _mm256_storeu_ps(c + i, vc);
+    }
+    if (i < count) m_fast_sincos_n_sse2(s + i, c + i, x + i, count - i);
+}
+
+MATH_TARGET("avx2,fma")
+void m_fast_atan2_n_fma(f32 *restrict out, const f32 *restrict y,
+                        const f32 *restrict x, u32 count)
+{
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(out + i, atan2_x8(_mm256_loadu_ps(y + i),
+                                           _mm256_loadu_ps(x + i)));
+    }
+    if (i < count) m_fast_atan2_n_sse2(out + i, y + i, x + i, count - i);
+}
+#endif // MATH_DISPATCH
+
+/*************************
+ * Public
+ *************************/
+void m_fast_sincos_n(f32 *restrict s, f32 *restrict c, const f32 *restrict x,
+                     u32 count)
+{
+    g_math_kernels.sincos_n(s, c, x, count);
+}
+
+void m_fast_rsqrt_n(f32 *restrict out, const f32 *restrict in, u32 count)
+{
+    g_math_kernels.rsqrt_n(out, in, count);
+}
+
+void m_fast_exp_n(f32 *restrict out, const f32 *restrict in, u32 count)
+{
+    g_math_kernels.exp_n(out, in, count);
+}
+
+void m_fast_log_n(f32 *restrict out, const f32 *restrict in, u32 count)
+{
+    g_math_kernels.log_n(out, in, count);
+}
+
+void m_fast_atan2_n(f32 *restrict out, const f32 *restrict y,
+                    const f32 *restrict x, u32 count)
+{
+    g_math_kernels.atan2_n(out, y, x, count);
+}
+
+void m_fast_acos_n(f32 *restrict out, const f32 *restrict in, u32 count)
+{
+    g_math_kernels.acos_n(out, in, count);
+}
@@ -0,0 +1,338 @@
+#ifndef MATH_FAST_H
+#define MATH_FAST_H
+
+#include "math_wide.h"
+
+/*
+ * Approximate transcendentals, Cephes style range reduction plus minimax
+ * polynomials. Max errors below are measured against double precision
+ * libm over the stated range (see test_fast_math):
+ *
+ *   sin/cos  abs 1e-7   |x| <= 8192, degrades past that
+ *   rsqrt    rel 3e-7   x > 0 (0 gives NaN), one Newton step
+ *   exp      rel 1e-7   |x| <= 87, input clamped to [-88.37, 88.37]
+ *   log      abs 3e-7   x in [0.01, 100], 1 ulp of the result beyond
+ *                       x <= 0 gives NaN (no -inf for 0)
+ *   atan2    abs 3e-7   finite input, atan2(0, 0) is 0
+ *   acos     abs 4e-7   input clamped to [-1, 1]
+ *
+ * The _x4 kernels are inline SSE2, m_fast_* are the scalar entry points
+ * (lane 0 of the same kernels) and the *_n batch functions are runtime
+ * dispatched (SSE2 or AVX2+FMA). Without SSE everything forwards to libm.
+ */
+
+#define M_FAST_4_OVER_PI 1.27323954473516268615f
+#define M_FAST_LOG2E 1.44269504088896340736f
+#define M_FAST_EXP_MAX 88.3762626647949f
+#define M_FAST_SQRTHF 0.707106781186547524f
+#define M_FAST_TAN_3PI_8 2.414213562373095f
+#define M_FAST_TAN_PI_8 0.4142135623730950f
+
+// Cody-Waite split constants
+#define M_FAST_PI4_A 0.78515625f
+#define M_FAST_PI4_B 2.4187564849853515625e-4f
+#define M_FAST_PI4_C 3.77489497744594108e-8f
+#define M_FAST_LN2_HI 0.693359375f
+#define M_FAST_LN2_LO -2.12194440e-4f
+
+#if MATH_SSE
+#    define M_FAST_POLY(p, z, c) _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(c))
+
+INL void m_fast_sincos_x4(f32x4 x, f32x4 *s, f32x4 *c)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 sign_sin = _mm_and_ps(x, sign);
+    x = _mm_andnot_ps(sign, x);
+
+    // octant, rounded up to even so the remainder is in [-pi/4, pi/4]
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(M_FAST_4_OVER_PI)));
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)),
+                      _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+
+    __m128i four = _mm_set1_epi32(4);
+    __m128i j_cos = _mm_sub_epi32(j, _mm_set1_epi32(2));
+    __m128 swap_sin =
+        _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, four), 29));
+    __m128 sign_cos =
+        _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(j_cos, four), 29));
+    __m128 poly_mask = _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+    sign_sin = _mm_xor_ps(sign_sin, swap_sin);
+
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(M_FAST_PI4_A)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(M_FAST_PI4_B)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(M_FAST_PI4_C)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 pc = _mm_set1_ps(2.443315711809948e-5f);
+    pc = M_FAST_POLY(pc, z, -1.388731625493765e-3f);
+    pc = M_FAST_POLY(pc, z, 4.166664568298827e-2f);
+    pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+    pc = _mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    pc = _mm_add_ps(pc, _mm_set1_ps(1.0f));
+
+    __m128 ps = _mm_set1_ps(-1.9515295891e-4f);
+    ps = M_FAST_POLY(ps, z, 8.3321608736e-3f);
+    ps = M_FAST_POLY(ps, z, -1.6666654611e-1f);
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), x), x);
+
+    // odd quadrant pairs swap the two polynomials
+    *s = _mm_xor_ps(f32x4_select(poly_mask, ps, pc), sign_sin);
+    *c = _mm_xor_ps(f32x4_select(poly_mask, pc, ps), sign_cos);
+}
+
+INL f32x4 m_fast_rsqrt_x4(f32x4 x)
+{
+    // 12 bit estimate, r * (1.5 - 0.5 * x * r * r) doubles the precision
+    __m128 r = _mm_rsqrt_ps(x);
+    __m128 hx = _mm_mul_ps(x, _mm_set1_ps(0.5f));
+    __m128 t = _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(hx, _mm_mul_ps(r, r)));
+    return _mm_mul_ps(r, t);
+}
+
+INL f32x4 m_fast_exp_x4(f32x4 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    x = _mm_min_ps(x, _mm_set1_ps(M_FAST_EXP_MAX));
+    x = _mm_max_ps(x, _mm_set1_ps(-M_FAST_EXP_MAX));
+
+    // n = floor(x / ln2 + 0.5), r = x - n * ln2
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(M_FAST_LOG2E)),
+                           _mm_set1_ps(0.5f));
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    fx = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, fx), one));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(M_FAST_LN2_HI)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(M_FAST_LN2_LO)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 y = _mm_set1_ps(1.9875691500e-4f);
+    y = M_FAST_POLY(y, x, 1.3981999507e-3f);
+    y = M_FAST_POLY(y, x, 8.3334519073e-3f);
+    y = M_FAST_POLY(y, x, 4.1665795894e-2f);
+    y = M_FAST_POLY(y, x, 1.6666665459e-1f);
+    y = M_FAST_POLY(y, x, 5.0000001201e-1f);
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), one);
+
+    // 2^n straight into the exponent bits
+    __m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(0x7f));
+    return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(n, 23)));
+}
+
+INL f32x4 m_fast_log_x4(f32x4 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 invalid = _mm_cmple_ps(x, _mm_setzero_ps());
+    x = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000)));
+
+    // x = m * 2^e with m in [0.5, 1)
+    __m128i ei = _mm_srli_epi32(_mm_castps_si128(x), 23);
+    ei = _mm_sub_epi32(ei, _mm_set1_epi32(0x7f));
+    x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000)));
+    x = _mm_or_ps(x, _mm_set1_ps(0.5f));
+    __m128 e = _mm_add_ps(_mm_cvtepi32_ps(ei), one);
+
+    // m < sqrt(1/2): use 2m - 1 and e - 1, keeps m - 1 small
+    __m128 mask = _mm_cmplt_ps(x, _mm_set1_ps(M_FAST_SQRTHF));
+    __m128 tmp = _mm_and_ps(x, mask);
+    x = _mm_sub_ps(x, one);
+    e = _mm_sub_ps(e, _mm_and_ps(one, mask));
+    x = _mm_add_ps(x, tmp);
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 y = _mm_set1_ps(7.0376836292e-2f);
+    y = M_FAST_POLY(y, x, -1.1514610310e-1f);
+    y = M_FAST_POLY(y, x, 1.1676998740e-1f);
+    y = M_FAST_POLY(y, x, -1.2420140846e-1f);
+    y = M_FAST_POLY(y, x, 1.4249322787e-1f);
+    y = M_FAST_POLY(y, x, -1.6668057665e-1f);
+    y = M_FAST_POLY(y, x, 2.0000714765e-1f);
+    y = M_FAST_POLY(y, x, -2.4999993993e-1f);
+    y = M_FAST_POLY(y, x, 3.3333331174e-1f);
+    y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(M_FAST_LN2_LO)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    x = _mm_add_ps(x, y);
+    x = _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(M_FAST_LN2_HI)));
+    return _mm_or_ps(x, invalid);
+}
+
+INL f32x4 m_fast_atan_x4(f32x4 x)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 sx = _mm_and_ps(x, sign);
+    x = _mm_andnot_ps(sign, x);
+
+    // fold into [0, tan(pi/8)] around 0, pi/4 or pi/2
+    __m128 big = _mm_cmpgt_ps(x, _mm_set1_ps(M_FAST_TAN_3PI_8));
+    __m128 mid = _mm_cmpgt_ps(x, _mm_set1_ps(M_FAST_TAN_PI_8));
+    __m128 xb = _mm_div_ps(_mm_set1_ps(-1.0f), x);
+    __m128 xm = _mm_div_ps(_mm_sub_ps(x, one), _mm_add_ps(x, one));
+    x = f32x4_select(big, xb, f32x4_select(mid, xm, x));
+    __m128 y0 = f32x4_select(
+        big, _mm_set1_ps(M_HALF_PI),
+        _mm_and_ps(mid, _mm_set1_ps(M_QUARTER_PI)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 p = _mm_set1_ps(8.05374449538e-2f);
+    p = M_FAST_POLY(p, z, -1.38776856032e-1f);
+    p = M_FAST_POLY(p, z, 1.99777106478e-1f);
+    p = M_FAST_POLY(p, z, -3.33329491539e-1f);
+    p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), x), x);
+
+    return _mm_xor_ps(_mm_add_ps(y0, p), sx);
+}
+
+INL f32x4 m_fast_atan2_x4(f32x4 y, f32x4 x)
+{
+    const __m128 zero = _mm_setzero_ps();
+    __m128 r = m_fast_atan_x4(_mm_div_ps(y, x));
+
+    // left half plane, move by pi toward the sign of y
+    __m128 pi = _mm_or_ps(_mm_set1_ps(M_PI),
+                          _mm_and_ps(y, _mm_set1_ps(-0.0f)));
+    r = _mm_add_ps(r, _mm_and_ps(_mm_cmplt_ps(x, zero), pi));
+
+    __m128 origin =
+        _mm_and_ps(_mm_cmpeq_ps(x, zero), _mm_cmpeq_ps(y, zero));
+    return _mm_andnot_ps(origin, r);
+}
+
+INL f32x4 m_fast_acos_x4(f32x4 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), one);
+    __m128 sx = _mm_and_ps(x, sign);
+    __m128 a = _mm_andnot_ps(sign, x);
+
+    // asin(t) on [0, 0.5]; |x| > 0.5 goes through sqrt((1 - |x|) / 2)
+    __m128 big = _mm_cmpgt_ps(a, _mm_set1_ps(0.5f));
+    __m128 zb = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(one, a));
+    __m128 z = f32x4_select(big, zb, _mm_mul_ps(a, a));
+    __m128 t = f32x4_select(big, _mm_sqrt_ps(zb), a);
+
+    __m128 p = _mm_set1_ps(4.2163199048e-2f);
+    p = M_FAST_POLY(p, z, 2.4181311049e-2f);
+    p = M_FAST_POLY(p, z, 4.5470025998e-2f);
+    p = M_FAST_POLY(p, z, 7.4953002686e-2f);
+    p = M_FAST_POLY(p, z, 1.6666752422e-1f);
+    p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), t), t);
+
+    // big: 2 asin(t), mirrored to pi - 2 asin(t) for negative x
+    __m128 rb = _mm_add_ps(p, p);
+    rb = f32x4_select(_mm_cmplt_ps(x, _mm_setzero_ps()),
+                      _mm_sub_ps(_mm_set1_ps(M_PI), rb), rb);
+    __m128 rs = _mm_sub_ps(_mm_set1_ps(M_HALF_PI), _mm_xor_ps(p, sx));
+    return f32x4_select(big, rb, rs);
+}
+
+#    undef M_FAST_POLY
+
+INL void m_fast_sincos(f32 x, f32 *s, f32 *c)
+{
+    f32x4 vs, vc;
+    m_fast_sincos_x4(_mm_set1_ps(x), &vs, &vc);
+    *s = _mm_cvtss_f32(vs);
+    *c = _mm_cvtss_f32(vc);
+}
+
+INL f32 m_fast_sin(f32 x)
+{
+    f32 s, c;
+    m_fast_sincos(x, &s, &c);
+    return s;
+}
+
+INL f32 m_fast_cos(f32 x)
+{
+    f32 s, c;
+    m_fast_sincos(x, &s, &c);
+    return c;
+}
+
+INL f32 m_fast_rsqrt(f32 x)
+{
+    return _mm_cvtss_f32(m_fast_rsqrt_x4(_mm_set1_ps(x)));
+}
+
+INL f32 m_fast_exp(f32 x)
+{
+    return _mm_cvtss_f32(m_fast_exp_x4(_mm_set1_ps(x)));
+}
+
+INL f32 m_fast_log(f32 x)
+{
+    return _mm_cvtss_f32(m_fast_log_x4(_mm_set1_ps(x)));
+}
+
+INL f32 m_fast_atan2(f32 y, f32 x)
+{
+    return _mm_cvtss_f32(m_fast_atan2_x4(_mm_set1_ps(y), _mm_set1_ps(x)));
+}
+
+INL f32 m_fast_acos(f32 x)
+{
+    return _mm_cvtss_f32(m_fast_acos_x4(_mm_set1_ps(x)));
+}
+
+// sin/cos of all three angles in one kernel call
+INL void m_fast_sincos3(vec3 angles, vec3 *s, vec3 *c)
+{
+    f32x4 vs, vc;
+    m_fast_sincos_x4(angles.simd, &vs, &vc);
+    s->simd = m_simd_mask_xyz(vs);
+    c->simd = m_simd_mask_xyz(vc);
+}
+#else
+INL void m_fast_sincos(f32 x, f32 *s, f32 *c)
+{
+    *s = m_sin(x);
+    *c = m_cos(x);
+}
+INL f32 m_fast_sin(f32 x) { return m_sin(x); }
+INL f32 m_fast_cos(f32 x) { return m_cos(x); }
+INL f32 m_fast_rsqrt(f32 x) { return 1.0f / m_sqrt(x); }
+INL f32 m_fast_exp(f32 x) { return m_exp(x); }
+INL f32 m_fast_log(f32 x) { return m_log(x); }
+INL f32 m_fast_atan2(f32 y, f32 x) { return m_atan2(y, x); }
+INL f32 m_fast_acos(f32 x) { return m_acos(CLAMP(x, -1.0f, 1.0f)); }
+
+INL void m_fast_sincos3(vec3 angles, vec3 *s, vec3 *c)
+{
+    *s = vec3_create(m_sin(angles.x), m_sin(angles.y), m_sin(angles.z));
+    *c = vec3_create(m_cos(angles.x), m_cos(angles.y), m_cos(angles.z));
+}
+#endif // MATH_SSE
+
+// Same matrix as mat4_rotation_xyz with the six trig calls batched
+// clang-format off
+INL mat4 mat4_rotation_xyz_fast(vec3 angles)
+{
+    vec3 s, c;
+    m_fast_sincos3(angles, &s, &c);
+
+    return mat4_create(
+        c.y * c.z,                    c.y * s.z,                    -s.y,       0.0f,
+        c.z * s.x * s.y - c.x * s.z,  c.x * c.z + s.x * s.y * s.z,  c.y * s.x,  0.0f,
+        c.x * c.z * s.y + s.x * s.z,  c.x * s.y * s.z - c.z * s.x,  c.x * c.y,  0.0f,
+        0.0f,                         0.0f,                         0.0f,       1.0f
+    );
+}
+// clang-format on
+
+/*************************
+ * Batch (runtime dispatched)
+ *************************/
+void m_fast_sincos_n(f32 *restrict s, f32 *restrict c, const f32 *restrict x,
+                     u32 count);
+void m_fast_rsqrt_n(f32 *restrict out, const f32 *restrict in, u32 count);
+void m_fast_exp_n(f32 *restrict out, const f32 *restrict in, u32 count);
+void m_fast_log_n(f32 *restrict out, const f32 *restrict in, u32 count);
+void m_fast_atan2_n(f32 *restrict out, const f32 *restrict y,
+                    const f32 *restrict x, u32 count);
+void m_fast_acos_n(f32 *restrict out, const f32 *restrict in, u32 count);
+
+#endif // MATH_FAST_H
@@ -1,24 +1,14 @@
 #include "math_test.h"
+#include "math_batch.h"
+#include "math_dispatch.h"
+#include "math_wide.h"
+#include "math_fast.h"
 
 #include "engine/core/clock.h"
+#include "engine/core/test.h"
 
 #include <stdio.h>
 
-#define RUN_TEST(test_func)                                                   \
-    do                                                                        \
-    {                                                                         \
-        if (!test_func())                                                     \
-        {                                                                     \
-            printf("->FAIL: %s\n", #test_func);                               \
-            all_passed = false;                                               \
-        }                                                                     \
-        else                                                                  \
-        {                                                                     \
-            printf("->PASS: %s\n", #test_func);                               \
-        }                                                                     \
-    }                                                                         \
-    while (0)
-
 b8 expect_f32(f32 actual, f32 expected, f32 t, const char *test_name)
 {
     b8 passed = m_abs(actual - expected) <= t;
@@ -244,7 +234,328 @@ b8 test_matrix_inverse(void)
     return all_passed;
 }
 
-void math_run_all_tests(void)
+b8 test_matrix_inverse_simd(void)
+{
+    b8 all_passed = true;
+
+    mat4 inputs[7];
+    inputs[0] = mat4_identity();
+    inputs[1] = mat4_translation(vec3_create(1.0f, -2.0f, 3.0f));
+    inputs[2] = mat4_mul(mat4_rotation_xyz(vec3_create(0.3f, -1.2f, 2.0f)),
+                         mat4_translation(vec3_create(4.0f, 5.0f, -6.0f)));
+    inputs[3] = mat4_mul(mat4_scaling(vec3_create(2.0f, 0.5f, 3.0f)),
+                         mat4_rotation_y(0.7f));
+    inputs[4] = mat4_perspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    inputs[5] = mat4_create(2.0f, 1.0f, 0.0f, 3.0f,  // column 0
+                            -1.0f, 4.0f, 2.0f, 0.0f, // column 1
+                            0.5f, 0.0f, 3.0f, 1.0f,  // column 2
+                            1.0f, 2.0f, -1.0f, 5.0f  // column 3
+    );
+    inputs[6] = mat4_zero(); // singular, expect identity
+
+    // single inverse against the scalar reference
+    for (u32 i = 0; i < 7; i++)
+    {
+        mat4 expected = mat4_inverse_scalar(inputs[i]);
+        all_passed &= expect_mat4(mat4_inverse(inputs[i]), expected, 0.001f,
+                                  "inverse(simd) vs scalar");
+    }
+
+    // M * inverse(M) must be identity for the invertible ones
+    for (u32 i = 0; i < 6; i++)
+    {
+        mat4 product = mat4_mul(inputs[i], mat4_inverse(inputs[i]));
+        all_passed &= expect_mat4(product, mat4_identity(), 0.001f,
+                                  "M * inverse(M)");
+    }
+
+    // odd count so the batch path also hits its scalar tail
+    mat4 batch[7];
+    mat4_inverse_n(batch, inputs, 7);
+    for (u32 i = 0; i < 7; i++)
+    {
+        mat4 expected = mat4_inverse_scalar(inputs[i]);
+        all_passed &= expect_mat4(batch[i], expected, 0.001f,
+                                  "mat4_inverse_n vs scalar");
+    }
+
+    return all_passed;
+}
+
+b8 test_batch_transforms(void)
+{
+    b8 all_passed = true;
+
+    mat4 m = mat4_mul(mat4_rotation_xyz(vec3_create(0.4f, 1.1f, -0.3f)),
+                      mat4_translation(vec3_create(3.0f, -1.0f, 2.0f)));
+    mat4 vp = mat4_mul(mat4_look_at(vec3_create(2.0f, 3.0f, 8.0f),
+                                    vec3_zero(), vec3_up()),
+                       mat4_perspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f));
+
+    // odd counts so the 2-wide paths also run their tails
+    vec3 points[5], points_out[5];
+    mat4 models[3], mvp[3];
+    aabb boxes[3], boxes_out[3];
+    for (u32 i = 0; i < 5; i++)
+    {
+        f32 f = (f32)i;
+        points[i] = vec3_create(f, -2.0f * f + 1.0f, 0.5f * f - 3.0f);
+    }
+    for (u32 i = 0; i < 3; i++)
+    {
+        f32 f = (f32)i + 1.0f;
+        models[i] = mat4_mul(mat4_scaling(vec3_create(f, 1.0f, 0.5f * f)),
+                             mat4_rotation_y(0.3f * f));
+        boxes[i].min = vec3_create(-f, -1.0f, -0.5f * f);
+        boxes[i].max = vec3_create(f, 2.0f * f, 0.25f);
+    }
+
+    mat4_mul_vec3_n(points_out, points, &m, 5);
+    for (u32 i = 0; i < 5; i++)
+    {
+        all_passed &= expect_vec3(points_out[i], mat4_mul_vec3(m, points[i]),
+                                  0.0001f, "mat4_mul_vec3_n");
+    }
+
+    mat4_mul_n(mvp, models, &vp, 3);
+    for (u32 i = 0; i < 3; i++)
+    {
+        all_passed &= expect_mat4(mvp[i], mat4_mul(models[i], vp), 0.0001f,
+                                  "mat4_mul_n");
+    }
+
+    // reference: bounds of the 8 transformed corners
+    aabb_transform_n(boxes_out, boxes, &m, 3);
+    for (u32 i = 0; i < 3; i++)
+    {
+        vec3 mn = vec3_create(M_INFINITE, M_INFINITE, M_INFINITE);
+        vec3 mx = vec3_create(-M_INFINITE, -M_INFINITE, -M_INFINITE);
+        for (u32 c = 0; c < 8; c++)
+        {
+            aabb b = boxes[i];
+            vec3 corner = vec3_create((c & 1) ? b.max.x : b.min.x,
+                                      (c & 2) ? b.max.y : b.min.y,
+                                      (c & 4) ? b.max.z : b.min.z);
+            vec3 p = mat4_mul_vec3(m, corner);
+            mn = vec3_create(MIN(mn.x, p.x), MIN(mn.y, p.y), MIN(mn.z, p.z));
+            mx = vec3_create(MAX(mx.x, p.x), MAX(mx.y, p.y), MAX(mx.z, p.z));
+        }
+        all_passed &=
+            expect_vec3(boxes_out[i].min, mn, 0.0001f, "aabb_transform_n min");
+        all_passed &=
+            expect_vec3(boxes_out[i].max, mx, 0.0001f, "aabb_transform_n max");
+    }
+
+    return all_passed;
+}
+
+b8 test_simd_dispatch(void)
+{
+    b8 all_passed = true;
+
+    mat4 inputs[5];
+    for (u32 i = 0; i < 5; i++)
+    {
+        f32 f = (f32)i + 1.0f;
+        inputs[i] =
+            mat4_mul(mat4_rotation_xyz(vec3_create(0.2f * f, -0.5f, f)),
+                     mat4_translation(vec3_create(f, 2.0f, -f)));
+    }
+
+    // run every variant the host can execute against the scalar reference
+    math_simd_t saved = math_simd_level();
+    math_simd_t max = math_simd_supported();
+    for (u32 level = MATH_SIMD_SCALAR; level <= (u32)max; level++)
+    {
+        math_dispatch_select((math_simd_t)level);
+        printf("   simd level: %s\n", math_simd_name(math_simd_level()));
+
+        mat4 out[5];
+        mat4_inverse_n(out, inputs, 5);
+        for (u32 i = 0; i < 5; i++)
+        {
+            all_passed &= expect_mat4(out[i], mat4_inverse_scalar(inputs[i]),
+                                      0.001f, "dispatched mat4_inverse_n");
+        }
+        all_passed &= test_batch_transforms();
+    }
+    math_dispatch_select(saved);
+
+    return all_passed;
+}
+
+b8 test_wide_vectors(void)
+{
+    b8 all_passed = true;
+#if MATH_SSE
+    vec3 a[8], b[8], out[8];
+    for (u32 i = 0; i < 8; i++)
+    {
+        f32 f = (f32)i;
+        a[i] = vec3_create(f - 3.0f, 0.5f * f, 2.0f - f);
+        b[i] = vec3_create(1.0f, -f, 0.25f * f + 1.0f);
+    }
+    a[5] = vec3_zero(); // normalize must give zero, not NaN
+
+    vec3x4 a4 = vec3x4_load(a), b4 = vec3x4_load(b);
+    vec3x4_store(out, vec3x4_cross(a4, b4));
+    for (u32 i = 0; i < 4; i++)
+    {
+        all_passed &= expect_vec3(out[i], vec3_cross(a[i], b[i]), 0.0001f,
+                                  "vec3x4_cross");
+    }
+
+    f32 dots[8];
+    f32x4_store(dots, vec3x4_dot(a4, b4));
+    for (u32 i = 0; i < 4; i++)
+    {
+        all_passed &=
+            expect_f32(dots[i], vec3_dot(a[i], b[i]), 0.0001f, "vec3x4_dot");
+    }
+
+    vec3x8 a8 = vec3x8_load(a), b8 = vec3x8_load(b);
+    vec3x8_store(out, vec3x8_normalize(vec3x8_add(a8, a8)));
+    for (u32 i = 0; i < 8; i++)
+    {
+        vec3 expected = vec3_normalize(vec3_add(a[i], a[i]));
+        all_passed &=
+            expect_vec3(out[i], expected, 0.0001f, "vec3x8_normalize");
+    }
+
+    // keep a where dot(a, b) > 0, else b
+    f32x8 mask = f32x8_gt(vec3x8_dot(a8, b8), f32x8_set1(0.0f));
+    vec3x8_store(out, vec3x8_select(mask, a8, b8));
+    for (u32 i = 0; i < 8; i++)
+    {
+        vec3 expected = vec3_dot(a[i], b[i]) > 0.0f ? a[i] : b[i];
+        all_passed &= expect_vec3(out[i], expected, 0.0f, "vec3x8_select");
+    }
+#endif
+    return all_passed;
+}
+
+b8 test_fast_math(void)
+{
+    b8 all_passed = true;
+
+    // 37 samples, so the 4 and 8 wide paths both run a tail
+    enum { N = 37 };
+    f32 x[N], y[N], pos[N], unit[N], o1[N], o2[N];
+    for (u32 i = 0; i < N; i++)
+    {
+        f32 t = (f32)i / (f32)(N - 1);
+        x[i] = LERP(-50.0f, 50.0f, t);
+        y[i] = LERP(20.0f, -30.0f, t);
+        pos[i] = LERP(0.01f, 100.0f, t);
+        unit[i] = LERP(-1.0f, 1.0f, t);
+    }
+
+    math_simd_t saved = math_simd_level();
+    math_simd_t max = math_simd_supported();
+    for (u32 level = MATH_SIMD_SCALAR; level <= (u32)max; level++)
+    {
+        math_dispatch_select((math_simd_t)level);
+
+        m_fast_sincos_n(o1, o2, x, N);
+        for (u32 i = 0; i < N; i++)
+        {
+            all_passed &= expect_f32(o1[i], m_sin(x[i]), 2e-6f, "sincos_n");
+            all_passed &= expect_f32(o2[i], m_cos(x[i]), 2e-6f, "sincos_n");
+        }
+
+        m_fast_rsqrt_n(o1, pos, N);
+        for (u32 i = 0; i < N; i++)
+        {
+            f32 ref = 1.0f / m_sqrt(pos[i]);
+            all_passed &= expect_f32(o1[i], ref, ref * 1e-6f, "rsqrt_n");
+        }
+
+        m_fast_exp_n(o1, x, N);
+        for (u32 i = 0; i < N; i++)
+        {
+            f32 ref = m_exp(x[i]);
+            all_passed &= expect_f32(o1[i], ref, ref * 1e-6f, "exp_n");
+        }
+
+        m_fast_log_n(o1, pos, N);
+        for (u32 i = 0; i < N; i++)
+            all_passed &= expect_f32(o1[i], m_log(pos[i]), 1e-6f, "log_n");
+
+        m_fast_atan2_n(o1, y, x, N);
+        for (u32 i = 0; i < N; i++)
+        {
+            all_passed &=
+                expect_f32(o1[i], m_atan2(y[i], x[i]), 1e-6f, "atan2_n");
+        }
+
+        m_fast_acos_n(o1, unit, N);
+        for (u32 i = 0; i < N; i++)
+            all_passed &= expect_f32(o1[i], m_acos(unit[i]), 1e-6f, "acos_n");
+    }
+    math_dispatch_select(saved);
+
+    // scalar entry points and the batched rotation
+    all_passed &=
+        expect_f32(m_fast_sin(1.0f), m_sin(1.0f), 1e-6f, "m_fast_sin");
+    all_passed &= expect_f32(m_fast_cos(-2.5f), m_cos(-2.5f), 1e-6f,
+                             "m_fast_cos");
+    all_passed &= expect_f32(m_fast_atan2(-1.0f, -1.0f),
+                             m_atan2(-1.0f, -1.0f), 1e-6f, "m_fast_atan2");
+    vec3 angles = vec3_create(0.3f, -1.2f, 2.1f);
+    all_passed &= expect_mat4(mat4_rotation_xyz_fast(angles),
+                              mat4_rotation_xyz(angles), 1e-6f,
+                              "mat4_rotation_xyz_fast");
+
+    return all_passed;
+}
+
+b8 test_frustum(void)
+{
+    b8 all_passed = true;
+
+    // identity view looking down -Z, 90 degree fov so the side planes sit
+    // at 45 degrees
+    mat4 view = mat4_identity();
+    mat4 proj = mat4_perspective(90.0f, 1.0f, 0.1f, 100.0f);
+    frustum f = frustum_from_mat4(mat4_mul(view, proj));
+
+    all_passed &= expect_vec4(f.planes[FRUSTUM_NEAR],
+                              vec4_create(0.0f, 0.0f, -1.0f, -0.1f), 1e-4f,
+                              "frustum near plane");
+    all_passed &= expect_f32(plane_distance(f.planes[FRUSTUM_LEFT],
+                                            vec3_create(0.0f, 0.0f, -5.0f)),
+                             5.0f * 0.70710678f, 1e-4f, "left plane distance");
+
+    all_passed &= expect_f32(
+        (f32)frustum_sphere_visible(&f, vec3_create(0.0f, 0.0f, -5.0f), 0.1f),
+        1.0f, 0.0f, "sphere inside");
+    all_passed &= expect_f32(
+        (f32)frustum_sphere_visible(&f, vec3_create(0.0f, 0.0f, 5.0f), 1.0f),
+        0.0f, 0.0f, "sphere behind");
+    all_passed &= expect_f32(
+        (f32)frustum_sphere_visible(&f, vec3_create(0.0f, 0.0f, -200.0f),
+                                    1.0f),
+        0.0f, 0.0f, "sphere past far");
+    all_passed &= expect_f32(
+        (f32)frustum_sphere_visible(&f, vec3_create(6.0f, 0.0f, -5.0f), 1.0f),
+        1.0f, 0.0f, "sphere straddling right");
+    all_passed &= expect_f32(
+        (f32)frustum_sphere_visible(&f, vec3_create(6.0f, 0.0f, -5.0f), 0.5f),
+        0.0f, 0.0f, "sphere outside right");
+
+    aabb straddle = {vec3_create(-20.0f, -1.0f, -6.0f),
+                     vec3_create(20.0f, 1.0f, -4.0f)};
+    aabb outside = {vec3_create(8.0f, -1.0f, -6.0f),
+                    vec3_create(9.0f, 1.0f, -4.0f)};
+    all_passed &= expect_f32((f32)frustum_aabb_visible(&f, straddle), 1.0f,
+                             0.0f, "aabb straddling");
+    all_passed &= expect_f32((f32)frustum_aabb_visible(&f, outside), 0.0f,
+                             0.0f, "aabb outside");
+
+    return all_passed;
+}
+
+b8 math_run_all_tests(void)
 {
     printf("\n=== RUN MATH LIBRARY TEST ===\n");
 
@@ -255,8 +566,15 @@ void math_run_all_tests(void)
     RUN_TEST(test_transforms);
     RUN_TEST(test_matrices_dir);
     RUN_TEST(test_matrix_inverse);
+    RUN_TEST(test_matrix_inverse_simd);
+    RUN_TEST(test_batch_transforms);
+    RUN_TEST(test_simd_dispatch);
+    RUN_TEST(test_wide_vectors);
+    RUN_TEST(test_fast_math);
+    RUN_TEST(test_frustum);
 
     printf("%s\n", all_passed ? "ALL PASSED" : "SOME FAILED");
+    return all_passed;
 }
 
 void test_simd_vs_scalar(void)
@@ -268,7 +586,7 @@ void test_simd_vs_scalar(void)
     mat4 a = mat4_identity();
     mat4 b = mat4_rotation_x(M_PI / 4.0f);
 
-    // Only benchmark matrices since vectors use scalar
+    // Matrices only, vec3/vec4 go through SSE on both sides
     f64 start = timer_get();
     for (u32 i = 0; i < ITERATIONS; i++)
     {
@@ -328,8 +646,7 @@ void benchmark_simd_vs_scalar(math_benchmark *result)
     end = timer_get();
     result->matrix_scalar_time = end - start;
 
-    // Benchmark vector operations (both use scalar since we removed vector
-    // SIMD)
+    // Benchmark vector operations (SSE vec3 when MATH_SSE)
     start = timer_get();
     for (u32 i = 0; i < ITERATIONS; i++)
     {
@@ -16,7 +16,7 @@ typedef struct math_benchmark {
 
 void benchmark_simd_vs_scalar(math_benchmark *result);
 
-void math_run_all_tests(void);
+b8 math_run_all_tests(void);
 void test_simd_vs_scalar(void);
 
 b8 test_vectors(void);
@@ -25,6 +25,12 @@ b8 test_quaternions(void);
 b8 test_transforms(void);
 b8 test_matrices_dir(void);
 b8 test_matrix_inverse(void);
+b8 test_matrix_inverse_simd(void);
+b8 test_batch_transforms(void);
+b8 test_simd_dispatch(void);
+b8 test_wide_vectors(void);
+b8 test_fast_math(void);
+b8 test_frustum(void);
 
 b8 expect_f32(f32 actual, f32 expected, f32 t, const char *test_name);
 b8 expect_vec3(vec3 actual, vec3 expected, f32 t, const char *test_name);
@@ -11,6 +11,41 @@
 #    define MATH_SSE 0
 #endif
 
+#if defined(__AVX__)
+#    define MATH_AVX 1
+#    include <immintrin.h> // AVX
+#else
+#    define MATH_AVX 0
+#endif
+
+#if defined(__AVX2__)
+#    define MATH_AVX2 1
+#else
+#    define MATH_AVX2 0
+#endif
+
+#if defined(__FMA__)
+#    define MATH_FMA 1
+#else
+#    define MATH_FMA 0
+#endif
+
+// The MATH_AVX* flags above describe the baseline the build targets. Batch
+// kernels are compiled for every x86 level regardless and picked at
+// runtime (see math_dispatch.h), MATH_TARGET marks those functions.
+#if MATH_SSE && (defined(__GNUC__) || defined(_MSC_VER))
+#    define MATH_DISPATCH 1
+#    include <immintrin.h>
+#    if defined(__GNUC__)
+#        define MATH_TARGET(isa) __attribute__((target(isa)))
+#    else
+#        define MATH_TARGET(isa)
+#    endif
+#else
+#    define MATH_DISPATCH 0
+#    define MATH_TARGET(isa)
+#endif
+
 // Vector types
 typedef union VEC2
 {
@@ -38,6 +73,9 @@ typedef union VEC3
         f32 u, v, t;
     };
     f32 elements[3];
+#if MATH_SSE
+    __m128 simd; // w lane is padding, kept at zero
+#endif
 } ALIGN(16) vec3;
 
 typedef union VEC4
@@ -52,6 +90,9 @@ typedef union VEC4
         f32 u, v, t, s;
     };
     f32 elements[4];
+#if MATH_SSE
+    __m128 simd;
+#endif
 } ALIGN(16) vec4;
 
 typedef union MAT4
@@ -84,8 +125,22 @@ typedef union QUAT
 
     vec4 as_vec4;
     f32 elements[4];
+#if MATH_SSE
+    __m128 simd;
+#endif
 } ALIGN(16) quat;
 
+typedef struct AABB {
+    vec3 min;
+    vec3 max;
+} ALIGN(16) aabb;
+
+// Planes are (normal, d) with the normal pointing inside, a point p is on
+// the inner side when dot(normal, p) + d >= 0
+typedef struct FRUSTUM {
+    vec4 planes[6];
+} ALIGN(16) frustum;
+
 typedef struct vertex {
     vec3 position;
     vec3 normal;
@@ -0,0 +1,307 @@
+#ifndef MATH_WIDE_H
+#define MATH_WIDE_H
+
+#include "maths.h"
+
+/*
+ * SoA wide vectors: vec3x4 holds 4 vec3 (one lane each), vec3x8 holds 8.
+ * Everything here is inline, so the width is fixed at compile time. vec3x8
+ * uses a ymm register per component when the build targets AVX, otherwise
+ * two xmm halves. Masks come from the f32xN compares (all bits set in a
+ * true lane) and feed the select functions.
+ */
+#if MATH_SSE
+
+/*************************
+ * f32x4
+ *************************/
+typedef __m128 f32x4;
+
+INL f32x4 f32x4_set1(f32 s) { return _mm_set1_ps(s); }
+INL f32x4 f32x4_load(const f32 *src) { return _mm_loadu_ps(src); }
+INL void f32x4_store(f32 *dst, f32x4 v) { _mm_storeu_ps(dst, v); }
+INL f32x4 f32x4_add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+INL f32x4 f32x4_sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+INL f32x4 f32x4_mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+INL f32x4 f32x4_div(f32x4 a, f32x4 b) { return _mm_div_ps(a, b); }
+INL f32x4 f32x4_sqrt(f32x4 v) { return _mm_sqrt_ps(v); }
+INL f32x4 f32x4_min(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+INL f32x4 f32x4_max(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+INL f32x4 f32x4_lt(f32x4 a, f32x4 b) { return _mm_cmplt_ps(a, b); }
+INL f32x4 f32x4_gt(f32x4 a, f32x4 b) { return _mm_cmpgt_ps(a, b); }
+INL u32 f32x4_mask(f32x4 m) { return (u32)_mm_movemask_ps(m); }
+
+// mask ? a : b, per lane
+INL f32x4 f32x4_select(f32x4 mask, f32x4 a, f32x4 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/*************************
+ * f32x8
+ *************************/
+#    if MATH_AVX
+typedef __m256 f32x8;
+
+INL f32x8 f32x8_set1(f32 s) { return _mm256_set1_ps(s); }
+INL f32x8 f32x8_load(const f32 *src) { return _mm256_loadu_ps(src); }
+INL void f32x8_store(f32 *dst, f32x8 v) { _mm256_storeu_ps(dst, v); }
+INL f32x8 f32x8_add(f32x8 a, f32x8 b) { return _mm256_add_ps(a, b); }
+INL f32x8 f32x8_sub(f32x8 a, f32x8 b) { return _mm256_sub_ps(a, b); }
+INL f32x8 f32x8_mul(f32x8 a, f32x8 b) { return _mm256_mul_ps(a, b); }
+INL f32x8 f32x8_div(f32x8 a, f32x8 b) { return _mm256_div_ps(a, b); }
+INL f32x8 f32x8_sqrt(f32x8 v) { return _mm256_sqrt_ps(v); }
+INL f32x8 f32x8_min(f32x8 a, f32x8 b) { return _mm256_min_ps(a, b); }
+INL f32x8 f32x8_max(f32x8 a, f32x8 b) { return _mm256_max_ps(a, b); }
+INL f32x8 f32x8_lt(f32x8 a, f32x8 b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+}
+INL f32x8 f32x8_gt(f32x8 a, f32x8 b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+}
+INL u32 f32x8_mask(f32x8 m) { return (u32)_mm256_movemask_ps(m); }
+
+INL f32x8 f32x8_select(f32x8 mask, f32x8 a, f32x8 b)
+{
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+INL f32x4 f32x8_lo(f32x8 v) { return _mm256_castps256_ps128(v); }
+INL f32x4 f32x8_hi(f32x8 v) { return _mm256_extractf128_ps(v, 1); }
+INL f32x8 f32x8_combine(f32x4 lo, f32x4 hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+#    else
+typedef struct {
+    f32x4 lo, hi;
+} f32x8;
+
+#        define F32X8_OP2(name, op)                                           \
+            INL f32x8 f32x8_##name(f32x8 a, f32x8 b)                          \
+            {                                                                 \
+                return (f32x8){op(a.lo, b.lo), op(a.hi, b.hi)};               \
+            }
+
+F32X8_OP2(add, _mm_add_ps)
+F32X8_OP2(sub, _mm_sub_ps)
+F32X8_OP2(mul, _mm_mul_ps)
+F32X8_OP2(div, _mm_div_ps)
+F32X8_OP2(min, _mm_min_ps)
+F32X8_OP2(max, _mm_max_ps)
+F32X8_OP2(lt, _mm_cmplt_ps)
+F32X8_OP2(gt, _mm_cmpgt_ps)
+#        undef F32X8_OP2
+
+INL f32x8 f32x8_set1(f32 s)
+{
+    return (f32x8){_mm_set1_ps(s), _mm_set1_ps(s)};
+}
+INL f32x8 f32x8_load(const f32 *src)
+{
+    return (f32x8){_mm_loadu_ps(src), _mm_loadu_ps(src + 4)};
+}
+INL void f32x8_store(f32 *dst, f32x8 v)
+{
+    _mm_storeu_ps(dst, v.lo);
+    _mm_storeu_ps(dst + 4, v.hi);
+}
+INL f32x8 f32x8_sqrt(f32x8 v)
+{
+    return (f32x8){_mm_sqrt_ps(v.lo), _mm_sqrt_ps(v.hi)};
+}
+INL u32 f32x8_mask(f32x8 m)
+{
+    return (u32)_mm_movemask_ps(m.lo) | ((u32)_mm_movemask_ps(m.hi) << 4);
+}
+
+INL f32x8 f32x8_select(f32x8 mask, f32x8 a, f32x8 b)
+{
+    return (f32x8){f32x4_select(mask.lo, a.lo, b.lo),
+                   f32x4_select(mask.hi, a.hi, b.hi)};
+}
+
+INL f32x4 f32x8_lo(f32x8 v) { return v.lo; }
+INL f32x4 f32x8_hi(f32x8 v) { return v.hi; }
+INL f32x8 f32x8_combine(f32x4 lo, f32x4 hi) { return (f32x8){lo, hi}; }
+#    endif // MATH_AVX
+
+/*************************
+ * VECTOR 3 x4
+ *************************/
+typedef struct {
+    f32x4 x, y, z;
+} vec3x4;
+
+INL vec3x4 vec3x4_set1(vec3 v)
+{
+    return (vec3x4){_mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z)};
+}
+
+// AoS <-> SoA, src/dst hold 4 vec3
+INL vec3x4 vec3x4_load(const vec3 *src)
+{
+    __m128 r0 = _mm_load_ps(src[0].elements);
+    __m128 r1 = _mm_load_ps(src[1].elements);
+    __m128 r2 = _mm_load_ps(src[2].elements);
+    __m128 r3 = _mm_load_ps(src[3].elements);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    return (vec3x4){r0, r1, r2};
+}
+
+INL void vec3x4_store(vec3 *dst, vec3x4 v)
+{
+    __m128 r0 = v.x, r1 = v.y, r2 = v.z, r3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_store_ps(dst[0].elements, r0);
+    _mm_store_ps(dst[1].elements, r1);
+    _mm_store_ps(dst[2].elements, r2);
+    _mm_store_ps(dst[3].elements, r3);
+}
+
+INL vec3x4 vec3x4_add(vec3x4 a, vec3x4 b)
+{
+    return (vec3x4){f32x4_add(a.x, b.x), f32x4_add(a.y, b.y),
+                    f32x4_add(a.z, b.z)};
+}
+
+INL vec3x4 vec3x4_sub(vec3x4 a, vec3x4 b)
+{
+    return (vec3x4){f32x4_sub(a.x, b.x), f32x4_sub(a.y, b.y),
+                    f32x4_sub(a.z, b.z)};
+}
+
+INL vec3x4 vec3x4_mul(vec3x4 a, vec3x4 b)
+{
+    return (vec3x4){f32x4_mul(a.x, b.x), f32x4_mul(a.y, b.y),
+                    f32x4_mul(a.z, b.z)};
+}
+
+INL vec3x4 vec3x4_scale(vec3x4 v, f32x4 s)
+{
+    return (vec3x4){f32x4_mul(v.x, s), f32x4_mul(v.y, s), f32x4_mul(v.z, s)};
+}
+
+INL f32x4 vec3x4_dot(vec3x4 a, vec3x4 b)
+{
+    f32x4 r = f32x4_mul(a.x, b.x);
+    r = f32x4_add(r, f32x4_mul(a.y, b.y));
+    return f32x4_add(r, f32x4_mul(a.z, b.z));
+}
+
+INL vec3x4 vec3x4_cross(vec3x4 a, vec3x4 b)
+{
+    return (vec3x4){
+        f32x4_sub(f32x4_mul(a.y, b.z), f32x4_mul(a.z, b.y)),
+        f32x4_sub(f32x4_mul(a.z, b.x), f32x4_mul(a.x, b.z)),
+        f32x4_sub(f32x4_mul(a.x, b.y), f32x4_mul(a.y, b.x))};
+}
+
+INL f32x4 vec3x4_length(vec3x4 v) { return f32x4_sqrt(vec3x4_dot(v, v)); }
+
+INL vec3x4 vec3x4_select(f32x4 mask, vec3x4 a, vec3x4 b)
+{
+    return (vec3x4){f32x4_select(mask, a.x, b.x),
+                    f32x4_select(mask, a.y, b.y),
+                    f32x4_select(mask, a.z, b.z)};
+}
+
+// Same rule as vec3_normalize, lanes not longer than epsilon become zero
+INL vec3x4 vec3x4_normalize(vec3x4 v)
+{
+    f32x4 len = vec3x4_length(v);
+    f32x4 ok = f32x4_gt(len, f32x4_set1(M_EPSILON));
+    vec3x4 n = vec3x4_scale(v, f32x4_div(f32x4_set1(1.0f), len));
+    f32x4 zero = _mm_setzero_ps();
+    return vec3x4_select(ok, n, (vec3x4){zero, zero, zero});
+}
+
+/*************************
+ * VECTOR 3 x8
+ *************************/
+typedef struct {
+    f32x8 x, y, z;
+} vec3x8;
+
+INL vec3x8 vec3x8_set1(vec3 v)
+{
+    return (vec3x8){f32x8_set1(v.x), f32x8_set1(v.y), f32x8_set1(v.z)};
+}
+
+// AoS <-> SoA, src/dst hold 8 vec3
+INL vec3x8 vec3x8_load(const vec3 *src)
+{
+    vec3x4 lo = vec3x4_load(src);
+    vec3x4 hi = vec3x4_load(src + 4);
+    return (vec3x8){f32x8_combine(lo.x, hi.x), f32x8_combine(lo.y, hi.y),
+                    f32x8_combine(lo.z, hi.z)};
+}
+
+INL void vec3x8_store(vec3 *dst, vec3x8 v)
+{
+    vec3x4_store(dst, (vec3x4){f32x8_lo(v.x), f32x8_lo(v.y), f32x8_lo(v.z)});
+    vec3x4_store(dst + 4,
+                 (vec3x4){f32x8_hi(v.x), f32x8_hi(v.y), f32x8_hi(v.z)});
+}
+
+INL vec3x8 vec3x8_add(vec3x8 a, vec3x8 b)
+{
+    return (vec3x8){f32x8_add(a.x, b.x), f32x8_add(a.y, b.y),
+                    f32x8_add(a.z, b.z)};
+}
+
+INL vec3x8 vec3x8_sub(vec3x8 a, vec3x8 b)
+{
+    return (vec3x8){f32x8_sub(a.x, b.x), f32x8_sub(a.y, b.y),
+                    f32x8_sub(a.z, b.z)};
+}
+
+INL vec3x8 vec3x8_mul(vec3x8 a, vec3x8 b)
+{
+    return (vec3x8){f32x8_mul(a.x, b.x), f32x8_mul(a.y, b.y),
+                    f32x8_mul(a.z, b.z)};
+}
+
+INL vec3x8 vec3x8_scale(vec3x8 v, f32x8 s)
+{
+    return (vec3x8){f32x8_mul(v.x, s), f32x8_mul(v.y, s), f32x8_mul(v.z, s)};
+}
+
+INL f32x8 vec3x8_dot(vec3x8 a, vec3x8 b)
+{
+    f32x8 r = f32x8_mul(a.x, b.x);
+    r = f32x8_add(r, f32x8_mul(a.y, b.y));
+    return f32x8_add(r, f32x8_mul(a.z, b.z));
+}
+
+INL vec3x8 vec3x8_cross(vec3x8 a, vec3x8 b)
+{
+    return (vec3x8){
+        f32x8_sub(f32x8_mul(a.y, b.z), f32x8_mul(a.z, b.y)),
+        f32x8_sub(f32x8_mul(a.z, b.x), f32x8_mul(a.x, b.z)),
+        f32x8_sub(f32x8_mul(a.x, b.y), f32x8_mul(a.y, b.x))};
+}
+
+INL f32x8 vec3x8_length(vec3x8 v) { return f32x8_sqrt(vec3x8_dot(v, v)); }
+
+INL vec3x8 vec3x8_select(f32x8 mask, vec3x8 a, vec3x8 b)
+{
+    return (vec3x8){f32x8_select(mask, a.x, b.x),
+                    f32x8_select(mask, a.y, b.y),
+                    f32x8_select(mask, a.z, b.z)};
+}
+
+INL vec3x8 vec3x8_normalize(vec3x8 v)
+{
+    f32x8 len = vec3x8_length(v);
+    f32x8 ok = f32x8_gt(len, f32x8_set1(M_EPSILON));
+    vec3x8 n = vec3x8_scale(v, f32x8_div(f32x8_set1(1.0f), len));
+    f32x8 zero = f32x8_set1(0.0f);
+    return vec3x8_select(ok, n, (vec3x8){zero, zero, zero});
+}
+
+#endif // MATH_SSE
+
+#endif // MATH_WIDE_H
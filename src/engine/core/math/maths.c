@@ -1,4 +1,5 @@
 #include "maths.h"
+#include "math_dispatch.h"
 
 f32 vec2_length(vec2 v) { return sqrtf(vec2_length_sq(v)); }
 
@@ -95,10 +96,10 @@ mat4 mat4_inverse(mat4 m)
 }
 */
 
-mat4 mat4_inverse(mat4 m)
+mat4 mat4_inverse_scalar(mat4 m)
 {
     mat4 result;
-    static f32 inv[16];
+    f32 inv[16];
 
     const f32 *mat = m.data;
 
@@ -178,6 +179,247 @@ mat4 mat4_inverse(mat4 m)
     return result;
 }
 
+#if MATH_SSE
+/*
+ * Block-wise inverse. The matrix is split in four 2x2 blocks
+ *   | A B |
+ *   | C D |
+ * and each block lives in one register as (m00, m01, m10, m11). Inverse of
+ * the transpose is the transpose of the inverse, so the columns can be fed
+ * in as rows and the result comes out column-major again.
+ */
+#define SHUF4(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define SWIZ4(v, x, y, z, w) SHUF4(v, v, x, y, z, w)
+
+// A * B
+static INL __m128 mat2_mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, SWIZ4(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(SWIZ4(a, 1, 0, 3, 2), SWIZ4(b, 2, 1, 2, 1)));
+}
+
+// adj(A) * B
+static INL __m128 mat2_adj_mul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZ4(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(SWIZ4(a, 1, 1, 2, 2), SWIZ4(b, 2, 3, 0, 1)));
+}
+
+// A * adj(B)
+static INL __m128 mat2_mul_adj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZ4(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(SWIZ4(a, 1, 0, 3, 2), SWIZ4(b, 2, 1, 2, 1)));
+}
+
+mat4 mat4_inverse_simd(mat4 m)
+{
+    __m128 c0 = _mm_load_ps(&m.data[0]);
+    __m128 c1 = _mm_load_ps(&m.data[4]);
+    __m128 c2 = _mm_load_ps(&m.data[8]);
+    __m128 c3 = _mm_load_ps(&m.data[12]);
+
+    __m128 a = SHUF4(c0, c1, 0, 1, 0, 1);
+    __m128 b = SHUF4(c0, c1, 2, 3, 2, 3);
+    __m128 c = SHUF4(c2, c3, 0, 1, 0, 1);
+    __m128 d = SHUF4(c2, c3, 2, 3, 2, 3);
+
+    // (|A|, |B|, |C|, |D|)
+    __m128 det_sub = _mm_sub_ps(
+        _mm_mul_ps(SHUF4(c0, c2, 0, 2, 0, 2), SHUF4(c1, c3, 1, 3, 1, 3)),
+        _mm_mul_ps(SHUF4(c0, c2, 1, 3, 1, 3), SHUF4(c1, c3, 0, 2, 0, 2)));
+    __m128 det_a = SWIZ4(det_sub, 0, 0, 0, 0);
+    __m128 det_b = SWIZ4(det_sub, 1, 1, 1, 1);
+    __m128 det_c = SWIZ4(det_sub, 2, 2, 2, 2);
+    __m128 det_d = SWIZ4(det_sub, 3, 3, 3, 3);
+
+    __m128 d_c = mat2_adj_mul(d, c);
+    __m128 a_b = mat2_adj_mul(a, b);
+
+    // adjugates of the result blocks
+    __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), mat2_mul(b, d_c));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), mat2_mul(c, a_b));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), mat2_mul_adj(d, a_b));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), mat2_mul_adj(a, d_c));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A)B * adj(D)C)
+    __m128 tr = _mm_mul_ps(a_b, SWIZ4(d_c, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, SWIZ4(tr, 1, 0, 3, 2));
+    tr = _mm_add_ps(tr, SWIZ4(tr, 2, 3, 0, 1));
+    __m128 det_m = _mm_add_ps(_mm_mul_ps(det_a, det_d),
+                              _mm_mul_ps(det_b, det_c));
+    det_m = _mm_sub_ps(det_m, tr);
+
+    if (m_abs(_mm_cvtss_f32(det_m)) < 1e-10f) return mat4_identity();
+
+    __m128 r_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+    x = _mm_mul_ps(x, r_det);
+    y = _mm_mul_ps(y, r_det);
+    z = _mm_mul_ps(z, r_det);
+    w = _mm_mul_ps(w, r_det);
+
+    mat4 result;
+    _mm_store_ps(&result.data[0], SHUF4(x, y, 3, 1, 3, 1));
+    _mm_store_ps(&result.data[4], SHUF4(x, y, 2, 0, 2, 0));
+    _mm_store_ps(&result.data[8], SHUF4(z, w, 3, 1, 3, 1));
+    _mm_store_ps(&result.data[12], SHUF4(z, w, 2, 0, 2, 0));
+    return result;
+}
+#endif // MATH_SSE
+
+#if MATH_DISPATCH
+/*
+ * Same block inverse as mat4_inverse_simd, two matrices at a time. Every
+ * shuffle used stays inside its 128-bit lane, so lane 0 carries in[0] and
+ * lane 1 carries in[1] through the whole computation.
+ */
+#define SHUF8(a, b, x, y, z, w)                                               \
+    _mm256_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define SWIZ8(v, x, y, z, w) SHUF8(v, v, x, y, z, w)
+
+MATH_TARGET("avx")
+static INL __m256 mat2_mul_x2(__m256 a, __m256 b)
+{
+    return _mm256_add_ps(
+        _mm256_mul_ps(a, SWIZ8(b, 0, 3, 0, 3)),
+        _mm256_mul_ps(SWIZ8(a, 1, 0, 3, 2), SWIZ8(b, 2, 1, 2, 1)));
+}
+
+MATH_TARGET("avx")
+static INL __m256 mat2_adj_mul_x2(__m256 a, __m256 b)
+{
+    return _mm256_sub_ps(
+        _mm256_mul_ps(SWIZ8(a, 3, 3, 0, 0), b),
+        _mm256_mul_ps(SWIZ8(a, 1, 1, 2, 2), SWIZ8(b, 2, 3, 0, 1)));
+}
+
+MATH_TARGET("avx")
+static INL __m256 mat2_mul_adj_x2(__m256 a, __m256 b)
+{
+    return _mm256_sub_ps(
+        _mm256_mul_ps(a, SWIZ8(b, 3, 0, 3, 0)),
+        _mm256_mul_ps(SWIZ8(a, 1, 0, 3, 2), SWIZ8(b, 2, 1, 2, 1)));
+}
+
+MATH_TARGET("avx")
+static INL __m256 load_col_x2(const mat4 *m, u32 col)
+{
+    __m256 lo = _mm256_castps128_ps256(_mm_load_ps(&m[0].data[col * 4]));
+    return _mm256_insertf128_ps(lo, _mm_load_ps(&m[1].data[col * 4]), 1);
+}
+
+MATH_TARGET("avx")
+static INL void store_col_x2(mat4 *m, u32 col, __m256 v)
+{
+    _mm_store_ps(&m[0].data[col * 4], _mm256_castps256_ps128(v));
+    _mm_store_ps(&m[1].data[col * 4], _mm256_extractf128_ps(v, 1));
+}
+
+MATH_TARGET("avx")
+static void mat4_inverse_x2(mat4 *restrict out, const mat4 *restrict in)
+{
+    __m256 c0 = load_col_x2(in, 0);
+    __m256 c1 = load_col_x2(in, 1);
+    __m256 c2 = load_col_x2(in, 2);
+    __m256 c3 = load_col_x2(in, 3);
+
+    __m256 a = SHUF8(c0, c1, 0, 1, 0, 1);
+    __m256 b = SHUF8(c0, c1, 2, 3, 2, 3);
+    __m256 c = SHUF8(c2, c3, 0, 1, 0, 1);
+    __m256 d = SHUF8(c2, c3, 2, 3, 2, 3);
+
+    __m256 det_sub = _mm256_sub_ps(
+        _mm256_mul_ps(SHUF8(c0, c2, 0, 2, 0, 2), SHUF8(c1, c3, 1, 3, 1, 3)),
+        _mm256_mul_ps(SHUF8(c0, c2, 1, 3, 1, 3), SHUF8(c1, c3, 0, 2, 0, 2)));
+    __m256 det_a = SWIZ8(det_sub, 0, 0, 0, 0);
+    __m256 det_b = SWIZ8(det_sub, 1, 1, 1, 1);
+    __m256 det_c = SWIZ8(det_sub, 2, 2, 2, 2);
+    __m256 det_d = SWIZ8(det_sub, 3, 3, 3, 3);
+
+    __m256 d_c = mat2_adj_mul_x2(d, c);
+    __m256 a_b = mat2_adj_mul_x2(a, b);
+
+    __m256 x = _mm256_sub_ps(_mm256_mul_ps(det_d, a), mat2_mul_x2(b, d_c));
+    __m256 w = _mm256_sub_ps(_mm256_mul_ps(det_a, d), mat2_mul_x2(c, a_b));
+    __m256 y = _mm256_sub_ps(_mm256_mul_ps(det_b, c), mat2_mul_adj_x2(d, a_b));
+    __m256 z = _mm256_sub_ps(_mm256_mul_ps(det_c, b), mat2_mul_adj_x2(a, d_c));
+
+    __m256 tr = _mm256_mul_ps(a_b, SWIZ8(d_c, 0, 2, 1, 3));
+    tr = _mm256_add_ps(tr, SWIZ8(tr, 1, 0, 3, 2));
+    tr = _mm256_add_ps(tr, SWIZ8(tr, 2, 3, 0, 1));
+    __m256 det_m = _mm256_add_ps(_mm256_mul_ps(det_a, det_d),
+                                 _mm256_mul_ps(det_b, det_c));
+    det_m = _mm256_sub_ps(det_m, tr);
+
+    const __m256 sign = _mm256_setr_ps(1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f,
+                                       -1.0f, 1.0f);
+    __m256 r_det = _mm256_div_ps(sign, det_m);
+    x = _mm256_mul_ps(x, r_det);
+    y = _mm256_mul_ps(y, r_det);
+    z = _mm256_mul_ps(z, r_det);
+    w = _mm256_mul_ps(w, r_det);
+
+    // singular lanes fall back to identity, same as the scalar path
+    __m256 abs_det = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), det_m);
+    __m256 singular =
+        _mm256_cmp_ps(abs_det, _mm256_set1_ps(1e-10f), _CMP_LT_OQ);
+
+    __m256 r0 = SHUF8(x, y, 3, 1, 3, 1);
+    __m256 r1 = SHUF8(x, y, 2, 0, 2, 0);
+    __m256 r2 = SHUF8(z, w, 3, 1, 3, 1);
+    __m256 r3 = SHUF8(z, w, 2, 0, 2, 0);
+
+    r0 = _mm256_blendv_ps(r0, _mm256_setr_ps(1, 0, 0, 0, 1, 0, 0, 0),
+                          singular);
+    r1 = _mm256_blendv_ps(r1, _mm256_setr_ps(0, 1, 0, 0, 0, 1, 0, 0),
+                          singular);
+    r2 = _mm256_blendv_ps(r2, _mm256_setr_ps(0, 0, 1, 0, 0, 0, 1, 0),
+                          singular);
+    r3 = _mm256_blendv_ps(r3, _mm256_setr_ps(0, 0, 0, 1, 0, 0, 0, 1),
+                          singular);
+
+    store_col_x2(out, 0, r0);
+    store_col_x2(out, 1, r1);
+    store_col_x2(out, 2, r2);
+    store_col_x2(out, 3, r3);
+}
+
+MATH_TARGET("avx")
+void mat4_inverse_n_avx(mat4 *restrict out, const mat4 *restrict in,
+                        u32 count)
+{
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) mat4_inverse_x2(&out[i], &in[i]);
+    if (i < count) out[i] = mat4_inverse_simd(in[i]);
+}
+
+void mat4_inverse_n_sse2(mat4 *restrict out, const mat4 *restrict in,
+                         u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = mat4_inverse_simd(in[i]);
+}
+#endif // MATH_DISPATCH
+
+void mat4_inverse_n_scalar(mat4 *restrict out, const mat4 *restrict in,
+                           u32 count)
+{
+    for (u32 i = 0; i < count; i++) out[i] = mat4_inverse_scalar(in[i]);
+}
+
+mat4 mat4_inverse(mat4 m)
+{
+#if MATH_SSE
+    return mat4_inverse_simd(m);
+#else
+    return mat4_inverse_scalar(m);
+#endif
+}
+
+void mat4_inverse_n(mat4 *restrict out, const mat4 *restrict in, u32 count)
+{
+    g_math_kernels.mat4_inverse_n(out, in, count);
+}
+
 mat4 mat4_look_at(vec3 eye, vec3 target, vec3 up)
 {
     vec3 z = vec3_normalize(vec3_sub(target, eye));
@@ -233,6 +475,32 @@ mat4 mat4_orthographic(f32 left, f32 right, f32 bottom, f32 top, f32 near,
                        -2.0f * fn, -(far + near) * fn, 0.0f, 0.0f, 0.0f, 1.0f);
 }
 
+frustum frustum_from_mat4(mat4 m)
+{
+    // rows of the column-major matrix
+    vec4 r0 = vec4_create(m.m00, m.m01, m.m02, m.m03);
+    vec4 r1 = vec4_create(m.m10, m.m11, m.m12, m.m13);
+    vec4 r2 = vec4_create(m.m20, m.m21, m.m22, m.m23);
+    vec4 r3 = vec4_create(m.m30, m.m31, m.m32, m.m33);
+
+    frustum f;
+    f.planes[FRUSTUM_LEFT] = vec4_add(r3, r0);
+    f.planes[FRUSTUM_RIGHT] = vec4_sub(r3, r0);
+    f.planes[FRUSTUM_BOTTOM] = vec4_add(r3, r1);
+    f.planes[FRUSTUM_TOP] = vec4_sub(r3, r1);
+    f.planes[FRUSTUM_NEAR] = vec4_add(r3, r2);
+    f.planes[FRUSTUM_FAR] = vec4_sub(r3, r2);
+
+    // unit normals so distances (and sphere radii) are in world units
+    for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+    {
+        vec4 p = f.planes[i];
+        f32 len = m_sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (len > M_EPSILON) f.planes[i] = vec4_scale(p, 1.0f / len);
+    }
+    return f;
+}
+
 quat quat_slerp(quat a, quat b, f32 t)
 {
     // Calculate cosine of angle between quaternions
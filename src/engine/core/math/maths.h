@@ -19,6 +19,31 @@
 #define M_DEG2RAD (M_PI / 180.0f)
 #define M_RAD2DEG (180.0f / M_PI)
 
+#if MATH_SSE
+// Lane helpers for the vec/quat SSE paths. vec3 keeps its w lane at zero,
+// the 3 wide sum ignores it anyway.
+#    define M_SIMD_SIGN_MASK _mm_set1_ps(-0.0f)
+
+INL f32 m_simd_hsum3(__m128 v)
+{
+    __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+    return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(v, y), z));
+}
+
+INL f32 m_simd_hsum4(__m128 v)
+{
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(s);
+}
+
+INL __m128 m_simd_mask_xyz(__m128 v)
+{
+    return _mm_and_ps(v, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+}
+#endif
+
 INL b8 mat4_has_nan(const mat4 *m)
 {
     for (u32 i = 0; i < 16; i++)
@@ -149,11 +174,15 @@ f32 vec3_length(vec3 v);
 // Constructor
 INL vec3 vec3_create(f32 x, f32 y, f32 z)
 {
+#if MATH_SSE
+    return (vec3){.simd = _mm_setr_ps(x, y, z, 0.0f)};
+#else
     vec3 result;
     result.x = x;
     result.y = y;
     result.z = z;
     return result;
+#endif
 }
 
 INL vec3 vec3_zero(void) { return vec3_create(0.0f, 0.0f, 0.0f); }
@@ -168,47 +197,92 @@ INL vec3 vec3_back(void) { return vec3_create(0.0f, 0.0f, 1.0f); }
 // Arithmetic
 INL vec3 vec3_add(vec3 v1, vec3 v2)
 {
+#if MATH_SSE
+    return (vec3){.simd = _mm_add_ps(v1.simd, v2.simd)};
+#else
     return vec3_create(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);
+#endif
 }
 
 INL vec3 vec3_sub(vec3 v1, vec3 v2)
 {
+#if MATH_SSE
+    return (vec3){.simd = _mm_sub_ps(v1.simd, v2.simd)};
+#else
     return vec3_create(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z);
+#endif
 }
 
 INL vec3 vec3_mul(vec3 v1, vec3 v2)
 {
+#if MATH_SSE
+    return (vec3){.simd = _mm_mul_ps(v1.simd, v2.simd)};
+#else
     return vec3_create(v1.x * v2.x, v1.y * v2.y, v1.z * v2.z);
+#endif
 }
 
 INL vec3 vec3_div(vec3 v1, vec3 v2)
 {
+#if MATH_SSE
+    // 0/0 in the padding lane, mask it back to zero
+    return (vec3){.simd = m_simd_mask_xyz(_mm_div_ps(v1.simd, v2.simd))};
+#else
     return vec3_create(v1.x / v2.x, v1.y / v2.y, v1.z / v2.z);
+#endif
 }
 
 // Scalar
 INL vec3 vec3_scale(vec3 v, f32 s)
 {
+#if MATH_SSE
+    return (vec3){.simd = _mm_mul_ps(v.simd, _mm_set1_ps(s))};
+#else
     return (vec3){.x = v.x * s, .y = v.y * s, .z = v.z * s};
+#endif
 }
 
 INL vec3 vec3_scale_div(vec3 v, f32 s)
 {
+#if MATH_SSE
+    return (vec3){.simd = _mm_div_ps(v.simd, _mm_set1_ps(s))};
+#else
     return (vec3){{v.x / s, v.y / s, v.z / s}};
+#endif
 }
 
 // Operations
-INL f32 vec3_length_sq(vec3 v) { return v.x * v.x + v.y * v.y + v.z * v.z; }
+INL f32 vec3_length_sq(vec3 v)
+{
+#if MATH_SSE
+    return m_simd_hsum3(_mm_mul_ps(v.simd, v.simd));
+#else
+    return v.x * v.x + v.y * v.y + v.z * v.z;
+#endif
+}
 
 INL f32 vec3_dot(vec3 v1, vec3 v2)
 {
+#if MATH_SSE
+    return m_simd_hsum3(_mm_mul_ps(v1.simd, v2.simd));
+#else
     return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+#endif
 }
 
 INL vec3 vec3_cross(vec3 v1, vec3 v2)
 {
+#if MATH_SSE
+    // (a * b.yzx - a.yzx * b).yzx, the w lane stays 0
+    __m128 a_yzx = _mm_shuffle_ps(v1.simd, v1.simd, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(v2.simd, v2.simd, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(v1.simd, b_yzx),
+                          _mm_mul_ps(a_yzx, v2.simd));
+    return (vec3){.simd = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1))};
+#else
     return vec3_create(v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z,
                        v1.x * v2.y - v1.y * v2.x);
+#endif
 }
 
 // Normalization
@@ -248,14 +322,25 @@ INL f32 vec3_distance_sq(vec3 v1, vec3 v2)
 
 INL vec3 vec3_lerp(vec3 v1, vec3 v2, f32 t)
 {
+#if MATH_SSE
+    __m128 d = _mm_sub_ps(v2.simd, v1.simd);
+    return (vec3){.simd = _mm_add_ps(v1.simd, _mm_mul_ps(d, _mm_set1_ps(t)))};
+#else
     return vec3_create(LERP(v1.x, v2.x, t), LERP(v1.y, v2.y, t),
                        LERP(v1.z, v2.z, t));
+#endif
 }
 
 INL b8 vec3_compare(vec3 a, vec3 b, f32 tolerance)
 {
+#if MATH_SSE
+    __m128 d = _mm_andnot_ps(M_SIMD_SIGN_MASK, _mm_sub_ps(a.simd, b.simd));
+    __m128 le = _mm_cmple_ps(d, _mm_set1_ps(tolerance));
+    return (_mm_movemask_ps(le) & 0x7) == 0x7;
+#else
     return (m_abs(a.x - b.x) <= tolerance) &&
            (m_abs(a.y - b.y) <= tolerance) && (m_abs(a.z - b.z) <= tolerance);
+#endif
 }
 
 INL b8 vec3_is_zero(vec3 v) { return vec3_compare(v, vec3_zero(), M_EPSILON); }
@@ -275,12 +360,16 @@ f32 vec4_length(vec4 v);
 // Constructor
 INL vec4 vec4_create(f32 x, f32 y, f32 z, f32 w)
 {
+#if MATH_SSE
+    return (vec4){.simd = _mm_setr_ps(x, y, z, w)};
+#else
     vec4 result;
     result.x = x;
     result.y = y;
     result.z = z;
     result.w = w;
     return result;
+#endif
 }
 
 INL vec4 vec4_unit_zero(void) { return vec4_create(0.0f, 0.0f, 0.0f, 0.0f); }
@@ -293,44 +382,76 @@ INL vec4 vec4_unit_w(void) { return vec4_create(0.0f, 0.0f, 0.0f, 1.0f); }
 // Arithmetic
 INL vec4 vec4_add(vec4 v1, vec4 v2)
 {
+#if MATH_SSE
+    return (vec4){.simd = _mm_add_ps(v1.simd, v2.simd)};
+#else
     return vec4_create(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w);
+#endif
 }
 
 INL vec4 vec4_sub(vec4 v1, vec4 v2)
 {
+#if MATH_SSE
+    return (vec4){.simd = _mm_sub_ps(v1.simd, v2.simd)};
+#else
     return vec4_create(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w - v2.w);
+#endif
 }
 
 INL vec4 vec4_mul(vec4 v1, vec4 v2)
 {
+#if MATH_SSE
+    return (vec4){.simd = _mm_mul_ps(v1.simd, v2.simd)};
+#else
     return vec4_create(v1.x * v2.x, v1.y * v2.y, v1.z * v2.z, v1.w * v2.w);
+#endif
 }
 
 INL vec4 vec4_div(vec4 v1, vec4 v2)
 {
+#if MATH_SSE
+    return (vec4){.simd = _mm_div_ps(v1.simd, v2.simd)};
+#else
     return vec4_create(v1.x / v2.x, v1.y / v2.y, v1.z / v2.z, v1.w / v2.w);
+#endif
 }
 
 // Scalar
 INL vec4 vec4_scale(vec4 v, f32 s)
 {
+#if MATH_SSE
+    return (vec4){.simd = _mm_mul_ps(v.simd, _mm_set1_ps(s))};
+#else
     return (vec4){.x = v.x * s, .y = v.y * s, .z = v.z * s, .w = v.w * s};
+#endif
 }
 
 INL vec4 vec4_scale_div(vec4 v, f32 s)
 {
+#if MATH_SSE
+    return (vec4){.simd = _mm_div_ps(v.simd, _mm_set1_ps(s))};
+#else
     return (vec4){{v.x / s, v.y / s, v.z / s, v.w / s}};
+#endif
 }
 
 // Operations
 INL f32 vec4_length_sq(vec4 v)
 {
+#if MATH_SSE
+    return m_simd_hsum4(_mm_mul_ps(v.simd, v.simd));
+#else
     return v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w;
+#endif
 }
 
 INL f32 vec4_dot(vec4 v1, vec4 v2)
 {
+#if MATH_SSE
+    return m_simd_hsum4(_mm_mul_ps(v1.simd, v2.simd));
+#else
     return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+#endif
 }
 
 // Normalization
@@ -368,15 +489,25 @@ INL f32 vec4_distance_sq(vec4 a, vec4 b)
 
 INL vec4 vec4_lerp(vec4 a, vec4 b, f32 t)
 {
+#if MATH_SSE
+    __m128 d = _mm_sub_ps(b.simd, a.simd);
+    return (vec4){.simd = _mm_add_ps(a.simd, _mm_mul_ps(d, _mm_set1_ps(t)))};
+#else
     return vec4_create(LERP(a.x, b.x, t), LERP(a.y, b.y, t), LERP(a.z, b.z, t),
                        LERP(a.w, b.w, t));
+#endif
 }
 
 INL b8 vec4_compare(vec4 a, vec4 b, f32 tolerance)
 {
+#if MATH_SSE
+    __m128 d = _mm_andnot_ps(M_SIMD_SIGN_MASK, _mm_sub_ps(a.simd, b.simd));
+    return _mm_movemask_ps(_mm_cmple_ps(d, _mm_set1_ps(tolerance))) == 0xF;
+#else
     return (m_abs(a.x - b.x) <= tolerance) &&
            (m_abs(a.y - b.y) <= tolerance) &&
            (m_abs(a.z - b.z) <= tolerance) && (m_abs(a.w - b.w) <= tolerance);
+#endif
 }
 
 INL b8 vec4_is_zero(vec4 v)
@@ -389,9 +520,15 @@ INL b8 vec4_is_zero(vec4 v)
  *************************/
 // Declaration (implement in maths.c)
 
-// BUG: Please dont use this, still have a bug!!
-// use mat4_inverse_rigid instead.
+// General inverse. Uses the SSE block inverse when available, otherwise
+// the scalar cofactor expansion. Singular matrices return identity.
+// For camera/rigid transforms mat4_inverse_rigid is still cheaper.
 mat4 mat4_inverse(mat4 m);
+mat4 mat4_inverse_scalar(mat4 m);
+
+// Batch inverse, out[i] = mat4_inverse(in[i]). Runtime dispatched, the AVX
+// variant inverts two matrices per iteration. out and in must not overlap.
+void mat4_inverse_n(mat4 *restrict out, const mat4 *restrict in, u32 count);
 
 mat4 mat4_look_at(vec3 eye, vec3 target, vec3 up);
 mat4 mat4_perspective(f32 fov, f32 aspect, f32 near, f32 far);
@@ -521,12 +658,21 @@ INL vec4 mat4_mul_vec4(mat4 m, vec4 v) {
 */
 
 INL vec4 mat4_mul_vec4(mat4 m, vec4 v) {
+#if MATH_SSE
+    // sum of columns scaled by the matching component
+    __m128 r = _mm_mul_ps(m.columns[0].simd, _mm_set1_ps(v.x));
+    r = _mm_add_ps(r, _mm_mul_ps(m.columns[1].simd, _mm_set1_ps(v.y)));
+    r = _mm_add_ps(r, _mm_mul_ps(m.columns[2].simd, _mm_set1_ps(v.z)));
+    r = _mm_add_ps(r, _mm_mul_ps(m.columns[3].simd, _mm_set1_ps(v.w)));
+    return (vec4){.simd = r};
+#else
     return (vec4){{
         m.m00 * v.x + m.m01 * v.y + m.m02 * v.z + m.m03 * v.w,  // Col 0 dot
         m.m10 * v.x + m.m11 * v.y + m.m12 * v.z + m.m13 * v.w,  // Col 1 dot
         m.m20 * v.x + m.m21 * v.y + m.m22 * v.z + m.m23 * v.w,  // Col 2 dot
         m.m30 * v.x + m.m31 * v.y + m.m32 * v.z + m.m33 * v.w   // Col 3 dot
     }};
+#endif
 }
 
 INL vec3 mat4_mul_vec3(mat4 m, vec3 v)
@@ -742,7 +888,11 @@ quat quat_look_rotation(vec3 direction, vec3 up);
 
 // Constructor
 INL quat quat_create(f32 x, f32 y, f32 z, f32 w) { 
+#if MATH_SSE
+    return (quat){.simd = _mm_setr_ps(x, y, z, w)};
+#else
     return (quat){.x = x, .y = y, .z = z, .w = w}; 
+#endif
 }
 
 INL quat quat_identity(void) { 
@@ -755,35 +905,72 @@ INL quat quat_zero(void) {
 
 // Basic operations
 INL quat quat_add(quat a, quat b) {
+#if MATH_SSE
+    return (quat){.simd = _mm_add_ps(a.simd, b.simd)};
+#else
     return quat_create(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+#endif
 }
 
 INL quat quat_sub(quat a, quat b) {
+#if MATH_SSE
+    return (quat){.simd = _mm_sub_ps(a.simd, b.simd)};
+#else
     return quat_create(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+#endif
 }
 
 INL quat quat_scale(quat q, f32 scalar) {
+#if MATH_SSE
+    return (quat){.simd = _mm_mul_ps(q.simd, _mm_set1_ps(scalar))};
+#else
     return quat_create(q.x * scalar, q.y * scalar, q.z * scalar, q.w * scalar);
+#endif
 }
 
 // Multiplication (Hamilton product)
 INL quat quat_mul(quat a, quat b) {
+#if MATH_SSE
+    // a.w * b plus each of a.xyz times a signed swizzle of b
+    __m128 bv = b.simd;
+    __m128 r = _mm_mul_ps(_mm_set1_ps(a.w), bv);
+    __m128 t = _mm_shuffle_ps(bv, bv, _MM_SHUFFLE(0, 1, 2, 3)); // wzyx
+    t = _mm_xor_ps(t, _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.x), t));
+    t = _mm_shuffle_ps(bv, bv, _MM_SHUFFLE(1, 0, 3, 2)); // zwxy
+    t = _mm_xor_ps(t, _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.y), t));
+    t = _mm_shuffle_ps(bv, bv, _MM_SHUFFLE(2, 3, 0, 1)); // yxwz
+    t = _mm_xor_ps(t, _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.z), t));
+    return (quat){.simd = r};
+#else
     return quat_create(
         a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
         a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
         a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
         a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
     );
+#endif
 }
 
 // Conjugate (inverse for unit quaternions)
 INL quat quat_conjugate(quat q) {
+#if MATH_SSE
+    return (quat){.simd = _mm_xor_ps(q.simd,
+                                     _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f))};
+#else
     return quat_create(-q.x, -q.y, -q.z, q.w);
+#endif
 }
 
 // Dot product
 INL f32 quat_dot(quat a, quat b) {
+#if MATH_SSE
+    return m_simd_hsum4(_mm_mul_ps(a.simd, b.simd));
+#else
     return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+#endif
 }
 
 // Length operations
@@ -859,15 +1046,70 @@ INL vec3 quat_mul_vec3(quat q, vec3 v) {
 
 // Interpolation
 INL quat quat_lerp(quat a, quat b, f32 t) {
+#if MATH_SSE
+    __m128 d = _mm_sub_ps(b.simd, a.simd);
+    return quat_normalize(
+        (quat){.simd = _mm_add_ps(a.simd, _mm_mul_ps(d, _mm_set1_ps(t)))});
+#else
     return quat_normalize(quat_create(
         LERP(a.x, b.x, t),
         LERP(a.y, b.y, t),
         LERP(a.z, b.z, t),
         LERP(a.w, b.w, t)
     ));
+#endif
+}
+
+/*************************
+ * FRUSTUM
+ *************************/
+typedef enum {
+    FRUSTUM_LEFT = 0,
+    FRUSTUM_RIGHT,
+    FRUSTUM_BOTTOM,
+    FRUSTUM_TOP,
+    FRUSTUM_NEAR,
+    FRUSTUM_FAR,
+    FRUSTUM_PLANE_COUNT
+} frustum_plane_t;
+
+// Declaration (implement in maths.c)
+// Gribb/Hartmann extraction from clip = view_proj * p, GL depth [-1, 1].
+// With this library's mat4_mul order that is mat4_mul(view, proj).
+frustum frustum_from_mat4(mat4 view_proj);
+
+INL f32 plane_distance(vec4 plane, vec3 p)
+{
+    return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+}
+
+INL b8 frustum_sphere_visible(const frustum *f, vec3 center, f32 radius)
+{
+    for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+    {
+        if (plane_distance(f->planes[i], center) < -radius) return false;
+    }
+    return true;
+}
+
+// Conservative, tests the corner furthest along each plane normal
+INL b8 frustum_aabb_visible(const frustum *f, aabb box)
+{
+    for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+    {
+        vec4 pl = f->planes[i];
+        vec3 p = vec3_create(pl.x >= 0.0f ? box.max.x : box.min.x,
+                             pl.y >= 0.0f ? box.max.y : box.min.y,
+                             pl.z >= 0.0f ? box.max.z : box.min.z);
+        if (plane_distance(pl, p) < 0.0f) return false;
+    }
+    return true;
 }
 
 #if MATH_SSE
+// Declaration (implement in maths.c)
+mat4 mat4_inverse_simd(mat4 m);
+
 INL mat4 mat4_mul_simd(mat4 a, mat4 b) {
     mat4 result;
     
@@ -1,4 +1,5 @@
 #include "memory.h"
+#include "engine/platform/thread.h"
 
 // std
 #include <stdio.h>
@@ -27,6 +28,8 @@ static mem_state *g_mem;
 static u64 g_mem_count = 0;
 static u64 g_mem_capacity = 0;
 static u64 g_mem_reserved = 0;
+// ALLOC/FREE are called from worker threads too, guards the tracking
+static mutex_t g_mem_lock;
 
 static const char *tag_str[MEM_MAX_TAG] = {
     "MEM_UNKNOWN", "MEM_GAME",  "MEM_ARENA",    "MEM_RENDER",
@@ -60,6 +63,7 @@ b8 memory_sys_init(u64 total_size)
     g_mem_count = 0;
     g_counter = (struct status){0};
     g_mem_reserved = total_size;
+    mutex_init(&g_mem_lock);
 
     LOG_INFO("Memory System Init");
     return true;
@@ -73,6 +77,7 @@ void memory_sys_kill(void)
     free(g_mem);
     g_mem = 0;
     g_mem_count = 0;
+    mutex_destroy(&g_mem_lock);
     LOG_INFO("Memory System Kill");
 }
 
@@ -82,6 +87,7 @@ void *alloc_dbg(u64 size, memtag_t tag, const char *file, u32 line)
     if (!block) return 0;
 
     memset(block, 0, size);
+    mutex_lock(&g_mem_lock);
     if (g_mem_count < g_mem_capacity)
     {
         g_mem[g_mem_count++] = (mem_state){
@@ -96,6 +102,7 @@ void *alloc_dbg(u64 size, memtag_t tag, const char *file, u32 line)
     g_counter.total_allocated += size;
     g_counter.tag_alloc_count[tag]++;
     g_counter.tag_allocation[tag] += size;
+    mutex_unlock(&g_mem_lock);
 
     return block;
 }
@@ -104,6 +111,7 @@ void alloc_free(void *block, u64 size, memtag_t tag)
 {
     if (!block) return;
 
+    mutex_lock(&g_mem_lock);
     b8 found = false;
     for (u64 i = 0; i < g_mem_count; ++i)
     {
@@ -115,11 +123,12 @@ void alloc_free(void *block, u64 size, memtag_t tag)
         }
     }
 
-    if (!found) LOG_WARN("attempted to free unknown ptr %p", block);
-    free(block);
-
     g_counter.tag_alloc_count[tag]--;
     g_counter.tag_allocation[tag] -= size;
+    mutex_unlock(&g_mem_lock);
+
+    if (!found) LOG_WARN("attempted to free unknown ptr %p", block);
+    free(block);
 }
 
 char *mem_debug_stat(void)
@@ -0,0 +1,170 @@
+#include "offset_alloc.h"
+#include "memory.h"
+
+// std
+#include <string.h>
+
+static b8 reserve_ranges(offset_alloc_t *oa, u32 count)
+{
+    if (count <= oa->free_capacity) return true;
+
+    u32 capacity = MAX(oa->free_capacity * 2, 16u);
+    while (capacity < count) capacity *= 2;
+
+    offset_range_t *ranges =
+        ALLOC(sizeof(offset_range_t) * capacity, MEM_DYNARRAY);
+    if (!ranges) return false;
+
+    if (oa->free)
+    {
+        memcpy(ranges, oa->free, sizeof(offset_range_t) * oa->free_count);
+        FREE(oa->free, sizeof(offset_range_t) * oa->free_capacity,
+             MEM_DYNARRAY);
+    }
+    oa->free = ranges;
+    oa->free_capacity = capacity;
+    return true;
+}
+
+static void insert_range(offset_alloc_t *oa, u32 at, offset_range_t r)
+{
+    memmove(&oa->free[at + 1], &oa->free[at],
+            sizeof(offset_range_t) * (oa->free_count - at));
+    oa->free[at] = r;
+    oa->free_count++;
+}
+
+static void remove_range(offset_alloc_t *oa, u32 at)
+{
+    memmove(&oa->free[at], &oa->free[at + 1],
+            sizeof(offset_range_t) * (oa->free_count - at - 1));
+    oa->free_count--;
+}
+
+b8 offset_alloc_create(offset_alloc_t *oa, u32 size)
+{
+    memset(oa, 0, sizeof(offset_alloc_t));
+    if (!reserve_ranges(oa, 16)) return false;
+
+    oa->size = size;
+    if (size) oa->free[oa->free_count++] = (offset_range_t){0, size};
+    return true;
+}
+
+void offset_alloc_destroy(offset_alloc_t *oa)
+{
+    if (oa->free)
+    {
+        FREE(oa->free, sizeof(offset_range_t) * oa->free_capacity,
+             MEM_DYNARRAY);
+    }
+    memset(oa, 0, sizeof(offset_alloc_t));
+}
+
+u32 offset_alloc(offset_alloc_t *oa, u32 size)
+{
+    if (size == 0) return INVALID_32;
+
+    u32 best = INVALID_32;
+    for (u32 i = 0; i < oa->free_count; i++)
+    {
+        u32 s = oa->free[i].size;
+        if (s < size) continue;
+        if (best == INVALID_32 || s < oa->free[best].size) best = i;
+        if (s == size) break;
+    }
+    if (best == INVALID_32) return INVALID_32;
+
+    offset_range_t *r = &oa->free[best];
+    u32 offset = r->offset;
+    r->offset += size;
+    r->size -= size;
+    if (r->size == 0) remove_range(oa, best);
+
+    oa->used += size;
+    return offset;
+}
+
+void offset_free(offset_alloc_t *oa, u32 offset, u32 size)
+{
+    if (size == 0 || offset == INVALID_32) return;
+
+    // first free range past the freed one
+    u32 at = 0;
+    while (at < oa->free_count && oa->free[at].offset < offset) at++;
+
+    ASSERT(at == oa->free_count || offset + size <= oa->free[at].offset,
+           "offset_free: range overlaps a free range");
+    ASSERT(at == 0 ||
+               oa->free[at - 1].offset + oa->free[at - 1].size <= offset,
+           "offset_free: range overlaps a free range");
+
+    b8 merge_prev =
+        at > 0 && oa->free[at - 1].offset + oa->free[at - 1].size == offset;
+    b8 merge_next =
+        at < oa->free_count && offset + size == oa->free[at].offset;
+
+    if (merge_prev && merge_next)
+    {
+        oa->free[at - 1].size += size + oa->free[at].size;
+        remove_range(oa, at);
+    }
+    else if (merge_prev)
+    {
+        oa->free[at - 1].size += size;
+    }
+    else if (merge_next)
+    {
+        oa->free[at].offset = offset;
+        oa->free[at].size += size;
+    }
+    else
+    {
+        if (!reserve_ranges(oa, oa->free_count + 1))
+        {
+            LOG_ERROR("offset_alloc: lost %u units at %u", size, offset);
+            return;
+        }
+        insert_range(oa, at, (offset_range_t){offset, size});
+    }
+
+    oa->used -= size;
+}
+
+b8 offset_alloc_grow(offset_alloc_t *oa, u32 new_size)
+{
+    if (new_size <= oa->size) return true;
+
+    u32 old_size = oa->size;
+    u32 extra = new_size - old_size;
+
+    if (!reserve_ranges(oa, oa->free_count + 1)) return false;
+
+    // offset_free expects the range to have been handed out
+    oa->size = new_size;
+    oa->used += extra;
+    offset_free(oa, old_size, extra);
+    return true;
+}
+
+u32 offset_alloc_grow_size(const offset_alloc_t *oa, u32 count)
+{
+    u32 tail = 0;
+    if (oa->free_count)
+    {
+        const offset_range_t *last = &oa->free[oa->free_count - 1];
+        if (last->offset + last->size == oa->size) tail = last->size;
+    }
+
+    u32 size = MAX(oa->size, 1u);
+    while (size - oa->size + tail < count) size *= 2;
+    return MAX(size, oa->size * 2);
+}
+
+u32 offset_alloc_largest_free(const offset_alloc_t *oa)
+{
+    u32 largest = 0;
+    for (u32 i = 0; i < oa->free_count; i++)
+        largest = MAX(largest, oa->free[i].size);
+    return largest;
+}
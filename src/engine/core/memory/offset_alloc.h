@@ -0,0 +1,45 @@
+#ifndef OFFSET_ALLOC_H
+#define OFFSET_ALLOC_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * Hands out [offset, offset + size) ranges of an external resource, like a
+ * GPU buffer, in whatever unit the caller uses. Free ranges are kept sorted
+ * by offset so a freed range merges with its neighbours right away.
+ */
+
+typedef struct {
+    u32 offset;
+    u32 size;
+} offset_range_t;
+
+typedef struct {
+    offset_range_t *free;
+    u32 free_count;
+    u32 free_capacity;
+
+    u32 size;
+    u32 used;
+} offset_alloc_t;
+
+b8 offset_alloc_create(offset_alloc_t *oa, u32 size);
+
+void offset_alloc_destroy(offset_alloc_t *oa);
+
+// Best fit, returns INVALID_32 when no free range is large enough
+u32 offset_alloc(offset_alloc_t *oa, u32 size);
+
+void offset_free(offset_alloc_t *oa, u32 offset, u32 size);
+
+// Extends the managed space to new_size, the new tail becomes free
+b8 offset_alloc_grow(offset_alloc_t *oa, u32 new_size);
+
+// Smallest doubling of the size, at least twice it, after which one free
+// range holds count: the new space plus a free range it merges with at the
+// old end. Free ranges elsewhere don't count, they stay apart.
+u32 offset_alloc_grow_size(const offset_alloc_t *oa, u32 count);
+
+u32 offset_alloc_largest_free(const offset_alloc_t *oa);
+
+#endif // OFFSET_ALLOC_H
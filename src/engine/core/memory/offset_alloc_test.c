@@ -0,0 +1,63 @@
+#include "offset_alloc_test.h"
+#include "engine/core/test.h"
+#include "engine/core/memory/offset_alloc.h"
+
+b8 test_offset_alloc(void)
+{
+    b8 all_passed = true;
+    offset_alloc_t oa;
+    if (!offset_alloc_create(&oa, 100)) return false;
+
+    // [0,40) [40,70) [70,90) [90,100), then free the first and third so
+    // the free ranges are [0,40) and [70,90)
+    u32 a = offset_alloc(&oa, 40);
+    u32 b = offset_alloc(&oa, 30);
+    u32 c = offset_alloc(&oa, 20);
+    u32 d = offset_alloc(&oa, 10);
+    all_passed &= expect_u64(d, 90, "offset_alloc in order");
+    all_passed &= expect_u64(offset_alloc(&oa, 1), INVALID_32,
+                             "offset_alloc full");
+    offset_free(&oa, a, 40);
+    offset_free(&oa, c, 20);
+    all_passed &= expect_u64(oa.free_count, 2, "offset_free apart");
+    all_passed &= expect_u64(offset_alloc_largest_free(&oa), 40,
+                             "offset_alloc_largest_free");
+
+    // best fit takes the 20 range, not the first one
+    u32 e = offset_alloc(&oa, 15);
+    all_passed &= expect_u64(e, 70, "offset_alloc best fit");
+    offset_free(&oa, e, 15);
+
+    // 60 units are free in total but the old end is used, so the grow must
+    // hold all 150 in the new space alone
+    u32 size = offset_alloc_grow_size(&oa, 150);
+    all_passed &= expect_u64(size, 400, "grow size, used end");
+    all_passed &= offset_alloc_grow(&oa, size);
+    u32 f = offset_alloc(&oa, 150);
+    all_passed &= expect_u64(f, 100, "offset_alloc after grow");
+
+    // a free range at the old end merges with the new space
+    offset_free(&oa, f, 150);
+    offset_free(&oa, d, 10);
+    all_passed &= expect_u64(offset_alloc_grow_size(&oa, 400), 800,
+                             "grow size, free end");
+    all_passed &= expect_u64(offset_alloc_largest_free(&oa), 330,
+                             "offset_free merges");
+
+    // everything back merges into a single range
+    offset_free(&oa, b, 30);
+    all_passed &= expect_u64(oa.free_count, 1, "offset_free merges all");
+    all_passed &= expect_u64(oa.used, 0, "offset_alloc used");
+
+    offset_alloc_destroy(&oa);
+    return all_passed;
+}
+
+b8 offset_alloc_run_tests(void)
+{
+    printf("\n=== RUN OFFSET ALLOC TEST ===\n");
+
+    b8 all_passed = true;
+    RUN_TEST(test_offset_alloc);
+    return all_passed;
+}
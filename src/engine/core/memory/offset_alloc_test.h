@@ -0,0 +1,10 @@
+#ifndef OFFSET_ALLOC_TEST_H
+#define OFFSET_ALLOC_TEST_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+b8 offset_alloc_run_tests(void);
+
+b8 test_offset_alloc(void);
+
+#endif // OFFSET_ALLOC_TEST_H
@@ -0,0 +1,48 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include "define.h" // IWYU pragma: keep
+
+#include <stdio.h>
+
+/*
+ * CPU tests, built and run by `make test`. Each module with tests has a
+ * xxx_test.c next to it with one xxx_run_tests entry that test_entry.c
+ * calls. Tests run without a window or a GL context, memory_sys_init and
+ * math_dispatch_init are done for them.
+ */
+
+// Runs a b8 (void) test and folds it into the caller's all_passed
+#define RUN_TEST(test_func)                                                   \
+    do                                                                        \
+    {                                                                         \
+        if (!test_func())                                                     \
+        {                                                                     \
+            printf("->FAIL: %s\n", #test_func);                               \
+            all_passed = false;                                               \
+        }                                                                     \
+        else                                                                  \
+        {                                                                     \
+            printf("->PASS: %s\n", #test_func);                               \
+        }                                                                     \
+    }                                                                         \
+    while (0)
+
+INL b8 expect_u64(u64 actual, u64 expected, const char *test_name)
+{
+    b8 passed = actual == expected;
+    if (!passed)
+    {
+        printf("  %s: expected %llu, got %llu\n", test_name,
+               (unsigned long long)expected, (unsigned long long)actual);
+    }
+    return passed;
+}
+
+INL b8 expect_true(b8 condition, const char *test_name)
+{
+    if (!condition) printf("  %s: failed\n", test_name);
+    return condition;
+}
+
+#endif // TEST_H
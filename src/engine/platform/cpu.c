@@ -0,0 +1,106 @@
+#include "cpu.h"
+
+// std
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||           \
+    defined(_M_IX86)
+#    define CPU_X86 1
+#    if defined(_MSC_VER)
+#        include <intrin.h>
+#    else
+#        include <cpuid.h>
+#    endif
+#else
+#    define CPU_X86 0
+#endif
+
+static cpu_info_t g_cpu = {0};
+static b8 g_probed = false;
+
+#if CPU_X86
+static void cpuid(u32 leaf, u32 sub, u32 out[4])
+{
+#    if defined(_MSC_VER)
+    __cpuidex((int *)out, (int)leaf, (int)sub);
+#    else
+    __cpuid_count(leaf, sub, out[0], out[1], out[2], out[3]);
+#    endif
+}
+
+// XCR0, tells which register states the OS saves on context switch
+static u64 xgetbv0(void)
+{
+#    if defined(_MSC_VER)
+    return _xgetbv(0);
+#    else
+    u32 eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((u64)edx << 32) | eax;
+#    endif
+}
+#endif
+
+const cpu_info_t *cpu_probe(void)
+{
+    if (g_probed) return &g_cpu;
+    memset(&g_cpu, 0, sizeof(cpu_info_t));
+
+#if CPU_X86
+    u32 r[4];
+    cpuid(0, 0, r);
+    u32 max_leaf = r[0];
+    memcpy(g_cpu.vendor + 0, &r[1], 4); // ebx
+    memcpy(g_cpu.vendor + 4, &r[3], 4); // edx
+    memcpy(g_cpu.vendor + 8, &r[2], 4); // ecx
+
+    cpuid(0x80000000u, 0, r);
+    if (r[0] >= 0x80000004u)
+    {
+        for (u32 i = 0; i < 3; i++)
+        {
+            cpuid(0x80000002u + i, 0, r);
+            memcpy(g_cpu.brand + i * 16, r, 16);
+        }
+    }
+
+    if (max_leaf >= 1)
+    {
+        cpuid(1, 0, r);
+        u32 ecx = r[2], edx = r[3];
+        if (edx & (1u << 26)) g_cpu.features |= CPU_SSE2;
+        if (ecx & (1u << 0)) g_cpu.features |= CPU_SSE3;
+        if (ecx & (1u << 9)) g_cpu.features |= CPU_SSSE3;
+        if (ecx & (1u << 19)) g_cpu.features |= CPU_SSE41;
+        if (ecx & (1u << 20)) g_cpu.features |= CPU_SSE42;
+
+        // AVX needs both the cpu bit and the OS saving ymm state
+        b8 osxsave = (ecx & (1u << 27)) != 0;
+        u64 xcr0 = osxsave ? xgetbv0() : 0;
+        b8 os_avx = (xcr0 & 0x06) == 0x06;
+        b8 os_avx512 = (xcr0 & 0xE6) == 0xE6;
+
+        if (os_avx && (ecx & (1u << 28))) g_cpu.features |= CPU_AVX;
+        if (os_avx && (ecx & (1u << 12))) g_cpu.features |= CPU_FMA;
+
+        if (max_leaf >= 7)
+        {
+            cpuid(7, 0, r);
+            u32 ebx7 = r[1];
+            if (os_avx && (ebx7 & (1u << 5))) g_cpu.features |= CPU_AVX2;
+            if (os_avx512 && (ebx7 & (1u << 16)))
+                g_cpu.features |= CPU_AVX512F;
+        }
+    }
+#else
+    strncpy(g_cpu.vendor, "unknown", sizeof(g_cpu.vendor) - 1);
+#endif
+
+    g_probed = true;
+    return &g_cpu;
+}
+
+b8 cpu_has(u32 features)
+{
+    return (cpu_probe()->features & features) == features;
+}
@@ -0,0 +1,30 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+typedef enum {
+    CPU_SSE2 = 0x001,
+    CPU_SSE3 = 0x002,
+    CPU_SSSE3 = 0x004,
+    CPU_SSE41 = 0x008,
+    CPU_SSE42 = 0x010,
+    CPU_AVX = 0x020,
+    CPU_AVX2 = 0x040,
+    CPU_FMA = 0x080,
+    CPU_AVX512F = 0x100
+} cpu_feature_t;
+
+typedef struct {
+    u32 features;
+    char vendor[13];
+    char brand[49];
+} cpu_info_t;
+
+// Probe once with cpuid (and xgetbv for OS support of the wide registers).
+// Safe to call again, later calls return the cached result.
+const cpu_info_t *cpu_probe(void);
+
+b8 cpu_has(u32 features);
+
+#endif // CPU_H
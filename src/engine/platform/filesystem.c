@@ -96,6 +96,12 @@ b8 file_exist(const char *path)
     return stat(path, &buffer) == 0;
 }
 
+b8 file_exist_relative(const char *path)
+{
+    path_t full = path_join(g_fs->base_path.buffer, path);
+    return file_exist(full.buffer);
+}
+
 b8 file_open(const char *path, filemode_t mode, file_t *handle)
 {
     handle->is_valid = false;
@@ -185,3 +191,23 @@ b8 file_read_all_binary(file_t *handle, u8 *out_byte, u64 *out_read)
     }
     return false;
 }
+
+b8 file_write_binary(file_t *handle, const void *data, u64 size)
+{
+    if (!handle->handle || !data) return false;
+    return fwrite(data, 1, size, (FILE *)handle->handle) == size;
+}
+
+b8 file_make_dir(const char *path)
+{
+    if (file_exist_relative(path)) return true;
+
+    path_t full = path_join(g_fs->base_path.buffer, path);
+#if PLATFORM_LINUX
+    b8 made = mkdir(full.buffer, 0755) == 0;
+#elif PLATFORM_WINDOWS
+    b8 made = _mkdir(full.buffer) == 0;
+#endif
+    if (!made) LOG_ERROR("failed to create directory '%s'", full.buffer);
+    return made;
+}
@@ -31,6 +31,9 @@ void file_system_kill(file_system_t *fs);
 // utilities
 b8 file_exist(const char *path);
 
+// Like file_exist, relative to the base path as file_open is
+b8 file_exist_relative(const char *path);
+
 b8 file_open(const char *path, filemode_t mode, file_t *handle);
 
 void file_close(file_t *handle);
@@ -41,4 +44,9 @@ b8 file_read_all_text(file_t *handle, char *text, u64 *out_read);
 
 b8 file_read_all_binary(file_t *handle, u8 *out_byte, u64 *out_read);
 
+b8 file_write_binary(file_t *handle, const void *data, u64 size);
+
+// Creates a directory under the base path, true if it exists afterwards
+b8 file_make_dir(const char *path);
+
 #endif // FILESYSTEM_H
@@ -0,0 +1,133 @@
+#include "thread.h"
+#include "engine/core/memory/memory.h"
+
+#if PLATFORM_WINDOWS
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <unistd.h>
+#endif
+
+// fn and arg outlive the caller's stack until the thread picks them up
+typedef struct {
+    thread_fn fn;
+    void *arg;
+} thread_start_t;
+
+#if PLATFORM_WINDOWS
+static DWORD WINAPI thread_entry(LPVOID param)
+#else
+static void *thread_entry(void *param)
+#endif
+{
+    thread_start_t start = *(thread_start_t *)param;
+    FREE(param, sizeof(thread_start_t), MEM_UNKNOWN);
+    start.fn(start.arg);
+    return 0;
+}
+
+b8 thread_create(thread_t *thread, thread_fn fn, void *arg)
+{
+    thread_start_t *start = ALLOC(sizeof(thread_start_t), MEM_UNKNOWN);
+    if (!start) return false;
+    start->fn = fn;
+    start->arg = arg;
+
+#if PLATFORM_WINDOWS
+    thread->handle = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+    b8 ok = thread->handle != NULL;
+#else
+    b8 ok = pthread_create(&thread->handle, NULL, thread_entry, start) == 0;
+#endif
+
+    if (!ok)
+    {
+        LOG_ERROR("Failed to create thread");
+        FREE(start, sizeof(thread_start_t), MEM_UNKNOWN);
+    }
+    return ok;
+}
+
+void thread_join(thread_t *thread)
+{
+#if PLATFORM_WINDOWS
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    thread->handle = NULL;
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+u32 thread_hw_count(void)
+{
+#if PLATFORM_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long count = (long)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (u32)count : 1;
+}
+
+#if PLATFORM_WINDOWS
+void mutex_init(mutex_t *mutex) { InitializeSRWLock((PSRWLOCK)&mutex->lock); }
+
+// SRW locks need no cleanup
+void mutex_destroy(mutex_t *mutex) { (void)mutex; }
+
+void mutex_lock(mutex_t *mutex)
+{
+    AcquireSRWLockExclusive((PSRWLOCK)&mutex->lock);
+}
+
+void mutex_unlock(mutex_t *mutex)
+{
+    ReleaseSRWLockExclusive((PSRWLOCK)&mutex->lock);
+}
+
+void cond_init(cond_t *cond)
+{
+    InitializeConditionVariable((PCONDITION_VARIABLE)&cond->cond);
+}
+
+void cond_destroy(cond_t *cond) { (void)cond; }
+
+void cond_wait(cond_t *cond, mutex_t *mutex)
+{
+    SleepConditionVariableSRW((PCONDITION_VARIABLE)&cond->cond,
+                              (PSRWLOCK)&mutex->lock, INFINITE, 0);
+}
+
+void cond_signal(cond_t *cond)
+{
+    WakeConditionVariable((PCONDITION_VARIABLE)&cond->cond);
+}
+
+void cond_broadcast(cond_t *cond)
+{
+    WakeAllConditionVariable((PCONDITION_VARIABLE)&cond->cond);
+}
+#else
+void mutex_init(mutex_t *mutex) { pthread_mutex_init(&mutex->lock, NULL); }
+
+void mutex_destroy(mutex_t *mutex) { pthread_mutex_destroy(&mutex->lock); }
+
+void mutex_lock(mutex_t *mutex) { pthread_mutex_lock(&mutex->lock); }
+
+void mutex_unlock(mutex_t *mutex) { pthread_mutex_unlock(&mutex->lock); }
+
+void cond_init(cond_t *cond) { pthread_cond_init(&cond->cond, NULL); }
+
+void cond_destroy(cond_t *cond) { pthread_cond_destroy(&cond->cond); }
+
+void cond_wait(cond_t *cond, mutex_t *mutex)
+{
+    pthread_cond_wait(&cond->cond, &mutex->lock);
+}
+
+void cond_signal(cond_t *cond) { pthread_cond_signal(&cond->cond); }
+
+void cond_broadcast(cond_t *cond) { pthread_cond_broadcast(&cond->cond); }
+#endif
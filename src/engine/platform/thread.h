@@ -0,0 +1,68 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * Thin wrappers over pthreads and Win32. Mutexes and condition variables
+ * are plain structs that live wherever the caller puts them, no heap.
+ */
+
+#if PLATFORM_WINDOWS
+typedef struct {
+    void *handle;
+} thread_t;
+
+typedef struct {
+    void *lock; // SRWLOCK
+} mutex_t;
+
+typedef struct {
+    void *cond; // CONDITION_VARIABLE
+} cond_t;
+#else
+#    include <pthread.h>
+
+typedef struct {
+    pthread_t handle;
+} thread_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+} mutex_t;
+
+typedef struct {
+    pthread_cond_t cond;
+} cond_t;
+#endif
+
+typedef void (*thread_fn)(void *arg);
+
+b8 thread_create(thread_t *thread, thread_fn fn, void *arg);
+
+void thread_join(thread_t *thread);
+
+// Logical processors, at least 1
+u32 thread_hw_count(void);
+
+void mutex_init(mutex_t *mutex);
+
+void mutex_destroy(mutex_t *mutex);
+
+void mutex_lock(mutex_t *mutex);
+
+void mutex_unlock(mutex_t *mutex);
+
+void cond_init(cond_t *cond);
+
+void cond_destroy(cond_t *cond);
+
+// mutex must be locked, it is again when this returns. Wakeups can be
+// spurious, wait in a loop on the actual condition.
+void cond_wait(cond_t *cond, mutex_t *mutex);
+
+void cond_signal(cond_t *cond);
+
+void cond_broadcast(cond_t *cond);
+
+#endif // THREAD_H
@@ -1,4 +1,5 @@
 #include "window.h"
+#include "engine/rendering/gl_state.h"
 
 // std
 #include <string.h>
@@ -8,7 +9,7 @@ static window_system_t *g_ws = NULL;
 static void window_clbk(GLFWwindow *window, int width, int height)
 {
     (void)window;
-    glViewport(0, 0, width, height);
+    gl_state_viewport(0, 0, width, height);
     LOG_DEBUG("Window resized to: %d x %d", width, height);
 }
 
@@ -102,4 +103,9 @@ void window_sys_get_size(int *width, int *height)
     glfwGetWindowSize(g_ws->handle, width, height);
 }
 
+void window_sys_get_framebuffer_size(int *width, int *height)
+{
+    glfwGetFramebufferSize(g_ws->handle, width, height);
+}
+
 GLFWwindow *window_sys_get_handle(void) { return g_ws->handle; }
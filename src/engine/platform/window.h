@@ -26,6 +26,9 @@ void window_sys_swapbuffer(window_system_t *ws);
 
 void window_sys_get_size(int *width, int *height);
 
+// In pixels, differs from the window size on high DPI screens
+void window_sys_get_framebuffer_size(int *width, int *height);
+
 GLFWwindow *window_sys_get_handle(void);
 
 #endif // WINDOW_H
@@ -1,5 +1,5 @@
 #include "camera_system.h"
-#include "engine/core/math/maths.h"
+#include "engine/core/math/math_fast.h"
 #include "engine/platform/window.h"
 
 // std
@@ -36,7 +36,7 @@ static void recalculate_matrix(camera_t *cam)
 {
     if (!cam) return;
 
-    mat4 rotation = mat4_rotation_xyz(cam->rotation);
+    mat4 rotation = mat4_rotation_xyz_fast(cam->rotation);
     mat4 translation = mat4_translation(cam->position);
     mat4 view = mat4_mul(translation, rotation);
 
@@ -106,6 +106,10 @@ void camera_update(camera_system_t *cs)
     {
         update_proj_pers(&cs->world, aspect_ratio);
         recalculate_matrix(&cs->world);
+
+        cs->world.view_proj = mat4_mul(cs->world.view, cs->world.proj);
+        cs->world.frustum = frustum_from_mat4(cs->world.view_proj);
+        cs->world.version++;
     }
 }
 
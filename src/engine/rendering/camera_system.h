@@ -13,6 +13,8 @@ typedef enum {
 typedef struct {
     mat4 proj;
     mat4 view;
+    mat4 view_proj;
+    frustum frustum; // world space, refreshed with view_proj
 
     f32 near, far, fov;
     f32 aspect_ratio;
@@ -21,6 +23,7 @@ typedef struct {
 
     camera_projection_type_t proj_type;
 
+    u32 version; // bumped whenever the matrices change
     b8 dirty;
 } camera_t;
 
@@ -0,0 +1,352 @@
+#include "capture_system.h"
+#include "engine/core/memory/memory.h"
+#include "engine/platform/filesystem.h"
+#include "engine/rendering/gl_state.h"
+#include "engine/resource/image_ops.h"
+#include "engine/resource/png_writer.h"
+#include "engine/resource/resc_loader.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <stdio.h>
+#include <string.h>
+
+#define FENCE_TIMEOUT_NS 1000000ull // 1ms per wait, loop until signaled
+
+static capture_system_t *g_cs = NULL;
+
+static const char *const g_extensions[CAPTURE_FORMAT_COUNT] = {".png",
+                                                               ".raw"};
+
+// stb can't load headerless files, only PNG captures compare
+static b8 is_raw(const char *path)
+{
+    const char *ext = g_extensions[CAPTURE_FORMAT_RAW];
+    u64 len = strlen(path), ext_len = strlen(ext);
+    return len >= ext_len && strcmp(path + len - ext_len, ext) == 0;
+}
+
+// Runs on a worker, no GL
+static b8 write_job(capture_job_t *job)
+{
+    u64 row_size = (u64)job->width * 4;
+    b8 ok = false;
+    if (job->format == CAPTURE_FORMAT_PNG)
+    {
+        // backbuffer alpha is whatever blending left there, drop it. In
+        // place, every pixel only moves towards the front.
+        u64 count = (u64)job->width * job->height;
+        for (u64 i = 0; i < count; i++)
+        {
+            job->pixels[i * 3 + 0] = job->pixels[i * 4 + 0];
+            job->pixels[i * 3 + 1] = job->pixels[i * 4 + 1];
+            job->pixels[i * 3 + 2] = job->pixels[i * 4 + 2];
+        }
+        ok = png_write(job->path, job->pixels, job->width, job->height, 3,
+                       true);
+    }
+    else
+    {
+        file_t file;
+        if (file_open(job->path, WRITE_BINARY, &file))
+        {
+            ok = true;
+            for (u32 y = job->height; ok && y > 0; y--)
+            {
+                const u8 *row = job->pixels + (y - 1) * row_size;
+                ok = file_write_binary(&file, row, row_size);
+            }
+            file_close(&file);
+        }
+    }
+
+    if (!ok) LOG_ERROR("capture: failed to write %s", job->path);
+    FREE(job->pixels, row_size * job->height, MEM_RESOURCE);
+    return ok;
+}
+
+static void worker_main(void *arg)
+{
+    capture_system_t *cs = arg;
+    for (;;)
+    {
+        mutex_lock(&cs->lock);
+        while (!cs->quit && cs->job_count == 0)
+            cond_wait(&cs->wake, &cs->lock);
+        // queued jobs still get written on quit
+        if (cs->job_count == 0)
+        {
+            mutex_unlock(&cs->lock);
+            return;
+        }
+
+        capture_job_t job = cs->jobs[cs->job_head];
+        cs->job_head = (cs->job_head + 1) % CAPTURE_MAX_JOBS;
+        cs->job_count--;
+        cs->busy++;
+        mutex_unlock(&cs->lock);
+
+        b8 ok = write_job(&job);
+
+        mutex_lock(&cs->lock);
+        cs->busy--;
+        if (ok) cs->stats.written++;
+        else cs->stats.failed++;
+        cond_broadcast(&cs->done);
+        mutex_unlock(&cs->lock);
+    }
+}
+
+static void queue_job(capture_system_t *cs, capture_job_t *job)
+{
+    if (cs->worker_count == 0)
+    {
+        b8 ok = write_job(job);
+        if (ok) cs->stats.written++;
+        else cs->stats.failed++;
+        return;
+    }
+
+    mutex_lock(&cs->lock);
+    if (cs->job_count == CAPTURE_MAX_JOBS) cs->stats.stalls++;
+    while (cs->job_count == CAPTURE_MAX_JOBS) cond_wait(&cs->done, &cs->lock);
+    u32 tail = (cs->job_head + cs->job_count) % CAPTURE_MAX_JOBS;
+    cs->jobs[tail] = *job;
+    cs->job_count++;
+    cond_signal(&cs->wake);
+    mutex_unlock(&cs->lock);
+}
+
+// Maps the slot once its fence has passed and queues the pixels. false
+// when it is still in flight and wait isn't set.
+static b8 collect(capture_system_t *cs, capture_slot_t *slot, b8 wait)
+{
+    if (!slot->fence) return true;
+
+    GLsync fence = (GLsync)slot->fence;
+    GLenum r = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (wait && r == GL_TIMEOUT_EXPIRED)
+        r = glClientWaitSync(fence, 0, FENCE_TIMEOUT_NS);
+    if (r == GL_TIMEOUT_EXPIRED) return false;
+    glDeleteSync(fence);
+    slot->fence = NULL;
+
+    u64 size = (u64)slot->width * slot->height * 4;
+    u8 *pixels = r == GL_WAIT_FAILED ? NULL : ALLOC(size, MEM_RESOURCE);
+    const void *src = NULL;
+    if (pixels)
+    {
+        gl_state_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+        src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size,
+                               GL_MAP_READ_BIT);
+        if (src)
+        {
+            memcpy(pixels, src, size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        gl_state_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    if (!src)
+    {
+        LOG_ERROR("capture: failed to read back %s", slot->path);
+        if (pixels) FREE(pixels, size, MEM_RESOURCE);
+        mutex_lock(&cs->lock);
+        cs->stats.failed++;
+        mutex_unlock(&cs->lock);
+        return true;
+    }
+
+    capture_job_t job = {.pixels = pixels,
+                         .width = slot->width,
+                         .height = slot->height,
+                         .format = slot->format};
+    memcpy(job.path, slot->path, CAPTURE_PATH_SIZE);
+    queue_job(cs, &job);
+    return true;
+}
+
+capture_system_t *capture_sys_init(arena_alloc_t *arena)
+{
+    capture_system_t *cs = arena_alloc(arena, sizeof(capture_system_t));
+    if (!cs) return NULL;
+    memset(cs, 0, sizeof(capture_system_t));
+    cs->arena = arena;
+
+    for (u32 i = 0; i < CAPTURE_RING; i++)
+        glGenBuffers(1, &cs->slots[i].pbo);
+    if (!file_make_dir(CAPTURE_DIR))
+        LOG_WARN("capture: failed to create %s", CAPTURE_DIR);
+
+    mutex_init(&cs->lock);
+    cond_init(&cs->wake);
+    cond_init(&cs->done);
+    u32 hw = thread_hw_count();
+    u32 count = CLAMP(hw / 4, 1, CAPTURE_MAX_WORKERS);
+    for (u32 i = 0; i < count; i++)
+    {
+        if (!thread_create(&cs->workers[i], worker_main, cs)) break;
+        cs->worker_count++;
+    }
+
+    g_cs = cs;
+    LOG_INFO("Capture System Init (%u workers)", cs->worker_count);
+    return cs;
+}
+
+void capture_sys_kill(capture_system_t *cs)
+{
+    if (!g_cs) return;
+
+    capture_sys_flush(cs);
+    mutex_lock(&cs->lock);
+    cs->quit = true;
+    cond_broadcast(&cs->wake);
+    mutex_unlock(&cs->lock);
+    for (u32 i = 0; i < cs->worker_count; i++) thread_join(&cs->workers[i]);
+
+    for (u32 i = 0; i < CAPTURE_RING; i++)
+        gl_state_delete_buffer(cs->slots[i].pbo);
+    mutex_destroy(&cs->lock);
+    cond_destroy(&cs->wake);
+    cond_destroy(&cs->done);
+
+    LOG_INFO("Capture System Kill (%u written, %u failed, %u stalls)",
+             cs->stats.written, cs->stats.failed, cs->stats.stalls);
+    memset(cs, 0, sizeof(capture_system_t));
+    g_cs = NULL;
+}
+
+void capture_sys_screenshot(capture_system_t *cs, const char *path,
+                            capture_format_t format)
+{
+    cs->shot = true;
+    cs->shot_format = format;
+    snprintf(cs->shot_path, CAPTURE_PATH_SIZE, "%s", path);
+}
+
+void capture_sys_record(capture_system_t *cs, const char *prefix,
+                        u32 frames, capture_format_t format)
+{
+    cs->record_left = frames;
+    cs->record_index = 0;
+    cs->record_format = format;
+    snprintf(cs->record_prefix, sizeof(cs->record_prefix), "%s", prefix);
+}
+
+void capture_sys_end_frame(capture_system_t *cs, u32 fbo, u32 width,
+                           u32 height)
+{
+    // oldest first, fences pass in order so stop at the first that hasn't
+    for (u32 i = 0; i < CAPTURE_RING; i++)
+    {
+        capture_slot_t *slot =
+            &cs->slots[(cs->next_slot + i) % CAPTURE_RING];
+        if (!collect(cs, slot, false)) break;
+    }
+
+    if (width == 0 || height == 0) return; // minimized, keep the request
+
+    capture_format_t format;
+    char path[CAPTURE_PATH_SIZE];
+    if (cs->shot)
+    {
+        format = cs->shot_format;
+        memcpy(path, cs->shot_path, CAPTURE_PATH_SIZE);
+        cs->shot = false;
+    }
+    else if (cs->record_left)
+    {
+        format = cs->record_format;
+        snprintf(path, CAPTURE_PATH_SIZE, "%s_%05u%s", cs->record_prefix,
+                 cs->record_index, g_extensions[format]);
+        cs->record_index++;
+        cs->record_left--;
+    }
+    else
+    {
+        return;
+    }
+
+    capture_slot_t *slot = &cs->slots[cs->next_slot];
+    if (slot->fence)
+    {
+        cs->stats.stalls++;
+        collect(cs, slot, true);
+    }
+    cs->next_slot = (cs->next_slot + 1) % CAPTURE_RING;
+
+    u64 size = (u64)width * height * 4;
+    gl_state_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    if (slot->capacity < size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, NULL,
+                     GL_STREAM_READ);
+        slot->capacity = size;
+    }
+    gl_state_bind_framebuffer(fbo);
+    glReadPixels(0, 0, (GLsizei)width, (GLsizei)height, GL_RGBA,
+                 GL_UNSIGNED_BYTE, NULL);
+    gl_state_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot->fence = (void *)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->width = width;
+    slot->height = height;
+    slot->format = format;
+    memcpy(slot->path, path, CAPTURE_PATH_SIZE);
+    cs->stats.requested++;
+}
+
+void capture_sys_flush(capture_system_t *cs)
+{
+    for (u32 i = 0; i < CAPTURE_RING; i++)
+        collect(cs, &cs->slots[(cs->next_slot + i) % CAPTURE_RING], true);
+
+    mutex_lock(&cs->lock);
+    while (cs->job_count || cs->busy) cond_wait(&cs->done, &cs->lock);
+    mutex_unlock(&cs->lock);
+}
+
+capture_stats_t capture_sys_stats(capture_system_t *cs)
+{
+    mutex_lock(&cs->lock);
+    capture_stats_t stats = cs->stats;
+    mutex_unlock(&cs->lock);
+    return stats;
+}
+
+b8 capture_sys_compare(const char *path, const char *golden, u32 tolerance,
+                       capture_diff_t *out)
+{
+    memset(out, 0, sizeof(capture_diff_t));
+    if (is_raw(path) || is_raw(golden))
+    {
+        LOG_ERROR("capture: %s or %s is raw, only PNG compares", path,
+                  golden);
+        return false;
+    }
+
+    i32 w[2] = {0}, h[2] = {0}, channels = 0;
+    u8 *a = read_image_file(path, &w[0], &h[0], &channels);
+    u8 *b = read_image_file(golden, &w[1], &h[1], &channels);
+
+    b8 ok = a && b && w[0] == w[1] && h[0] == h[1];
+    if (ok)
+    {
+        out->width = (u32)w[0];
+        out->height = (u32)h[0];
+        out->mismatched = image_diff(a, b, out->width * out->height,
+                                     tolerance, &out->max_error);
+    }
+    else if (a && b)
+    {
+        LOG_ERROR("capture: %s is %dx%d, %s is %dx%d", path, w[0], h[0],
+                  golden, w[1], h[1]);
+    }
+
+    if (a) stbi_image_free(a);
+    if (b) stbi_image_free(b);
+    return ok;
+}
+
+capture_system_t *get_capture_system(void) { return g_cs; }
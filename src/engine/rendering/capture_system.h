@@ -0,0 +1,130 @@
+#ifndef CAPTURE_SYSTEM_H
+#define CAPTURE_SYSTEM_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/memory/arena.h"
+#include "engine/platform/thread.h"
+
+/*
+ * Frame captures that don't stall the frame. capture_sys_end_frame reads
+ * the finished frame with glReadPixels into one of a ring of pixel pack
+ * buffers and fences it, so the copy is only queued on the GPU. Later
+ * frames map the buffer once its fence has passed, usually one or two
+ * frames on, copy the pixels out and hand them to a worker that encodes
+ * and writes the file. The render thread only waits when all CAPTURE_RING
+ * buffers or CAPTURE_MAX_JOBS encodes are still busy, stats.stalls counts
+ * those.
+ *
+ * Screenshots take one frame, recordings every frame for a while, for
+ * benchmark runs. capture_sys_compare diffs a capture against a golden
+ * image, with capture_sys_flush in between so the file is complete.
+ */
+
+#define CAPTURE_RING 3
+#define CAPTURE_MAX_JOBS 8
+#define CAPTURE_MAX_WORKERS 2
+#define CAPTURE_PATH_SIZE 128
+#define CAPTURE_DIR "captures"
+
+typedef enum {
+    CAPTURE_FORMAT_PNG, // RGB, alpha dropped
+    CAPTURE_FORMAT_RAW, // headerless RGBA8, rows top down
+    CAPTURE_FORMAT_COUNT
+} capture_format_t;
+
+// A readback in flight
+typedef struct {
+    u32 pbo;
+    u64 capacity;
+    void *fence; // GLsync, NULL when the slot is free
+    u32 width;
+    u32 height;
+    capture_format_t format;
+    char path[CAPTURE_PATH_SIZE];
+} capture_slot_t;
+
+// Pixels out of a slot, waiting for a worker
+typedef struct {
+    u8 *pixels; // RGBA8 rows bottom up, as read
+    u32 width;
+    u32 height;
+    capture_format_t format;
+    char path[CAPTURE_PATH_SIZE];
+} capture_job_t;
+
+typedef struct {
+    u32 requested; // readbacks issued
+    u32 written;
+    u32 failed;
+    u32 stalls; // the render thread waited for a slot or the encoder
+} capture_stats_t;
+
+typedef struct {
+    u32 width;
+    u32 height;
+    u32 mismatched; // pixels with a channel off by more than the tolerance
+    u32 max_error;  // largest channel difference
+} capture_diff_t;
+
+typedef struct {
+    arena_alloc_t *arena;
+
+    capture_slot_t slots[CAPTURE_RING];
+    u32 next_slot; // used in order, so this one is the oldest in flight
+
+    // what the next frames read
+    b8 shot;
+    capture_format_t shot_format;
+    char shot_path[CAPTURE_PATH_SIZE];
+    u32 record_left;
+    u32 record_index;
+    capture_format_t record_format;
+    char record_prefix[CAPTURE_PATH_SIZE - 16]; // room for _00000.png
+
+    // shared with the workers, under lock
+    thread_t workers[CAPTURE_MAX_WORKERS];
+    u32 worker_count;
+    mutex_t lock;
+    cond_t wake; // a job was queued, or quit
+    cond_t done; // a job finished
+    b8 quit;
+    capture_job_t jobs[CAPTURE_MAX_JOBS];
+    u32 job_head;
+    u32 job_count;
+    u32 busy; // jobs being encoded
+    capture_stats_t stats;
+} capture_system_t;
+
+capture_system_t *capture_sys_init(arena_alloc_t *arena);
+
+// Writes out every readback issued, then stops the workers
+void capture_sys_kill(capture_system_t *cs);
+
+// Captures the next frame into path, relative to the asset directory
+void capture_sys_screenshot(capture_system_t *cs, const char *path,
+                            capture_format_t format);
+
+// Captures the next frames into prefix_00000.png (or .raw) and on, 0
+// stops a recording
+void capture_sys_record(capture_system_t *cs, const char *prefix,
+                        u32 frames, capture_format_t format);
+
+// Once a frame, after it is rendered into fbo and before the swap. Hands
+// finished readbacks to the workers and issues the one asked for.
+void capture_sys_end_frame(capture_system_t *cs, u32 fbo, u32 width,
+                           u32 height);
+
+// Blocks until every readback issued is on disk
+void capture_sys_flush(capture_system_t *cs);
+
+capture_stats_t capture_sys_stats(capture_system_t *cs);
+
+// Loads both image files and compares them channel by channel. false when
+// either doesn't load or the sizes differ. PNG only, CAPTURE_FORMAT_RAW
+// files have no header to load them by and are refused.
+b8 capture_sys_compare(const char *path, const char *golden, u32 tolerance,
+                       capture_diff_t *out);
+
+capture_system_t *get_capture_system(void);
+
+#endif // CAPTURE_SYSTEM_H
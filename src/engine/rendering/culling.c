@@ -0,0 +1,434 @@
+#include "culling.h"
+#include "engine/core/math/math_dispatch.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+
+// std
+#include <string.h>
+
+// Arrays live in one block, capacity kept at a multiple of 8
+#define CULL_ALIGN_COUNT(n) (((n) + 7u) & ~7u)
+
+/*************************
+ * SoA storage
+ *************************/
+static b8 soa_resize(f32 **arrays, u32 array_count, u32 count, u32 *capacity,
+                     u32 new_capacity)
+{
+    new_capacity = CULL_ALIGN_COUNT(MAX(new_capacity, 8u));
+    u64 stride = (u64)new_capacity * sizeof(f32);
+    f32 *block = ALLOC(stride * array_count, MEM_RENDER);
+    if (!block)
+    {
+        LOG_ERROR("culling: failed to allocate %u entries", new_capacity);
+        return false;
+    }
+
+    f32 *old = arrays[0];
+    for (u32 i = 0; i < array_count; i++)
+    {
+        f32 *dst = block + (u64)i * new_capacity;
+        if (old) memcpy(dst, arrays[i], count * sizeof(f32));
+        arrays[i] = dst;
+    }
+
+    if (old) FREE(old, (u64)*capacity * sizeof(f32) * array_count, MEM_RENDER);
+    *capacity = new_capacity;
+    return true;
+}
+
+static void soa_free(f32 **arrays, u32 array_count, u32 capacity)
+{
+    if (arrays[0])
+        FREE(arrays[0], (u64)capacity * sizeof(f32) * array_count, MEM_RENDER);
+    for (u32 i = 0; i < array_count; i++) arrays[i] = NULL;
+}
+
+b8 cull_spheres_create(cull_spheres_t *set, u32 capacity)
+{
+    memset(set, 0, sizeof(cull_spheres_t));
+    return soa_resize(&set->x, 4, 0, &set->capacity, capacity);
+}
+
+void cull_spheres_destroy(cull_spheres_t *set)
+{
+    if (!set) return;
+    soa_free(&set->x, 4, set->capacity);
+    memset(set, 0, sizeof(cull_spheres_t));
+}
+
+u32 cull_spheres_push(cull_spheres_t *set, vec3 center, f32 radius)
+{
+    if (set->count == set->capacity &&
+        !soa_resize(&set->x, 4, set->count, &set->capacity,
+                    set->capacity * 2))
+    {
+        return INVALID_32;
+    }
+
+    u32 i = set->count++;
+    set->x[i] = center.x;
+    set->y[i] = center.y;
+    set->z[i] = center.z;
+    set->radius[i] = radius;
+    return i;
+}
+
+b8 cull_aabbs_create(cull_aabbs_t *set, u32 capacity)
+{
+    memset(set, 0, sizeof(cull_aabbs_t));
+    return soa_resize(&set->min_x, 6, 0, &set->capacity, capacity);
+}
+
+void cull_aabbs_destroy(cull_aabbs_t *set)
+{
+    if (!set) return;
+    soa_free(&set->min_x, 6, set->capacity);
+    memset(set, 0, sizeof(cull_aabbs_t));
+}
+
+u32 cull_aabbs_push(cull_aabbs_t *set, aabb box)
+{
+    if (set->count == set->capacity &&
+        !soa_resize(&set->min_x, 6, set->count, &set->capacity,
+                    set->capacity * 2))
+    {
+        return INVALID_32;
+    }
+
+    u32 i = set->count++;
+    set->min_x[i] = box.min.x;
+    set->min_y[i] = box.min.y;
+    set->min_z[i] = box.min.z;
+    set->max_x[i] = box.max.x;
+    set->max_y[i] = box.max.y;
+    set->max_z[i] = box.max.z;
+    return i;
+}
+
+/*************************
+ * Scalar
+ *************************/
+// AABB test reduces to a point test against the corner furthest along
+// each plane normal, picked once per plane instead of per box
+typedef struct {
+    const f32 *x, *y, *z;
+} corner_arrays_t;
+
+static void aabb_corners(const frustum *f, const cull_aabbs_t *set,
+                         corner_arrays_t corners[FRUSTUM_PLANE_COUNT])
+{
+    for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+    {
+        const vec4 *pl = &f->planes[p];
+        corners[p].x = pl->x >= 0.0f ? set->max_x : set->min_x;
+        corners[p].y = pl->y >= 0.0f ? set->max_y : set->min_y;
+        corners[p].z = pl->z >= 0.0f ? set->max_z : set->min_z;
+    }
+}
+
+static u32 spheres_scalar(const frustum *f, const cull_spheres_t *set,
+                          u32 begin, u32 *out, u32 n)
+{
+    for (u32 i = begin; i < set->count; i++)
+    {
+        vec3 c = vec3_create(set->x[i], set->y[i], set->z[i]);
+        out[n] = i;
+        n += frustum_sphere_visible(f, c, set->radius[i]);
+    }
+    return n;
+}
+
+static u32 aabbs_scalar(const frustum *f, const corner_arrays_t *corners,
+                        u32 begin, u32 count, u32 *out, u32 n)
+{
+    for (u32 i = begin; i < count; i++)
+    {
+        b8 visible = true;
+        for (u32 p = 0; p < FRUSTUM_PLANE_COUNT && visible; p++)
+        {
+            vec3 v = vec3_create(corners[p].x[i], corners[p].y[i],
+                                 corners[p].z[i]);
+            visible = plane_distance(f->planes[p], v) >= 0.0f;
+        }
+        out[n] = i;
+        n += visible;
+    }
+    return n;
+}
+
+// Squared distance from the sphere's center to each box, per axis the gap
+// past the nearer face or 0 inside the slab
+static u32 sphere_scalar(const cull_aabbs_t *set, u32 begin, u32 end,
+                         vec3 c, f32 radius, u32 *out, u32 n)
+{
+    f32 r2 = radius * radius;
+    for (u32 i = begin; i < end; i++)
+    {
+        f32 dx = MAX(MAX(set->min_x[i] - c.x, c.x - set->max_x[i]), 0.0f);
+        f32 dy = MAX(MAX(set->min_y[i] - c.y, c.y - set->max_y[i]), 0.0f);
+        f32 dz = MAX(MAX(set->min_z[i] - c.z, c.z - set->max_z[i]), 0.0f);
+        out[n] = i;
+        n += dx * dx + dy * dy + dz * dz <= r2;
+    }
+    return n;
+}
+
+#if MATH_SSE
+/*************************
+ * SSE
+ *************************/
+// Branchless compaction, every lane writes and only visible ones advance
+#    define CULL_EMIT(out, n, base, mask, lanes)                              \
+        for (u32 k = 0; k < (lanes); k++)                                     \
+        {                                                                     \
+            (out)[n] = (base) + k;                                            \
+            n += ((mask) >> k) & 1u;                                          \
+        }
+
+static u32 spheres_sse(const frustum *f, const cull_spheres_t *set, u32 *out)
+{
+    __m128 pl[FRUSTUM_PLANE_COUNT][4];
+    for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        for (u32 c = 0; c < 4; c++)
+            pl[p][c] = _mm_set1_ps(f->planes[p].elements[c]);
+
+    u32 n = 0, i = 0;
+    for (; i + 4 <= set->count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(set->x + i);
+        __m128 y = _mm_loadu_ps(set->y + i);
+        __m128 z = _mm_loadu_ps(set->z + i);
+        __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(),
+                                  _mm_loadu_ps(set->radius + i));
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(pl[p][0], x), pl[p][3]);
+            d = _mm_add_ps(d, _mm_mul_ps(pl[p][1], y));
+            d = _mm_add_ps(d, _mm_mul_ps(pl[p][2], z));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(d, neg_r));
+        }
+
+        u32 mask = (u32)_mm_movemask_ps(visible);
+        CULL_EMIT(out, n, i, mask, 4);
+    }
+    return spheres_scalar(f, set, i, out, n);
+}
+
+static u32 aabbs_sse(const frustum *f, const cull_aabbs_t *set, u32 *out)
+{
+    corner_arrays_t corners[FRUSTUM_PLANE_COUNT];
+    aabb_corners(f, set, corners);
+
+    __m128 pl[FRUSTUM_PLANE_COUNT][4];
+    for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        for (u32 c = 0; c < 4; c++)
+            pl[p][c] = _mm_set1_ps(f->planes[p].elements[c]);
+
+    u32 n = 0, i = 0;
+    for (; i + 4 <= set->count; i += 4)
+    {
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        {
+            __m128 x = _mm_loadu_ps(corners[p].x + i);
+            __m128 y = _mm_loadu_ps(corners[p].y + i);
+            __m128 z = _mm_loadu_ps(corners[p].z + i);
+            __m128 d = _mm_add_ps(_mm_mul_ps(pl[p][0], x), pl[p][3]);
+            d = _mm_add_ps(d, _mm_mul_ps(pl[p][1], y));
+            d = _mm_add_ps(d, _mm_mul_ps(pl[p][2], z));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(d, _mm_setzero_ps()));
+        }
+
+        u32 mask = (u32)_mm_movemask_ps(visible);
+        CULL_EMIT(out, n, i, mask, 4);
+    }
+    return aabbs_scalar(f, corners, i, set->count, out, n);
+}
+
+static u32 sphere_sse(const cull_aabbs_t *set, u32 begin, u32 end, vec3 c,
+                      f32 radius, u32 *out)
+{
+    __m128 cx = _mm_set1_ps(c.x);
+    __m128 cy = _mm_set1_ps(c.y);
+    __m128 cz = _mm_set1_ps(c.z);
+    __m128 r2 = _mm_set1_ps(radius * radius);
+    __m128 zero = _mm_setzero_ps();
+
+    u32 n = 0, i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 dx = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(set->min_x + i), cx),
+                               _mm_sub_ps(cx, _mm_loadu_ps(set->max_x + i)));
+        __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(set->min_y + i), cy),
+                               _mm_sub_ps(cy, _mm_loadu_ps(set->max_y + i)));
+        __m128 dz = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(set->min_z + i), cz),
+                               _mm_sub_ps(cz, _mm_loadu_ps(set->max_z + i)));
+        dx = _mm_max_ps(dx, zero);
+        dy = _mm_max_ps(dy, zero);
+        dz = _mm_max_ps(dz, zero);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        d2 = _mm_add_ps(d2, _mm_mul_ps(dz, dz));
+
+        u32 mask = (u32)_mm_movemask_ps(_mm_cmple_ps(d2, r2));
+        CULL_EMIT(out, n, i, mask, 4);
+    }
+    return sphere_scalar(set, i, end, c, radius, out, n);
+}
+#endif // MATH_SSE
+
+#if MATH_DISPATCH
+/*************************
+ * AVX
+ *************************/
+MATH_TARGET("avx")
+static u32 spheres_avx(const frustum *f, const cull_spheres_t *set, u32 *out)
+{
+    __m256 pl[FRUSTUM_PLANE_COUNT][4];
+    for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        for (u32 c = 0; c < 4; c++)
+            pl[p][c] = _mm256_set1_ps(f->planes[p].elements[c]);
+
+    u32 n = 0, i = 0;
+    for (; i + 8 <= set->count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(set->x + i);
+        __m256 y = _mm256_loadu_ps(set->y + i);
+        __m256 z = _mm256_loadu_ps(set->z + i);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(),
+                                     _mm256_loadu_ps(set->radius + i));
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(pl[p][0], x), pl[p][3]);
+            d = _mm256_add_ps(d, _mm256_mul_ps(pl[p][1], y));
+            d = _mm256_add_ps(d, _mm256_mul_ps(pl[p][2], z));
+            visible = _mm256_and_ps(visible,
+                                    _mm256_cmp_ps(d, neg_r, _CMP_GE_OQ));
+        }
+
+        u32 mask = (u32)_mm256_movemask_ps(visible);
+        CULL_EMIT(out, n, i, mask, 8);
+    }
+    return spheres_scalar(f, set, i, out, n);
+}
+
+MATH_TARGET("avx")
+static u32 aabbs_avx(const frustum *f, const cull_aabbs_t *set, u32 *out)
+{
+    corner_arrays_t corners[FRUSTUM_PLANE_COUNT];
+    aabb_corners(f, set, corners);
+
+    __m256 pl[FRUSTUM_PLANE_COUNT][4];
+    for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        for (u32 c = 0; c < 4; c++)
+            pl[p][c] = _mm256_set1_ps(f->planes[p].elements[c]);
+
+    u32 n = 0, i = 0;
+    for (; i + 8 <= set->count; i += 8)
+    {
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; p++)
+        {
+            __m256 x = _mm256_loadu_ps(corners[p].x + i);
+            __m256 y = _mm256_loadu_ps(corners[p].y + i);
+            __m256 z = _mm256_loadu_ps(corners[p].z + i);
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(pl[p][0], x), pl[p][3]);
+            d = _mm256_add_ps(d, _mm256_mul_ps(pl[p][1], y));
+            d = _mm256_add_ps(d, _mm256_mul_ps(pl[p][2], z));
+            visible = _mm256_and_ps(
+                visible, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        u32 mask = (u32)_mm256_movemask_ps(visible);
+        CULL_EMIT(out, n, i, mask, 8);
+    }
+    return aabbs_scalar(f, corners, i, set->count, out, n);
+}
+
+MATH_TARGET("avx")
+static u32 sphere_avx(const cull_aabbs_t *set, u32 begin, u32 end, vec3 c,
+                      f32 radius, u32 *out)
+{
+    __m256 cx = _mm256_set1_ps(c.x);
+    __m256 cy = _mm256_set1_ps(c.y);
+    __m256 cz = _mm256_set1_ps(c.z);
+    __m256 r2 = _mm256_set1_ps(radius * radius);
+    __m256 zero = _mm256_setzero_ps();
+
+    u32 n = 0, i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 dx =
+            _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(set->min_x + i), cx),
+                          _mm256_sub_ps(cx, _mm256_loadu_ps(set->max_x + i)));
+        __m256 dy =
+            _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(set->min_y + i), cy),
+                          _mm256_sub_ps(cy, _mm256_loadu_ps(set->max_y + i)));
+        __m256 dz =
+            _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(set->min_z + i), cz),
+                          _mm256_sub_ps(cz, _mm256_loadu_ps(set->max_z + i)));
+        dx = _mm256_max_ps(dx, zero);
+        dy = _mm256_max_ps(dy, zero);
+        dz = _mm256_max_ps(dz, zero);
+        __m256 d2 =
+            _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        d2 = _mm256_add_ps(d2, _mm256_mul_ps(dz, dz));
+
+        u32 mask = (u32)_mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ));
+        CULL_EMIT(out, n, i, mask, 8);
+    }
+    return sphere_scalar(set, i, end, c, radius, out, n);
+}
+#endif // MATH_DISPATCH
+
+/*************************
+ * Public
+ *************************/
+u32 cull_spheres_frustum(const frustum *f, const cull_spheres_t *set,
+                         u32 *out_visible)
+{
+    // follows the level picked by math_dispatch
+#if MATH_DISPATCH
+    if (math_simd_level() >= MATH_SIMD_AVX)
+        return spheres_avx(f, set, out_visible);
+#endif
+#if MATH_SSE
+    if (math_simd_level() >= MATH_SIMD_SSE2)
+        return spheres_sse(f, set, out_visible);
+#endif
+    return spheres_scalar(f, set, 0, out_visible, 0);
+}
+
+u32 cull_aabbs_frustum(const frustum *f, const cull_aabbs_t *set,
+                       u32 *out_visible)
+{
+#if MATH_DISPATCH
+    if (math_simd_level() >= MATH_SIMD_AVX)
+        return aabbs_avx(f, set, out_visible);
+#endif
+#if MATH_SSE
+    if (math_simd_level() >= MATH_SIMD_SSE2)
+        return aabbs_sse(f, set, out_visible);
+#endif
+    corner_arrays_t corners[FRUSTUM_PLANE_COUNT];
+    aabb_corners(f, set, corners);
+    return aabbs_scalar(f, corners, 0, set->count, out_visible, 0);
+}
+
+u32 cull_aabbs_sphere(const cull_aabbs_t *set, u32 begin, u32 end,
+                      vec3 center, f32 radius, u32 *out_hits)
+{
+#if MATH_DISPATCH
+    if (math_simd_level() >= MATH_SIMD_AVX)
+        return sphere_avx(set, begin, end, center, radius, out_hits);
+#endif
+#if MATH_SSE
+    if (math_simd_level() >= MATH_SIMD_SSE2)
+        return sphere_sse(set, begin, end, center, radius, out_hits);
+#endif
+    return sphere_scalar(set, begin, end, center, radius, out_hits, 0);
+}
@@ -0,0 +1,53 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/math/math_types.h"
+
+/*
+ * Frustum culling over SoA bounds. Entries are tested 4 (SSE) or 8 (AVX)
+ * at a time and the survivors are written as a compacted index list, so
+ * the caller only walks what is visible. Index i refers to the i-th push.
+ */
+
+typedef struct {
+    f32 *x, *y, *z, *radius;
+    u32 count;
+    u32 capacity;
+} cull_spheres_t;
+
+typedef struct {
+    f32 *min_x, *min_y, *min_z;
+    f32 *max_x, *max_y, *max_z;
+    u32 count;
+    u32 capacity;
+} cull_aabbs_t;
+
+b8 cull_spheres_create(cull_spheres_t *set, u32 capacity);
+
+void cull_spheres_destroy(cull_spheres_t *set);
+
+// Grows the set when full, returns the index of the new entry or
+// INVALID_32 if the allocation failed
+u32 cull_spheres_push(cull_spheres_t *set, vec3 center, f32 radius);
+
+b8 cull_aabbs_create(cull_aabbs_t *set, u32 capacity);
+
+void cull_aabbs_destroy(cull_aabbs_t *set);
+
+u32 cull_aabbs_push(cull_aabbs_t *set, aabb box);
+
+// out_visible needs room for set->count indices. Returns how many were
+// written, in ascending order.
+u32 cull_spheres_frustum(const frustum *f, const cull_spheres_t *set,
+                         u32 *out_visible);
+
+u32 cull_aabbs_frustum(const frustum *f, const cull_aabbs_t *set,
+                       u32 *out_visible);
+
+// Boxes in [begin, end) touching the sphere, written like the frustum
+// tests. out_hits needs room for end - begin indices.
+u32 cull_aabbs_sphere(const cull_aabbs_t *set, u32 begin, u32 end,
+                      vec3 center, f32 radius, u32 *out_hits);
+
+#endif // CULLING_H
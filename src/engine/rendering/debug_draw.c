@@ -0,0 +1,271 @@
+#include "debug_draw.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_state.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <string.h>
+
+static debug_draw_t *g_dd = NULL;
+
+// Room for count vertices in the mode's end of the array, NULL when full
+static debug_vertex_t *reserve(debug_draw_t *dd, u32 count,
+                               debug_draw_mode_t mode)
+{
+    u32 used = dd->depth_count + dd->overlay_count;
+    if (used + count > DEBUG_DRAW_MAX_VERTICES)
+    {
+        dd->dropped += count / 2;
+        return NULL;
+    }
+
+    if (mode == DEBUG_DRAW_OVERLAY)
+    {
+        dd->overlay_count += count;
+        return dd->vertices + DEBUG_DRAW_MAX_VERTICES - dd->overlay_count;
+    }
+    debug_vertex_t *v = dd->vertices + dd->depth_count;
+    dd->depth_count += count;
+    return v;
+}
+
+static void put(debug_vertex_t *v, vec3 p, u32 color)
+{
+    v->x = p.x;
+    v->y = p.y;
+    v->z = p.z;
+    v->color = color;
+}
+
+debug_draw_t *debug_draw_init(arena_alloc_t *arena)
+{
+    debug_draw_t *dd = arena_alloc(arena, sizeof(debug_draw_t));
+    if (!dd) return NULL;
+    memset(dd, 0, sizeof(debug_draw_t));
+    dd->arena = arena;
+
+    dd->vertices =
+        ALLOC(sizeof(debug_vertex_t) * DEBUG_DRAW_MAX_VERTICES, MEM_RENDER);
+    if (!dd->vertices ||
+        !stream_buffer_create(&dd->stream, GL_ARRAY_BUFFER,
+                              sizeof(debug_vertex_t) * DEBUG_DRAW_MAX_VERTICES,
+                              sizeof(debug_vertex_t)))
+    {
+        LOG_ERROR("debug draw: failed to create the vertex buffers");
+        return NULL;
+    }
+
+    for (u32 i = 0; i <= DEBUG_DRAW_CIRCLE_SEGMENTS; i++)
+    {
+        f32 angle = M_PI2 * (f32)(i % DEBUG_DRAW_CIRCLE_SEGMENTS) /
+                    (f32)DEBUG_DRAW_CIRCLE_SEGMENTS;
+        dd->circle_sin[i] = m_sin(angle);
+        dd->circle_cos[i] = m_cos(angle);
+    }
+
+    // draws pick their vertices with first, the pointers never move
+    glGenVertexArrays(1, &dd->vao);
+    gl_state_bind_vao(dd->vao);
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, dd->stream.buffer);
+    glEnableVertexAttribArray(ATTR_POSITION);
+    glEnableVertexAttribArray(ATTR_COLOR);
+    glVertexAttribPointer(ATTR_POSITION, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(debug_vertex_t),
+                          (void *)OFFSETOF(debug_vertex_t, x));
+    glVertexAttribPointer(ATTR_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                          sizeof(debug_vertex_t),
+                          (void *)OFFSETOF(debug_vertex_t, color));
+    gl_state_bind_vao(0);
+
+    g_dd = dd;
+    LOG_INFO("Debug Draw Init (%d lines)", DEBUG_DRAW_MAX_LINES);
+    return dd;
+}
+
+void debug_draw_kill(debug_draw_t *dd)
+{
+    if (!g_dd) return;
+
+    gl_state_delete_vao(dd->vao);
+    stream_buffer_destroy(&dd->stream);
+    FREE(dd->vertices, sizeof(debug_vertex_t) * DEBUG_DRAW_MAX_VERTICES,
+         MEM_RENDER);
+
+    memset(dd, 0, sizeof(debug_draw_t));
+    g_dd = NULL;
+    LOG_INFO("Debug Draw Kill");
+}
+
+void debug_draw_reset(debug_draw_t *dd)
+{
+    dd->depth_count = 0;
+    dd->overlay_count = 0;
+    dd->dropped = 0;
+}
+
+void debug_draw_line(debug_draw_t *dd, vec3 a, vec3 b, u32 color,
+                     debug_draw_mode_t mode)
+{
+    debug_vertex_t *v = reserve(dd, 2, mode);
+    if (!v) return;
+    put(&v[0], a, color);
+    put(&v[1], b, color);
+}
+
+void debug_draw_aabb(debug_draw_t *dd, aabb box, u32 color,
+                     debug_draw_mode_t mode)
+{
+    // corner i takes max on the axes whose bit is set, x = 1, y = 2, z = 4
+    static const u8 edges[12][2] = {{0, 1}, {2, 3}, {4, 5}, {6, 7},
+                                    {0, 2}, {1, 3}, {4, 6}, {5, 7},
+                                    {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+    debug_vertex_t *v = reserve(dd, 24, mode);
+    if (!v) return;
+
+    vec3 corners[8];
+    for (u32 i = 0; i < 8; i++)
+    {
+        corners[i] = vec3_create((i & 1) ? box.max.x : box.min.x,
+                                 (i & 2) ? box.max.y : box.min.y,
+                                 (i & 4) ? box.max.z : box.min.z);
+    }
+    for (u32 e = 0; e < 12; e++)
+    {
+        put(v++, corners[edges[e][0]], color);
+        put(v++, corners[edges[e][1]], color);
+    }
+}
+
+void debug_draw_sphere(debug_draw_t *dd, vec3 center, f32 radius,
+                       u32 color, debug_draw_mode_t mode)
+{
+    debug_vertex_t *v = reserve(dd, DEBUG_DRAW_CIRCLE_SEGMENTS * 6, mode);
+    if (!v) return;
+
+    for (u32 i = 0; i < DEBUG_DRAW_CIRCLE_SEGMENTS; i++)
+    {
+        for (u32 k = i; k <= i + 1; k++)
+        {
+            f32 s = dd->circle_sin[k] * radius;
+            f32 c = dd->circle_cos[k] * radius;
+            u32 n = k - i;
+            put(&v[n], vec3_create(center.x + c, center.y + s, center.z),
+                color);
+            put(&v[2 + n], vec3_create(center.x, center.y + c, center.z + s),
+                color);
+            put(&v[4 + n], vec3_create(center.x + s, center.y, center.z + c),
+                color);
+        }
+        v += 6;
+    }
+}
+
+void debug_draw_frustum(debug_draw_t *dd, mat4 view_proj, u32 color,
+                        debug_draw_mode_t mode)
+{
+    mat4 inv = mat4_inverse(view_proj);
+    vec3 corners[8];
+    for (u32 i = 0; i < 8; i++)
+    {
+        vec4 p = mat4_mul_vec4(
+            inv, vec4_create((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f,
+                             (i & 4) ? 1.0f : -1.0f, 1.0f));
+        corners[i] = vec3_create(p.x / p.w, p.y / p.w, p.z / p.w);
+    }
+
+    // same corner order as an aabb, near face first
+    static const u8 edges[12][2] = {{0, 1}, {2, 3}, {4, 5}, {6, 7},
+                                    {0, 2}, {1, 3}, {4, 6}, {5, 7},
+                                    {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+    debug_vertex_t *v = reserve(dd, 24, mode);
+    if (!v) return;
+    for (u32 e = 0; e < 12; e++)
+    {
+        put(v++, corners[edges[e][0]], color);
+        put(v++, corners[edges[e][1]], color);
+    }
+}
+
+void debug_draw_axes(debug_draw_t *dd, mat4 transform, f32 size,
+                     debug_draw_mode_t mode)
+{
+    static const u32 colors[3] = {DEBUG_RED, DEBUG_GREEN, DEBUG_BLUE};
+    debug_vertex_t *v = reserve(dd, 6, mode);
+    if (!v) return;
+
+    const f32 *m = transform.data;
+    vec3 origin = vec3_create(m[12], m[13], m[14]);
+    for (u32 i = 0; i < 3; i++)
+    {
+        vec3 axis = vec3_normalize(vec3_create(m[i * 4], m[i * 4 + 1],
+                                               m[i * 4 + 2]));
+        put(v++, origin, colors[i]);
+        put(v++, vec3_add(origin, vec3_scale(axis, size)), colors[i]);
+    }
+}
+
+void debug_draw_grid(debug_draw_t *dd, vec3 center, f32 spacing, u32 count,
+                     u32 color, debug_draw_mode_t mode)
+{
+    if (count == 0) return;
+    debug_vertex_t *v = reserve(dd, count * 4, mode);
+    if (!v) return;
+
+    f32 half = (f32)(count - 1) * spacing * 0.5f;
+    for (u32 i = 0; i < count; i++)
+    {
+        f32 t = (f32)i * spacing - half;
+        put(v++, vec3_create(center.x + t, center.y, center.z - half), color);
+        put(v++, vec3_create(center.x + t, center.y, center.z + half), color);
+        put(v++, vec3_create(center.x - half, center.y, center.z + t), color);
+        put(v++, vec3_create(center.x + half, center.y, center.z + t), color);
+    }
+}
+
+void debug_draw_render(debug_draw_t *dd, const shader_t *shader)
+{
+    u32 depth = dd->depth_count;
+    u32 overlay = dd->overlay_count;
+    if (dd->dropped && !dd->stats.dropped)
+    {
+        LOG_WARN("debug draw: %u lines past %d dropped", dd->dropped,
+                 DEBUG_DRAW_MAX_LINES);
+    }
+    dd->stats.lines = (depth + overlay) / 2;
+    dd->stats.dropped = dd->dropped;
+    if (depth + overlay == 0 || !shader || !shader->program) return;
+
+    // both ends of the array back to back, depth tested first
+    stream_buffer_begin_frame(&dd->stream);
+    u64 offset = 0;
+    debug_vertex_t *dst = stream_buffer_alloc(
+        &dd->stream, sizeof(debug_vertex_t) * (depth + overlay), &offset);
+    if (!dst)
+    {
+        stream_buffer_end_frame(&dd->stream);
+        return;
+    }
+    memcpy(dst, dd->vertices, sizeof(debug_vertex_t) * depth);
+    memcpy(dst + depth,
+           dd->vertices + DEBUG_DRAW_MAX_VERTICES - overlay,
+           sizeof(debug_vertex_t) * overlay);
+    stream_buffer_flush(&dd->stream);
+
+    GLint first = (GLint)(offset / sizeof(debug_vertex_t));
+    gl_state_use_program(shader->program);
+    gl_state_bind_vao(dd->vao);
+    gl_state_depth_mask(false);
+    if (depth) glDrawArrays(GL_LINES, first, (GLsizei)depth);
+    if (overlay)
+    {
+        gl_state_enable(GL_DEPTH_TEST, false);
+        glDrawArrays(GL_LINES, first + (GLint)depth, (GLsizei)overlay);
+        gl_state_enable(GL_DEPTH_TEST, true);
+    }
+    gl_state_depth_mask(true);
+    stream_buffer_end_frame(&dd->stream);
+}
+
+debug_draw_t *get_debug_draw(void) { return g_dd; }
@@ -0,0 +1,111 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/math/math_types.h"
+#include "engine/core/memory/arena.h"
+#include "engine/rendering/render.h"
+#include "engine/rendering/shader_system.h"
+#include "engine/rendering/stream_buffer.h"
+
+/*
+ * Immediate mode debug lines. Anything may add lines, boxes, spheres,
+ * frustums, axes or grids during a frame; they are appended as vertices to
+ * one CPU array and debug_draw_render, from DEBUG_UI_PASS, copies them
+ * into a stream buffer and draws them with at most two glDrawArrays, the
+ * depth tested lines then the overlay ones. Depth tested lines fill the
+ * array from the front and overlay lines from the back, so both fit one
+ * allocation and one copy each.
+ *
+ * Nothing is kept between frames, debug_draw_reset drops the lines once
+ * they are drawn. Past DEBUG_DRAW_MAX_LINES the rest are dropped and
+ * counted.
+ */
+
+#define DEBUG_DRAW_MAX_LINES (128 * 1024)
+#define DEBUG_DRAW_MAX_VERTICES (DEBUG_DRAW_MAX_LINES * 2)
+#define DEBUG_DRAW_CIRCLE_SEGMENTS 24
+
+// RGBA8, r in the lowest byte so it reads back as GL_RGBA bytes
+#define DEBUG_RGBA(r, g, b, a)                                                \
+    ((u32)(r) | (u32)(g) << 8 | (u32)(b) << 16 | (u32)(a) << 24)
+#define DEBUG_RED DEBUG_RGBA(255, 64, 64, 255)
+#define DEBUG_GREEN DEBUG_RGBA(64, 255, 64, 255)
+#define DEBUG_BLUE DEBUG_RGBA(64, 96, 255, 255)
+#define DEBUG_YELLOW DEBUG_RGBA(255, 230, 64, 255)
+#define DEBUG_WHITE DEBUG_RGBA(255, 255, 255, 255)
+#define DEBUG_GRAY DEBUG_RGBA(128, 128, 128, 255)
+
+typedef enum {
+    DEBUG_DRAW_DEPTH,   // hidden behind the scene
+    DEBUG_DRAW_OVERLAY, // always on top
+} debug_draw_mode_t;
+
+// 16 bytes, vec3 would pad it to 32
+typedef struct {
+    f32 x, y, z; // world space
+    u32 color;
+} debug_vertex_t;
+
+typedef struct {
+    u32 lines;   // drawn last frame
+    u32 dropped; // past DEBUG_DRAW_MAX_LINES last frame
+} debug_draw_stats_t;
+
+typedef struct {
+    arena_alloc_t *arena;
+
+    // depth tested lines from the front, overlay lines from the back
+    debug_vertex_t *vertices;
+    u32 depth_count;
+    u32 overlay_count;
+    u32 dropped;
+
+    // unit circle, DEBUG_DRAW_CIRCLE_SEGMENTS + 1 points, the last one is
+    // the first again
+    f32 circle_sin[DEBUG_DRAW_CIRCLE_SEGMENTS + 1];
+    f32 circle_cos[DEBUG_DRAW_CIRCLE_SEGMENTS + 1];
+
+    stream_buffer_t stream;
+    u32 vao;
+
+    debug_draw_stats_t stats;
+} debug_draw_t;
+
+debug_draw_t *debug_draw_init(arena_alloc_t *arena);
+
+void debug_draw_kill(debug_draw_t *dd);
+
+// Drops every line added so far, once per frame after the frame rendered
+void debug_draw_reset(debug_draw_t *dd);
+
+void debug_draw_line(debug_draw_t *dd, vec3 a, vec3 b, u32 color,
+                     debug_draw_mode_t mode);
+
+void debug_draw_aabb(debug_draw_t *dd, aabb box, u32 color,
+                     debug_draw_mode_t mode);
+
+// Three circles, one around each axis
+void debug_draw_sphere(debug_draw_t *dd, vec3 center, f32 radius,
+                       u32 color, debug_draw_mode_t mode);
+
+// The 12 edges of the volume view_proj maps onto clip space, e.g. a
+// camera's view_proj
+void debug_draw_frustum(debug_draw_t *dd, mat4 view_proj, u32 color,
+                        debug_draw_mode_t mode);
+
+// transform's x, y and z axes in red, green and blue, size long
+void debug_draw_axes(debug_draw_t *dd, mat4 transform, f32 size,
+                     debug_draw_mode_t mode);
+
+// count lines each way on the xz plane through center, spacing apart
+void debug_draw_grid(debug_draw_t *dd, vec3 center, f32 spacing, u32 count,
+                     u32 color, debug_draw_mode_t mode);
+
+// Streams and draws everything added this frame into whatever is bound,
+// from DEBUG_UI_PASS. Skipped while shader isn't linked.
+void debug_draw_render(debug_draw_t *dd, const shader_t *shader);
+
+debug_draw_t *get_debug_draw(void);
+
+#endif // DEBUG_DRAW_H
@@ -0,0 +1,138 @@
+#include "gl_ext.h"
+
+#include <GLFW/glfw3.h>
+
+// std
+#include <stdlib.h>
+#include <string.h>
+
+gl_ext_t g_gl_ext = {0};
+
+// KERFUFFLE_GL_NO_EXT=1 pretends nothing past 3.3 exists, handy to run the
+// fallback paths on a modern driver
+static b8 ext_disabled(void)
+{
+    const char *env = getenv("KERFUFFLE_GL_NO_EXT");
+    return env && env[0] && env[0] != '0';
+}
+
+static void *load(const char *core, const char *ext)
+{
+    void *fn = (void *)glfwGetProcAddress(core);
+    if (!fn && ext) fn = (void *)glfwGetProcAddress(ext);
+    return fn;
+}
+
+b8 gl_ext_has(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (ext && strcmp(ext, name) == 0) return true;
+    }
+    return false;
+}
+
+b8 gl_version_at_least(i32 major, i32 minor)
+{
+    return g_gl_ext.major > major ||
+           (g_gl_ext.major == major && g_gl_ext.minor >= minor);
+}
+
+void gl_ext_init(void)
+{
+    memset(&g_gl_ext, 0, sizeof(gl_ext_t));
+    glGetIntegerv(GL_MAJOR_VERSION, &g_gl_ext.major);
+    glGetIntegerv(GL_MINOR_VERSION, &g_gl_ext.minor);
+
+    if (ext_disabled())
+    {
+        LOG_WARN("GL extensions disabled by KERFUFFLE_GL_NO_EXT");
+        return;
+    }
+
+    if (gl_version_at_least(4, 4) || gl_ext_has("GL_ARB_buffer_storage"))
+    {
+        g_gl_ext.BufferStorage = (PFNGLBUFFERSTORAGEPROC)load(
+            "glBufferStorage", "glBufferStorageARB");
+        g_gl_ext.buffer_storage = g_gl_ext.BufferStorage != NULL;
+    }
+
+    b8 base_instance =
+        gl_version_at_least(4, 2) || gl_ext_has("GL_ARB_base_instance");
+    if (base_instance && (gl_version_at_least(4, 3) ||
+                          gl_ext_has("GL_ARB_multi_draw_indirect")))
+    {
+        g_gl_ext.MultiDrawElementsIndirect =
+            (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load(
+                "glMultiDrawElementsIndirect",
+                "glMultiDrawElementsIndirectARB");
+        g_gl_ext.multi_draw_indirect =
+            g_gl_ext.MultiDrawElementsIndirect != NULL;
+    }
+
+    if (gl_version_at_least(4, 3) ||
+        (gl_ext_has("GL_ARB_compute_shader") &&
+         gl_ext_has("GL_ARB_shader_storage_buffer_object")))
+    {
+        g_gl_ext.DispatchCompute =
+            (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute", NULL);
+        g_gl_ext.MemoryBarrier = (PFNGLMEMORYBARRIERPROC)load(
+            "glMemoryBarrier", "glMemoryBarrierEXT");
+        g_gl_ext.compute =
+            g_gl_ext.DispatchCompute != NULL && g_gl_ext.MemoryBarrier != NULL;
+    }
+
+    GLint formats = 0;
+    if (gl_version_at_least(4, 1) || gl_ext_has("GL_ARB_get_program_binary"))
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats > 0)
+    {
+        g_gl_ext.GetProgramBinary =
+            (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary", NULL);
+        g_gl_ext.ProgramBinary =
+            (PFNGLPROGRAMBINARYPROC)load("glProgramBinary", NULL);
+        g_gl_ext.ProgramParameteri =
+            (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri", NULL);
+        g_gl_ext.program_binary = g_gl_ext.GetProgramBinary &&
+                                  g_gl_ext.ProgramBinary &&
+                                  g_gl_ext.ProgramParameteri;
+    }
+
+    if (gl_ext_has("GL_KHR_parallel_shader_compile"))
+    {
+        g_gl_ext.MaxShaderCompilerThreads =
+            (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load(
+                "glMaxShaderCompilerThreadsKHR", NULL);
+    }
+    else if (gl_ext_has("GL_ARB_parallel_shader_compile"))
+    {
+        g_gl_ext.MaxShaderCompilerThreads =
+            (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load(
+                "glMaxShaderCompilerThreadsARB", NULL);
+    }
+    if (g_gl_ext.MaxShaderCompilerThreads)
+    {
+        // let the driver pick how many threads
+        g_gl_ext.MaxShaderCompilerThreads(0xFFFFFFFFu);
+        g_gl_ext.parallel_shader_compile = true;
+    }
+
+    g_gl_ext.texture_s3tc = gl_ext_has("GL_EXT_texture_compression_s3tc");
+    g_gl_ext.texture_bptc = gl_version_at_least(4, 2) ||
+                            gl_ext_has("GL_ARB_texture_compression_bptc");
+
+    LOG_INFO("GL %d.%d | buffer_storage: %s | multi_draw_indirect: %s | "
+             "compute: %s | program_binary: %s | parallel_compile: %s | "
+             "s3tc: %s | bptc: %s",
+             g_gl_ext.major, g_gl_ext.minor,
+             g_gl_ext.buffer_storage ? "yes" : "no",
+             g_gl_ext.multi_draw_indirect ? "yes" : "no",
+             g_gl_ext.compute ? "yes" : "no",
+             g_gl_ext.program_binary ? "yes" : "no",
+             g_gl_ext.parallel_shader_compile ? "yes" : "no",
+             g_gl_ext.texture_s3tc ? "yes" : "no",
+             g_gl_ext.texture_bptc ? "yes" : "no");
+}
@@ -0,0 +1,121 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+#include "deps/glad/glad.h"
+
+/*
+ * glad is generated for GL 3.3 core only. Anything newer is looked up here
+ * at runtime, either from the core version the context reports or from the
+ * matching ARB/KHR extension. Check the flag before using a pointer.
+ */
+
+// ARB_buffer_storage / GL 4.4
+#ifndef GL_MAP_PERSISTENT_BIT
+#    define GL_MAP_PERSISTENT_BIT 0x0040
+#    define GL_MAP_COHERENT_BIT 0x0080
+#    define GL_DYNAMIC_STORAGE_BIT 0x0100
+#    define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+// ARB_draw_indirect / GL 4.0
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#    define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// ARB_compute_shader + ARB_shader_storage_buffer_object / GL 4.3
+#ifndef GL_COMPUTE_SHADER
+#    define GL_COMPUTE_SHADER 0x91B9
+#    define GL_SHADER_STORAGE_BUFFER 0x90D2
+#    define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#    define GL_COMMAND_BARRIER_BIT 0x00000040
+#    define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+
+// ARB_get_program_binary / GL 4.1
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#    define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#    define GL_PROGRAM_BINARY_LENGTH 0x8741
+#    define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#    define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#    define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#    define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#    define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// ARB_texture_compression_bptc / GL 4.2
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#    define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+typedef void(APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size,
+                                               const void *data,
+                                               GLbitfield flags);
+typedef void(APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(
+    GLenum mode, GLenum type, const void *indirect, GLsizei drawcount,
+    GLsizei stride);
+typedef void(APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint x, GLuint y,
+                                                 GLuint z);
+typedef void(APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void(APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program,
+                                                  GLsizei buf_size,
+                                                  GLsizei *length,
+                                                  GLenum *format,
+                                                  void *binary);
+typedef void(APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum format,
+                                               const void *binary,
+                                               GLsizei length);
+typedef void(APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program,
+                                                   GLenum pname, GLint value);
+typedef void(APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+typedef struct {
+    i32 major;
+    i32 minor;
+
+    b8 buffer_storage;
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+
+    // also implies base instance support, commands may set base_instance
+    b8 multi_draw_indirect;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect;
+
+    // compute shaders with shader storage buffers
+    b8 compute;
+    PFNGLDISPATCHCOMPUTEPROC DispatchCompute;
+    PFNGLMEMORYBARRIERPROC MemoryBarrier;
+
+    // only set when the driver reports at least one binary format
+    b8 program_binary;
+    PFNGLGETPROGRAMBINARYPROC GetProgramBinary;
+    PFNGLPROGRAMBINARYPROC ProgramBinary;
+    PFNGLPROGRAMPARAMETERIPROC ProgramParameteri;
+
+    // GL_COMPLETION_STATUS_KHR can be polled without blocking
+    b8 parallel_shader_compile;
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC MaxShaderCompilerThreads;
+
+    // block compressed uploads, RGTC (BC4/BC5) is core since 3.0
+    b8 texture_s3tc; // BC1, BC3
+    b8 texture_bptc; // BC7
+} gl_ext_t;
+
+extern gl_ext_t g_gl_ext;
+
+// Call after gladLoadGL, needs the context current
+void gl_ext_init(void);
+
+b8 gl_ext_has(const char *name);
+
+b8 gl_version_at_least(i32 major, i32 minor);
+
+#endif // GL_EXT_H
@@ -0,0 +1,351 @@
+#include "gl_state.h"
+#include "engine/rendering/gl_ext.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <string.h>
+
+#define GL_UNKNOWN INVALID_32
+
+typedef enum {
+    BUFFER_ARRAY,
+    BUFFER_UNIFORM,
+    BUFFER_COPY_READ,
+    BUFFER_COPY_WRITE,
+    BUFFER_PIXEL_PACK,
+    BUFFER_PIXEL_UNPACK,
+    BUFFER_TEXTURE,
+    BUFFER_DRAW_INDIRECT,
+    BUFFER_SHADER_STORAGE,
+    BUFFER_SLOT_COUNT
+} buffer_slot_t;
+
+typedef enum {
+    CAP_DEPTH_TEST,
+    CAP_CULL_FACE,
+    CAP_BLEND,
+    CAP_SCISSOR_TEST,
+    CAP_COUNT
+} cap_slot_t;
+
+typedef struct {
+    u32 program;
+    u32 vao;
+    u32 fbo;
+    u32 buffers[BUFFER_SLOT_COUNT];
+    u32 ubo_bindings[GL_STATE_MAX_UBO_BINDINGS];
+    u64 ubo_offsets[GL_STATE_MAX_UBO_BINDINGS];
+    u64 ubo_sizes[GL_STATE_MAX_UBO_BINDINGS]; // INVALID_64 for whole buffer
+
+    u32 active_unit;
+    u32 texture_targets[GL_STATE_MAX_TEXTURE_UNITS];
+    u32 textures[GL_STATE_MAX_TEXTURE_UNITS];
+    u32 samplers[GL_STATE_MAX_TEXTURE_UNITS];
+
+    u32 caps[CAP_COUNT];
+    u32 depth_func;
+    u32 depth_mask;
+    u32 cull_face;
+    u32 front_face;
+    u32 blend_src, blend_dst;
+    i32 viewport[4];
+    b8 viewport_known;
+
+    gl_state_stats_t stats;
+} gl_state_t;
+
+static gl_state_t g_gl;
+
+// true when the cached value already matches, otherwise stores it
+static b8 elide(u32 *cached, u32 value)
+{
+    if (*cached == value)
+    {
+        g_gl.stats.elided++;
+        return true;
+    }
+    *cached = value;
+    g_gl.stats.issued++;
+    return false;
+}
+
+static i32 buffer_slot(u32 target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+    case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+    case GL_COPY_READ_BUFFER: return BUFFER_COPY_READ;
+    case GL_COPY_WRITE_BUFFER: return BUFFER_COPY_WRITE;
+    case GL_PIXEL_PACK_BUFFER: return BUFFER_PIXEL_PACK;
+    case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+    case GL_TEXTURE_BUFFER: return BUFFER_TEXTURE;
+    case GL_DRAW_INDIRECT_BUFFER: return BUFFER_DRAW_INDIRECT;
+    case GL_SHADER_STORAGE_BUFFER: return BUFFER_SHADER_STORAGE;
+    default: return -1;
+    }
+}
+
+static i32 cap_slot(u32 cap)
+{
+    switch (cap)
+    {
+    case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+    case GL_CULL_FACE: return CAP_CULL_FACE;
+    case GL_BLEND: return CAP_BLEND;
+    case GL_SCISSOR_TEST: return CAP_SCISSOR_TEST;
+    default: return -1;
+    }
+}
+
+void gl_state_init(void)
+{
+    gl_state_invalidate();
+    memset(&g_gl.stats, 0, sizeof(gl_state_stats_t));
+    LOG_INFO("GL State Cache Init");
+}
+
+void gl_state_invalidate(void)
+{
+    gl_state_stats_t stats = g_gl.stats;
+    memset(&g_gl, 0xFF, sizeof(gl_state_t));
+    g_gl.viewport_known = false;
+    g_gl.stats = stats;
+}
+
+gl_state_stats_t gl_state_end_frame(void)
+{
+    gl_state_stats_t stats = g_gl.stats;
+    memset(&g_gl.stats, 0, sizeof(gl_state_stats_t));
+    return stats;
+}
+
+void gl_state_use_program(u32 program)
+{
+    if (elide(&g_gl.program, program)) return;
+    glUseProgram(program);
+}
+
+void gl_state_bind_vao(u32 vao)
+{
+    if (elide(&g_gl.vao, vao)) return;
+    glBindVertexArray(vao);
+}
+
+void gl_state_bind_buffer(u32 target, u32 buffer)
+{
+    i32 slot = buffer_slot(target);
+    if (slot >= 0 && elide(&g_gl.buffers[slot], buffer)) return;
+    if (slot < 0) g_gl.stats.issued++;
+    glBindBuffer(target, buffer);
+}
+
+void gl_state_bind_buffer_base(u32 target, u32 index, u32 buffer)
+{
+    // also binds the generic target
+    i32 slot = buffer_slot(target);
+    if (target == GL_UNIFORM_BUFFER && index < GL_STATE_MAX_UBO_BINDINGS)
+    {
+        if (g_gl.ubo_bindings[index] == buffer &&
+            g_gl.ubo_offsets[index] == 0 &&
+            g_gl.ubo_sizes[index] == INVALID_64 &&
+            g_gl.buffers[slot] == buffer)
+        {
+            g_gl.stats.elided++;
+            return;
+        }
+        g_gl.ubo_bindings[index] = buffer;
+        g_gl.ubo_offsets[index] = 0;
+        g_gl.ubo_sizes[index] = INVALID_64;
+    }
+    if (slot >= 0) g_gl.buffers[slot] = buffer;
+
+    g_gl.stats.issued++;
+    glBindBufferBase(target, index, buffer);
+}
+
+void gl_state_bind_buffer_range(u32 target, u32 index, u32 buffer, u64 offset,
+                                u64 size)
+{
+    i32 slot = buffer_slot(target);
+    if (target == GL_UNIFORM_BUFFER && index < GL_STATE_MAX_UBO_BINDINGS)
+    {
+        if (g_gl.ubo_bindings[index] == buffer &&
+            g_gl.ubo_offsets[index] == offset &&
+            g_gl.ubo_sizes[index] == size && g_gl.buffers[slot] == buffer)
+        {
+            g_gl.stats.elided++;
+            return;
+        }
+        g_gl.ubo_bindings[index] = buffer;
+        g_gl.ubo_offsets[index] = offset;
+        g_gl.ubo_sizes[index] = size;
+    }
+    if (slot >= 0) g_gl.buffers[slot] = buffer;
+
+    g_gl.stats.issued++;
+    glBindBufferRange(target, index, buffer, (GLintptr)offset,
+                      (GLsizeiptr)size);
+}
+
+void gl_state_bind_framebuffer(u32 fbo)
+{
+    if (elide(&g_gl.fbo, fbo)) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void gl_state_bind_texture(u32 unit, u32 target, u32 texture)
+{
+    if (unit >= GL_STATE_MAX_TEXTURE_UNITS)
+    {
+        g_gl.stats.issued += 2;
+        g_gl.active_unit = GL_UNKNOWN;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        return;
+    }
+
+    // a different target on the same unit is a separate binding point, the
+    // cache only remembers the last one so switching back reissues
+    if (g_gl.texture_targets[unit] == target && g_gl.textures[unit] == texture)
+    {
+        g_gl.stats.elided++;
+        return;
+    }
+
+    if (!elide(&g_gl.active_unit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+
+    g_gl.texture_targets[unit] = target;
+    g_gl.textures[unit] = texture;
+    g_gl.stats.issued++;
+    glBindTexture(target, texture);
+}
+
+void gl_state_bind_sampler(u32 unit, u32 sampler)
+{
+    if (unit >= GL_STATE_MAX_TEXTURE_UNITS)
+    {
+        g_gl.stats.issued++;
+        glBindSampler(unit, sampler);
+        return;
+    }
+
+    // sampler binding takes the unit directly, no glActiveTexture
+    if (elide(&g_gl.samplers[unit], sampler)) return;
+    glBindSampler(unit, sampler);
+}
+
+void gl_state_enable(u32 cap, b8 enable)
+{
+    i32 slot = cap_slot(cap);
+    if (slot >= 0 && elide(&g_gl.caps[slot], enable ? 1u : 0u)) return;
+    if (slot < 0) g_gl.stats.issued++;
+
+    if (enable)
+        glEnable(cap);
+    else
+        glDisable(cap);
+}
+
+void gl_state_depth_func(u32 func)
+{
+    if (elide(&g_gl.depth_func, func)) return;
+    glDepthFunc(func);
+}
+
+void gl_state_depth_mask(b8 write)
+{
+    if (elide(&g_gl.depth_mask, write ? 1u : 0u)) return;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void gl_state_cull_face(u32 face)
+{
+    if (elide(&g_gl.cull_face, face)) return;
+    glCullFace(face);
+}
+
+void gl_state_front_face(u32 winding)
+{
+    if (elide(&g_gl.front_face, winding)) return;
+    glFrontFace(winding);
+}
+
+void gl_state_blend_func(u32 src, u32 dst)
+{
+    if (g_gl.blend_src == src && g_gl.blend_dst == dst)
+    {
+        g_gl.stats.elided++;
+        return;
+    }
+    g_gl.blend_src = src;
+    g_gl.blend_dst = dst;
+    g_gl.stats.issued++;
+    glBlendFunc(src, dst);
+}
+
+void gl_state_viewport(i32 x, i32 y, i32 width, i32 height)
+{
+    i32 *vp = g_gl.viewport;
+    if (g_gl.viewport_known && vp[0] == x && vp[1] == y && vp[2] == width &&
+        vp[3] == height)
+    {
+        g_gl.stats.elided++;
+        return;
+    }
+    vp[0] = x;
+    vp[1] = y;
+    vp[2] = width;
+    vp[3] = height;
+    g_gl.viewport_known = true;
+    g_gl.stats.issued++;
+    glViewport(x, y, width, height);
+}
+
+void gl_state_delete_program(u32 program)
+{
+    if (!program) return;
+    if (g_gl.program == program) g_gl.program = GL_UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void gl_state_delete_vao(u32 vao)
+{
+    if (!vao) return;
+    if (g_gl.vao == vao) g_gl.vao = 0;
+    glDeleteVertexArrays(1, &vao);
+}
+
+void gl_state_delete_buffer(u32 buffer)
+{
+    if (!buffer) return;
+    for (u32 i = 0; i < BUFFER_SLOT_COUNT; i++)
+        if (g_gl.buffers[i] == buffer) g_gl.buffers[i] = 0;
+    for (u32 i = 0; i < GL_STATE_MAX_UBO_BINDINGS; i++)
+        if (g_gl.ubo_bindings[i] == buffer) g_gl.ubo_bindings[i] = 0;
+    glDeleteBuffers(1, &buffer);
+}
+
+void gl_state_delete_texture(u32 texture)
+{
+    if (!texture) return;
+    for (u32 i = 0; i < GL_STATE_MAX_TEXTURE_UNITS; i++)
+        if (g_gl.textures[i] == texture) g_gl.textures[i] = 0;
+    glDeleteTextures(1, &texture);
+}
+
+void gl_state_delete_sampler(u32 sampler)
+{
+    if (!sampler) return;
+    for (u32 i = 0; i < GL_STATE_MAX_TEXTURE_UNITS; i++)
+        if (g_gl.samplers[i] == sampler) g_gl.samplers[i] = 0;
+    glDeleteSamplers(1, &sampler);
+}
+
+void gl_state_delete_framebuffer(u32 fbo)
+{
+    if (!fbo) return;
+    if (g_gl.fbo == fbo) g_gl.fbo = 0;
+    glDeleteFramebuffers(1, &fbo);
+}
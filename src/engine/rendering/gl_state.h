@@ -0,0 +1,76 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * Shadow copy of the GL state the renderer touches. Every setter compares
+ * against the cached value and only calls into GL when it differs. Code
+ * that goes around these calls must gl_state_invalidate() afterwards.
+ */
+
+#define GL_STATE_MAX_TEXTURE_UNITS 16
+#define GL_STATE_MAX_UBO_BINDINGS 16
+
+typedef struct {
+    u32 issued;
+    u32 elided;
+} gl_state_stats_t;
+
+// Call once the GL context is current
+void gl_state_init(void);
+
+// Forget everything, the next call of each setter always reaches GL
+void gl_state_invalidate(void);
+
+// Returns the counters for the frame that just ended and clears them
+gl_state_stats_t gl_state_end_frame(void);
+
+void gl_state_use_program(u32 program);
+
+void gl_state_bind_vao(u32 vao);
+
+// GL_ELEMENT_ARRAY_BUFFER belongs to the VAO and is never elided
+void gl_state_bind_buffer(u32 target, u32 buffer);
+
+void gl_state_bind_buffer_base(u32 target, u32 index, u32 buffer);
+
+void gl_state_bind_buffer_range(u32 target, u32 index, u32 buffer, u64 offset,
+                                u64 size);
+
+void gl_state_bind_framebuffer(u32 fbo);
+
+void gl_state_bind_texture(u32 unit, u32 target, u32 texture);
+
+void gl_state_bind_sampler(u32 unit, u32 sampler);
+
+// GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND and GL_SCISSOR_TEST are cached,
+// anything else goes straight through
+void gl_state_enable(u32 cap, b8 enable);
+
+void gl_state_depth_func(u32 func);
+
+void gl_state_depth_mask(b8 write);
+
+void gl_state_cull_face(u32 face);
+
+void gl_state_front_face(u32 winding);
+
+void gl_state_blend_func(u32 src, u32 dst);
+
+void gl_state_viewport(i32 x, i32 y, i32 width, i32 height);
+
+// Deleting a bound object silently unbinds it, these keep the cache honest
+void gl_state_delete_program(u32 program);
+
+void gl_state_delete_vao(u32 vao);
+
+void gl_state_delete_buffer(u32 buffer);
+
+void gl_state_delete_texture(u32 texture);
+
+void gl_state_delete_sampler(u32 sampler);
+
+void gl_state_delete_framebuffer(u32 fbo);
+
+#endif // GL_STATE_H
@@ -0,0 +1,176 @@
+#include "gpu_cull.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_ext.h"
+#include "engine/rendering/gl_state.h"
+
+// std
+#include <string.h>
+
+// std430 object in cull.comp.glsl
+typedef struct {
+    vec4 sphere;
+    u32 cmd;
+    u32 pad[3];
+} gpu_cull_object_t;
+
+static u32 create_buffer(u32 target, u64 size, const void *data, u32 usage)
+{
+    u32 buffer;
+    glGenBuffers(1, &buffer);
+    gl_state_bind_buffer(target, buffer);
+    glBufferData(target, (GLsizeiptr)size, data, usage);
+    return buffer;
+}
+
+b8 gpu_cull_supported(void)
+{
+    return g_gl_ext.compute && g_gl_ext.multi_draw_indirect;
+}
+
+// One command per mesh in use, sized for every object using it
+static void build_objects(gpu_cull_t *gc, const mesh_system_t *ms,
+                          const cull_spheres_t *bounds,
+                          const mesh_handle_t *meshes, u32 *cmd_of,
+                          mesh_indirect_cmd_t *cmds,
+                          gpu_cull_object_t *objects)
+{
+    memset(cmd_of, 0xFF, sizeof(u32) * ms->mesh_count);
+
+    for (u32 i = 0; i < bounds->count; i++)
+    {
+        mesh_handle_t mesh = meshes[i];
+        if (cmd_of[mesh] == INVALID_32)
+        {
+            const internal_geo_t *geo = mesh_sys_get(ms, mesh);
+            cmd_of[mesh] = gc->cmd_count;
+            cmds[gc->cmd_count++] = (mesh_indirect_cmd_t){
+                .count = geo->ind_count,
+                .first_index = geo->ind_offset,
+                .base_vertex = (i32)geo->vert_offset,
+            };
+        }
+        cmds[cmd_of[mesh]].base_instance++;
+
+        objects[i] = (gpu_cull_object_t){
+            .sphere = vec4_create(bounds->x[i], bounds->y[i], bounds->z[i],
+                                  bounds->radius[i]),
+            .cmd = cmd_of[mesh],
+        };
+    }
+
+    // sizes to start offsets
+    u32 base = 0;
+    for (u32 i = 0; i < gc->cmd_count; i++)
+    {
+        u32 size = cmds[i].base_instance;
+        cmds[i].base_instance = base;
+        base += size;
+    }
+}
+
+b8 gpu_cull_create(gpu_cull_t *gc, const mesh_system_t *ms,
+                   const cull_spheres_t *bounds,
+                   const render_instance_t *instances,
+                   const mesh_handle_t *meshes)
+{
+    memset(gc, 0, sizeof(gpu_cull_t));
+    if (!gpu_cull_supported() || bounds->count == 0) return false;
+
+    u32 count = bounds->count;
+    u32 slot_count = ms->mesh_count;
+    u32 *cmd_of = ALLOC(sizeof(u32) * slot_count, MEM_RENDER);
+    mesh_indirect_cmd_t *cmds =
+        ALLOC(sizeof(mesh_indirect_cmd_t) * slot_count, MEM_RENDER);
+    gpu_cull_object_t *objects =
+        ALLOC(sizeof(gpu_cull_object_t) * count, MEM_RENDER);
+
+    b8 ok = cmd_of && cmds && objects;
+    if (ok)
+    {
+        build_objects(gc, ms, bounds, meshes, cmd_of, cmds, objects);
+        u32 program = render_upload_compute("shaders/cull");
+        if (program) shader_sys_adopt(&gc->shader, program);
+        ok = program != 0;
+    }
+
+    if (ok)
+    {
+        gc->planes_name = shader_sys_name("planes");
+        gc->count_name = shader_sys_name("object_count");
+
+        u64 cmds_size = sizeof(mesh_indirect_cmd_t) * gc->cmd_count;
+        u64 instances_size = sizeof(render_instance_t) * count;
+        gc->objects = create_buffer(GL_SHADER_STORAGE_BUFFER,
+                                    sizeof(gpu_cull_object_t) * count,
+                                    objects, GL_STATIC_DRAW);
+        gc->instances = create_buffer(GL_SHADER_STORAGE_BUFFER,
+                                      instances_size, instances,
+                                      GL_STATIC_DRAW);
+        gc->templates = create_buffer(GL_COPY_READ_BUFFER, cmds_size, cmds,
+                                      GL_STATIC_DRAW);
+        gc->commands = create_buffer(GL_DRAW_INDIRECT_BUFFER, cmds_size,
+                                     NULL, GL_DYNAMIC_COPY);
+        gc->visible = create_buffer(GL_SHADER_STORAGE_BUFFER, instances_size,
+                                    NULL, GL_DYNAMIC_COPY);
+        gc->object_count = count;
+    }
+
+    if (cmd_of) FREE(cmd_of, sizeof(u32) * slot_count, MEM_RENDER);
+    if (cmds)
+        FREE(cmds, sizeof(mesh_indirect_cmd_t) * slot_count, MEM_RENDER);
+    if (objects)
+        FREE(objects, sizeof(gpu_cull_object_t) * count, MEM_RENDER);
+
+    if (!ok)
+    {
+        LOG_WARN("GPU cull: setup failed, use the CPU culler");
+        gpu_cull_destroy(gc);
+        return false;
+    }
+
+    LOG_INFO("GPU cull: %u objects, %u commands", count, gc->cmd_count);
+    return true;
+}
+
+void gpu_cull_destroy(gpu_cull_t *gc)
+{
+    if (gc->shader.program) shader_sys_release(&gc->shader);
+    if (gc->objects) gl_state_delete_buffer(gc->objects);
+    if (gc->instances) gl_state_delete_buffer(gc->instances);
+    if (gc->templates) gl_state_delete_buffer(gc->templates);
+    if (gc->commands) gl_state_delete_buffer(gc->commands);
+    if (gc->visible) gl_state_delete_buffer(gc->visible);
+    memset(gc, 0, sizeof(gpu_cull_t));
+}
+
+void gpu_cull_dispatch(gpu_cull_t *gc, const frustum *f)
+{
+    if (!gc->shader.program) return;
+
+    // zero the instance counts on the GPU, no sync with last frame's draw
+    gl_state_bind_buffer(GL_COPY_READ_BUFFER, gc->templates);
+    gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, gc->commands);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        (GLsizeiptr)(sizeof(mesh_indirect_cmd_t) *
+                                     gc->cmd_count));
+
+    // only uploaded when the frustum moved, the count once
+    gl_state_use_program(gc->shader.program);
+    shader_sys_set_vec4s(&gc->shader, gc->planes_name, f->planes,
+                         FRUSTUM_PLANE_COUNT);
+    shader_sys_set_u32(&gc->shader, gc->count_name, gc->object_count);
+
+    gl_state_bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 0, gc->objects);
+    gl_state_bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 1, gc->instances);
+    gl_state_bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 2, gc->commands);
+    gl_state_bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 3, gc->visible);
+
+    u32 groups = (gc->object_count + GPU_CULL_GROUP_SIZE - 1) /
+                 GPU_CULL_GROUP_SIZE;
+    g_gl_ext.DispatchCompute(groups, 1, 1);
+
+    // the draw reads commands as indirect args and visible as attributes
+    g_gl_ext.MemoryBarrier(GL_COMMAND_BARRIER_BIT |
+                           GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
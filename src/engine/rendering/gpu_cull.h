@@ -0,0 +1,49 @@
+#ifndef GPU_CULL_H
+#define GPU_CULL_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/math/math_types.h"
+#include "engine/rendering/culling.h"
+#include "engine/rendering/mesh_system.h"
+#include "engine/rendering/render.h"
+#include "engine/rendering/shader_system.h"
+
+/*
+ * Compute shader culling of a static object set, GL 4.3+. Each mesh gets
+ * one indirect command with room for all of its objects; survivors are
+ * appended with an atomic on the command's instance count, so visibility
+ * never comes back to the CPU. Without compute use cull_spheres_frustum.
+ */
+
+#define GPU_CULL_GROUP_SIZE 64 // local_size_x in cull.comp.glsl
+
+typedef struct {
+    shader_t shader; // program is 0 when setup failed
+    u32 planes_name;
+    u32 count_name;
+
+    u32 objects;   // sphere + command index per object
+    u32 instances; // source render_instance_t per object
+    u32 templates; // commands with zero instances, copied in each frame
+    u32 commands;  // indirect buffer written by the pass
+    u32 visible;   // compacted instances, read as instance attributes
+
+    u32 object_count;
+    u32 cmd_count;
+} gpu_cull_t;
+
+b8 gpu_cull_supported(void);
+
+// Uploads the objects once, object i is drawn with meshes[i] and
+// instances[i] when bounds entry i is visible
+b8 gpu_cull_create(gpu_cull_t *gc, const mesh_system_t *ms,
+                   const cull_spheres_t *bounds,
+                   const render_instance_t *instances,
+                   const mesh_handle_t *meshes);
+
+void gpu_cull_destroy(gpu_cull_t *gc);
+
+// Resets the commands and runs the pass, draws after this see the result
+void gpu_cull_dispatch(gpu_cull_t *gc, const frustum *f);
+
+#endif // GPU_CULL_H
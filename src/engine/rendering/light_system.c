@@ -0,0 +1,309 @@
+#include "light_system.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_state.h"
+#include "engine/rendering/render.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <string.h>
+
+#define LIGHT_TILE_COUNT (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y)
+
+enum {
+    LIGHT_BUFFER_DATA,
+    LIGHT_BUFFER_CLUSTERS,
+    LIGHT_BUFFER_INDICES,
+    LIGHT_BUFFER_COUNT
+};
+
+static light_system_t *g_ls = NULL;
+
+static const u32 g_units[LIGHT_BUFFER_COUNT] = {
+    TEX_UNIT_LIGHT_DATA, TEX_UNIT_LIGHT_CLUSTERS, TEX_UNIT_LIGHT_INDICES};
+static const GLenum g_formats[LIGHT_BUFFER_COUNT] = {GL_RGBA32F, GL_RG32UI,
+                                                     GL_R16UI};
+
+// View space point at depth in front of the camera, on the ray through
+// ndc x, y. Works for either projection.
+static vec3 unproject(mat4 inv_proj, f32 x, f32 y, f32 depth)
+{
+    vec4 a = mat4_mul_vec4(inv_proj, vec4_create(x, y, -1.0f, 1.0f));
+    vec4 b = mat4_mul_vec4(inv_proj, vec4_create(x, y, 1.0f, 1.0f));
+    vec3 n = vec3_create(a.x / a.w, a.y / a.w, a.z / a.w);
+    vec3 f = vec3_create(b.x / b.w, b.y / b.w, b.z / b.w);
+    return vec3_lerp(n, f, (-depth - n.z) / (f.z - n.z));
+}
+
+static void build_bounds(light_system_t *ls, const camera_t *cam)
+{
+    mat4 inv = mat4_inverse(cam->proj);
+    f32 ratio = cam->far / cam->near;
+    f32 log_ratio = m_log(ratio);
+    ls->slice_scale = (f32)LIGHT_CLUSTER_Z / log_ratio;
+    ls->slice_bias = -(f32)LIGHT_CLUSTER_Z * m_log(cam->near) / log_ratio;
+
+    ls->bounds.count = 0;
+    for (u32 z = 0; z < LIGHT_CLUSTER_Z; z++)
+    {
+        f32 depth[2] = {
+            cam->near * m_pow(ratio, (f32)z / LIGHT_CLUSTER_Z),
+            cam->near * m_pow(ratio, (f32)(z + 1) / LIGHT_CLUSTER_Z)};
+        for (u32 y = 0; y < LIGHT_CLUSTER_Y; y++)
+        {
+            f32 ndc_y[2] = {-1.0f + 2.0f * (f32)y / LIGHT_CLUSTER_Y,
+                            -1.0f + 2.0f * (f32)(y + 1) / LIGHT_CLUSTER_Y};
+            for (u32 x = 0; x < LIGHT_CLUSTER_X; x++)
+            {
+                f32 ndc_x[2] = {-1.0f + 2.0f * (f32)x / LIGHT_CLUSTER_X,
+                                -1.0f + 2.0f * (f32)(x + 1) / LIGHT_CLUSTER_X};
+
+                // the 8 corners of the frustum slice the cluster covers
+                aabb box = {.min = vec3_create(1e30f, 1e30f, 1e30f),
+                            .max = vec3_create(-1e30f, -1e30f, -1e30f)};
+                for (u32 c = 0; c < 8; c++)
+                {
+                    vec3 p = unproject(inv, ndc_x[c & 1], ndc_y[(c >> 1) & 1],
+                                       depth[c >> 2]);
+                    box.min = vec3_create(MIN(box.min.x, p.x),
+                                          MIN(box.min.y, p.y),
+                                          MIN(box.min.z, p.z));
+                    box.max = vec3_create(MAX(box.max.x, p.x),
+                                          MAX(box.max.y, p.y),
+                                          MAX(box.max.z, p.z));
+                }
+                cull_aabbs_push(&ls->bounds, box);
+            }
+        }
+    }
+    ls->bounds_proj = cam->proj;
+}
+
+static u32 slice_of(const light_system_t *ls, f32 depth)
+{
+    f32 slice = m_log(depth) * ls->slice_scale + ls->slice_bias;
+    f32 clamped = CLAMP(slice, 0.0f, (f32)(LIGHT_CLUSTER_Z - 1));
+    return (u32)clamped;
+}
+
+static void upload(light_system_t *ls, u32 buffer, const void *data,
+                   u64 size)
+{
+    gl_state_bind_buffer(GL_TEXTURE_BUFFER, ls->buffers[buffer]);
+    // orphaned, draws still reading last frame's lists keep their copy. An
+    // empty buffer can't back a texture, keep at least one texel.
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)MAX(size, 16), NULL,
+                 GL_STREAM_DRAW);
+    if (size) glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)size, data);
+}
+
+light_system_t *light_sys_init(arena_alloc_t *arena)
+{
+    light_system_t *ls = arena_alloc(arena, sizeof(light_system_t));
+    if (!ls) return NULL;
+    memset(ls, 0, sizeof(light_system_t));
+    ls->arena = arena;
+    ls->ambient = vec3_create(0.05f, 0.05f, 0.05f);
+
+    ls->lights = ALLOC(sizeof(point_light_t) * LIGHT_SYS_MAX_LIGHTS,
+                       MEM_RENDER);
+    ls->alive = ALLOC(sizeof(b8) * LIGHT_SYS_MAX_LIGHTS, MEM_RENDER);
+    ls->free_slots = ALLOC(sizeof(u32) * LIGHT_SYS_MAX_LIGHTS, MEM_RENDER);
+    ls->hits = ALLOC(sizeof(u32) * LIGHT_TILE_COUNT, MEM_RENDER);
+    ls->pairs = ALLOC(sizeof(u32) * LIGHT_MAX_REFERENCES, MEM_RENDER);
+    ls->clusters = ALLOC(sizeof(u32) * 2 * LIGHT_CLUSTER_COUNT, MEM_RENDER);
+    ls->indices = ALLOC(sizeof(u16) * LIGHT_MAX_REFERENCES, MEM_RENDER);
+    ls->gpu_lights =
+        ALLOC(sizeof(vec4) * 2 * LIGHT_SYS_MAX_LIGHTS, MEM_RENDER);
+    if (!ls->lights || !ls->alive || !ls->free_slots || !ls->hits ||
+        !ls->pairs || !ls->clusters || !ls->indices || !ls->gpu_lights ||
+        !cull_aabbs_create(&ls->bounds, LIGHT_CLUSTER_COUNT))
+    {
+        LOG_ERROR("light system: out of memory");
+        return NULL;
+    }
+
+    glGenBuffers(LIGHT_BUFFER_COUNT, ls->buffers);
+    glGenTextures(LIGHT_BUFFER_COUNT, ls->textures);
+    for (u32 i = 0; i < LIGHT_BUFFER_COUNT; i++)
+    {
+        upload(ls, i, NULL, 0);
+        gl_state_bind_texture(g_units[i], GL_TEXTURE_BUFFER, ls->textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, g_formats[i], ls->buffers[i]);
+    }
+
+    g_ls = ls;
+    LOG_INFO("Light System Init (%ux%ux%u clusters)", LIGHT_CLUSTER_X,
+             LIGHT_CLUSTER_Y, LIGHT_CLUSTER_Z);
+    return ls;
+}
+
+void light_sys_kill(light_system_t *ls)
+{
+    if (!g_ls) return;
+
+    for (u32 i = 0; i < LIGHT_BUFFER_COUNT; i++)
+    {
+        gl_state_delete_texture(ls->textures[i]);
+        gl_state_delete_buffer(ls->buffers[i]);
+    }
+    cull_aabbs_destroy(&ls->bounds);
+
+    FREE(ls->lights, sizeof(point_light_t) * LIGHT_SYS_MAX_LIGHTS,
+         MEM_RENDER);
+    FREE(ls->alive, sizeof(b8) * LIGHT_SYS_MAX_LIGHTS, MEM_RENDER);
+    FREE(ls->free_slots, sizeof(u32) * LIGHT_SYS_MAX_LIGHTS, MEM_RENDER);
+    FREE(ls->hits, sizeof(u32) * LIGHT_TILE_COUNT, MEM_RENDER);
+    FREE(ls->pairs, sizeof(u32) * LIGHT_MAX_REFERENCES, MEM_RENDER);
+    FREE(ls->clusters, sizeof(u32) * 2 * LIGHT_CLUSTER_COUNT, MEM_RENDER);
+    FREE(ls->indices, sizeof(u16) * LIGHT_MAX_REFERENCES, MEM_RENDER);
+    FREE(ls->gpu_lights, sizeof(vec4) * 2 * LIGHT_SYS_MAX_LIGHTS,
+         MEM_RENDER);
+
+    memset(ls, 0, sizeof(light_system_t));
+    g_ls = NULL;
+    LOG_INFO("Light System Kill");
+}
+
+light_handle_t light_sys_add(light_system_t *ls, point_light_t light)
+{
+    u32 slot;
+    if (ls->free_count) slot = ls->free_slots[--ls->free_count];
+    else if (ls->slot_count < LIGHT_SYS_MAX_LIGHTS) slot = ls->slot_count++;
+    else
+    {
+        LOG_WARN("light system: more than %d lights", LIGHT_SYS_MAX_LIGHTS);
+        return INVALID_32;
+    }
+
+    ls->lights[slot] = light;
+    ls->alive[slot] = true;
+    ls->stats.lights++;
+    return slot;
+}
+
+void light_sys_remove(light_system_t *ls, light_handle_t light)
+{
+    if (light >= ls->slot_count || !ls->alive[light]) return;
+    ls->alive[light] = false;
+    ls->free_slots[ls->free_count++] = light;
+    ls->stats.lights--;
+}
+
+point_light_t *light_sys_get(light_system_t *ls, light_handle_t light)
+{
+    if (light >= ls->slot_count || !ls->alive[light]) return NULL;
+    return &ls->lights[light];
+}
+
+void light_sys_update(light_system_t *ls, const camera_t *cam, u32 width,
+                      u32 height)
+{
+    if (ls->bounds.count == 0 ||
+        memcmp(&ls->bounds_proj, &cam->proj, sizeof(mat4)) != 0)
+        build_bounds(ls, cam);
+    ls->width = width;
+    ls->height = height;
+
+    // (cluster, light) pairs, in light order
+    u32 visible = 0;
+    u32 refs = 0;
+    u32 dropped = 0;
+    for (u32 i = 0; i < ls->slot_count; i++)
+    {
+        if (!ls->alive[i]) continue;
+        const point_light_t *light = &ls->lights[i];
+        vec3 p = mat4_mul_vec3(cam->view, light->position);
+        f32 r = light->radius;
+        f32 depth = -p.z;
+        if (depth + r < cam->near || depth - r > cam->far) continue;
+
+        u32 first = slice_of(ls, MAX(depth - r, cam->near));
+        u32 last = slice_of(ls, MIN(depth + r, cam->far));
+        u32 hit_count = 0;
+        for (u32 z = first; z <= last; z++)
+        {
+            u32 begin = z * LIGHT_TILE_COUNT;
+            u32 n = cull_aabbs_sphere(&ls->bounds, begin,
+                                      begin + LIGHT_TILE_COUNT, p, r,
+                                      ls->hits);
+            for (u32 k = 0; k < n; k++)
+            {
+                if (refs == LIGHT_MAX_REFERENCES)
+                {
+                    dropped++;
+                    continue;
+                }
+                ls->pairs[refs++] = ls->hits[k] << 16 | visible;
+            }
+            hit_count += n;
+        }
+        if (hit_count == 0) continue;
+
+        vec3 w = light->position;
+        vec3 c = vec3_scale(light->color, light->intensity);
+        ls->gpu_lights[visible * 2] = vec4_create(w.x, w.y, w.z, r);
+        ls->gpu_lights[visible * 2 + 1] = vec4_create(c.x, c.y, c.z, 0.0f);
+        visible++;
+    }
+
+    // counting sort into one contiguous list per cluster
+    u32 *clusters = ls->clusters;
+    memset(clusters, 0, sizeof(u32) * 2 * LIGHT_CLUSTER_COUNT);
+    for (u32 k = 0; k < refs; k++) clusters[(ls->pairs[k] >> 16) * 2 + 1]++;
+
+    u32 offset = 0;
+    u32 max_count = 0;
+    for (u32 c = 0; c < LIGHT_CLUSTER_COUNT; c++)
+    {
+        u32 count = clusters[c * 2 + 1];
+        clusters[c * 2] = offset;
+        clusters[c * 2 + 1] = 0; // counted up again by the scatter
+        offset += count;
+        max_count = MAX(max_count, count);
+    }
+    for (u32 k = 0; k < refs; k++)
+    {
+        u32 c = ls->pairs[k] >> 16;
+        ls->indices[clusters[c * 2] + clusters[c * 2 + 1]++] =
+            (u16)(ls->pairs[k] & 0xFFFF);
+    }
+
+    upload(ls, LIGHT_BUFFER_DATA, ls->gpu_lights,
+           sizeof(vec4) * 2 * visible);
+    upload(ls, LIGHT_BUFFER_CLUSTERS, clusters,
+           sizeof(u32) * 2 * LIGHT_CLUSTER_COUNT);
+    upload(ls, LIGHT_BUFFER_INDICES, ls->indices, sizeof(u16) * refs);
+
+    if (dropped && !ls->stats.dropped)
+    {
+        LOG_WARN("light system: %u cluster references past %d dropped",
+                 dropped, LIGHT_MAX_REFERENCES);
+    }
+    ls->stats.visible = visible;
+    ls->stats.references = refs;
+    ls->stats.dropped = dropped;
+    ls->stats.max_per_cluster = max_count;
+}
+
+void light_sys_frame(const light_system_t *ls, render_frame_t *frame)
+{
+    frame->ambient = ls->ambient;
+    frame->cluster_scale =
+        vec4_create((f32)LIGHT_CLUSTER_X / (f32)MAX(ls->width, 1u),
+                    (f32)LIGHT_CLUSTER_Y / (f32)MAX(ls->height, 1u),
+                    ls->slice_scale, ls->slice_bias);
+    frame->cluster_dims[0] = LIGHT_CLUSTER_X;
+    frame->cluster_dims[1] = LIGHT_CLUSTER_Y;
+    frame->cluster_dims[2] = LIGHT_CLUSTER_Z;
+    frame->light_count = ls->stats.visible;
+}
+
+void light_sys_bind(light_system_t *ls)
+{
+    for (u32 i = 0; i < LIGHT_BUFFER_COUNT; i++)
+        gl_state_bind_texture(g_units[i], GL_TEXTURE_BUFFER, ls->textures[i]);
+}
+
+light_system_t *get_light_system(void) { return g_ls; }
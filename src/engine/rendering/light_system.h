@@ -0,0 +1,111 @@
+#ifndef LIGHT_SYSTEM_H
+#define LIGHT_SYSTEM_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/math/math_types.h"
+#include "engine/core/memory/arena.h"
+#include "engine/rendering/camera_system.h"
+#include "engine/rendering/culling.h"
+#include "engine/rendering/render_queue.h"
+
+/*
+ * Clustered forward lighting. The view frustum is cut into
+ * LIGHT_CLUSTER_X x LIGHT_CLUSTER_Y screen tiles and LIGHT_CLUSTER_Z depth
+ * slices, exponentially spaced between the camera's near and far planes so
+ * clusters stay roughly cubic. Every frame each point light is tested
+ * against the view space bounds of the clusters in the slices its sphere
+ * spans (cull_aabbs_sphere, SIMD) and the hits are sorted into one light
+ * index list per cluster.
+ *
+ * Three texture buffers carry the result to common/lighting.glsl: the
+ * lights, an offset and count per cluster, and the index lists. A fragment
+ * finds its cluster from gl_FragCoord and its view depth and only shades
+ * the lights listed there.
+ */
+
+#define LIGHT_SYS_MAX_LIGHTS 1024
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+#define LIGHT_CLUSTER_COUNT                                                   \
+    (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z)
+#define LIGHT_MAX_REFERENCES (64 * 1024) // index list entries, u16 each
+
+typedef u32 light_handle_t; // INVALID_32 for none
+
+typedef struct {
+    vec3 position; // world space
+    f32 radius;    // no light reaches past it
+    vec3 color;    // linear, scaled by intensity
+    f32 intensity;
+} point_light_t;
+
+typedef struct {
+    u32 lights;     // added
+    u32 visible;    // touching at least one cluster
+    u32 references; // entries in the index lists
+    u32 dropped;    // references past LIGHT_MAX_REFERENCES
+    u32 max_per_cluster;
+} light_stats_t;
+
+typedef struct {
+    arena_alloc_t *arena;
+
+    point_light_t *lights; // LIGHT_SYS_MAX_LIGHTS slots
+    b8 *alive;
+    u32 *free_slots;
+    u32 free_count;
+    u32 slot_count; // slots handed out so far, free or not
+    vec3 ambient;
+
+    // view space cluster bounds, index (z * Y + y) * X + x. Rebuilt when
+    // the projection changes.
+    cull_aabbs_t bounds;
+    mat4 bounds_proj;
+    f32 slice_scale; // slice = log(depth) * scale + bias
+    f32 slice_bias;
+    u32 width;
+    u32 height;
+
+    // per frame scratch
+    u32 *hits;       // LIGHT_CLUSTER_X * Y
+    u32 *pairs;      // cluster << 16 | light, LIGHT_MAX_REFERENCES
+    u32 *clusters;   // offset and count, LIGHT_CLUSTER_COUNT pairs
+    u16 *indices;    // LIGHT_MAX_REFERENCES
+    vec4 *gpu_lights; // position and radius, color; per visible light
+
+    // GL_TEXTURE_BUFFER views of light_data, light_clusters and
+    // light_indices
+    u32 buffers[3];
+    u32 textures[3];
+
+    light_stats_t stats;
+} light_system_t;
+
+light_system_t *light_sys_init(arena_alloc_t *arena);
+
+void light_sys_kill(light_system_t *ls);
+
+// INVALID_32 when all LIGHT_SYS_MAX_LIGHTS are in use
+light_handle_t light_sys_add(light_system_t *ls, point_light_t light);
+
+void light_sys_remove(light_system_t *ls, light_handle_t light);
+
+// Edit in place, moves are picked up by the next update. NULL for a
+// removed light.
+point_light_t *light_sys_get(light_system_t *ls, light_handle_t light);
+
+// Assigns the lights to clusters and uploads the lists. Once per frame,
+// after the camera moved and before the frame block is streamed.
+void light_sys_update(light_system_t *ls, const camera_t *cam, u32 width,
+                      u32 height);
+
+// The frame block fields the cluster lookup needs
+void light_sys_frame(const light_system_t *ls, render_frame_t *frame);
+
+// Binds the texture buffers to their TEX_UNIT_LIGHT_* units
+void light_sys_bind(light_system_t *ls);
+
+light_system_t *get_light_system(void);
+
+#endif // LIGHT_SYSTEM_H
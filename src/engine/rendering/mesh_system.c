@@ -0,0 +1,378 @@
+#include "mesh_system.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_ext.h"
+#include "engine/rendering/gl_state.h"
+#include "engine/rendering/render.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <string.h>
+
+static mesh_system_t *g_ms = NULL;
+
+// Vertex attributes of the shared VAO, needs it bound
+static void point_vertex_attribs(mesh_system_t *ms)
+{
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, ms->vbo);
+    glVertexAttribPointer(ATTR_POSITION, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(vertex), (void *)OFFSETOF(vertex, position));
+    glVertexAttribPointer(ATTR_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(vertex),
+                          (void *)OFFSETOF(vertex, normal));
+    glVertexAttribPointer(ATTR_TEXCOORD, 2, GL_FLOAT, GL_FALSE,
+                          sizeof(vertex), (void *)OFFSETOF(vertex, texcoord));
+}
+
+static void point_instance_attribs(u32 buffer, u64 base)
+{
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, buffer);
+    for (u32 i = 0; i < 4; i++)
+    {
+        u64 offset = base + OFFSETOF(render_instance_t, model) +
+                     i * sizeof(vec4);
+        glVertexAttribPointer(ATTR_INSTANCE_MODEL + i, 4, GL_FLOAT, GL_FALSE,
+                              sizeof(render_instance_t), (void *)offset);
+    }
+    glVertexAttribPointer(
+        ATTR_INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(render_instance_t),
+        (void *)(base + OFFSETOF(render_instance_t, color)));
+    glVertexAttribPointer(
+        ATTR_INSTANCE_UV_RECT, 4, GL_FLOAT, GL_FALSE,
+        sizeof(render_instance_t),
+        (void *)(base + OFFSETOF(render_instance_t, uv_rect)));
+    glVertexAttribPointer(
+        ATTR_INSTANCE_LAYER, 1, GL_FLOAT, GL_FALSE, sizeof(render_instance_t),
+        (void *)(base + OFFSETOF(render_instance_t, layer)));
+}
+
+// Copies the old contents into a buffer of new_bytes and frees the old one
+static u32 grow_buffer(u32 old, u64 old_bytes, u64 new_bytes)
+{
+    u32 buffer;
+    glGenBuffers(1, &buffer);
+    gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)new_bytes, NULL,
+                 GL_STATIC_DRAW);
+
+    gl_state_bind_buffer(GL_COPY_READ_BUFFER, old);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        (GLsizeiptr)old_bytes);
+    gl_state_delete_buffer(old);
+    return buffer;
+}
+
+static b8 reserve_vertices(mesh_system_t *ms, u32 count)
+{
+    offset_alloc_t *oa = &ms->vertex_ranges;
+    if (offset_alloc_largest_free(oa) >= count) return true;
+
+    u32 size = offset_alloc_grow_size(oa, count);
+
+    ms->vbo = grow_buffer(ms->vbo, (u64)oa->size * sizeof(vertex),
+                          (u64)size * sizeof(vertex));
+    gl_state_bind_vao(ms->vao);
+    point_vertex_attribs(ms);
+
+    LOG_DEBUG("mesh system: vertex buffer %u -> %u", oa->size, size);
+    if (!offset_alloc_grow(oa, size)) return false;
+    ASSERT(offset_alloc_largest_free(oa) >= count,
+           "mesh system: grown vertex buffer has no range for the mesh");
+    return true;
+}
+
+static b8 reserve_indices(mesh_system_t *ms, u32 count)
+{
+    offset_alloc_t *oa = &ms->index_ranges;
+    if (offset_alloc_largest_free(oa) >= count) return true;
+
+    u32 size = offset_alloc_grow_size(oa, count);
+
+    ms->ebo = grow_buffer(ms->ebo, (u64)oa->size * sizeof(u32),
+                          (u64)size * sizeof(u32));
+    gl_state_bind_vao(ms->vao);
+    gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ms->ebo);
+
+    LOG_DEBUG("mesh system: index buffer %u -> %u", oa->size, size);
+    if (!offset_alloc_grow(oa, size)) return false;
+    ASSERT(offset_alloc_largest_free(oa) >= count,
+           "mesh system: grown index buffer has no range for the mesh");
+    return true;
+}
+
+static u32 take_slot(mesh_system_t *ms)
+{
+    if (ms->free_count) return ms->free_slots[--ms->free_count];
+
+    if (ms->mesh_count == ms->mesh_capacity)
+    {
+        u32 capacity = MAX(ms->mesh_capacity * 2, 64u);
+        internal_geo_t *meshes =
+            ALLOC(sizeof(internal_geo_t) * capacity, MEM_RENDER);
+        u32 *slots = ALLOC(sizeof(u32) * capacity, MEM_RENDER);
+        if (!meshes || !slots)
+        {
+            if (meshes)
+                FREE(meshes, sizeof(internal_geo_t) * capacity, MEM_RENDER);
+            if (slots) FREE(slots, sizeof(u32) * capacity, MEM_RENDER);
+            return INVALID_32;
+        }
+
+        if (ms->meshes)
+        {
+            memcpy(meshes, ms->meshes,
+                   sizeof(internal_geo_t) * ms->mesh_count);
+            FREE(ms->meshes, sizeof(internal_geo_t) * ms->mesh_capacity,
+                 MEM_RENDER);
+            FREE(ms->free_slots, sizeof(u32) * ms->mesh_capacity,
+                 MEM_RENDER);
+        }
+        ms->meshes = meshes;
+        ms->free_slots = slots;
+        ms->mesh_capacity = capacity;
+    }
+    return ms->mesh_count++;
+}
+
+mesh_system_t *mesh_sys_init(arena_alloc_t *arena)
+{
+    mesh_system_t *ms = arena_alloc(arena, sizeof(mesh_system_t));
+    if (!ms) return NULL;
+    memset(ms, 0, sizeof(mesh_system_t));
+
+    ms->arena = arena;
+    if (!offset_alloc_create(&ms->vertex_ranges, MESH_SYS_VERTEX_CAPACITY) ||
+        !offset_alloc_create(&ms->index_ranges, MESH_SYS_INDEX_CAPACITY))
+    {
+        LOG_ERROR("mesh system: failed to create range allocators");
+        return NULL;
+    }
+
+    glGenVertexArrays(1, &ms->vao);
+    gl_state_bind_vao(ms->vao);
+
+    glGenBuffers(1, &ms->vbo);
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, ms->vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 (GLsizeiptr)(MESH_SYS_VERTEX_CAPACITY * sizeof(vertex)),
+                 NULL, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &ms->ebo);
+    gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ms->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 (GLsizeiptr)(MESH_SYS_INDEX_CAPACITY * sizeof(u32)), NULL,
+                 GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(ATTR_POSITION);
+    glEnableVertexAttribArray(ATTR_NORMAL);
+    glEnableVertexAttribArray(ATTR_TEXCOORD);
+    point_vertex_attribs(ms);
+
+    // instance attributes, advance once per instance. Seeded with a single
+    // identity instance so plain draws never read past the end.
+    render_instance_t identity = {
+        .model = mat4_identity(),
+        .color = vec4_create(1.0f, 1.0f, 1.0f, 1.0f),
+        .uv_rect = vec4_create(0.0f, 0.0f, 1.0f, 1.0f)};
+    glGenBuffers(1, &ms->instance_vbo);
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, ms->instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(render_instance_t), &identity,
+                 GL_STATIC_DRAW);
+
+    for (u32 loc = ATTR_INSTANCE_MODEL; loc <= ATTR_INSTANCE_LAYER; loc++)
+    {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+    mesh_sys_point_instances(ms, ms->instance_vbo, 0);
+
+    g_ms = ms;
+    LOG_INFO("Mesh System Init");
+    return ms;
+}
+
+void mesh_sys_kill(mesh_system_t *ms)
+{
+    if (!ms) return;
+
+    gl_state_delete_vao(ms->vao);
+    gl_state_delete_buffer(ms->vbo);
+    gl_state_delete_buffer(ms->ebo);
+    gl_state_delete_buffer(ms->instance_vbo);
+
+    if (ms->meshes)
+    {
+        FREE(ms->meshes, sizeof(internal_geo_t) * ms->mesh_capacity,
+             MEM_RENDER);
+        FREE(ms->free_slots, sizeof(u32) * ms->mesh_capacity, MEM_RENDER);
+    }
+    offset_alloc_destroy(&ms->vertex_ranges);
+    offset_alloc_destroy(&ms->index_ranges);
+
+    memset(ms, 0, sizeof(mesh_system_t));
+    g_ms = NULL;
+    LOG_INFO("Mesh System Kill");
+}
+
+mesh_handle_t mesh_sys_upload(mesh_system_t *ms, const render_geo_t *geo)
+{
+    ASSERT(geo->vert_size == geo->vert_count * sizeof(vertex),
+           "mesh_sys_upload: vertices must use the engine vertex layout");
+
+    if (!reserve_vertices(ms, geo->vert_count) ||
+        !reserve_indices(ms, geo->indices_count))
+    {
+        LOG_ERROR("mesh system: out of memory for %u vertices",
+                  geo->vert_count);
+        return INVALID_32;
+    }
+
+    u32 slot = take_slot(ms);
+    if (slot == INVALID_32) return INVALID_32;
+
+    u32 vert_offset = offset_alloc(&ms->vertex_ranges, geo->vert_count);
+    u32 ind_offset = offset_alloc(&ms->index_ranges, geo->indices_count);
+    if (vert_offset == INVALID_32 || ind_offset == INVALID_32)
+    {
+        // offset_free skips the INVALID_32 one
+        offset_free(&ms->vertex_ranges, vert_offset, geo->vert_count);
+        offset_free(&ms->index_ranges, ind_offset, geo->indices_count);
+        ms->free_slots[ms->free_count++] = slot;
+        LOG_ERROR("mesh system: no range for %u vertices, %u indices",
+                  geo->vert_count, geo->indices_count);
+        return INVALID_32;
+    }
+
+    internal_geo_t *mesh = &ms->meshes[slot];
+    mesh->vert_count = geo->vert_count;
+    mesh->vert_size = geo->vert_size;
+    mesh->vert_offset = vert_offset;
+    mesh->ind_count = geo->indices_count;
+    mesh->ind_size = geo->indices_size;
+    mesh->ind_offset = ind_offset;
+
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, ms->vbo);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    (GLintptr)((u64)mesh->vert_offset * sizeof(vertex)),
+                    geo->vert_size, geo->vertices);
+
+    // the element binding is VAO state
+    gl_state_bind_vao(ms->vao);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                    (GLintptr)((u64)mesh->ind_offset * sizeof(u32)),
+                    geo->indices_size, geo->indices);
+
+    return slot;
+}
+
+void mesh_sys_release(mesh_system_t *ms, mesh_handle_t mesh)
+{
+    if (mesh >= ms->mesh_count || ms->meshes[mesh].ind_count == 0) return;
+
+    internal_geo_t *geo = &ms->meshes[mesh];
+    offset_free(&ms->vertex_ranges, geo->vert_offset, geo->vert_count);
+    offset_free(&ms->index_ranges, geo->ind_offset, geo->ind_count);
+    memset(geo, 0, sizeof(internal_geo_t));
+
+    ms->free_slots[ms->free_count++] = mesh;
+}
+
+const internal_geo_t *mesh_sys_get(const mesh_system_t *ms,
+                                   mesh_handle_t mesh)
+{
+    if (mesh >= ms->mesh_count) return NULL;
+    return &ms->meshes[mesh];
+}
+
+void mesh_sys_bind(mesh_system_t *ms) { gl_state_bind_vao(ms->vao); }
+
+void mesh_sys_draw(mesh_system_t *ms, mesh_handle_t mesh)
+{
+    const internal_geo_t *geo = &ms->meshes[mesh];
+    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)geo->ind_count,
+                             GL_UNSIGNED_INT,
+                             (void *)((u64)geo->ind_offset * sizeof(u32)),
+                             (GLint)geo->vert_offset);
+}
+
+void mesh_sys_draw_instanced(mesh_system_t *ms, mesh_handle_t mesh,
+                             u32 count)
+{
+    const internal_geo_t *geo = &ms->meshes[mesh];
+    glDrawElementsInstancedBaseVertex(
+        GL_TRIANGLES, (GLsizei)geo->ind_count, GL_UNSIGNED_INT,
+        (void *)((u64)geo->ind_offset * sizeof(u32)), (GLsizei)count,
+        (GLint)geo->vert_offset);
+}
+
+u32 mesh_sys_build_cmds(const mesh_system_t *ms, const mesh_handle_t *meshes,
+                        u32 count, u32 first_instance,
+                        mesh_indirect_cmd_t *out)
+{
+    u32 written = 0;
+    mesh_handle_t run = INVALID_32;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        if (meshes[i] == run)
+        {
+            out[written - 1].instance_count++;
+            continue;
+        }
+
+        run = meshes[i];
+        const internal_geo_t *geo = &ms->meshes[run];
+        out[written++] = (mesh_indirect_cmd_t){
+            .count = geo->ind_count,
+            .instance_count = 1,
+            .first_index = geo->ind_offset,
+            .base_vertex = (i32)geo->vert_offset,
+            .base_instance = first_instance + i,
+        };
+    }
+    return written;
+}
+
+u32 mesh_sys_draw_indirect(mesh_system_t *ms, const mesh_indirect_cmd_t *cmds,
+                           u32 count, u32 indirect_buffer,
+                           u64 indirect_offset, u32 instance_buffer)
+{
+    if (count == 0) return 0;
+
+    if (indirect_buffer && g_gl_ext.multi_draw_indirect)
+    {
+        // base_instance offsets the instance fetch, attributes start at 0
+        mesh_sys_point_instances(ms, instance_buffer, 0);
+        gl_state_bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+        g_gl_ext.MultiDrawElementsIndirect(
+            GL_TRIANGLES, GL_UNSIGNED_INT, (void *)indirect_offset,
+            (GLsizei)count, sizeof(mesh_indirect_cmd_t));
+        return 1;
+    }
+
+    // 3.3 has no base instance, move the attributes instead
+    for (u32 i = 0; i < count; i++)
+    {
+        const mesh_indirect_cmd_t *cmd = &cmds[i];
+        mesh_sys_point_instances(
+            ms, instance_buffer,
+            (u64)cmd->base_instance * sizeof(render_instance_t));
+        glDrawElementsInstancedBaseVertex(
+            GL_TRIANGLES, (GLsizei)cmd->count, GL_UNSIGNED_INT,
+            (void *)((u64)cmd->first_index * sizeof(u32)),
+            (GLsizei)cmd->instance_count, cmd->base_vertex);
+    }
+    return count;
+}
+
+void mesh_sys_point_instances(mesh_system_t *ms, u32 buffer, u64 base)
+{
+    if (ms->instance_buffer == buffer && ms->instance_base == base) return;
+
+    gl_state_bind_vao(ms->vao);
+    point_instance_attribs(buffer, base);
+    ms->instance_buffer = buffer;
+    ms->instance_base = base;
+}
+
+mesh_system_t *get_mesh_system(void) { return g_ms; }
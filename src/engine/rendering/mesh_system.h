@@ -0,0 +1,111 @@
+#ifndef MESH_SYSTEM_H
+#define MESH_SYSTEM_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/memory/arena.h"
+#include "engine/core/memory/offset_alloc.h"
+
+/*
+ * All static geometry lives in one vertex and one index buffer behind a
+ * single VAO. A mesh is a handle to the vertex/index ranges it was given,
+ * drawn with the BaseVertex variants so indices stay mesh-local. Buffers
+ * double when full.
+ */
+
+#define MESH_SYS_VERTEX_CAPACITY (64 * 1024) // vertices
+#define MESH_SYS_INDEX_CAPACITY (256 * 1024) // u32 indices
+
+typedef u32 mesh_handle_t; // INVALID_32 for none
+
+typedef struct {
+    void *vertices;
+    u32 vert_count;
+    u32 vert_size;
+    void *indices;
+    u32 indices_count;
+    u32 indices_size;
+} render_geo_t;
+
+// Offsets are in elements of the shared buffers, sizes in bytes
+typedef struct {
+    u32 vert_count;
+    u32 vert_size;
+    u32 vert_offset;
+
+    u32 ind_count;
+    u32 ind_size;
+    u32 ind_offset;
+} internal_geo_t;
+
+// Layout of GL's DrawElementsIndirectCommand
+typedef struct {
+    u32 count;
+    u32 instance_count;
+    u32 first_index;
+    i32 base_vertex;
+    u32 base_instance;
+} mesh_indirect_cmd_t;
+
+typedef struct {
+    arena_alloc_t *arena;
+
+    u32 vao;
+    u32 vbo;
+    u32 ebo;
+    u32 instance_vbo; // single identity instance, see render.h
+    u32 instance_buffer; // what the instance attributes point at now
+    u64 instance_base;
+
+    offset_alloc_t vertex_ranges;
+    offset_alloc_t index_ranges;
+
+    internal_geo_t *meshes;
+    u32 mesh_count;
+    u32 mesh_capacity;
+
+    u32 *free_slots;
+    u32 free_count;
+} mesh_system_t;
+
+mesh_system_t *mesh_sys_init(arena_alloc_t *arena);
+
+void mesh_sys_kill(mesh_system_t *ms);
+
+// Vertices are in the engine vertex layout, indices are u32
+mesh_handle_t mesh_sys_upload(mesh_system_t *ms, const render_geo_t *geo);
+
+void mesh_sys_release(mesh_system_t *ms, mesh_handle_t mesh);
+
+const internal_geo_t *mesh_sys_get(const mesh_system_t *ms,
+                                   mesh_handle_t mesh);
+
+// Binds the shared VAO, draws below assume it is bound
+void mesh_sys_bind(mesh_system_t *ms);
+
+void mesh_sys_draw(mesh_system_t *ms, mesh_handle_t mesh);
+
+void mesh_sys_draw_instanced(mesh_system_t *ms, mesh_handle_t mesh,
+                             u32 count);
+
+// One command per run of equal handles in meshes, instance i of the input
+// is base instance first_instance + i. out needs room for count commands,
+// returns how many were written.
+u32 mesh_sys_build_cmds(const mesh_system_t *ms, const mesh_handle_t *meshes,
+                        u32 count, u32 first_instance,
+                        mesh_indirect_cmd_t *out);
+
+// Draws cmds with one glMultiDrawElementsIndirect when indirect_buffer is
+// set (cmds copied there at indirect_offset, cmds may then be NULL),
+// otherwise one draw per command. Instances come from instance_buffer.
+// Returns the draw calls.
+u32 mesh_sys_draw_indirect(mesh_system_t *ms, const mesh_indirect_cmd_t *cmds,
+                           u32 count, u32 indirect_buffer,
+                           u64 indirect_offset, u32 instance_buffer);
+
+// Re-points the instance attributes at render_instance_t data starting at
+// byte offset base of buffer
+void mesh_sys_point_instances(mesh_system_t *ms, u32 buffer, u64 base);
+
+mesh_system_t *get_mesh_system(void);
+
+#endif // MESH_SYSTEM_H
@@ -1,6 +1,11 @@
 #include "render.h"
-#include "engine/core/math/math_types.h"
-#include "engine/resource/resc_loader.h"
+#include "engine/core/paths.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_ext.h"
+#include "engine/rendering/gl_state.h"
+#include "engine/rendering/shader_cache.h"
+#include "engine/rendering/shader_source.h"
 
 #include "deps/glad/glad.h"
 
@@ -8,12 +13,18 @@
 #include <string.h>
 #include <stdio.h>
 
+// Status is only queried once the program is linked, asking right away
+// would wait for the driver's compiler
 static GLuint compile_shader(GLenum type, const char *src)
 {
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &src, NULL);
     glCompileShader(shader);
+    return shader;
+}
 
+static void log_compile_errors(GLuint shader)
+{
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success)
@@ -22,42 +33,6 @@ static GLuint compile_shader(GLenum type, const char *src)
         glGetShaderInfoLog(shader, 512, NULL, info);
         LOG_ERROR("Shader compile error: %s", info);
     }
-    return shader;
-}
-
-static void init_mesh(render_system_t *rs, render_mesh_t *mesh)
-{
-    if (mesh->vao != 0)
-    {
-        glDeleteVertexArrays(1, &mesh->vao);
-        glDeleteBuffers(1, &mesh->vbo);
-        glDeleteBuffers(1, &mesh->ebo);
-    }
-
-    glGenVertexArrays(1, &mesh->vao);
-    glBindVertexArray(mesh->vao);
-
-    glGenBuffers(1, &mesh->vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
-    glBufferData(GL_ARRAY_BUFFER, rs->geo->vert_size, rs->geo->vertices,
-                 GL_STATIC_DRAW);
-
-    glGenBuffers(1, &mesh->ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, rs->geo->indices_size,
-                 rs->geo->indices, GL_STATIC_DRAW);
-
-    // position attribute
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex),
-                          (void *)OFFSETOF(vertex, position));
-
-    // normal attribute
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex),
-                          (void *)OFFSETOF(vertex, position));
-
-    glBindVertexArray(0);
 }
 
 render_system_t *render_sys_init(arena_alloc_t *arena)
@@ -68,11 +43,6 @@ render_system_t *render_sys_init(arena_alloc_t *arena)
 
     rs->arena = arena;
     rs->cam = get_camera_system();
-    rs->rs_mesh = ALLOC(sizeof(render_mesh_t), MEM_RENDER);
-    rs->rs_quad = ALLOC(sizeof(render_mesh_t), MEM_RENDER);
-    rs->rs_light = ALLOC(sizeof(render_mesh_t), MEM_RENDER);
-
-    rs->geo = ALLOC(sizeof(render_geo_t), MEM_RENDER);
 
     // glad setup
     int version_glad = gladLoadGL();
@@ -81,24 +51,32 @@ render_system_t *render_sys_init(arena_alloc_t *arena)
         LOG_FATAL("Failed to initialize OpenGL context");
         return NULL;
     }
+    gl_state_init();
+    gl_ext_init();
+    shader_cache_init();
 
-    rs->current_fbo = 0;
-    rs->clear_color = (vec4){{0.0f, 0.0f, 0.0f, 1.0f}};
+    rs->meshes = mesh_sys_init(arena);
+    if (!rs->meshes)
+    {
+        LOG_FATAL("Failed to initialize mesh system");
+        return NULL;
+    }
+
+    rs->graph = render_graph_init(arena);
+    if (!rs->graph)
+    {
+        LOG_FATAL("Failed to initialize render graph");
+        return NULL;
+    }
 
-    // set renderpass
-    rs->main_pass = (render_pass_t){.fbo = rs->main_fbo,
-                                    .clear_color = rs->clear_color,
-                                    .clear_mask = GL_COLOR_BUFFER_BIT |
-                                                  GL_DEPTH_BUFFER_BIT};
-
-    glClearColor(rs->clear_color.r, rs->clear_color.g, rs->clear_color.b,
-                 rs->clear_color.a);
-    glViewport(0, 0, 1280, 720);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glFrontFace(GL_CCW);
-    glDepthFunc(GL_LESS);
+    // targets and clears are declared per pass on the graph
+    rs->clear_color = (vec4){{0.0f, 0.0f, 0.0f, 1.0f}};
+    gl_state_viewport(0, 0, 1280, 720);
+    gl_state_enable(GL_DEPTH_TEST, true);
+    gl_state_enable(GL_CULL_FACE, true);
+    gl_state_cull_face(GL_BACK);
+    gl_state_front_face(GL_CCW);
+    gl_state_depth_func(GL_LESS);
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
     // TODO: Temporary code start
@@ -216,15 +194,16 @@ render_system_t *render_sys_init(arena_alloc_t *arena)
     indcs[33] = 20; indcs[34] = 21; indcs[35] = 23; // second
     // clang-format on
 
-    rs->geo->vertices = vert;
-    rs->geo->vert_count = 24;
-    rs->geo->vert_size = rs->geo->vert_count * sizeof(vertex);
-    rs->geo->indices = indcs;
-    rs->geo->indices_count = 36;
-    rs->geo->indices_size = rs->geo->indices_count * sizeof(u32);
+    render_geo_t geo = {0};
+    geo.vertices = vert;
+    geo.vert_count = 24;
+    geo.vert_size = geo.vert_count * sizeof(vertex);
+    geo.indices = indcs;
+    geo.indices_count = 36;
+    geo.indices_size = geo.indices_count * sizeof(u32);
 
-    init_mesh(rs, rs->rs_mesh);
-    init_mesh(rs, rs->rs_light);
+    rs->rs_mesh = mesh_sys_upload(rs->meshes, &geo);
+    rs->rs_light = mesh_sys_upload(rs->meshes, &geo);
 
     vertex *qvert = ALLOC(sizeof(vertex) * 4, MEM_ARRAY);
     f32 size = 5.0f;
@@ -251,24 +230,37 @@ render_system_t *render_sys_init(arena_alloc_t *arena)
     qindcs[4] = 3;
     qindcs[5] = 1; // second
 
-    rs->geo->vertices = qvert;
-    rs->geo->vert_count = 4;
-    rs->geo->vert_size = rs->geo->vert_count * sizeof(vertex);
-    rs->geo->indices = qindcs;
-    rs->geo->indices_count = 6;
-    rs->geo->indices_size = rs->geo->indices_count * sizeof(u32);
+    geo.vertices = qvert;
+    geo.vert_count = 4;
+    geo.vert_size = geo.vert_count * sizeof(vertex);
+    geo.indices = qindcs;
+    geo.indices_count = 6;
+    geo.indices_size = geo.indices_count * sizeof(u32);
 
-    init_mesh(rs, rs->rs_quad);
+    rs->rs_quad = mesh_sys_upload(rs->meshes, &geo);
 
     // TODO: Temporary code end
 
     // world
     glGenBuffers(1, &rs->ubo_buffer);
-    glBindBuffer(GL_UNIFORM_BUFFER, rs->ubo_buffer);
+    gl_state_bind_buffer(GL_UNIFORM_BUFFER, rs->ubo_buffer);
     glBufferData(GL_UNIFORM_BUFFER, sizeof(render_ubo_t), NULL,
                  GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, rs->ubo_buffer);
+    gl_state_bind_buffer_base(GL_UNIFORM_BUFFER, UBO_BINDING_CAMERA,
+                              rs->ubo_buffer);
+    rs->ubo_version = INVALID_32;
+
+    // per frame data, see stream_buffer.h
+    stream_buffer_create(&rs->ubo_stream, GL_UNIFORM_BUFFER,
+                         RENDER_UBO_STREAM_SIZE, 0);
+    stream_buffer_create(&rs->instance_stream, GL_ARRAY_BUFFER,
+                         RENDER_INSTANCE_STREAM_SIZE,
+                         sizeof(render_instance_t));
+    if (g_gl_ext.multi_draw_indirect)
+    {
+        stream_buffer_create(&rs->indirect_stream, GL_DRAW_INDIRECT_BUFFER,
+                             RENDER_INDIRECT_STREAM_SIZE, 16);
+    }
 
     FREE(vert, sizeof(vertex), MEM_ARRAY);
     FREE(indcs, sizeof(u32), MEM_ARRAY);
@@ -284,56 +276,37 @@ void render_sys_kill(render_system_t *rs)
 {
     if (!rs) return;
 
-    // FREE(rs->geo->vertices, sizeof(vertex) * rs->geo->vert_count,
-    // MEM_ARRAY); FREE(rs->geo->indices, sizeof(u32) * rs->geo->indices_count,
-    // MEM_ARRAY);
-
-    glDeleteVertexArrays(1, &rs->rs_light->vao);
-    glDeleteBuffers(1, &rs->rs_light->vbo);
-    glDeleteBuffers(1, &rs->rs_light->ebo);
-
-    glDeleteVertexArrays(1, &rs->rs_quad->vao);
-    glDeleteBuffers(1, &rs->rs_quad->vbo);
-    glDeleteBuffers(1, &rs->rs_quad->ebo);
-
-    glDeleteVertexArrays(1, &rs->rs_mesh->vao);
-    glDeleteBuffers(1, &rs->rs_mesh->vbo);
-    glDeleteBuffers(1, &rs->rs_mesh->ebo);
+    if (rs->indirect_cmds)
+    {
+        FREE(rs->indirect_cmds,
+             sizeof(mesh_indirect_cmd_t) * rs->indirect_capacity,
+             MEM_RENDER);
+    }
+    stream_buffer_destroy(&rs->indirect_stream);
+    stream_buffer_destroy(&rs->instance_stream);
+    stream_buffer_destroy(&rs->ubo_stream);
+    gl_state_delete_buffer(rs->ubo_buffer);
 
-    FREE(rs->geo, sizeof(render_geo_t), MEM_RENDER);
-    FREE(rs->rs_light, sizeof(render_mesh_t), MEM_RENDER);
-    FREE(rs->rs_quad, sizeof(render_mesh_t), MEM_RENDER);
-    FREE(rs->rs_mesh, sizeof(render_mesh_t), MEM_RENDER);
+    render_graph_kill(rs->graph);
+    mesh_sys_kill(rs->meshes);
     memset(rs, 0, sizeof(render_system_t));
     LOG_INFO("Render System Kill");
 }
 
 void render_sys_begin(render_system_t *rs, u8 id)
 {
-    render_pass_t *pass = 0;
-
-    switch (id)
-    {
-    case WORLD_PASS: pass = &rs->main_pass; break;
-    case DEBUG_UI_PASS: break;
-    }
+    (void)id;
 
-    if (rs->current_fbo != pass->fbo)
+    // world, only when the camera moved since the last upload
+    camera_t *cam = &rs->cam->world;
+    if (rs->ubo_version != cam->version)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, pass->fbo);
-        rs->current_fbo = pass->fbo;
+        rs->ubo.proj = cam->proj;
+        rs->ubo.view = cam->view;
+        gl_state_bind_buffer(GL_UNIFORM_BUFFER, rs->ubo_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(render_ubo_t), &rs->ubo);
+        rs->ubo_version = cam->version;
     }
-
-    // world
-    glBindBuffer(GL_UNIFORM_BUFFER, rs->ubo_buffer);
-
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(mat4),
-                    rs->cam->world.proj.data);
-    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(mat4), sizeof(mat4),
-                    rs->cam->world.view.data);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-
-    glClear(pass->clear_mask);
 }
 
 void render_sys_end(render_system_t *rs, u8 id)
@@ -350,83 +323,269 @@ void render_sys_update(render_system_t *rs, f64 delta)
 
 void render_draw(render_system_t *rs)
 {
-    glBindVertexArray(rs->rs_mesh->vao);
-    glDrawElements(GL_TRIANGLES, (int)rs->geo->indices_count, GL_UNSIGNED_INT,
-                   0);
-
-    glBindVertexArray(rs->rs_quad->vao);
-    glDrawElements(GL_TRIANGLES, (int)rs->geo->indices_count, GL_UNSIGNED_INT,
-                   0);
-    glBindVertexArray(0);
+    mesh_sys_bind(rs->meshes);
+    mesh_sys_draw(rs->meshes, rs->rs_mesh);
+    mesh_sys_draw(rs->meshes, rs->rs_quad);
 }
 
 void render_light(render_system_t *rs)
 {
-    glBindVertexArray(rs->rs_light->vao);
-    glDrawElements(GL_TRIANGLES, (int)rs->geo->indices_count, GL_UNSIGNED_INT,
-                   0);
-    glBindVertexArray(0);
+    mesh_sys_bind(rs->meshes);
+    mesh_sys_draw(rs->meshes, rs->rs_light);
 }
 
-u32 render_upload_shader(const char *name)
+void render_sys_frame_begin(render_system_t *rs)
+{
+    stream_buffer_begin_frame(&rs->ubo_stream);
+    stream_buffer_begin_frame(&rs->instance_stream);
+    if (rs->indirect_stream.buffer)
+        stream_buffer_begin_frame(&rs->indirect_stream);
+}
+
+void render_sys_frame_end(render_system_t *rs)
+{
+    stream_buffer_end_frame(&rs->ubo_stream);
+    stream_buffer_end_frame(&rs->instance_stream);
+    if (rs->indirect_stream.buffer)
+        stream_buffer_end_frame(&rs->indirect_stream);
+}
+
+b8 render_stream_instances(render_system_t *rs,
+                           const render_instance_t *instances, u32 count,
+                           u64 *out_offset)
+{
+    u64 size = (u64)count * sizeof(render_instance_t);
+    void *dst = stream_buffer_alloc(&rs->instance_stream, size, out_offset);
+    if (!dst) return false;
+
+    memcpy(dst, instances, size);
+    return true;
+}
+
+void render_draw_instanced_at(render_system_t *rs, mesh_handle_t mesh,
+                              u64 offset, u32 count)
 {
+    if (count == 0) return;
+
+    mesh_sys_point_instances(rs->meshes, rs->instance_stream.buffer, offset);
+    mesh_sys_bind(rs->meshes);
+    mesh_sys_draw_instanced(rs->meshes, mesh, count);
+}
+
+void render_draw_instanced(render_system_t *rs, mesh_handle_t mesh,
+                           const render_instance_t *instances, u32 count)
+{
+    u64 offset = 0;
+    if (count == 0 || !render_stream_instances(rs, instances, count, &offset))
+        return;
+
+    stream_buffer_flush(&rs->instance_stream);
+    render_draw_instanced_at(rs, mesh, offset, count);
+}
+
+static b8 reserve_indirect_cmds(render_system_t *rs, u32 count)
+{
+    if (count <= rs->indirect_capacity) return true;
+
+    u32 capacity = MAX(rs->indirect_capacity * 2, 256u);
+    while (capacity < count) capacity *= 2;
+
+    mesh_indirect_cmd_t *cmds =
+        ALLOC(sizeof(mesh_indirect_cmd_t) * capacity, MEM_RENDER);
+    if (!cmds) return false;
+
+    if (rs->indirect_cmds)
+    {
+        FREE(rs->indirect_cmds,
+             sizeof(mesh_indirect_cmd_t) * rs->indirect_capacity,
+             MEM_RENDER);
+    }
+    rs->indirect_cmds = cmds;
+    rs->indirect_capacity = capacity;
+    return true;
+}
+
+u32 render_draw_multi_at(render_system_t *rs, const mesh_handle_t *meshes,
+                         u32 count, u64 offset)
+{
+    if (count == 0 || !reserve_indirect_cmds(rs, count)) return 0;
+
+    u32 first = (u32)(offset / sizeof(render_instance_t));
+    u32 cmd_count = mesh_sys_build_cmds(rs->meshes, meshes, count, first,
+                                        rs->indirect_cmds);
+
+    u32 indirect = 0;
+    u64 indirect_offset = 0;
+    if (rs->indirect_stream.buffer)
+    {
+        u64 size = (u64)cmd_count * sizeof(mesh_indirect_cmd_t);
+        void *dst =
+            stream_buffer_alloc(&rs->indirect_stream, size, &indirect_offset);
+        if (dst)
+        {
+            memcpy(dst, rs->indirect_cmds, size);
+            stream_buffer_flush(&rs->indirect_stream);
+            indirect = rs->indirect_stream.buffer;
+        }
+    }
+
+    mesh_sys_bind(rs->meshes);
+    return mesh_sys_draw_indirect(rs->meshes, rs->indirect_cmds, cmd_count,
+                                  indirect, indirect_offset,
+                                  rs->instance_stream.buffer);
+}
+
+u32 render_draw_multi(render_system_t *rs, const mesh_handle_t *meshes,
+                      const render_instance_t *instances, u32 count)
+{
+    u64 offset = 0;
+    if (count == 0 || !render_stream_instances(rs, instances, count, &offset))
+        return 0;
+
+    stream_buffer_flush(&rs->instance_stream);
+    return render_draw_multi_at(rs, meshes, count, offset);
+}
+
+b8 render_shader_submit(const char *name, const char *defines,
+                        render_shader_job_t *job)
+{
+    memset(job, 0, sizeof(render_shader_job_t));
+    snprintf(job->name, sizeof(job->name), "%s", name);
+
     char vert_path[MAX_PATH];
     char frag_path[MAX_PATH];
     snprintf(vert_path, sizeof(vert_path), "%s.vert.glsl", name);
     snprintf(frag_path, sizeof(frag_path), "%s.frag.glsl", name);
 
     u64 vert_size = 0, frag_size = 0;
-    void *vert_src = read_file_text(vert_path, &vert_size);
-    void *frag_src = read_file_text(frag_path, &frag_size);
+    char *vert_src = shader_source_load(vert_path, defines, &vert_size);
+    char *frag_src = shader_source_load(frag_path, defines, &frag_size);
 
     if (!vert_src || !frag_src)
     {
         LOG_ERROR("Failed to load shader files: %s", name);
         if (vert_src) FREE(vert_src, vert_size, MEM_RESOURCE);
         if (frag_src) FREE(frag_src, frag_size, MEM_RESOURCE);
-        return 0;
+        return false;
     }
 
-    GLuint vert = compile_shader(GL_VERTEX_SHADER, vert_src);
-    GLuint frag = compile_shader(GL_FRAGMENT_SHADER, frag_src);
+    job->key = shader_cache_key_begin();
+    job->key = shader_cache_key_add(job->key, vert_src);
+    job->key = shader_cache_key_add(job->key, frag_src);
+    job->program = shader_cache_load(job->key);
+
+    if (!job->program)
+    {
+        job->vert = compile_shader(GL_VERTEX_SHADER, vert_src);
+        job->frag = compile_shader(GL_FRAGMENT_SHADER, frag_src);
+
+        job->program = glCreateProgram();
+        glAttachShader(job->program, job->vert);
+        glAttachShader(job->program, job->frag);
+        shader_cache_prepare(job->program);
+        glLinkProgram(job->program);
+    }
+
+    FREE(vert_src, vert_size, MEM_RESOURCE);
+    FREE(frag_src, frag_size, MEM_RESOURCE);
+    return true;
+}
+
+render_shader_status_t render_shader_poll(render_shader_job_t *job, b8 wait)
+{
+    if (!job->program) return RENDER_SHADER_FAILED;
+
+    // cache hits are linked already
+    if (!job->vert) return RENDER_SHADER_READY;
+
+    if (!wait && g_gl_ext.parallel_shader_compile)
+    {
+        GLint done = GL_FALSE;
+        glGetProgramiv(job->program, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done) return RENDER_SHADER_PENDING;
+    }
 
-    if (!vert || !frag)
+    GLint success;
+    glGetProgramiv(job->program, GL_LINK_STATUS, &success);
+    if (!success)
     {
-        LOG_ERROR("Failed to compile shaders: %s", name);
-        FREE(vert_src, vert_size, MEM_RESOURCE);
-        FREE(frag_src, frag_size, MEM_RESOURCE);
+        log_compile_errors(job->vert);
+        log_compile_errors(job->frag);
+
+        char info[512];
+        glGetProgramInfoLog(job->program, 512, NULL, info);
+        LOG_ERROR("Program link error (%s): %s", job->name, info);
+        glDeleteProgram(job->program);
+        job->program = 0;
+    }
+
+    glDeleteShader(job->vert);
+    glDeleteShader(job->frag);
+    job->vert = job->frag = 0;
+
+    if (!job->program) return RENDER_SHADER_FAILED;
+    shader_cache_store(job->key, job->program);
+    return RENDER_SHADER_READY;
+}
+
+void render_shader_cancel(render_shader_job_t *job)
+{
+    glDeleteShader(job->vert);
+    glDeleteShader(job->frag);
+    gl_state_delete_program(job->program);
+    job->vert = job->frag = job->program = 0;
+}
 
-        if (vert) glDeleteShader(vert);
-        if (frag) glDeleteShader(frag);
+u32 render_upload_shader(const char *name)
+{
+    render_shader_job_t job;
+    if (!render_shader_submit(name, NULL, &job)) return 0;
+    if (render_shader_poll(&job, true) != RENDER_SHADER_READY) return 0;
+    return job.program;
+}
+
+u32 render_upload_compute(const char *name)
+{
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s.comp.glsl", name);
+
+    u64 size = 0;
+    char *src = shader_source_load(path, NULL, &size);
+    if (!src)
+    {
+        LOG_ERROR("Failed to load compute shader: %s", name);
         return 0;
     }
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vert);
-    glAttachShader(program, frag);
+    u64 key = shader_cache_key_add(shader_cache_key_begin(), src);
+    GLuint program = shader_cache_load(key);
+    if (program)
+    {
+        FREE(src, size, MEM_RESOURCE);
+        return program;
+    }
+
+    GLuint comp = compile_shader(GL_COMPUTE_SHADER, src);
+    FREE(src, size, MEM_RESOURCE);
+
+    program = glCreateProgram();
+    glAttachShader(program, comp);
+    shader_cache_prepare(program);
     glLinkProgram(program);
 
-    // Check link status
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) log_compile_errors(comp);
+    glDeleteShader(comp);
     if (!success)
     {
         char info[512];
         glGetProgramInfoLog(program, 512, NULL, info);
         LOG_ERROR("Program link error: %s", info);
-
         glDeleteProgram(program);
-        glDeleteShader(vert);
-        glDeleteShader(frag);
-        FREE(vert_src, vert_size, MEM_RESOURCE);
-        FREE(frag_src, frag_size, MEM_RESOURCE);
         return 0;
     }
 
-    FREE(vert_src, vert_size, MEM_RESOURCE);
-    FREE(frag_src, frag_size, MEM_RESOURCE);
-    glDeleteShader(vert);
-    glDeleteShader(frag);
-
+    shader_cache_store(key, program);
     return program;
 }
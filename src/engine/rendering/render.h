@@ -4,75 +4,111 @@
 #include "engine/core/define.h" // IWYU pragma: keep
 #include "engine/core/memory/arena.h"
 #include "engine/rendering/camera_system.h"
+#include "engine/rendering/mesh_system.h"
+#include "engine/rendering/render_graph.h"
+#include "engine/rendering/stream_buffer.h"
 
-typedef enum { WORLD_PASS = 0x01, DEBUG_UI_PASS = 0x02 } render_layer_t;
+// Per region, STREAM_BUFFER_FRAMES regions each
+#define RENDER_UBO_STREAM_SIZE (256 * 1024)
+#define RENDER_INSTANCE_STREAM_SIZE (8 * 1024 * 1024)
+#define RENDER_INDIRECT_STREAM_SIZE (256 * 1024)
 
-typedef struct {
-    u32 fbo;
-    vec4 clear_color;
-    u32 clear_mask;
-} render_pass_t;
+typedef enum { WORLD_PASS = 0x01, DEBUG_UI_PASS = 0x02 } render_layer_t;
 
+// Vertex attribute slots, instance data starts after the per-vertex ones.
+// A mat4 takes four slots, one per column.
+enum {
+    ATTR_POSITION = 0,
+    ATTR_NORMAL = 1,
+    ATTR_COLOR = 1, // RGBA8 instead of a normal, debug_draw lines
+    ATTR_TEXCOORD = 2,
+    ATTR_INSTANCE_MODEL = 3,
+    ATTR_INSTANCE_COLOR = 7,
+    ATTR_INSTANCE_UV_RECT = 8,
+    ATTR_INSTANCE_LAYER = 9,
+};
+
+// Uniform block bindings shared by every shader
+enum {
+    UBO_BINDING_CAMERA = 0,
+    UBO_BINDING_OBJECT = 1,
+    UBO_BINDING_FRAME = 2,
+};
+
+// Texture units of samplers shared by every shader, set at link time
+enum {
+    TEX_UNIT_ALBEDO = 0,
+    TEX_UNIT_LIGHT_DATA = 1,
+    TEX_UNIT_LIGHT_CLUSTERS = 2,
+    TEX_UNIT_LIGHT_INDICES = 3,
+};
+
+// Per-instance data, streamed each frame through render_system_t. The
+// texture comes from the page bound for the draw, see texture_region_t;
+// a zeroed uv_rect samples one texel, white in the placeholder page.
+// Mirrored by the std430 struct instance in shaders/cull.comp.glsl.
 typedef struct {
-    u32 vao;
-    u32 vbo;
-    u32 ebo;
-    u32 index_count;
-} render_mesh_t;
+    mat4 model;
+    vec4 color;
+    vec4 uv_rect;
+    f32 layer;
+    f32 pad[3];
+} render_instance_t;
 
 typedef struct {
     mat4 proj;
     mat4 view;
 } render_ubo_t;
 
+// std140 object_block, one slice per draw
 typedef struct {
-    void *vertices;
-    u32 vert_count;
-    u32 vert_size;
-    void *indices;
-    u32 indices_count;
-    u32 indices_size;
-} render_geo_t;
-
+    mat4 model;
+    vec4 color;
+    vec4 uv_rect;
+    f32 layer;
+    f32 pad[3];
+} render_object_ubo_t;
+
+// std140 frame_block, vec3s padded to vec4
 typedef struct {
-    u32 vert_count;
-    u32 vert_size;
-    u32 vert_offset;
-
-    u32 ind_count;
-    u32 ind_size;
-    u32 ind_offset;
-} internal_geo_t;
+    vec4 view_pos;
+    vec4 ambient;
+    vec4 cluster_scale;
+    u32 cluster_dims[4]; // x, y, z and the light count
+} render_frame_ubo_t;
 
 typedef struct {
     arena_alloc_t *arena;
     camera_system_t *cam;
 
-    render_pass_t main_pass;
-    // render_pass_t test_pass;
-
-    u32 current_fbo;
     vec4 clear_color;
 
-    u32 main_fbo;
-    // u32 test_fbo;
+    // rebuilt every frame, see render_graph.h
+    render_graph_t *graph;
 
-    render_mesh_t *rs_mesh;
-    render_mesh_t *rs_quad;
-    render_mesh_t *rs_light;
+    mesh_system_t *meshes;
+    mesh_handle_t rs_mesh;
+    mesh_handle_t rs_quad;
+    mesh_handle_t rs_light;
 
     u32 ubo_buffer;
+    u32 ubo_version; // camera version last uploaded
     render_ubo_t ubo;
 
-    // TODO: temp vertex data
-    render_geo_t *geo;
+    stream_buffer_t ubo_stream;
+    stream_buffer_t instance_stream;
+    stream_buffer_t indirect_stream; // only with multi_draw_indirect
 
+    // multi draw commands are built here before they're streamed
+    mesh_indirect_cmd_t *indirect_cmds;
+    u32 indirect_capacity;
 } render_system_t;
 
 render_system_t *render_sys_init(arena_alloc_t *arena);
 
 void render_sys_kill(render_system_t *rs);
 
+// Per pass setup once its target is bound, e.g. the camera block
 void render_sys_begin(render_system_t *rs, u8 id);
 
 void render_sys_end(render_system_t *rs, u8 id);
@@ -83,6 +119,68 @@ void render_draw(render_system_t *rs);
 
 void render_light(render_system_t *rs); // NOTE: temp code.
 
+// Wraps all streamed uploads of a frame
+void render_sys_frame_begin(render_system_t *rs);
+
+void render_sys_frame_end(render_system_t *rs);
+
+// Copies instances into this frame's instance ring
+b8 render_stream_instances(render_system_t *rs,
+                           const render_instance_t *instances, u32 count,
+                           u64 *out_offset);
+
+// Draws count instances streamed at offset, flush the ring first
+void render_draw_instanced_at(render_system_t *rs, mesh_handle_t mesh,
+                              u64 offset, u32 count);
+
+// Streams the instances and draws them all with a single
+// glDrawElementsInstanced.
+void render_draw_instanced(render_system_t *rs, mesh_handle_t mesh,
+                           const render_instance_t *instances, u32 count);
+
+// Draws count instances streamed at offset, instance i with meshes[i].
+// Runs of equal meshes share a command and the whole list goes out as one
+// glMultiDrawElementsIndirect, or one draw per run on 3.3. Returns the
+// draw calls issued.
+u32 render_draw_multi_at(render_system_t *rs, const mesh_handle_t *meshes,
+                         u32 count, u64 offset);
+
+u32 render_draw_multi(render_system_t *rs, const mesh_handle_t *meshes,
+                      const render_instance_t *instances, u32 count);
+
+// A program in flight, see render_shader_submit
+typedef struct {
+    char name[64];
+    u32 program;
+    u32 vert; // 0 once linked or when loaded from the shader cache
+    u32 frag;
+    u64 key;
+} render_shader_job_t;
+
+typedef enum {
+    RENDER_SHADER_PENDING,
+    RENDER_SHADER_READY,
+    RENDER_SHADER_FAILED,
+} render_shader_status_t;
+
+// Starts compiling and linking name.vert/frag.glsl without checking any
+// status, so the driver can work on many programs at once. Sources go
+// through shader_source_load with defines, which may be NULL.
+b8 render_shader_submit(const char *name, const char *defines,
+                        render_shader_job_t *job);
+
+// Without wait, only returns READY or FAILED once the driver reports the
+// link done (KHR_parallel_shader_compile). Without the extension the
+// status query itself waits for the link.
+render_shader_status_t render_shader_poll(render_shader_job_t *job, b8 wait);
+
+// Drops a job that won't be polled again, with its program and shaders
+void render_shader_cancel(render_shader_job_t *job);
+
+// Submit and wait
 u32 render_upload_shader(const char *name);
 
+// Needs g_gl_ext.compute
+u32 render_upload_compute(const char *name);
+
 #endif // RENDERER_H
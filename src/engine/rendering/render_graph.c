@@ -0,0 +1,681 @@
+#include "render_graph.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_state.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <string.h>
+
+typedef struct {
+    GLenum internal;
+    GLenum format;
+    GLenum type;
+    GLenum attachment; // color formats add their index
+    u32 bytes;         // per pixel
+    const char *name;
+} rg_format_info_t;
+
+static const rg_format_info_t g_formats[RG_FORMAT_COUNT] = {
+    [RG_FORMAT_RGBA8] = {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+                         GL_COLOR_ATTACHMENT0, 4, "rgba8"},
+    [RG_FORMAT_RGBA16F] = {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT,
+                           GL_COLOR_ATTACHMENT0, 8, "rgba16f"},
+    [RG_FORMAT_DEPTH24_STENCIL8] = {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL,
+                                    GL_UNSIGNED_INT_24_8,
+                                    GL_DEPTH_STENCIL_ATTACHMENT, 4, "d24s8"},
+    [RG_FORMAT_DEPTH32F] = {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT,
+                            GL_FLOAT, GL_DEPTH_ATTACHMENT, 4, "d32f"},
+};
+
+static b8 is_depth(rg_format_t format)
+{
+    return g_formats[format].attachment != GL_COLOR_ATTACHMENT0;
+}
+
+render_graph_t *render_graph_init(arena_alloc_t *arena)
+{
+    render_graph_t *rg = arena_alloc(arena, sizeof(render_graph_t));
+    if (!rg) return NULL;
+    memset(rg, 0, sizeof(render_graph_t));
+
+    LOG_INFO("Render Graph Init");
+    return rg;
+}
+
+/*************************
+ * Pool
+ *************************/
+static void drop_framebuffer(render_graph_t *rg, u32 index)
+{
+    gl_state_delete_framebuffer(rg->framebuffers[index].id);
+    rg->framebuffers[index] = rg->framebuffers[--rg->framebuffer_count];
+}
+
+// Deletes the target's texture and every framebuffer it is attached to,
+// the slot stays
+static void delete_target(render_graph_t *rg, u32 index)
+{
+    u32 id = rg->targets[index].id;
+    for (u32 i = 0; i < rg->framebuffer_count;)
+    {
+        const rg_framebuffer_t *fb = &rg->framebuffers[i];
+        b8 attached = false;
+        for (u32 a = 0; a < RG_MAX_COLORS + 1; a++)
+            attached |= fb->attachments[a] == id;
+
+        if (attached)
+            drop_framebuffer(rg, i);
+        else
+            i++;
+    }
+    gl_state_delete_texture(id);
+    rg->targets[index].id = 0;
+}
+
+static void create_target(rg_target_t *target, const rg_texture_desc_t *desc)
+{
+    const rg_format_info_t *f = &g_formats[desc->format];
+    target->format = desc->format;
+    target->width = desc->width;
+    target->height = desc->height;
+
+    glGenTextures(1, &target->id);
+    gl_state_bind_texture(0, GL_TEXTURE_2D, target->id);
+    // NULL is an offset while an unpack buffer is bound
+    gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)f->internal, (GLsizei)desc->width,
+                 (GLsizei)desc->height, 0, f->format, f->type, NULL);
+
+    GLint filter = is_depth(desc->format) ? GL_NEAREST : GL_LINEAR;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    LOG_TRACE("render graph: new %ux%u %s target", desc->width,
+              desc->height, f->name);
+}
+
+// A free target of the same size and format, else a new one. A full pool
+// evicts a target this frame hasn't touched.
+static b8 acquire_target(render_graph_t *rg, rg_texture_t *tex)
+{
+    const rg_texture_desc_t *desc = &tex->desc;
+    u32 found = INVALID_32;
+    u32 idle = INVALID_32;
+    for (u32 i = 0; i < rg->target_count && found == INVALID_32; i++)
+    {
+        const rg_target_t *t = &rg->targets[i];
+        if (t->busy) continue;
+        if (t->format == desc->format && t->width == desc->width &&
+            t->height == desc->height)
+            found = i;
+        else if (t->last_frame != rg->frame && idle == INVALID_32)
+            idle = i;
+    }
+
+    if (found == INVALID_32)
+    {
+        if (rg->target_count < RG_MAX_TARGETS)
+        {
+            found = rg->target_count++;
+        }
+        else if (idle != INVALID_32)
+        {
+            found = idle;
+            delete_target(rg, found);
+        }
+        else
+        {
+            LOG_ERROR("render graph: no target left for %s", tex->name);
+            return false;
+        }
+        create_target(&rg->targets[found], desc);
+    }
+
+    rg->targets[found].busy = true;
+    rg->targets[found].last_frame = rg->frame;
+    tex->target = found;
+    return true;
+}
+
+// Cached by attachment set. 0 when incomplete or the cache is full of
+// framebuffers this frame uses.
+static u32 get_framebuffer(render_graph_t *rg, const rg_handle_t *colors,
+                           u32 color_count, rg_handle_t depth)
+{
+    u32 attachments[RG_MAX_COLORS + 1] = {0};
+    for (u32 i = 0; i < color_count; i++)
+        attachments[i] = render_graph_gl_texture(rg, colors[i]);
+    if (depth != INVALID_32)
+        attachments[RG_MAX_COLORS] = render_graph_gl_texture(rg, depth);
+
+    u32 oldest = INVALID_32;
+    for (u32 i = 0; i < rg->framebuffer_count; i++)
+    {
+        rg_framebuffer_t *fb = &rg->framebuffers[i];
+        if (memcmp(fb->attachments, attachments, sizeof(attachments)) == 0)
+        {
+            fb->last_frame = rg->frame;
+            return fb->id;
+        }
+        if (fb->last_frame != rg->frame &&
+            (oldest == INVALID_32 ||
+             fb->last_frame < rg->framebuffers[oldest].last_frame))
+            oldest = i;
+    }
+
+    if (rg->framebuffer_count == RG_MAX_FRAMEBUFFERS)
+    {
+        if (oldest == INVALID_32)
+        {
+            LOG_ERROR("render graph: out of framebuffers");
+            return 0;
+        }
+        drop_framebuffer(rg, oldest);
+    }
+
+    u32 fbo;
+    glGenFramebuffers(1, &fbo);
+    gl_state_bind_framebuffer(fbo);
+
+    GLenum buffers[RG_MAX_COLORS];
+    for (u32 i = 0; i < color_count; i++)
+    {
+        buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, buffers[i], GL_TEXTURE_2D,
+                               attachments[i], 0);
+    }
+    if (depth != INVALID_32)
+    {
+        GLenum point = g_formats[rg->textures[depth].desc.format].attachment;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, point, GL_TEXTURE_2D,
+                               attachments[RG_MAX_COLORS], 0);
+    }
+
+    if (color_count)
+    {
+        glDrawBuffers((GLsizei)color_count, buffers);
+    }
+    else
+    {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_ERROR("render graph: framebuffer incomplete (0x%x)", status);
+        gl_state_delete_framebuffer(fbo);
+        return 0;
+    }
+
+    rg_framebuffer_t *fb = &rg->framebuffers[rg->framebuffer_count++];
+    fb->id = fbo;
+    memcpy(fb->attachments, attachments, sizeof(attachments));
+    fb->last_frame = rg->frame;
+    return fbo;
+}
+
+void render_graph_kill(render_graph_t *rg)
+{
+    if (!rg) return;
+
+    while (rg->framebuffer_count) drop_framebuffer(rg, 0);
+    for (u32 i = 0; i < rg->target_count; i++)
+        gl_state_delete_texture(rg->targets[i].id);
+
+    memset(rg, 0, sizeof(render_graph_t));
+    LOG_INFO("Render Graph Kill");
+}
+
+/*************************
+ * Declaration
+ *************************/
+void render_graph_begin(render_graph_t *rg, u32 width, u32 height)
+{
+    rg->frame++;
+    rg->width = MAX(width, 1);
+    rg->height = MAX(height, 1);
+    rg->pass_count = 0;
+    rg->texture_count = 0;
+    rg->order_count = 0;
+    rg->compiled = false;
+    rg->failed = false;
+
+    // nothing refers to pool slots between frames, they can move
+    for (u32 i = 0; i < rg->target_count;)
+    {
+        if (rg->frame - rg->targets[i].last_frame > RG_RETIRE_FRAMES)
+        {
+            delete_target(rg, i);
+            rg->targets[i] = rg->targets[--rg->target_count];
+        }
+        else
+        {
+            i++;
+        }
+    }
+    for (u32 i = 0; i < rg->framebuffer_count;)
+    {
+        if (rg->frame - rg->framebuffers[i].last_frame > RG_RETIRE_FRAMES)
+            drop_framebuffer(rg, i);
+        else
+            i++;
+    }
+}
+
+static rg_pass_t *get_pass(render_graph_t *rg, rg_handle_t pass)
+{
+    if (pass < rg->pass_count) return &rg->passes[pass];
+    rg->failed = true;
+    LOG_ERROR("render graph: invalid pass %u", pass);
+    return NULL;
+}
+
+static b8 check_texture(render_graph_t *rg, rg_handle_t texture)
+{
+    if (texture < rg->texture_count) return true;
+    rg->failed = true;
+    LOG_ERROR("render graph: invalid texture %u", texture);
+    return false;
+}
+
+rg_handle_t render_graph_texture(render_graph_t *rg, const char *name,
+                                 rg_texture_desc_t desc)
+{
+    if (rg->texture_count == RG_MAX_TEXTURES || desc.format >= RG_FORMAT_COUNT)
+    {
+        rg->failed = true;
+        LOG_ERROR("render graph: can't declare texture %s", name);
+        return INVALID_32;
+    }
+
+    rg_texture_t *tex = &rg->textures[rg->texture_count];
+    tex->name = name;
+    tex->desc = desc;
+    if (!desc.width) tex->desc.width = rg->width;
+    if (!desc.height) tex->desc.height = rg->height;
+    tex->target = INVALID_32;
+    tex->first = INVALID_32;
+    tex->last = INVALID_32;
+    return rg->texture_count++;
+}
+
+rg_handle_t render_graph_add_pass(render_graph_t *rg, const char *name,
+                                  rg_execute_fn execute, void *user)
+{
+    if (rg->pass_count == RG_MAX_PASSES)
+    {
+        rg->failed = true;
+        LOG_ERROR("render graph: can't add pass %s", name);
+        return INVALID_32;
+    }
+
+    rg_pass_t *pass = &rg->passes[rg->pass_count];
+    memset(pass, 0, sizeof(rg_pass_t));
+    pass->name = name;
+    pass->execute = execute;
+    pass->user = user;
+    pass->depth = INVALID_32;
+    pass->blit = INVALID_32;
+    return rg->pass_count++;
+}
+
+rg_handle_t render_graph_add_blit(render_graph_t *rg, const char *name,
+                                  rg_handle_t texture)
+{
+    rg_handle_t pass = render_graph_add_pass(rg, name, NULL, NULL);
+    if (pass == INVALID_32 || !check_texture(rg, texture)) return INVALID_32;
+
+    render_graph_read(rg, pass, texture);
+    rg->passes[pass].backbuffer = true;
+    rg->passes[pass].blit = texture;
+    return pass;
+}
+
+void render_graph_read(render_graph_t *rg, rg_handle_t pass,
+                       rg_handle_t texture)
+{
+    rg_pass_t *p = get_pass(rg, pass);
+    if (!p || !check_texture(rg, texture)) return;
+
+    if (p->read_count == RG_MAX_READS)
+    {
+        rg->failed = true;
+        LOG_ERROR("render graph: %s reads too many textures", p->name);
+        return;
+    }
+    p->reads[p->read_count++] = texture;
+}
+
+void render_graph_write_color(render_graph_t *rg, rg_handle_t pass,
+                              rg_handle_t texture)
+{
+    rg_pass_t *p = get_pass(rg, pass);
+    if (!p || !check_texture(rg, texture)) return;
+
+    if (p->color_count == RG_MAX_COLORS ||
+        is_depth(rg->textures[texture].desc.format))
+    {
+        rg->failed = true;
+        LOG_ERROR("render graph: %s can't write %s as color", p->name,
+                  rg->textures[texture].name);
+        return;
+    }
+    p->colors[p->color_count++] = texture;
+}
+
+void render_graph_write_depth(render_graph_t *rg, rg_handle_t pass,
+                              rg_handle_t texture)
+{
+    rg_pass_t *p = get_pass(rg, pass);
+    if (!p || !check_texture(rg, texture)) return;
+
+    if (p->depth != INVALID_32 || !is_depth(rg->textures[texture].desc.format))
+    {
+        rg->failed = true;
+        LOG_ERROR("render graph: %s can't write %s as depth", p->name,
+                  rg->textures[texture].name);
+        return;
+    }
+    p->depth = texture;
+}
+
+void render_graph_write_backbuffer(render_graph_t *rg, rg_handle_t pass)
+{
+    rg_pass_t *p = get_pass(rg, pass);
+    if (p) p->backbuffer = true;
+}
+
+void render_graph_clear(render_graph_t *rg, rg_handle_t pass, u32 mask,
+                        vec4 color)
+{
+    rg_pass_t *p = get_pass(rg, pass);
+    if (!p) return;
+    p->clear_mask = mask;
+    p->clear_color = color;
+}
+
+void render_graph_keep(render_graph_t *rg, rg_handle_t pass)
+{
+    rg_pass_t *p = get_pass(rg, pass);
+    if (p) p->keep = true;
+}
+
+/*************************
+ * Compile
+ *************************/
+static b8 pass_reads(const rg_pass_t *pass, rg_handle_t texture)
+{
+    for (u32 i = 0; i < pass->read_count; i++)
+        if (pass->reads[i] == texture) return true;
+    return false;
+}
+
+static b8 pass_writes(const rg_pass_t *pass, rg_handle_t texture)
+{
+    for (u32 i = 0; i < pass->color_count; i++)
+        if (pass->colors[i] == texture) return true;
+    return pass->depth == texture;
+}
+
+// Sizes of one pass's attachments have to agree
+static const rg_texture_desc_t *attachment_desc(const render_graph_t *rg,
+                                                const rg_pass_t *pass)
+{
+    if (pass->color_count) return &rg->textures[pass->colors[0]].desc;
+    if (pass->depth != INVALID_32) return &rg->textures[pass->depth].desc;
+    return NULL;
+}
+
+static b8 validate(const render_graph_t *rg, const rg_pass_t *pass)
+{
+    const rg_texture_desc_t *desc = attachment_desc(rg, pass);
+    if (pass->backbuffer && desc)
+    {
+        LOG_ERROR("render graph: %s mixes the backbuffer and textures",
+                  pass->name);
+        return false;
+    }
+
+    for (u32 i = 0; desc && i <= pass->color_count; i++)
+    {
+        rg_handle_t t = i < pass->color_count ? pass->colors[i] : pass->depth;
+        if (t == INVALID_32) continue;
+
+        const rg_texture_desc_t *d = &rg->textures[t].desc;
+        if (d->width != desc->width || d->height != desc->height)
+        {
+            LOG_ERROR("render graph: %s has attachments of different sizes",
+                      pass->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Kahn's algorithm, the lowest declared pass that is ready goes first so
+// independent passes keep their declaration order
+static b8 sort_passes(const render_graph_t *rg, const u32 *deps, u32 *out)
+{
+    u32 done = 0;
+    for (u32 count = 0; count < rg->pass_count; count++)
+    {
+        u32 next = INVALID_32;
+        for (u32 p = 0; p < rg->pass_count && next == INVALID_32; p++)
+        {
+            if (!(done & (1u << p)) && (deps[p] & ~done) == 0) next = p;
+        }
+        if (next == INVALID_32)
+        {
+            LOG_ERROR("render graph: the passes depend on each other");
+            return false;
+        }
+        done |= 1u << next;
+        out[count] = next;
+    }
+    return true;
+}
+
+static void use_texture(render_graph_t *rg, rg_handle_t texture, u32 slot)
+{
+    if (texture == INVALID_32) return;
+    rg_texture_t *tex = &rg->textures[texture];
+    if (tex->first == INVALID_32) tex->first = slot;
+    tex->last = slot;
+}
+
+b8 render_graph_compile(render_graph_t *rg)
+{
+    rg->compiled = false;
+    if (rg->failed) return false;
+
+    for (u32 p = 0; p < rg->pass_count; p++)
+        if (!validate(rg, &rg->passes[p])) return false;
+
+    // writers run in declaration order, readers after all of them
+    u32 deps[RG_MAX_PASSES] = {0};
+    for (u32 t = 0; t < rg->texture_count; t++)
+    {
+        u32 writers = 0;
+        for (u32 p = 0; p < rg->pass_count; p++)
+        {
+            const rg_pass_t *pass = &rg->passes[p];
+            if (!pass_writes(pass, t)) continue;
+            if (pass_reads(pass, t))
+            {
+                LOG_ERROR("render graph: %s reads and writes %s", pass->name,
+                          rg->textures[t].name);
+                return false;
+            }
+            deps[p] |= writers;
+            writers |= 1u << p;
+        }
+        for (u32 p = 0; p < rg->pass_count; p++)
+            if (pass_reads(&rg->passes[p], t)) deps[p] |= writers;
+    }
+
+    u32 sorted[RG_MAX_PASSES];
+    if (!sort_passes(rg, deps, sorted)) return false;
+
+    // walk back from the roots, dependencies always sort earlier
+    u32 live = 0;
+    for (u32 p = 0; p < rg->pass_count; p++)
+    {
+        if (rg->passes[p].keep || rg->passes[p].backbuffer)
+            live |= 1u << p;
+    }
+    for (u32 i = rg->pass_count; i-- > 0;)
+    {
+        if (live & (1u << sorted[i])) live |= deps[sorted[i]];
+    }
+
+    rg->order_count = 0;
+    for (u32 i = 0; i < rg->pass_count; i++)
+    {
+        if (live & (1u << sorted[i])) rg->order[rg->order_count++] = sorted[i];
+    }
+
+    for (u32 t = 0; t < rg->texture_count; t++)
+    {
+        rg->textures[t].target = INVALID_32;
+        rg->textures[t].first = INVALID_32;
+        rg->textures[t].last = INVALID_32;
+    }
+    for (u32 s = 0; s < rg->order_count; s++)
+    {
+        const rg_pass_t *pass = &rg->passes[rg->order[s]];
+        for (u32 i = 0; i < pass->read_count; i++)
+            use_texture(rg, pass->reads[i], s);
+        for (u32 i = 0; i < pass->color_count; i++)
+            use_texture(rg, pass->colors[i], s);
+        use_texture(rg, pass->depth, s);
+    }
+
+    // a texture holds its target from its first slot through its last,
+    // then the next texture that starts can take it
+    for (u32 i = 0; i < rg->target_count; i++) rg->targets[i].busy = false;
+    for (u32 s = 0; s < rg->order_count; s++)
+    {
+        for (u32 t = 0; t < rg->texture_count; t++)
+        {
+            if (rg->textures[t].first == s &&
+                !acquire_target(rg, &rg->textures[t]))
+                return false;
+        }
+        for (u32 t = 0; t < rg->texture_count; t++)
+        {
+            if (rg->textures[t].last == s)
+                rg->targets[rg->textures[t].target].busy = false;
+        }
+    }
+
+    for (u32 s = 0; s < rg->order_count; s++)
+    {
+        rg_pass_t *pass = &rg->passes[rg->order[s]];
+        pass->fbo = 0;
+        if (pass->blit != INVALID_32)
+        {
+            // read framebuffer of the source
+            b8 depth = is_depth(rg->textures[pass->blit].desc.format);
+            pass->fbo = depth ? get_framebuffer(rg, NULL, 0, pass->blit)
+                              : get_framebuffer(rg, &pass->blit, 1,
+                                                INVALID_32);
+            if (!pass->fbo) return false;
+        }
+        else if (attachment_desc(rg, pass))
+        {
+            pass->fbo = get_framebuffer(rg, pass->colors, pass->color_count,
+                                        pass->depth);
+            if (!pass->fbo) return false;
+        }
+    }
+
+    rg_stats_t *stats = &rg->stats;
+    memset(stats, 0, sizeof(rg_stats_t));
+    stats->passes = rg->pass_count;
+    stats->culled = rg->pass_count - rg->order_count;
+    u32 used[RG_MAX_TARGETS] = {0};
+    for (u32 t = 0; t < rg->texture_count; t++)
+    {
+        u32 target = rg->textures[t].target;
+        if (target == INVALID_32) continue;
+        stats->textures++;
+        if (used[target]++) continue;
+
+        const rg_target_t *tg = &rg->targets[target];
+        stats->targets++;
+        stats->target_bytes +=
+            (u64)tg->width * tg->height * g_formats[tg->format].bytes;
+    }
+
+    rg->compiled = true;
+    return true;
+}
+
+/*************************
+ * Execute
+ *************************/
+static void blit(const render_graph_t *rg, const rg_pass_t *pass)
+{
+    const rg_texture_desc_t *src = &rg->textures[pass->blit].desc;
+    b8 depth = is_depth(src->format);
+    b8 same = src->width == rg->width && src->height == rg->height;
+    GLenum filter = depth || same ? GL_NEAREST : GL_LINEAR;
+
+    // the draw side is the backbuffer, already bound through gl_state
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, pass->fbo);
+    glBlitFramebuffer(0, 0, (GLint)src->width, (GLint)src->height, 0, 0,
+                      (GLint)rg->width, (GLint)rg->height,
+                      depth ? GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT,
+                      filter);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void render_graph_execute(render_graph_t *rg)
+{
+    if (!rg->compiled) return;
+
+    for (u32 s = 0; s < rg->order_count; s++)
+    {
+        const rg_pass_t *pass = &rg->passes[rg->order[s]];
+        const rg_texture_desc_t *desc = attachment_desc(rg, pass);
+        if (pass->backbuffer)
+        {
+            gl_state_bind_framebuffer(0);
+            gl_state_viewport(0, 0, (i32)rg->width, (i32)rg->height);
+        }
+        else if (desc)
+        {
+            gl_state_bind_framebuffer(pass->fbo);
+            gl_state_viewport(0, 0, (i32)desc->width, (i32)desc->height);
+        }
+
+        if (pass->clear_mask)
+        {
+            vec4 c = pass->clear_color;
+            if (pass->clear_mask & GL_COLOR_BUFFER_BIT)
+                glClearColor(c.r, c.g, c.b, c.a);
+            // the depth mask applies to clears too
+            if (pass->clear_mask & GL_DEPTH_BUFFER_BIT)
+                gl_state_depth_mask(true);
+            glClear(pass->clear_mask);
+        }
+
+        if (pass->blit != INVALID_32)
+            blit(rg, pass);
+        else if (pass->execute)
+            pass->execute(rg, pass->user);
+    }
+}
+
+u32 render_graph_gl_texture(const render_graph_t *rg, rg_handle_t texture)
+{
+    if (texture >= rg->texture_count) return 0;
+    u32 target = rg->textures[texture].target;
+    return target == INVALID_32 ? 0 : rg->targets[target].id;
+}
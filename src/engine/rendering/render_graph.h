@@ -0,0 +1,180 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/math/math_types.h"
+#include "engine/core/memory/arena.h"
+
+/*
+ * Frame graph over offscreen render targets. Every frame the passes are
+ * declared again with the textures they sample (reads) and the ones they
+ * render to (writes), then compiled and executed:
+ *
+ *  - Every writer of a texture runs before any of its readers, writers of
+ *    one texture keep their declaration order. A cycle fails the compile.
+ *  - Passes only run when something reaches the backbuffer through them,
+ *    or they are marked with render_graph_keep. The rest are culled.
+ *  - Textures are transient, they only exist from their first use to their
+ *    last. The GL textures behind them come from a pool, and one is handed
+ *    to the next texture of the same size and format as soon as its last
+ *    user is done, so textures that are never alive at once share memory.
+ *    The contents of a freshly handed out texture are undefined, its first
+ *    writer should clear it.
+ *
+ * Handles only live for the frame they were declared in. Pooled targets
+ * and framebuffers unused for RG_RETIRE_FRAMES frames are deleted.
+ */
+
+#define RG_MAX_PASSES 32 // dependencies are a u32 mask per pass
+#define RG_MAX_TEXTURES 32
+#define RG_MAX_READS 8
+#define RG_MAX_COLORS 4
+#define RG_MAX_TARGETS 32
+#define RG_MAX_FRAMEBUFFERS 32
+#define RG_RETIRE_FRAMES 60
+
+typedef u32 rg_handle_t; // INVALID_32 for none
+
+typedef enum {
+    RG_FORMAT_RGBA8,
+    RG_FORMAT_RGBA16F,
+    RG_FORMAT_DEPTH24_STENCIL8,
+    RG_FORMAT_DEPTH32F,
+    RG_FORMAT_COUNT
+} rg_format_t;
+
+typedef struct {
+    u32 width; // 0 for the graph's size
+    u32 height;
+    rg_format_t format;
+} rg_texture_desc_t;
+
+typedef struct render_graph_t render_graph_t;
+
+// Runs with the pass's framebuffer bound, the viewport set and the clears
+// done
+typedef void (*rg_execute_fn)(render_graph_t *rg, void *user);
+
+typedef struct {
+    const char *name; // not copied
+    rg_execute_fn execute;
+    void *user;
+
+    rg_handle_t reads[RG_MAX_READS];
+    u32 read_count;
+    rg_handle_t colors[RG_MAX_COLORS];
+    u32 color_count;
+    rg_handle_t depth;
+    b8 backbuffer; // renders to framebuffer 0, no other attachments
+    rg_handle_t blit; // copied to the backbuffer instead of execute
+
+    u32 clear_mask; // GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT
+    vec4 clear_color;
+    b8 keep;
+
+    u32 fbo; // set by the compile
+} rg_pass_t;
+
+typedef struct {
+    const char *name; // not copied
+    rg_texture_desc_t desc; // size resolved
+    u32 target; // pool index once compiled, INVALID_32 when unused
+    u32 first; // execution slots of the first and last use
+    u32 last;
+} rg_texture_t;
+
+typedef struct {
+    u32 id;
+    rg_format_t format;
+    u32 width;
+    u32 height;
+    u32 last_frame;
+    b8 busy; // during the compile, a live texture holds it
+} rg_target_t;
+
+typedef struct {
+    u32 id;
+    u32 attachments[RG_MAX_COLORS + 1]; // GL textures, depth last
+    u32 last_frame;
+} rg_framebuffer_t;
+
+typedef struct {
+    u32 passes;
+    u32 culled;
+    u32 textures; // used by the passes that run
+    u32 targets;  // pooled GL textures behind them
+    u64 target_bytes;
+} rg_stats_t;
+
+struct render_graph_t {
+    u32 width;
+    u32 height;
+    u32 frame;
+    b8 failed; // a bad declaration this frame, the compile refuses
+
+    rg_pass_t passes[RG_MAX_PASSES];
+    u32 pass_count;
+    rg_texture_t textures[RG_MAX_TEXTURES];
+    u32 texture_count;
+
+    // passes that run, in execution order
+    u32 order[RG_MAX_PASSES];
+    u32 order_count;
+    b8 compiled;
+
+    rg_target_t targets[RG_MAX_TARGETS];
+    u32 target_count;
+    rg_framebuffer_t framebuffers[RG_MAX_FRAMEBUFFERS];
+    u32 framebuffer_count;
+
+    rg_stats_t stats;
+};
+
+render_graph_t *render_graph_init(arena_alloc_t *arena);
+
+void render_graph_kill(render_graph_t *rg);
+
+// Drops last frame's declarations, width x height is the backbuffer
+void render_graph_begin(render_graph_t *rg, u32 width, u32 height);
+
+rg_handle_t render_graph_texture(render_graph_t *rg, const char *name,
+                                 rg_texture_desc_t desc);
+
+rg_handle_t render_graph_add_pass(render_graph_t *rg, const char *name,
+                                  rg_execute_fn execute, void *user);
+
+// Copies texture to the backbuffer, for the last pass of a frame
+rg_handle_t render_graph_add_blit(render_graph_t *rg, const char *name,
+                                  rg_handle_t texture);
+
+// pass samples texture
+void render_graph_read(render_graph_t *rg, rg_handle_t pass,
+                       rg_handle_t texture);
+
+void render_graph_write_color(render_graph_t *rg, rg_handle_t pass,
+                              rg_handle_t texture);
+
+void render_graph_write_depth(render_graph_t *rg, rg_handle_t pass,
+                              rg_handle_t texture);
+
+void render_graph_write_backbuffer(render_graph_t *rg, rg_handle_t pass);
+
+// mask is GL_COLOR_BUFFER_BIT and/or GL_DEPTH_BUFFER_BIT, depth clears
+// to 1
+void render_graph_clear(render_graph_t *rg, rg_handle_t pass, u32 mask,
+                        vec4 color);
+
+// Never culled, for passes with effects the graph can't see
+void render_graph_keep(render_graph_t *rg, rg_handle_t pass);
+
+// Orders, culls and assigns targets. false on a bad declaration or a
+// cycle, nothing runs then.
+b8 render_graph_compile(render_graph_t *rg);
+
+void render_graph_execute(render_graph_t *rg);
+
+// The GL texture behind texture, valid once compiled. 0 when no pass that
+// runs uses it.
+u32 render_graph_gl_texture(const render_graph_t *rg, rg_handle_t texture);
+
+#endif // RENDER_GRAPH_H
@@ -0,0 +1,372 @@
+#include "render_queue.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_state.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <string.h>
+
+#define KEY_PASS_SHIFT 60
+#define KEY_TRANSLUCENT_BIT (1ull << 59)
+
+static b8 queue_reserve(render_queue_t *rq, u32 capacity)
+{
+    if (capacity <= rq->capacity) return true;
+
+    render_cmd_t *cmds = ALLOC(sizeof(render_cmd_t) * capacity, MEM_RENDER);
+    u64 *keys = ALLOC(sizeof(u64) * capacity * 3, MEM_RENDER);
+    u32 *order = ALLOC(sizeof(u32) * capacity * 2, MEM_RENDER);
+    u64 *offsets = ALLOC(sizeof(u64) * capacity, MEM_RENDER);
+    if (!cmds || !keys || !order || !offsets)
+    {
+        LOG_ERROR("render queue: failed to grow to %u packets", capacity);
+        if (cmds) FREE(cmds, sizeof(render_cmd_t) * capacity, MEM_RENDER);
+        if (keys) FREE(keys, sizeof(u64) * capacity * 3, MEM_RENDER);
+        if (order) FREE(order, sizeof(u32) * capacity * 2, MEM_RENDER);
+        if (offsets) FREE(offsets, sizeof(u64) * capacity, MEM_RENDER);
+        return false;
+    }
+
+    if (rq->cmds)
+    {
+        memcpy(cmds, rq->cmds, sizeof(render_cmd_t) * rq->count);
+        memcpy(keys, rq->keys, sizeof(u64) * rq->count);
+        FREE(rq->cmds, sizeof(render_cmd_t) * rq->capacity, MEM_RENDER);
+        FREE(rq->keys, sizeof(u64) * rq->capacity * 3, MEM_RENDER);
+        FREE(rq->order, sizeof(u32) * rq->capacity * 2, MEM_RENDER);
+        FREE(rq->offsets, sizeof(u64) * rq->capacity, MEM_RENDER);
+    }
+
+    rq->cmds = cmds;
+    rq->offsets = offsets;
+    rq->keys = keys;
+    rq->sorted_keys = keys + capacity;
+    rq->keys_tmp = keys + capacity * 2;
+    rq->order = order;
+    rq->order_tmp = order + capacity;
+    rq->capacity = capacity;
+    rq->sorted = false;
+    return true;
+}
+
+render_queue_t *render_queue_init(arena_alloc_t *arena, u32 capacity)
+{
+    render_queue_t *rq = arena_alloc(arena, sizeof(render_queue_t));
+    if (!rq) return NULL;
+    memset(rq, 0, sizeof(render_queue_t));
+
+    if (!queue_reserve(rq, MAX(capacity, 64u))) return NULL;
+
+    LOG_INFO("Render Queue Init");
+    return rq;
+}
+
+void render_queue_kill(render_queue_t *rq)
+{
+    if (!rq) return;
+
+    FREE(rq->cmds, sizeof(render_cmd_t) * rq->capacity, MEM_RENDER);
+    FREE(rq->keys, sizeof(u64) * rq->capacity * 3, MEM_RENDER);
+    FREE(rq->order, sizeof(u32) * rq->capacity * 2, MEM_RENDER);
+    FREE(rq->offsets, sizeof(u64) * rq->capacity, MEM_RENDER);
+    memset(rq, 0, sizeof(render_queue_t));
+    LOG_INFO("Render Queue Kill");
+}
+
+void render_queue_reset(render_queue_t *rq)
+{
+    rq->count = 0;
+    rq->sorted = false;
+    memset(&rq->stats, 0, sizeof(render_queue_stats_t));
+}
+
+b8 render_queue_submit(render_queue_t *rq, u64 key, const render_cmd_t *cmd)
+{
+    if (rq->count == rq->capacity && !queue_reserve(rq, rq->capacity * 2))
+        return false;
+
+    rq->cmds[rq->count] = *cmd;
+    rq->keys[rq->count] = key;
+    rq->count++;
+    rq->sorted = false;
+    return true;
+}
+
+/*************************
+ * Sort
+ *************************/
+// LSD radix sort on 8-bit digits. All histograms come from one read of the
+// keys and a digit that is the same for every key skips its scatter pass,
+// which is common since the pass and flag bits rarely vary. Works on a
+// copy, keys and cmds stay in submit order so later submits and sorts
+// keep every key with its command.
+void render_queue_sort(render_queue_t *rq)
+{
+    if (rq->sorted) return;
+
+    u32 n = rq->count;
+    memcpy(rq->sorted_keys, rq->keys, sizeof(u64) * n);
+    for (u32 i = 0; i < n; i++) rq->order[i] = i;
+
+    if (n > 1)
+    {
+        u32 hist[8][256];
+        memset(hist, 0, sizeof(hist));
+        for (u32 i = 0; i < n; i++)
+        {
+            u64 k = rq->keys[i];
+            for (u32 d = 0; d < 8; d++) hist[d][(k >> (d * 8)) & 0xFF]++;
+        }
+
+        u64 *src_keys = rq->sorted_keys, *dst_keys = rq->keys_tmp;
+        u32 *src_order = rq->order, *dst_order = rq->order_tmp;
+        for (u32 d = 0; d < 8; d++)
+        {
+            u32 shift = d * 8;
+            if (hist[d][(src_keys[0] >> shift) & 0xFF] == n) continue;
+
+            u32 offset = 0;
+            for (u32 b = 0; b < 256; b++)
+            {
+                u32 c = hist[d][b];
+                hist[d][b] = offset;
+                offset += c;
+            }
+
+            for (u32 i = 0; i < n; i++)
+            {
+                u32 b = (u32)(src_keys[i] >> shift) & 0xFF;
+                u32 dst = hist[d][b]++;
+                dst_keys[dst] = src_keys[i];
+                dst_order[dst] = src_order[i];
+            }
+
+            u64 *tk = src_keys;
+            src_keys = dst_keys;
+            dst_keys = tk;
+            u32 *to = src_order;
+            src_order = dst_order;
+            dst_order = to;
+        }
+
+        // odd number of scatters leaves the result in the scratch half
+        if (src_keys != rq->sorted_keys)
+        {
+            memcpy(rq->sorted_keys, src_keys, sizeof(u64) * n);
+            memcpy(rq->order, src_order, sizeof(u32) * n);
+        }
+    }
+
+    rq->sorted = true;
+}
+
+/*************************
+ * Execute
+ *************************/
+static b8 stream_frame_block(render_system_t *rs, const render_frame_t *frame,
+                             u64 *out_offset)
+{
+    render_frame_ubo_t *dst = stream_buffer_alloc(
+        &rs->ubo_stream, sizeof(render_frame_ubo_t), out_offset);
+    if (!dst) return false;
+
+    vec3 v = frame->view_pos, a = frame->ambient;
+    dst->view_pos = vec4_create(v.x, v.y, v.z, 1.0f);
+    dst->ambient = vec4_create(a.x, a.y, a.z, 1.0f);
+    dst->cluster_scale = frame->cluster_scale;
+    for (u32 i = 0; i < 3; i++) dst->cluster_dims[i] = frame->cluster_dims[i];
+    dst->cluster_dims[3] = frame->light_count;
+    return true;
+}
+
+// White without a texture system or a material texture
+static texture_region_t material_region(const render_material_t *material)
+{
+    texture_system_t *ts = get_texture_system();
+    texture_handle_t texture = material ? material->texture : INVALID_32;
+    if (ts) return texture_sys_region(ts, texture);
+
+    return (texture_region_t){.page = TEX_SYS_PLACEHOLDER_PAGE,
+                              .uv_rect = vec4_create(0.0f, 0.0f, 1.0f,
+                                                     1.0f)};
+}
+
+// Writes every packet's object slice or instances up front, the orphaning
+// fallback can't keep the rings mapped while drawing
+static void stream_packets(render_queue_t *rq, render_system_t *rs)
+{
+    for (u32 i = 0; i < rq->count; i++)
+    {
+        const render_cmd_t *cmd = &rq->cmds[i];
+        u64 *offset = &rq->offsets[i];
+
+        if (cmd->indirect_buffer)
+        {
+            *offset = 0;
+            continue;
+        }
+
+        if (cmd->instances)
+        {
+            if (!render_stream_instances(rs, cmd->instances,
+                                         cmd->instance_count, offset))
+                *offset = INVALID_64;
+            continue;
+        }
+
+        render_object_ubo_t *obj = stream_buffer_alloc(
+            &rs->ubo_stream, sizeof(render_object_ubo_t), offset);
+        if (!obj)
+        {
+            *offset = INVALID_64;
+            continue;
+        }
+
+        vec3 c = cmd->material ? cmd->material->color
+                               : vec3_create(1.0f, 1.0f, 1.0f);
+        texture_region_t region = material_region(cmd->material);
+        obj->model = cmd->model;
+        obj->color = vec4_create(c.x, c.y, c.z, 1.0f);
+        obj->uv_rect = region.uv_rect;
+        obj->layer = (f32)region.layer;
+    }
+}
+
+void render_queue_prepare(render_queue_t *rq, render_system_t *rs,
+                          const render_frame_t *frame)
+{
+    render_queue_sort(rq);
+
+    u64 frame_offset = 0;
+    b8 has_frame = frame && stream_frame_block(rs, frame, &frame_offset);
+    stream_packets(rq, rs);
+    stream_buffer_flush(&rs->ubo_stream);
+    stream_buffer_flush(&rs->instance_stream);
+
+    if (has_frame)
+    {
+        stream_buffer_bind_range(&rs->ubo_stream, UBO_BINDING_FRAME,
+                                 frame_offset, sizeof(render_frame_ubo_t));
+    }
+
+    // the pass is the top of the key, each one is a contiguous run
+    memset(rq->pass_begin, 0, sizeof(rq->pass_begin));
+    memset(rq->pass_end, 0, sizeof(rq->pass_end));
+    for (u32 i = 0; i < rq->count; i++)
+    {
+        u32 pass = (u32)(rq->sorted_keys[i] >> KEY_PASS_SHIFT);
+        if (rq->pass_end[pass] == 0) rq->pass_begin[pass] = i;
+        rq->pass_end[pass] = i + 1;
+    }
+}
+
+void render_queue_execute_pass(render_queue_t *rq, render_system_t *rs,
+                               u8 pass)
+{
+    pass &= RENDER_QUEUE_PASSES - 1;
+    u32 begin = rq->pass_begin[pass], end = rq->pass_end[pass];
+    if (begin == end) return;
+
+    render_sys_begin(rs, pass);
+    rq->stats.pass_changes++;
+
+    shader_t *shader = NULL;
+    b8 bound = false;
+    texture_system_t *ts = get_texture_system();
+
+    for (u32 i = begin; i < end; i++)
+    {
+        u32 index = rq->order[i];
+        const render_cmd_t *cmd = &rq->cmds[index];
+        u64 offset = rq->offsets[index];
+        if (offset == INVALID_64) continue; // ring was full
+
+        if (cmd->shader != shader)
+        {
+            shader = cmd->shader;
+            bound = shader_sys_bind(shader);
+            rq->stats.shader_binds++;
+        }
+        if (!bound) continue; // still compiling, no fallback
+
+        // gl_state drops the rebinds of the page already bound
+        if (ts)
+        {
+            u32 page = cmd->instances || cmd->indirect_buffer
+                           ? cmd->texture_page
+                           : material_region(cmd->material).page;
+            texture_sys_bind_page(ts, page, TEX_UNIT_ALBEDO,
+                                  TEXTURE_SAMPLER_LINEAR_REPEAT);
+        }
+
+        if (cmd->indirect_buffer)
+        {
+            mesh_sys_bind(rs->meshes);
+            rq->stats.draw_calls += mesh_sys_draw_indirect(
+                rs->meshes, NULL, cmd->indirect_count, cmd->indirect_buffer,
+                0, cmd->instance_buffer);
+            continue;
+        }
+
+        if (cmd->instances && cmd->meshes)
+        {
+            rq->stats.draw_calls += render_draw_multi_at(
+                rs, cmd->meshes, cmd->instance_count, offset);
+            continue;
+        }
+
+        if (cmd->instances)
+        {
+            render_draw_instanced_at(rs, cmd->mesh, offset,
+                                     cmd->instance_count);
+            rq->stats.draw_calls++;
+            continue;
+        }
+
+        stream_buffer_bind_range(&rs->ubo_stream, UBO_BINDING_OBJECT, offset,
+                                 sizeof(render_object_ubo_t));
+        mesh_sys_bind(rs->meshes);
+        mesh_sys_draw(rs->meshes, cmd->mesh);
+        rq->stats.draw_calls++;
+    }
+
+    render_sys_end(rs, pass);
+}
+
+void render_queue_execute(render_queue_t *rq, render_system_t *rs,
+                          const render_frame_t *frame)
+{
+    render_queue_prepare(rq, rs, frame);
+    for (u32 pass = 0; pass < RENDER_QUEUE_PASSES; pass++)
+        render_queue_execute_pass(rq, rs, (u8)pass);
+}
+
+/*************************
+ * Keys
+ *************************/
+u32 render_key_depth(f32 distance, f32 far)
+{
+    f32 t = far > 0.0f ? distance / far : 0.0f;
+    t = CLAMP(t, 0.0f, 1.0f);
+    return (u32)(t * (f32)RENDER_KEY_DEPTH_MAX);
+}
+
+u64 render_key_opaque(u8 pass, u32 shader, u32 material, u32 mesh,
+                      u32 depth)
+{
+    return ((u64)(pass & 0xF) << KEY_PASS_SHIFT) |
+           ((u64)(shader & 0x3FF) << 49) |
+           ((u64)(material & 0xFFF) << 37) | ((u64)(mesh & 0x1FFF) << 24) |
+           (u64)(depth & RENDER_KEY_DEPTH_MAX);
+}
+
+u64 render_key_transparent(u8 pass, u32 shader, u32 material, u32 mesh,
+                           u32 depth)
+{
+    u32 far_first = RENDER_KEY_DEPTH_MAX - (depth & RENDER_KEY_DEPTH_MAX);
+    return ((u64)(pass & 0xF) << KEY_PASS_SHIFT) | KEY_TRANSLUCENT_BIT |
+           ((u64)far_first << 35) | ((u64)(shader & 0x3FF) << 25) |
+           ((u64)(material & 0xFFF) << 13) | (u64)(mesh & 0x1FFF);
+}
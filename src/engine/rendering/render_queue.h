@@ -0,0 +1,139 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/memory/arena.h"
+#include "engine/rendering/render.h"
+#include "engine/rendering/shader_system.h"
+#include "engine/rendering/texture_system.h"
+
+/*
+ * Draw packets are collected over the frame, radix sorted by a 64-bit key
+ * and executed in key order. Per draw data goes through the render system's
+ * stream rings, shader changes are tracked here and everything below that
+ * is filtered by gl_state.
+ *
+ * Opaque key, state first then front to back:
+ *   63..60 pass | 59 = 0 | 58..49 shader | 48..37 material | 36..24 mesh
+ *   | 23..0 depth
+ *
+ * Transparent key, back to front first then state:
+ *   63..60 pass | 59 = 1 | 58..35 ~depth | 34..25 shader | 24..13 material
+ *   | 12..0 mesh
+ *
+ * Textures are bound on TEX_UNIT_ALBEDO as a texture system page. Single
+ * draws use their material's texture, instanced draws bind texture_page
+ * and each instance picks its layer and rect, so instances with different
+ * textures of one page still go out as a single draw.
+ */
+
+#define RENDER_KEY_DEPTH_BITS 24
+#define RENDER_KEY_DEPTH_MAX ((1u << RENDER_KEY_DEPTH_BITS) - 1u)
+
+typedef struct {
+    u32 id; // sort id, 12 bits are used in the key
+    vec3 color;
+    texture_handle_t texture; // INVALID_32 for none
+} render_material_t;
+
+typedef struct {
+    shader_t *shader;
+    mesh_handle_t mesh;
+    const render_material_t *material; // NULL draws white
+
+    mat4 model;
+    // NULL for a single draw with model, otherwise one instanced draw
+    const render_instance_t *instances;
+    u32 instance_count;
+    // optional with instances, one mesh per instance in a single multi draw
+    const mesh_handle_t *meshes;
+    // instanced and indirect draws, the texture page the instances' layer
+    // and uv_rect point into. 0 is the placeholder page, white at layer 0.
+    u32 texture_page;
+
+    // commands already on the GPU, e.g. from gpu_cull. Drawn with
+    // instance attributes from instance_buffer, nothing is streamed.
+    u32 indirect_buffer;
+    u32 indirect_count;
+    u32 instance_buffer;
+} render_cmd_t;
+
+// Shared by every shader during a frame, streamed once into frame_block.
+// The light fields come from light_sys_frame.
+typedef struct {
+    vec3 view_pos;
+    vec3 ambient;
+    vec4 cluster_scale; // clusters per pixel in xy, slice scale and bias
+    u32 cluster_dims[3];
+    u32 light_count;
+} render_frame_t;
+
+typedef struct {
+    u32 draw_calls;
+    u32 shader_binds;
+    u32 pass_changes;
+} render_queue_stats_t;
+
+#define RENDER_QUEUE_PASSES 16 // 4 key bits
+
+typedef struct {
+    // by submit index, sorting leaves them in place
+    render_cmd_t *cmds;
+    u64 *keys;
+    u64 *offsets; // stream offset of each packet's data
+
+    // once sorted, sorted_keys[i] is keys[order[i]]
+    u64 *sorted_keys;
+    u32 *order;
+
+    // sorted range of each pass once prepared
+    u32 pass_begin[RENDER_QUEUE_PASSES];
+    u32 pass_end[RENDER_QUEUE_PASSES];
+
+    // radix sort scratch
+    u64 *keys_tmp;
+    u32 *order_tmp;
+
+    u32 count;
+    u32 capacity;
+    b8 sorted;
+
+    render_queue_stats_t stats;
+} render_queue_t;
+
+render_queue_t *render_queue_init(arena_alloc_t *arena, u32 capacity);
+
+void render_queue_kill(render_queue_t *rq);
+
+// Drops last frame's packets, keeps the storage
+void render_queue_reset(render_queue_t *rq);
+
+b8 render_queue_submit(render_queue_t *rq, u64 key, const render_cmd_t *cmd);
+
+void render_queue_sort(render_queue_t *rq);
+
+// Sorts if needed and streams every packet's data and the frame block.
+// Once per frame, after the last submit and before any pass executes.
+void render_queue_prepare(render_queue_t *rq, render_system_t *rs,
+                          const render_frame_t *frame);
+
+// Draws the prepared packets of one pass into whatever is bound, between
+// render_sys_begin and render_sys_end. Meant to run from a render graph
+// pass.
+void render_queue_execute_pass(render_queue_t *rq, render_system_t *rs,
+                               u8 pass);
+
+// Prepares, then executes every pass found in the keys in order
+void render_queue_execute(render_queue_t *rq, render_system_t *rs,
+                          const render_frame_t *frame);
+
+// distance is from the camera, far is the camera far plane
+u32 render_key_depth(f32 distance, f32 far);
+
+u64 render_key_opaque(u8 pass, u32 shader, u32 material, u32 mesh,
+                      u32 depth);
+
+u64 render_key_transparent(u8 pass, u32 shader, u32 material, u32 mesh,
+                           u32 depth);
+
+#endif // RENDER_QUEUE_H
@@ -0,0 +1,83 @@
+#include "render_queue_test.h"
+#include "engine/core/test.h"
+#include "engine/rendering/render_queue.h"
+
+// std
+#include <string.h>
+
+#define SORT_TEST_FIRST 40
+#define SORT_TEST_TOTAL 100 // past the initial 64, so the queue grows
+
+// Every sorted key must still point at the command it was submitted with.
+// The low 24 bits of each key and the command's instance_count both hold
+// the submit index.
+static b8 check_sorted(const render_queue_t *rq)
+{
+    b8 all_passed = true;
+    b8 seen[SORT_TEST_TOTAL] = {0};
+    for (u32 i = 0; i < rq->count; i++)
+    {
+        u64 key = rq->sorted_keys[i];
+        u32 index = rq->order[i];
+        if (i > 0 && key < rq->sorted_keys[i - 1])
+        {
+            printf("  keys out of order at %u\n", i);
+            all_passed = false;
+        }
+        all_passed &= expect_true(index < rq->count && !seen[index],
+                                  "order is a permutation");
+        if (index < rq->count) seen[index] = true;
+        all_passed &= expect_u64(rq->cmds[index].instance_count,
+                                 key & RENDER_KEY_DEPTH_MAX,
+                                 "key paired with its command");
+        all_passed &= expect_u64(rq->keys[i] & RENDER_KEY_DEPTH_MAX, i,
+                                 "keys stay in submit order");
+    }
+    return all_passed;
+}
+
+b8 test_render_queue_sort(void)
+{
+    b8 all_passed = true;
+    arena_alloc_t arena;
+    if (!arena_create(4096, &arena, NULL)) return false;
+    render_queue_t *rq = render_queue_init(&arena, 0);
+    if (!rq)
+    {
+        arena_kill(&arena);
+        return false;
+    }
+
+    // random pass, shader, material and mesh so most digits scatter
+    u64 seed = 99;
+    render_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    for (u32 i = 0; i < SORT_TEST_TOTAL; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        u64 key = (seed & ~(u64)RENDER_KEY_DEPTH_MAX) | i;
+        cmd.instance_count = i;
+        all_passed &= render_queue_submit(rq, key, &cmd);
+
+        // sort halfway, then keep submitting and sort again
+        if (i + 1 == SORT_TEST_FIRST || i + 1 == SORT_TEST_TOTAL)
+        {
+            render_queue_sort(rq);
+            all_passed &= check_sorted(rq);
+        }
+    }
+    all_passed &= expect_u64(rq->count, SORT_TEST_TOTAL, "submitted");
+
+    render_queue_kill(rq);
+    arena_kill(&arena);
+    return all_passed;
+}
+
+b8 render_queue_run_tests(void)
+{
+    printf("\n=== RUN RENDER QUEUE TEST ===\n");
+
+    b8 all_passed = true;
+    RUN_TEST(test_render_queue_sort);
+    return all_passed;
+}
@@ -0,0 +1,10 @@
+#ifndef RENDER_QUEUE_TEST_H
+#define RENDER_QUEUE_TEST_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+b8 render_queue_run_tests(void);
+
+b8 test_render_queue_sort(void);
+
+#endif // RENDER_QUEUE_TEST_H
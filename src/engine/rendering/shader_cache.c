@@ -0,0 +1,170 @@
+#include "shader_cache.h"
+#include "engine/core/hash.h"
+#include "engine/core/memory/memory.h"
+#include "engine/platform/filesystem.h"
+#include "engine/rendering/gl_ext.h"
+
+// std
+#include <stdio.h>
+#include <string.h>
+
+#define SHADER_CACHE_MAGIC 0x4B534843u // "KSHC"
+#define SHADER_CACHE_VERSION 1u
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u64 key;
+    u32 format;
+    u32 length;
+} shader_cache_header_t;
+
+typedef struct {
+    b8 enabled;
+    u64 seed;
+} shader_cache_t;
+
+static shader_cache_t g_cache;
+
+static void cache_path(u64 key, char *out, u64 size)
+{
+    snprintf(out, size, SHADER_CACHE_DIR "/%016llx.bin",
+             (unsigned long long)key);
+}
+
+void shader_cache_init(void)
+{
+    memset(&g_cache, 0, sizeof(shader_cache_t));
+    if (!g_gl_ext.program_binary) return;
+
+    const char *strings[] = {
+        (const char *)glGetString(GL_VENDOR),
+        (const char *)glGetString(GL_RENDERER),
+        (const char *)glGetString(GL_VERSION),
+    };
+
+    u64 seed = HASH_FNV1A_SEED;
+    for (u32 i = 0; i < ARRAY_SIZE(strings); i++)
+        if (strings[i]) seed = hash_fnv1a_str(seed, strings[i]);
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    GLint formats[16] = {0};
+    if (count > 0 && count <= (GLint)ARRAY_SIZE(formats))
+    {
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats);
+        seed = hash_fnv1a(seed, formats, sizeof(GLint) * (u64)count);
+    }
+
+    g_cache.seed = seed;
+    g_cache.enabled = file_make_dir(SHADER_CACHE_DIR);
+    LOG_INFO("Shader cache %s", g_cache.enabled ? "enabled" : "disabled");
+}
+
+u64 shader_cache_key_begin(void) { return g_cache.seed; }
+
+u64 shader_cache_key_add(u64 key, const char *text)
+{
+    // length first so ("ab", "c") and ("a", "bc") differ
+    u64 length = strlen(text);
+    key = hash_fnv1a(key, &length, sizeof(length));
+    return hash_fnv1a(key, text, length);
+}
+
+u32 shader_cache_load(u64 key)
+{
+    if (!g_cache.enabled) return 0;
+
+    char path[MAX_PATH];
+    cache_path(key, path, sizeof(path));
+    if (!file_exist_relative(path)) return 0;
+
+    file_t file;
+    if (!file_open(path, READ_BINARY, &file)) return 0;
+
+    u64 size = 0;
+    shader_cache_header_t header;
+    u8 *blob = NULL;
+    b8 ok = file_size(&file, &size) && size > sizeof(header);
+    if (ok)
+    {
+        blob = ALLOC(size, MEM_RESOURCE);
+        u64 read = 0;
+        ok = blob && file_read_all_binary(&file, blob, &read) && read == size;
+    }
+    file_close(&file);
+
+    if (ok)
+    {
+        memcpy(&header, blob, sizeof(header));
+        ok = header.magic == SHADER_CACHE_MAGIC &&
+             header.version == SHADER_CACHE_VERSION && header.key == key &&
+             header.length == size - sizeof(header);
+    }
+
+    u32 program = 0;
+    if (ok)
+    {
+        program = glCreateProgram();
+        g_gl_ext.ProgramBinary(program, header.format, blob + sizeof(header),
+                               (GLsizei)header.length);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            LOG_WARN("shader cache: %s rejected, recompiling", path);
+            glDeleteProgram(program);
+            program = 0;
+        }
+        else
+            LOG_DEBUG("shader cache: loaded %s", path);
+    }
+
+    if (blob) FREE(blob, size, MEM_RESOURCE);
+    return program;
+}
+
+void shader_cache_prepare(u32 program)
+{
+    if (!g_cache.enabled) return;
+    g_gl_ext.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                               GL_TRUE);
+}
+
+void shader_cache_store(u64 key, u32 program)
+{
+    if (!g_cache.enabled) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    u64 size = sizeof(shader_cache_header_t) + (u64)length;
+    u8 *blob = ALLOC(size, MEM_RESOURCE);
+    if (!blob) return;
+
+    shader_cache_header_t header = {.magic = SHADER_CACHE_MAGIC,
+                                    .version = SHADER_CACHE_VERSION,
+                                    .key = key};
+    GLenum format = 0;
+    GLsizei written = 0;
+    g_gl_ext.GetProgramBinary(program, length, &written, &format,
+                              blob + sizeof(header));
+    header.format = format;
+    header.length = (u32)written;
+    memcpy(blob, &header, sizeof(header));
+
+    char path[MAX_PATH];
+    cache_path(key, path, sizeof(path));
+
+    file_t file;
+    if (written > 0 && file_open(path, WRITE_BINARY, &file))
+    {
+        u64 total = sizeof(header) + (u64)written;
+        if (!file_write_binary(&file, blob, total))
+            LOG_WARN("shader cache: failed to write %s", path);
+        file_close(&file);
+    }
+    FREE(blob, size, MEM_RESOURCE);
+}
@@ -0,0 +1,33 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * Linked programs are saved with glGetProgramBinary under
+ * SHADER_CACHE_DIR/<key>.bin. The key covers the sources and whatever the
+ * caller adds (defines), on top of a seed from the driver's vendor,
+ * renderer, version and binary formats, so a driver update misses instead
+ * of feeding a stale binary. A binary the driver still rejects is treated
+ * as a miss too.
+ */
+
+#define SHADER_CACHE_DIR "shader_cache"
+
+// Needs gl_ext_init and the file system, disabled without program binaries
+void shader_cache_init(void);
+
+// Driver seed for shader_cache_key_add
+u64 shader_cache_key_begin(void);
+
+u64 shader_cache_key_add(u64 key, const char *text);
+
+// Returns a linked program or 0 on a miss
+u32 shader_cache_load(u64 key);
+
+// Call before glLinkProgram for programs that will be stored
+void shader_cache_prepare(u32 program);
+
+void shader_cache_store(u64 key, u32 program);
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,204 @@
+#include "shader_source.h"
+#include "engine/core/memory/memory.h"
+#include "engine/platform/filesystem.h"
+
+// std
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    char *data;
+    u64 length;
+    u64 capacity;
+    const char *defines;
+    b8 defined;
+    b8 ok;
+
+    // opened so far, index is the #line source string number
+    char paths[SHADER_SOURCE_MAX_INCLUDES][MAX_PATH];
+    u32 path_count;
+} source_t;
+
+static void append(source_t *s, const char *text, u64 length)
+{
+    if (!s->ok) return;
+
+    if (s->length + length + 1 > s->capacity)
+    {
+        u64 capacity = MAX(s->capacity * 2, 4096);
+        while (capacity < s->length + length + 1) capacity *= 2;
+
+        char *data = ALLOC(capacity, MEM_RESOURCE);
+        if (!data)
+        {
+            s->ok = false;
+            return;
+        }
+        if (s->data)
+        {
+            memcpy(data, s->data, s->length);
+            FREE(s->data, s->capacity, MEM_RESOURCE);
+        }
+        s->data = data;
+        s->capacity = capacity;
+    }
+
+    memcpy(s->data + s->length, text, length);
+    s->length += length;
+    s->data[s->length] = '\0';
+}
+
+static void append_line(source_t *s, u32 line, u32 source)
+{
+    char text[48];
+    int length = snprintf(text, sizeof(text), "#line %u %u\n", line, source);
+    append(s, text, (u64)length);
+}
+
+// read_file_text writes its terminator past the allocation, so not that
+static char *read_text(const char *path, u64 *out_size)
+{
+    file_t file;
+    if (!file_open(path, READ_TEXT, &file))
+    {
+        LOG_ERROR("shader: failed to open %s", path);
+        return NULL;
+    }
+
+    u64 size = 0;
+    char *text = NULL;
+    if (file_size(&file, &size)) text = ALLOC(size + 1, MEM_RESOURCE);
+
+    u64 read = 0;
+    if (text && !file_read_all_text(&file, text, &read))
+    {
+        FREE(text, size + 1, MEM_RESOURCE);
+        text = NULL;
+    }
+    file_close(&file);
+
+    if (!text)
+    {
+        LOG_ERROR("shader: failed to read %s", path);
+        return NULL;
+    }
+
+    text[MIN(read, size)] = '\0';
+    *out_size = size + 1;
+    return text;
+}
+
+static void expand(source_t *s, const char *path, u32 source, u32 depth);
+
+// directive points past "#include"
+static void include(source_t *s, const char *from, const char *directive,
+                    u32 line, u32 depth)
+{
+    const char *open = strchr(directive, '"');
+    const char *close = open ? strchr(open + 1, '"') : NULL;
+    if (!close)
+    {
+        LOG_ERROR("shader: %s:%u malformed #include", from, line);
+        s->ok = false;
+        return;
+    }
+
+    // relative to the including file
+    char path[MAX_PATH];
+    const char *slash = strrchr(from, '/');
+    int dir = slash ? (int)(slash - from) + 1 : 0;
+    int name = (int)(close - open - 1);
+    snprintf(path, sizeof(path), "%.*s%.*s", dir, from, name, open + 1);
+
+    // once per stage, so shared declarations can include each other
+    for (u32 i = 0; i < s->path_count; i++)
+    {
+        if (strcmp(s->paths[i], path) == 0) return;
+    }
+
+    if (s->path_count == SHADER_SOURCE_MAX_INCLUDES ||
+        depth == SHADER_SOURCE_MAX_DEPTH)
+    {
+        LOG_ERROR("shader: %s:%u too many includes", from, line);
+        s->ok = false;
+        return;
+    }
+
+    u32 index = s->path_count++;
+    snprintf(s->paths[index], MAX_PATH, "%s", path);
+
+    append_line(s, 1, index);
+    expand(s, s->paths[index], index, depth + 1);
+}
+
+static void expand(source_t *s, const char *path, u32 source, u32 depth)
+{
+    u64 size = 0;
+    char *text = read_text(path, &size);
+    if (!text)
+    {
+        s->ok = false;
+        return;
+    }
+
+    const char *line = text;
+    u32 number = 1;
+    while (*line && s->ok)
+    {
+        const char *end = strchr(line, '\n');
+        u64 length = end ? (u64)(end - line) + 1 : strlen(line);
+
+        const char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+
+        if (strncmp(p, "#include", 8) == 0)
+        {
+            // back to this file's numbering either way
+            include(s, path, p + 8, number, depth);
+            append_line(s, number + 1, source);
+        }
+        else
+        {
+            append(s, line, length);
+            if (!end) append(s, "\n", 1);
+
+            if (depth == 0 && strncmp(p, "#version", 8) == 0 && s->defines)
+            {
+                append(s, s->defines, strlen(s->defines));
+                append_line(s, number + 1, source);
+                s->defined = true;
+            }
+        }
+
+        line += length;
+        number++;
+    }
+
+    FREE(text, size, MEM_RESOURCE);
+}
+
+char *shader_source_load(const char *path, const char *defines,
+                         u64 *out_size)
+{
+    // include paths make this too big for the stack, GL thread only anyway
+    static source_t s;
+    memset(&s, 0, sizeof(source_t));
+    s.defines = defines && *defines ? defines : NULL;
+    s.ok = true;
+
+    snprintf(s.paths[0], MAX_PATH, "%s", path);
+    s.path_count = 1;
+    expand(&s, s.paths[0], 0, 0);
+
+    if (s.ok && s.defines && !s.defined)
+        LOG_WARN("shader: %s has no #version, defines dropped", path);
+
+    if (!s.ok || !s.data)
+    {
+        if (s.data) FREE(s.data, s.capacity, MEM_RESOURCE);
+        return NULL;
+    }
+
+    *out_size = s.capacity;
+    return s.data;
+}
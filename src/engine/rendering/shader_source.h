@@ -0,0 +1,23 @@
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * GLSL front-end. Resolves #include "path" relative to the including file,
+ * each file at most once per stage, and injects defines right after the
+ * #version line. Every inserted chunk is followed by a #line directive so
+ * driver errors keep pointing at the right line; the source string number
+ * is the include's position in the order they were opened, 0 is the stage
+ * file itself.
+ */
+
+#define SHADER_SOURCE_MAX_INCLUDES 16
+#define SHADER_SOURCE_MAX_DEPTH 8
+
+// defines is pasted as is ("#define A\n#define B\n"), may be NULL.
+// Returns NUL terminated text, out_size is the allocation for FREE.
+char *shader_source_load(const char *path, const char *defines,
+                         u64 *out_size);
+
+#endif // SHADER_SOURCE_H
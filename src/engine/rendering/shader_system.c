@@ -1,12 +1,285 @@
 #include "shader_system.h"
 #include "render.h"
+#include "gl_state.h"
+#include "engine/core/hash.h"
+#include "engine/core/memory/memory.h"
 #include "deps/glad/glad.h"
 
 // std
+#include <stdio.h>
 #include <string.h>
 
 static shader_system_t *g_sh = NULL;
 
+// Shared uniform blocks and where render.h expects them
+static const struct {
+    const char *name;
+    u32 binding;
+} g_block_bindings[] = {
+    {"camera_block", UBO_BINDING_CAMERA},
+    {"object_block", UBO_BINDING_OBJECT},
+    {"frame_block", UBO_BINDING_FRAME},
+};
+
+// Shared samplers and the units render.h puts their textures on
+static const struct {
+    const char *name;
+    u32 unit;
+} g_sampler_units[] = {
+    {"albedo_map", TEX_UNIT_ALBEDO},
+    {"light_data", TEX_UNIT_LIGHT_DATA},
+    {"light_clusters", TEX_UNIT_LIGHT_CLUSTERS},
+    {"light_indices", TEX_UNIT_LIGHT_INDICES},
+};
+
+static u32 lookup_slot(u32 name, u32 mask)
+{
+    return (name * 2654435761u) & mask;
+}
+
+// Uniform types glUniform1i sets
+static b8 int_like(u32 type)
+{
+    switch (type)
+    {
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_1D_SHADOW:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_1D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_2D_RECT_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_INT_SAMPLER_1D:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_3D:
+    case GL_INT_SAMPLER_CUBE:
+    case GL_INT_SAMPLER_1D_ARRAY:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D_RECT:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_1D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_3D:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE:
+    case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: return true;
+    default: return false;
+    }
+}
+
+// Bytes one element takes in the shadow, 0 for types the setters don't
+// know. Those get no shadow space and every set of them is refused.
+static u32 uniform_type_size(u32 type)
+{
+    if (int_like(type)) return 4; // ints, bools and samplers
+    switch (type)
+    {
+    case GL_FLOAT:
+    case GL_UNSIGNED_INT: return 4;
+    case GL_FLOAT_VEC2:
+    case GL_INT_VEC2:
+    case GL_UNSIGNED_INT_VEC2:
+    case GL_BOOL_VEC2: return 8;
+    case GL_FLOAT_VEC3:
+    case GL_INT_VEC3:
+    case GL_UNSIGNED_INT_VEC3:
+    case GL_BOOL_VEC3: return 12;
+    case GL_FLOAT_VEC4:
+    case GL_INT_VEC4:
+    case GL_UNSIGNED_INT_VEC4:
+    case GL_BOOL_VEC4:
+    case GL_FLOAT_MAT2: return 16;
+    case GL_FLOAT_MAT2x3:
+    case GL_FLOAT_MAT3x2: return 24;
+    case GL_FLOAT_MAT2x4:
+    case GL_FLOAT_MAT4x2: return 32;
+    case GL_FLOAT_MAT3: return 36;
+    case GL_FLOAT_MAT3x4:
+    case GL_FLOAT_MAT4x3: return 48;
+    case GL_FLOAT_MAT4: return 64;
+    default: return 0;
+    }
+}
+
+static void free_reflection(shader_t *shader)
+{
+    if (shader->uniforms)
+    {
+        FREE(shader->uniforms,
+             sizeof(shader_uniform_t) * shader->uniform_count, MEM_RENDER);
+        FREE(shader->lookup, sizeof(u16) * (shader->lookup_mask + 1),
+             MEM_RENDER);
+    }
+    if (shader->values) FREE(shader->values, shader->values_size, MEM_RENDER);
+    if (shader->blocks)
+    {
+        FREE(shader->blocks, sizeof(shader_block_t) * shader->block_count,
+             MEM_RENDER);
+    }
+
+    shader->uniforms = NULL;
+    shader->uniform_count = 0;
+    shader->lookup = NULL;
+    shader->lookup_mask = 0;
+    shader->values = NULL;
+    shader->values_size = 0;
+    shader->blocks = NULL;
+    shader->block_count = 0;
+}
+
+// Loose uniforms only, block members live in the UBOs
+static void reflect_uniforms(shader_t *shader)
+{
+    u32 program = shader->program;
+    GLint active = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &active);
+    if (active <= 0) return;
+
+    GLuint *indices = ALLOC(sizeof(GLuint) * (u32)active, MEM_RENDER);
+    GLint *block_of = ALLOC(sizeof(GLint) * (u32)active, MEM_RENDER);
+    for (GLint i = 0; i < active; i++) indices[i] = (GLuint)i;
+    glGetActiveUniformsiv(program, active, indices, GL_UNIFORM_BLOCK_INDEX,
+                          block_of);
+
+    u32 count = 0;
+    for (GLint i = 0; i < active; i++) count += block_of[i] == -1;
+
+    if (count > 0)
+    {
+        u32 slots = 8;
+        while (slots < count * 2) slots *= 2;
+
+        shader->uniforms = ALLOC(sizeof(shader_uniform_t) * count, MEM_RENDER);
+        shader->lookup = ALLOC(sizeof(u16) * slots, MEM_RENDER);
+        shader->lookup_mask = slots - 1;
+        memset(shader->lookup, 0, sizeof(u16) * slots);
+    }
+
+    u32 offset = 0;
+    for (GLint i = 0; i < active && shader->uniforms; i++)
+    {
+        if (block_of[i] != -1) continue;
+
+        char name[128];
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, sizeof(name), NULL, &size,
+                           &type, name);
+
+        // arrays are reported as "name[0]"
+        char *bracket = strchr(name, '[');
+        if (bracket) *bracket = '\0';
+
+        shader_uniform_t *u = &shader->uniforms[shader->uniform_count];
+        u->name = shader_sys_name(name);
+        u->location = glGetUniformLocation(program, name);
+        u->type = type;
+        u->count = (u32)size;
+        u->size = uniform_type_size(type) * u->count;
+        if (!u->size)
+        {
+            LOG_WARN("shader: uniform '%s' has unknown type 0x%x, it can't "
+                     "be set",
+                     name, type);
+        }
+        u->offset = offset;
+        offset += u->size;
+
+        u32 slot = lookup_slot(u->name, shader->lookup_mask);
+        while (shader->lookup[slot])
+            slot = (slot + 1) & shader->lookup_mask;
+        shader->lookup[slot] = (u16)(++shader->uniform_count);
+    }
+
+    // shadow starts unknown, the first set of each uniform always uploads
+    if (offset)
+    {
+        shader->values_size = offset + shader->uniform_count;
+        shader->values = ALLOC(shader->values_size, MEM_RENDER);
+        memset(shader->values, 0, shader->values_size);
+    }
+
+    FREE(indices, sizeof(GLuint) * (u32)active, MEM_RENDER);
+    FREE(block_of, sizeof(GLint) * (u32)active, MEM_RENDER);
+
+    // samplers keep their unit for the program's life, GL 3.3 has no
+    // layout(binding) to do it in the source. Unused ones are skipped.
+    for (u32 k = 0; k < ARRAY_SIZE(g_sampler_units); k++)
+    {
+        shader_sys_set_i32(shader, shader_sys_name(g_sampler_units[k].name),
+                           (i32)g_sampler_units[k].unit);
+    }
+}
+
+static void reflect_blocks(shader_t *shader)
+{
+    u32 program = shader->program;
+    GLint active = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &active);
+    if (active <= 0) return;
+
+    shader->blocks = ALLOC(sizeof(shader_block_t) * (u32)active, MEM_RENDER);
+    shader->block_count = (u32)active;
+
+    for (GLint i = 0; i < active; i++)
+    {
+        char name[128];
+        GLint size = 0;
+        glGetActiveUniformBlockName(program, (GLuint)i, sizeof(name), NULL,
+                                    name);
+        glGetActiveUniformBlockiv(program, (GLuint)i,
+                                  GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+
+        shader_block_t *b = &shader->blocks[i];
+        b->name = shader_sys_name(name);
+        b->index = (u32)i;
+        b->size = (u32)size;
+        b->binding = INVALID_32;
+
+        for (u32 k = 0; k < ARRAY_SIZE(g_block_bindings); k++)
+        {
+            if (strcmp(name, g_block_bindings[k].name) != 0) continue;
+            b->binding = g_block_bindings[k].binding;
+            glUniformBlockBinding(program, b->index, b->binding);
+        }
+        if (b->binding == INVALID_32)
+            LOG_WARN("shader: uniform block '%s' has no binding", name);
+    }
+}
+
+// Reflection, once the program is linked
+static void finish_shader(shader_t *shader, u32 program)
+{
+    free_reflection(shader);
+    shader->program = program;
+    reflect_uniforms(shader);
+    reflect_blocks(shader);
+}
+
+static void delete_shader(shader_t *shader)
+{
+    gl_state_delete_program(shader->program);
+    free_reflection(shader);
+    shader->program = 0;
+}
+
 shader_system_t *shader_sys_init(arena_alloc_t *arena)
 {
     shader_system_t *sh = arena_alloc(arena, sizeof(shader_system_t));
@@ -14,23 +287,12 @@ shader_system_t *shader_sys_init(arena_alloc_t *arena)
     memset(sh, 0, sizeof(shader_system_t));
 
     sh->arena = arena;
+    g_sh = sh;
 
-    sh->object_shader.program = 0;
-    // sh->object_shader.model = -1;
-    // sh->object_shader.light_pos = -1;
-    // sh->object_shader.view_pos = -1;
-    // sh->object_shader.light_color = -1;
-    // sh->object_shader.object_color = -1;
-
-    // Initialize light shader
-    sh->light_shader.program = 0;
-    // sh->light_shader.model = -1;
-    // sh->light_shader.light_pos = -1;
-    // sh->light_shader.view_pos = -1;
-    // sh->light_shader.light_color = -1;
-    // sh->light_shader.object_color = -1;
+    // everything else may fall back to this one, so it is not deferred
+    u32 program = render_upload_shader("shaders/default");
+    if (program) finish_shader(&sh->default_shader, program);
 
-    g_sh = sh;
     LOG_INFO("Shader System Init");
     return sh;
 }
@@ -38,49 +300,323 @@ shader_system_t *shader_sys_init(arena_alloc_t *arena)
 void shader_sys_kill(shader_system_t *sh)
 {
     if (!g_sh) return;
-    glDeleteProgram(sh->object_shader.program);
-    glDeleteProgram(sh->light_shader.program);
+    shader_sys_poll(sh, true);
+
+    shader_sys_family_kill(&sh->instanced);
+    delete_shader(&sh->default_shader);
+    delete_shader(&sh->object_shader);
+    delete_shader(&sh->light_shader);
+    delete_shader(&sh->debug_shader);
 
     memset(sh, 0, sizeof(shader_system_t));
+    g_sh = NULL;
     LOG_INFO("Shader System Kill");
 }
 
-b8 shader_sys_set(shader_t *shader, const char *name)
+// swap remove, order doesn't matter
+static void remove_job(shader_system_t *sh, u32 index)
 {
-    u32 program = render_upload_shader(name);
-    shader->program = program;
+    sh->job_count--;
+    sh->jobs[index] = sh->jobs[sh->job_count];
+    sh->job_shaders[index] = sh->job_shaders[sh->job_count];
+}
 
-    GLuint block = glGetUniformBlockIndex(shader->program, "camera_block");
-    if (block == GL_INVALID_INDEX)
-        LOG_WARN("invalid dumbass!!!");
-    else
-        glUniformBlockBinding(shader->program, block, 0);
+// The new job replaces whatever shader had, its linked program and any job
+// still pending for it. A failed submit leaves shader as it was.
+static b8 submit(shader_t *shader, const char *name, const char *defines)
+{
+    shader_system_t *sh = g_sh;
+    if (sh->job_count == SHADER_SYS_MAX_JOBS) shader_sys_poll(sh, true);
 
-    // NOTE: this for caching uniform
-    shader->model = glGetUniformLocation(shader->program, "model");
+    render_shader_job_t *job = &sh->jobs[sh->job_count];
+    if (!render_shader_submit(name, defines, job)) return false;
+    sh->job_shaders[sh->job_count++] = shader;
 
-    shader->light_pos = glGetUniformLocation(shader->program, "light_pos");
-    shader->view_pos = glGetUniformLocation(shader->program, "view_pos");
-    shader->light_color = glGetUniformLocation(shader->program, "light_color");
-    shader->object_color =
-        glGetUniformLocation(shader->program, "object_color");
+    // at most one job per shader, the new one is last
+    for (u32 i = 0; i + 1 < sh->job_count; i++)
+    {
+        if (sh->job_shaders[i] != shader) continue;
+        render_shader_cancel(&sh->jobs[i]);
+        remove_job(sh, i);
+        break;
+    }
+    delete_shader(shader);
     return true;
 }
 
-void shader_sys_bind(shader_t *shader)
+b8 shader_sys_set(shader_t *shader, const char *name)
+{
+    return submit(shader, name, NULL);
+}
+
+void shader_sys_adopt(shader_t *shader, u32 program)
+{
+    finish_shader(shader, program);
+}
+
+void shader_sys_release(shader_t *shader) { delete_shader(shader); }
+
+/*************************
+ * Permutations
+ *************************/
+void shader_sys_family_init(shader_family_t *family, const char *name,
+                            const char *const *features, u32 feature_count,
+                            const shader_t *fallback)
+{
+    ASSERT(feature_count <= SHADER_SYS_MAX_FEATURES, "too many features");
+    memset(family, 0, sizeof(shader_family_t));
+    snprintf(family->name, sizeof(family->name), "%s", name);
+    family->features = features;
+    family->feature_count = feature_count;
+    family->feature_mask = feature_count == 64
+                               ? ~0ull
+                               : (1ull << feature_count) - 1;
+    family->fallback = fallback;
+}
+
+void shader_sys_family_kill(shader_family_t *family)
+{
+    if (family->count == 0) return;
+
+    // jobs still point into the family
+    shader_sys_poll(g_sh, true);
+    for (u32 i = 0; i < family->count; i++)
+        delete_shader(&family->permutations[i]);
+
+    family->count = 0;
+    memset(family->slots, 0, sizeof(family->slots));
+}
+
+shader_t *shader_sys_permutation(shader_family_t *family, u64 mask)
+{
+    mask &= family->feature_mask;
+
+    u32 slot_mask = ARRAY_SIZE(family->slots) - 1;
+    u32 slot = (u32)hash_fnv1a(HASH_FNV1A_SEED, &mask, sizeof(mask)) &
+               slot_mask;
+    while (family->slots[slot])
+    {
+        u32 index = family->slots[slot] - 1u;
+        if (family->masks[index] == mask)
+            return &family->permutations[index];
+        slot = (slot + 1) & slot_mask;
+    }
+
+    if (family->count == SHADER_SYS_MAX_PERMUTATIONS)
+    {
+        LOG_ERROR("shader: %s is out of permutations", family->name);
+        return NULL;
+    }
+
+    char defines[2048];
+    u32 length = 0;
+    defines[0] = '\0';
+    for (u32 i = 0; i < family->feature_count; i++)
+    {
+        if (!(mask & (1ull << i))) continue;
+        int n = snprintf(defines + length, sizeof(defines) - length,
+                         "#define %s 1\n", family->features[i]);
+        if (n < 0 || length + (u32)n >= sizeof(defines))
+        {
+            LOG_ERROR("shader: %s defines too long", family->name);
+            return NULL;
+        }
+        length += (u32)n;
+    }
+
+    u32 index = family->count++;
+    shader_t *shader = &family->permutations[index];
+    memset(shader, 0, sizeof(shader_t));
+    shader->fallback = family->fallback;
+    family->masks[index] = mask;
+    family->slots[slot] = (u8)(index + 1);
+
+    // a failed submit stays in the table, the fallback keeps drawing
+    submit(shader, family->name, defines);
+    LOG_DEBUG("shader: %s permutation %llx", family->name,
+              (unsigned long long)mask);
+    return shader;
+}
+
+u32 shader_sys_poll(shader_system_t *sh, b8 wait)
+{
+    u32 i = 0;
+    while (i < sh->job_count)
+    {
+        render_shader_job_t *job = &sh->jobs[i];
+        render_shader_status_t status = render_shader_poll(job, wait);
+        if (status == RENDER_SHADER_PENDING)
+        {
+            i++;
+            continue;
+        }
+
+        if (status == RENDER_SHADER_READY)
+        {
+            finish_shader(sh->job_shaders[i], job->program);
+            LOG_DEBUG("shader ready: %s", job->name);
+        }
+        else
+            LOG_ERROR("shader failed: %s", job->name);
+
+        remove_job(sh, i);
+    }
+    return sh->job_count;
+}
+
+b8 shader_sys_bind(shader_t *shader)
+{
+    if (shader->program)
+    {
+        gl_state_use_program(shader->program);
+        return true;
+    }
+    if (shader->fallback && shader->fallback->program)
+    {
+        gl_state_use_program(shader->fallback->program);
+        return true;
+    }
+    return false;
+}
+
+/*************************
+ * Names
+ *************************/
+u32 shader_sys_name(const char *name)
+{
+    shader_system_t *sh = g_sh;
+    u64 hash = hash_fnv1a_str(HASH_FNV1A_SEED, name);
+    u32 slot = (u32)hash & (SHADER_SYS_NAME_SLOTS - 1);
+
+    while (sh->name_slots[slot])
+    {
+        u32 id = sh->name_slots[slot] - 1;
+        if (sh->name_hashes[id] == hash && strcmp(sh->names[id], name) == 0)
+            return id;
+        slot = (slot + 1) & (SHADER_SYS_NAME_SLOTS - 1);
+    }
+
+    if (sh->name_count == SHADER_SYS_MAX_NAMES)
+    {
+        LOG_ERROR("shader: name table full, '%s' dropped", name);
+        return INVALID_32;
+    }
+
+    u64 length = strlen(name) + 1;
+    char *copy = arena_alloc(sh->arena, length);
+    if (!copy) return INVALID_32;
+    memcpy(copy, name, length);
+
+    u32 id = sh->name_count++;
+    sh->names[id] = copy;
+    sh->name_hashes[id] = hash;
+    sh->name_slots[slot] = id + 1;
+    return id;
+}
+
+const char *shader_sys_name_str(u32 name)
+{
+    if (!g_sh || name >= g_sh->name_count) return NULL;
+    return g_sh->names[name];
+}
+
+/*************************
+ * Uniforms
+ *************************/
+i32 shader_sys_find(const shader_t *shader, u32 name)
+{
+    if (!shader->lookup) return -1;
+
+    u32 slot = lookup_slot(name, shader->lookup_mask);
+    while (shader->lookup[slot])
+    {
+        u32 index = shader->lookup[slot] - 1u;
+        if (shader->uniforms[index].name == name) return (i32)index;
+        slot = (slot + 1) & shader->lookup_mask;
+    }
+    return -1;
+}
+
+const shader_block_t *shader_sys_find_block(const shader_t *shader,
+                                            u32 name)
+{
+    for (u32 i = 0; i < shader->block_count; i++)
+        if (shader->blocks[i].name == name) return &shader->blocks[i];
+    return NULL;
+}
+
+// Updates the shadow, returns the uniform when GL needs the new value
+static shader_uniform_t *shadow_update(shader_t *shader, u32 name, u32 type,
+                                       const void *data, u32 size)
+{
+    i32 index = shader_sys_find(shader, name);
+    if (index < 0) return NULL;
+
+    shader_uniform_t *u = &shader->uniforms[index];
+    b8 type_ok = u->type == type || (type == GL_INT && int_like(u->type));
+    if (!type_ok || size > u->size)
+    {
+        LOG_WARN("shader: '%s' set with the wrong type",
+                 shader_sys_name_str(name));
+        return NULL;
+    }
+
+    // one known flag per uniform after the values
+    u8 *known = shader->values + shader->values_size - shader->uniform_count;
+    u8 *dst = shader->values + u->offset;
+    if (known[index] && memcmp(dst, data, size) == 0) return NULL;
+
+    memcpy(dst, data, size);
+    known[index] = 1;
+    gl_state_use_program(shader->program);
+    return u;
+}
+
+void shader_sys_set_mat4(shader_t *shader, u32 name, mat4 m)
+{
+    shader_uniform_t *u =
+        shadow_update(shader, name, GL_FLOAT_MAT4, m.data, sizeof(f32) * 16);
+    if (u) glUniformMatrix4fv(u->location, 1, GL_FALSE, m.data);
+}
+
+void shader_sys_set_vec4(shader_t *shader, u32 name, vec4 v)
+{
+    shader_uniform_t *u = shadow_update(shader, name, GL_FLOAT_VEC4,
+                                        v.elements, sizeof(f32) * 4);
+    if (u) glUniform4fv(u->location, 1, v.elements);
+}
+
+void shader_sys_set_vec3(shader_t *shader, u32 name, vec3 v)
+{
+    shader_uniform_t *u = shadow_update(shader, name, GL_FLOAT_VEC3,
+                                        v.elements, sizeof(f32) * 3);
+    if (u) glUniform3fv(u->location, 1, v.elements);
+}
+
+void shader_sys_set_f32(shader_t *shader, u32 name, f32 v)
+{
+    shader_uniform_t *u = shadow_update(shader, name, GL_FLOAT, &v, sizeof(v));
+    if (u) glUniform1f(u->location, v);
+}
+
+void shader_sys_set_vec4s(shader_t *shader, u32 name, const vec4 *v,
+                          u32 count)
 {
-    if (shader->program) glUseProgram(shader->program);
+    shader_uniform_t *u = shadow_update(shader, name, GL_FLOAT_VEC4, v,
+                                        sizeof(vec4) * count);
+    if (u) glUniform4fv(u->location, (GLsizei)count, v[0].elements);
 }
 
-void shader_sys_set_uniform_mat4(shader_t *shader, mat4 matrix)
+// ints, bools and sampler units
+void shader_sys_set_i32(shader_t *shader, u32 name, i32 v)
 {
-    if (shader->model == -1) return;
-    glUniformMatrix4fv(shader->model, 1, GL_FALSE, matrix.data);
+    shader_uniform_t *u = shadow_update(shader, name, GL_INT, &v, sizeof(v));
+    if (u) glUniform1i(u->location, v);
 }
 
-void shader_sys_set_vec3(shader_t *shader, i32 loc, vec3 v)
+void shader_sys_set_u32(shader_t *shader, u32 name, u32 v)
 {
-    (void)shader;
-    if (loc == -1) return;
-    glUniform3fv(loc, 1, &v.x);
+    shader_uniform_t *u =
+        shadow_update(shader, name, GL_UNSIGNED_INT, &v, sizeof(v));
+    if (u) glUniform1ui(u->location, v);
 }
@@ -4,35 +4,153 @@
 #include "engine/core/define.h" // IWYU pragma: keep
 #include "engine/core/memory/arena.h"
 #include "engine/core/math/math_types.h"
+#include "engine/rendering/render.h"
+
+/*
+ * Every active uniform and uniform block is reflected when a program
+ * links. Uniforms are looked up by interned name (shader_sys_name, once at
+ * setup) through a small per-shader hash table, and each keeps a CPU copy
+ * of its value so setting an unchanged value issues no GL call.
+ */
+
+// Programs still compiling after shader_sys_set
+#define SHADER_SYS_MAX_JOBS 256
+#define SHADER_SYS_MAX_NAMES 1024
+#define SHADER_SYS_NAME_SLOTS (SHADER_SYS_MAX_NAMES * 2)
+#define SHADER_SYS_MAX_FEATURES 64
+#define SHADER_SYS_MAX_PERMUTATIONS 32
+
+typedef struct {
+    u32 name; // interned
+    i32 location;
+    u32 type; // GL_FLOAT_VEC3, ...
+    u32 count; // array length
+    u32 offset; // into shader_t.values
+    u32 size;
+} shader_uniform_t;
 
 typedef struct {
-    u32 program;
-    i32 model;
-    // i32 view;
-    // i32 proj;
-
-    i32 light_pos;
-    i32 view_pos;
-    i32 light_color;
-    i32 object_color;
+    u32 name;
+    u32 index;
+    u32 binding; // INVALID_32 when it's not one of the shared blocks
+    u32 size;
+} shader_block_t;
+
+typedef struct shader_t {
+    u32 program; // 0 until linked
+    // bound instead while program is 0, NULL skips the draw
+    const struct shader_t *fallback;
+
+    shader_uniform_t *uniforms;
+    u32 uniform_count;
+    u16 *lookup; // open addressing, uniform index + 1, 0 is empty
+    u32 lookup_mask;
+
+    shader_block_t *blocks;
+    u32 block_count;
+
+    // last uploaded value of every uniform, then a set flag per uniform
+    u8 *values;
+    u32 values_size;
 } shader_t;
 
+// Bit i of a permutation mask defines features[i]. Permutations compile on
+// first request, the fallback stands in until they link.
+typedef struct {
+    char name[64];
+    const char *const *features;
+    u32 feature_count;
+    u64 feature_mask; // bits that have a feature, others are ignored
+    const shader_t *fallback;
+
+    u64 masks[SHADER_SYS_MAX_PERMUTATIONS];
+    shader_t permutations[SHADER_SYS_MAX_PERMUTATIONS];
+    u32 count;
+    u8 slots[SHADER_SYS_MAX_PERMUTATIONS * 2]; // index + 1, 0 is empty
+} shader_family_t;
+
 typedef struct {
     arena_alloc_t *arena;
+    shader_t default_shader; // flat object_color, linked at init
     shader_t object_shader;
     shader_t light_shader;
+    shader_t debug_shader; // debug_draw lines
+    shader_family_t instanced;
+
+    render_shader_job_t jobs[SHADER_SYS_MAX_JOBS];
+    shader_t *job_shaders[SHADER_SYS_MAX_JOBS];
+    u32 job_count;
+
+    // interned uniform names, ids index names
+    const char *names[SHADER_SYS_MAX_NAMES];
+    u64 name_hashes[SHADER_SYS_MAX_NAMES];
+    u32 name_count;
+    u32 name_slots[SHADER_SYS_NAME_SLOTS]; // id + 1, 0 is empty
 } shader_system_t;
 
 shader_system_t *shader_sys_init(arena_alloc_t *arena);
 
 void shader_sys_kill(shader_system_t *sh);
 
+// Submits name for compiling, the shader becomes usable once
+// shader_sys_poll sees it linked. Setting it again deletes the program it
+// had and drops a job still pending for it.
 b8 shader_sys_set(shader_t *shader, const char *name);
 
-void shader_sys_bind(shader_t *shader);
+// Takes over a program linked elsewhere, e.g. by render_upload_compute,
+// and reflects it so the setters below work on it
+void shader_sys_adopt(shader_t *shader, u32 program);
+
+// Deletes the program and its reflection
+void shader_sys_release(shader_t *shader);
+
+// features must outlive the family, at most SHADER_SYS_MAX_FEATURES
+void shader_sys_family_init(shader_family_t *family, const char *name,
+                            const char *const *features, u32 feature_count,
+                            const shader_t *fallback);
+
+// Deletes every permutation, waits for the ones still compiling
+void shader_sys_family_kill(shader_family_t *family);
+
+// Same mask, same shader. The first request submits the compile with a
+// #define per set bit. NULL when the family is full.
+shader_t *shader_sys_permutation(shader_family_t *family, u64 mask);
+
+// Picks up finished programs, wait blocks until all are done. Returns how
+// many are still compiling.
+u32 shader_sys_poll(shader_system_t *sh, b8 wait);
+
+// Binds the program or its fallback, false when neither is ready
+b8 shader_sys_bind(shader_t *shader);
+
+// Same string, same id. INVALID_32 when the table is full.
+u32 shader_sys_name(const char *name);
+
+const char *shader_sys_name_str(u32 name);
+
+// Index into shader->uniforms, or -1 when the program doesn't use it
+i32 shader_sys_find(const shader_t *shader, u32 name);
+
+const shader_block_t *shader_sys_find_block(const shader_t *shader,
+                                            u32 name);
+
+// Setters upload only when the value differs from the shadow. They bind
+// the shader's program, which gl_state elides when it's current.
+void shader_sys_set_mat4(shader_t *shader, u32 name, mat4 m);
+
+void shader_sys_set_vec4(shader_t *shader, u32 name, vec4 v);
+
+// The first count elements of a vec4 array
+void shader_sys_set_vec4s(shader_t *shader, u32 name, const vec4 *v,
+                          u32 count);
+
+void shader_sys_set_vec3(shader_t *shader, u32 name, vec3 v);
+
+void shader_sys_set_f32(shader_t *shader, u32 name, f32 v);
 
-void shader_sys_set_uniform_mat4(shader_t *shader, mat4 matrix);
+// ints, bools and sampler units
+void shader_sys_set_i32(shader_t *shader, u32 name, i32 v);
 
-void shader_sys_set_vec3(shader_t *shader, i32 loc, vec3 v);
+void shader_sys_set_u32(shader_t *shader, u32 name, u32 v);
 
 #endif // SHADER_SYSTEM_H
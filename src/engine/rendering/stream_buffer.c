@@ -0,0 +1,168 @@
+#include "stream_buffer.h"
+#include "engine/rendering/gl_ext.h"
+#include "engine/rendering/gl_state.h"
+
+// std
+#include <string.h>
+
+#define FENCE_TIMEOUT_NS 1000000ull // 1ms per wait, loop until signaled
+
+// alignment may be a struct size, not only a power of two
+static u64 align_up(u64 v, u64 a) { return (v + a - 1) / a * a; }
+
+static u64 region_base(const stream_buffer_t *sb)
+{
+    return (u64)sb->region * sb->region_size;
+}
+
+b8 stream_buffer_create(stream_buffer_t *sb, u32 target, u64 region_size,
+                        u32 alignment)
+{
+    memset(sb, 0, sizeof(stream_buffer_t));
+    sb->target = target;
+
+    if (alignment == 0)
+    {
+        GLint a = 16;
+        if (target == GL_UNIFORM_BUFFER)
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &a);
+        alignment = (u32)MAX(a, 16);
+    }
+    sb->alignment = alignment;
+    sb->region_size = align_up(region_size, alignment);
+
+    u64 total = sb->region_size * STREAM_BUFFER_FRAMES;
+    glGenBuffers(1, &sb->buffer);
+    gl_state_bind_buffer(target, sb->buffer);
+
+    if (g_gl_ext.buffer_storage)
+    {
+        GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        g_gl_ext.BufferStorage(target, (GLsizeiptr)total, NULL, flags);
+        sb->mapped = glMapBufferRange(target, 0, (GLsizeiptr)total, flags);
+        sb->persistent = sb->mapped != NULL;
+        if (!sb->persistent)
+        {
+            // immutable storage can't be re-specified, start over
+            LOG_WARN("stream buffer: persistent map failed, orphaning");
+            gl_state_delete_buffer(sb->buffer);
+            glGenBuffers(1, &sb->buffer);
+            gl_state_bind_buffer(target, sb->buffer);
+        }
+    }
+
+    if (!sb->persistent)
+        glBufferData(target, (GLsizeiptr)total, NULL, GL_STREAM_DRAW);
+
+    // begin_frame advances first, so the first frame lands in region 0
+    sb->region = STREAM_BUFFER_FRAMES - 1;
+    return sb->buffer != 0;
+}
+
+void stream_buffer_destroy(stream_buffer_t *sb)
+{
+    if (!sb->buffer) return;
+
+    for (u32 i = 0; i < STREAM_BUFFER_FRAMES; i++)
+        if (sb->fences[i]) glDeleteSync((GLsync)sb->fences[i]);
+
+    if (sb->mapped)
+    {
+        gl_state_bind_buffer(sb->target, sb->buffer);
+        glUnmapBuffer(sb->target);
+    }
+    gl_state_delete_buffer(sb->buffer);
+    memset(sb, 0, sizeof(stream_buffer_t));
+}
+
+void stream_buffer_begin_frame(stream_buffer_t *sb)
+{
+    sb->region = (sb->region + 1) % STREAM_BUFFER_FRAMES;
+    sb->head = 0;
+
+    if (sb->persistent)
+    {
+        GLsync fence = (GLsync)sb->fences[sb->region];
+        if (!fence) return;
+
+        // only blocks when the GPU is more than two frames behind
+        GLenum r = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                    FENCE_TIMEOUT_NS);
+        while (r == GL_TIMEOUT_EXPIRED)
+            r = glClientWaitSync(fence, 0, FENCE_TIMEOUT_NS);
+        if (r == GL_WAIT_FAILED) LOG_WARN("stream buffer: fence wait failed");
+
+        glDeleteSync(fence);
+        sb->fences[sb->region] = NULL;
+        return;
+    }
+
+    if (sb->region == 0)
+    {
+        gl_state_bind_buffer(sb->target, sb->buffer);
+        glBufferData(sb->target,
+                     (GLsizeiptr)(sb->region_size * STREAM_BUFFER_FRAMES),
+                     NULL, GL_STREAM_DRAW);
+    }
+}
+
+void *stream_buffer_alloc(stream_buffer_t *sb, u64 size, u64 *out_offset)
+{
+    u64 head = align_up(sb->head, sb->alignment);
+    if (head + size > sb->region_size)
+    {
+        LOG_WARN("stream buffer: region full (%lu + %lu > %lu)", head, size,
+                 sb->region_size);
+        return NULL;
+    }
+
+    u64 offset = region_base(sb) + head;
+    sb->head = head + size;
+    if (out_offset) *out_offset = offset;
+
+    if (sb->persistent) return sb->mapped + offset;
+
+    // map the rest of the region once, later allocs reuse the mapping
+    if (!sb->mapped)
+    {
+        u64 length = region_base(sb) + sb->region_size - offset;
+        gl_state_bind_buffer(sb->target, sb->buffer);
+        sb->mapped = glMapBufferRange(
+            sb->target, (GLintptr)offset, (GLsizeiptr)length,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                GL_MAP_INVALIDATE_RANGE_BIT);
+        sb->mapped_offset = offset;
+        if (!sb->mapped)
+        {
+            LOG_ERROR("stream buffer: glMapBufferRange failed");
+            return NULL;
+        }
+    }
+    return sb->mapped + (offset - sb->mapped_offset);
+}
+
+void stream_buffer_flush(stream_buffer_t *sb)
+{
+    // coherent mapping needs nothing, the fallback can't draw while mapped
+    if (sb->persistent || !sb->mapped) return;
+
+    gl_state_bind_buffer(sb->target, sb->buffer);
+    glUnmapBuffer(sb->target);
+    sb->mapped = NULL;
+}
+
+void stream_buffer_end_frame(stream_buffer_t *sb)
+{
+    stream_buffer_flush(sb);
+    if (!sb->persistent) return;
+
+    sb->fences[sb->region] =
+        (void *)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void stream_buffer_bind_range(stream_buffer_t *sb, u32 index, u64 offset,
+                              u64 size)
+{
+    gl_state_bind_buffer_range(sb->target, index, sb->buffer, offset, size);
+}
@@ -0,0 +1,59 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * Ring of STREAM_BUFFER_FRAMES regions for data rewritten every frame.
+ *
+ * With buffer_storage the whole buffer is mapped once, persistent and
+ * coherent, and each region is guarded by a fence placed at the end of
+ * the frame that wrote it. Without it the buffer is orphaned each time the
+ * ring wraps and regions are mapped UNSYNCHRONIZED on demand, since
+ * nothing in fresh storage can still be in flight.
+ *
+ * Per frame: begin_frame, any number of alloc, flush before the draws that
+ * read the data, end_frame.
+ */
+
+#define STREAM_BUFFER_FRAMES 3
+
+typedef struct {
+    u32 buffer;
+    u32 target;
+    u32 alignment;
+
+    u64 region_size;
+    u32 region;
+    u64 head; // write offset inside the current region
+
+    u8 *mapped;
+    u64 mapped_offset; // fallback, absolute offset the mapping starts at
+    b8 persistent;
+
+    void *fences[STREAM_BUFFER_FRAMES];
+} stream_buffer_t;
+
+// alignment of 0 picks GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform
+// buffers and 16 for anything else
+b8 stream_buffer_create(stream_buffer_t *sb, u32 target, u64 region_size,
+                        u32 alignment);
+
+void stream_buffer_destroy(stream_buffer_t *sb);
+
+void stream_buffer_begin_frame(stream_buffer_t *sb);
+
+// Returns a write pointer and the absolute buffer offset of the block, or
+// NULL when the region is full
+void *stream_buffer_alloc(stream_buffer_t *sb, u64 size, u64 *out_offset);
+
+// Makes everything allocated so far visible to GL, draws may read it after
+void stream_buffer_flush(stream_buffer_t *sb);
+
+void stream_buffer_end_frame(stream_buffer_t *sb);
+
+// glBindBufferRange of a block returned by stream_buffer_alloc
+void stream_buffer_bind_range(stream_buffer_t *sb, u32 index, u64 offset,
+                              u64 size);
+
+#endif // STREAM_BUFFER_H
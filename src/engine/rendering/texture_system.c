@@ -0,0 +1,743 @@
+#include "texture_system.h"
+#include "engine/core/hash.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+#include "engine/rendering/gl_ext.h"
+#include "engine/rendering/gl_state.h"
+#include "engine/resource/image_ops.h"
+#include "engine/resource/resc_loader.h"
+
+#include "deps/glad/glad.h"
+
+// std
+#include <stdio.h>
+#include <string.h>
+
+static texture_system_t *g_ts = NULL;
+
+static const GLenum g_gl_formats[BC_FORMAT_COUNT] = {
+    [BC_FORMAT_NONE] = GL_RGBA8,
+    [BC_FORMAT_BC1] = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+    [BC_FORMAT_BC3] = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+    [BC_FORMAT_BC4] = GL_COMPRESSED_RED_RGTC1,
+    [BC_FORMAT_BC5] = GL_COMPRESSED_RG_RGTC2,
+    [BC_FORMAT_BC7] = GL_COMPRESSED_RGBA_BPTC_UNORM,
+};
+
+static bc_format_t pick_format(const texture_system_t *ts,
+                               texture_usage_t usage, const u8 *pixels,
+                               u64 count)
+{
+    bc_format_t format = BC_FORMAT_BC7;
+    if (usage == TEXTURE_USAGE_NORMAL)
+        format = BC_FORMAT_BC5;
+    else if (usage == TEXTURE_USAGE_MASK)
+        format = BC_FORMAT_BC4;
+    else if (!(ts->formats & (1u << BC_FORMAT_BC7)))
+    {
+        format = BC_FORMAT_BC1;
+        for (u64 i = 0; i < count; i++)
+        {
+            if (pixels[i * 4 + 3] != 255)
+            {
+                format = BC_FORMAT_BC3;
+                break;
+            }
+        }
+    }
+    return ts->formats & (1u << format) ? format : BC_FORMAT_NONE;
+}
+
+// The machine split between the workers busy right now, so one big
+// texture alone encodes on every core. Taken once per texture, requests
+// arriving mid encode oversubscribe for a moment.
+static u32 encode_threads(texture_system_t *ts)
+{
+    mutex_lock(&ts->lock);
+    u32 busy = MAX(ts->busy, 1u);
+    mutex_unlock(&ts->lock);
+    return MAX(ts->hw_threads / busy, 1u);
+}
+
+// RGBA8 mips filtered for the usage, then compressed level by level.
+// data is NULL when out of memory.
+static texture_file_t cook(texture_system_t *ts, texture_usage_t usage,
+                           const u8 *pixels, u32 width, u32 height)
+{
+    texture_file_t file = {
+        .width = width,
+        .height = height,
+        .levels = image_mip_count(width, height),
+    };
+
+    u64 rgba_size = image_mip_chain_size(width, height);
+    u8 *rgba = ALLOC(rgba_size, MEM_RESOURCE);
+    if (!rgba) return file;
+
+    u64 base_size = (u64)width * height * 4;
+    memcpy(rgba, pixels, base_size);
+    image_build_mips(rgba, width, height, IMAGE_FILTER_BOX,
+                     usage == TEXTURE_USAGE_COLOR);
+    // averaged normals come out short
+    if (usage == TEXTURE_USAGE_NORMAL)
+    {
+        u32 count = (u32)((rgba_size - base_size) / 4);
+        image_renormalize(rgba + base_size, count);
+    }
+
+    file.format = pick_format(ts, usage, pixels, (u64)width * height);
+    if (file.format == BC_FORMAT_NONE)
+    {
+        file.data = rgba;
+        file.size = file.alloc_size = rgba_size;
+        return file;
+    }
+
+    file.size = texture_file_chain_size(file.format, width, height,
+                                        file.levels);
+    file.alloc_size = file.size;
+    file.data = ALLOC(file.size, MEM_RESOURCE);
+    if (file.data)
+    {
+        const u8 *src = rgba;
+        u8 *dst = file.data;
+        u32 threads = encode_threads(ts);
+        for (u32 level = 0; level < file.levels; level++)
+        {
+            bc_encode_image(file.format, TEX_SYS_QUALITY, dst, src, width,
+                            height, threads);
+            src += (u64)width * height * 4;
+            dst += bc_image_size(file.format, width, height);
+            width = MAX(width / 2, 1);
+            height = MAX(height / 2, 1);
+        }
+    }
+    FREE(rgba, rgba_size, MEM_RESOURCE);
+    return file;
+}
+
+// Level 0 only with the edges extruded, mips would bleed between sprites
+static texture_file_t cook_sprite(const u8 *pixels, u32 width, u32 height)
+{
+    u32 border = TEX_SYS_ATLAS_BORDER;
+    texture_file_t file = {
+        .format = BC_FORMAT_NONE,
+        .width = width + border * 2,
+        .height = height + border * 2,
+        .levels = 1,
+    };
+
+    u64 size = (u64)file.width * file.height * 4;
+    file.data = ALLOC(size, MEM_RESOURCE);
+    if (!file.data) return file;
+
+    image_extrude(file.data, pixels, width, height, border);
+    file.size = file.alloc_size = size;
+    return file;
+}
+
+// Runs on a worker, no GL
+static texture_decoded_t decode(texture_system_t *ts,
+                                const texture_t *tex,
+                                texture_handle_t handle)
+{
+    texture_decoded_t out = {.handle = handle};
+
+    u64 size = 0;
+    u8 *data = read_file_binary(tex->path, &size);
+    if (!data) return out;
+
+    // the name covers everything that changes the cooked result except
+    // the source itself, edits show up as a stale hash in the header
+    u64 source_hash = hash_fnv1a(HASH_FNV1A_SEED, data, size);
+    char cache_path[MAX_PATH];
+    if (ts->cache)
+    {
+        u32 params[3] = {tex->usage, TEX_SYS_QUALITY, ts->formats};
+        u64 key = hash_fnv1a_str(HASH_FNV1A_SEED, tex->path);
+        key = hash_fnv1a(key, params, sizeof(params));
+        snprintf(cache_path, sizeof(cache_path),
+                 TEX_SYS_CACHE_DIR "/%016llx" TEXTURE_FILE_EXT,
+                 (unsigned long long)key);
+
+        if (texture_file_read(cache_path, &out.image))
+        {
+            if (out.image.source_hash == source_hash)
+            {
+                FREE(data, size, MEM_RESOURCE);
+                return out;
+            }
+            texture_file_free(&out.image);
+        }
+    }
+
+    i32 width = 0, height = 0, channels = 0;
+    u8 *pixels = stbi_load_from_memory(data, (i32)size, &width, &height,
+                                       &channels, STBI_rgb_alpha);
+    FREE(data, size, MEM_RESOURCE);
+
+    // stbi_failure_reason is one global in this version, the other
+    // workers overwrite it
+    if (!pixels)
+    {
+        LOG_WARN("texture: can't decode %s", tex->path);
+        return out;
+    }
+
+    // small sprites skip the cook, oversized ones are plain color
+    u32 max_sprite = TEX_SYS_ATLAS_MAX_SPRITE;
+    texture_usage_t usage = tex->usage;
+    out.atlas = usage == TEXTURE_USAGE_SPRITE && (u32)width <= max_sprite &&
+                (u32)height <= max_sprite;
+    if (usage == TEXTURE_USAGE_SPRITE) usage = TEXTURE_USAGE_COLOR;
+
+    if (out.atlas)
+        out.image = cook_sprite(pixels, (u32)width, (u32)height);
+    else
+        out.image = cook(ts, usage, pixels, (u32)width, (u32)height);
+    out.image.source_hash = source_hash;
+    stbi_image_free(pixels);
+
+    if (ts->cache && out.image.data && out.image.format != BC_FORMAT_NONE)
+        texture_file_write(cache_path, &out.image);
+    return out;
+}
+
+static void worker_main(void *arg)
+{
+    texture_system_t *ts = arg;
+    for (;;)
+    {
+        mutex_lock(&ts->lock);
+        while (!ts->quit && ts->request_count == 0)
+            cond_wait(&ts->wake, &ts->lock);
+        if (ts->quit)
+        {
+            mutex_unlock(&ts->lock);
+            return;
+        }
+
+        texture_handle_t handle = ts->requests[ts->request_head];
+        ts->request_head = (ts->request_head + 1) % TEX_SYS_MAX_TEXTURES;
+        ts->request_count--;
+        ts->busy++;
+        mutex_unlock(&ts->lock);
+
+        // the path is never written again once requested
+        texture_decoded_t out = decode(ts, &ts->textures[handle], handle);
+
+        mutex_lock(&ts->lock);
+        u32 tail =
+            (ts->decoded_head + ts->decoded_count) % TEX_SYS_MAX_TEXTURES;
+        ts->decoded[tail] = out;
+        ts->decoded_count++;
+        ts->busy--;
+        mutex_unlock(&ts->lock);
+    }
+}
+
+// Allocates every level for all layers, nothing is uploaded. Needs the
+// unpack buffer unbound, leaves the page bound on unit 0.
+static u32 create_page(texture_system_t *ts, bc_format_t format, u32 width,
+                       u32 height, u32 levels, u32 layers, b8 atlas)
+{
+    if (ts->page_count == TEX_SYS_MAX_PAGES)
+    {
+        LOG_ERROR("texture system: all %u pages in use", TEX_SYS_MAX_PAGES);
+        return INVALID_32;
+    }
+
+    texture_page_t *page = &ts->pages[ts->page_count];
+    memset(page, 0, sizeof(texture_page_t));
+    if (atlas)
+    {
+        page->packers = ALLOC(sizeof(atlas_packer_t) * layers, MEM_RENDER);
+        if (!page->packers)
+        {
+            LOG_ERROR("texture system: out of memory for an atlas page");
+            return INVALID_32;
+        }
+        for (u32 i = 0; i < layers; i++)
+            atlas_packer_init(&page->packers[i], width, height);
+    }
+    page->format = format;
+    page->width = width;
+    page->height = height;
+    page->levels = levels;
+    page->layer_count = layers;
+
+    glGenTextures(1, &page->id);
+    gl_state_bind_texture(0, GL_TEXTURE_2D_ARRAY, page->id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL,
+                    (GLint)levels - 1);
+
+    GLenum gl_format = g_gl_formats[format];
+    for (u32 level = 0; level < levels; level++)
+    {
+        if (format == BC_FORMAT_NONE)
+        {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, GL_RGBA8,
+                         (GLsizei)width, (GLsizei)height, (GLsizei)layers, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        else
+        {
+            u64 size = bc_image_size(format, width, height) * layers;
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level,
+                                   gl_format, (GLsizei)width,
+                                   (GLsizei)height, (GLsizei)layers, 0,
+                                   (GLsizei)size, NULL);
+        }
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+
+    LOG_TRACE("texture page %u: %s %ux%u, %u levels, %u layers%s",
+              ts->page_count, bc_format_name(format), page->width,
+              page->height, levels, layers, atlas ? " (atlas)" : "");
+    return ts->page_count++;
+}
+
+static void create_placeholder(texture_system_t *ts)
+{
+    // white for draws without a texture, then magenta and black, nobody
+    // mistakes it for the real thing
+    const u32 pixels[2][4] = {
+        {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF},
+        {0xFFFF00FF, 0xFF000000, 0xFF000000, 0xFFFF00FF},
+    };
+
+    u32 page = create_page(ts, BC_FORMAT_NONE, 2, 2, 2, 2, false);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 2, 2, 2, GL_RGBA,
+                    GL_UNSIGNED_BYTE, pixels);
+    // complete under the mipmapped samplers too
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    ts->pages[page].layer_used = 2;
+}
+
+static void create_samplers(texture_system_t *ts)
+{
+    glGenSamplers(TEXTURE_SAMPLER_COUNT, ts->samplers);
+
+    u32 s = ts->samplers[TEXTURE_SAMPLER_LINEAR_REPEAT];
+    glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    s = ts->samplers[TEXTURE_SAMPLER_LINEAR_CLAMP];
+    glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    s = ts->samplers[TEXTURE_SAMPLER_NEAREST_CLAMP];
+    glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+texture_system_t *texture_sys_init(arena_alloc_t *arena)
+{
+    texture_system_t *ts = arena_alloc(arena, sizeof(texture_system_t));
+    if (!ts) return NULL;
+    memset(ts, 0, sizeof(texture_system_t));
+    ts->arena = arena;
+
+    ts->textures = ALLOC(sizeof(texture_t) * TEX_SYS_MAX_TEXTURES, MEM_RENDER);
+    ts->requests =
+        ALLOC(sizeof(texture_handle_t) * TEX_SYS_MAX_TEXTURES, MEM_RENDER);
+    ts->decoded =
+        ALLOC(sizeof(texture_decoded_t) * TEX_SYS_MAX_TEXTURES, MEM_RENDER);
+    if (!ts->textures || !ts->requests || !ts->decoded)
+    {
+        LOG_ERROR("texture system: out of memory");
+        return NULL;
+    }
+
+    if (!stream_buffer_create(&ts->upload, GL_PIXEL_UNPACK_BUFFER,
+                              TEX_SYS_UPLOAD_BUDGET, 0))
+    {
+        LOG_ERROR("texture system: failed to create the upload buffer");
+        return NULL;
+    }
+    // a bound unpack buffer turns every client-memory upload into an offset
+    gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    i32 max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    ts->max_layers = (u32)MAX(max_layers, 1);
+    create_placeholder(ts);
+    create_samplers(ts);
+
+    // RGTC is core, the rest depends on the driver
+    ts->formats = (1u << BC_FORMAT_NONE) | (1u << BC_FORMAT_BC4) |
+                  (1u << BC_FORMAT_BC5);
+    if (g_gl_ext.texture_s3tc)
+        ts->formats |= (1u << BC_FORMAT_BC1) | (1u << BC_FORMAT_BC3);
+    if (g_gl_ext.texture_bptc) ts->formats |= 1u << BC_FORMAT_BC7;
+    ts->cache = file_make_dir(TEX_SYS_CACHE_DIR);
+
+    // stb's flag is global in this version, set it before any worker runs
+    stbi_set_flip_vertically_on_load(true);
+
+    mutex_init(&ts->lock);
+    cond_init(&ts->wake);
+    // one core stays with the render thread, CLAMP needs a plain value
+    ts->hw_threads = MAX(thread_hw_count(), 1u);
+    u32 count = MAX(ts->hw_threads - 1, 1u);
+    count = MIN(count, TEX_SYS_MAX_WORKERS);
+    for (u32 i = 0; i < count; i++)
+    {
+        if (!thread_create(&ts->workers[i], worker_main, ts)) break;
+        ts->worker_count++;
+    }
+
+    g_ts = ts;
+    LOG_INFO("Texture System Init (%u workers, %u hardware threads)",
+             ts->worker_count, ts->hw_threads);
+    return ts;
+}
+
+void texture_sys_kill(texture_system_t *ts)
+{
+    if (!g_ts) return;
+
+    mutex_lock(&ts->lock);
+    ts->quit = true;
+    cond_broadcast(&ts->wake);
+    mutex_unlock(&ts->lock);
+    for (u32 i = 0; i < ts->worker_count; i++) thread_join(&ts->workers[i]);
+
+    for (u32 i = 0; i < ts->decoded_count; i++)
+    {
+        u32 index = (ts->decoded_head + i) % TEX_SYS_MAX_TEXTURES;
+        texture_file_free(&ts->decoded[index].image);
+    }
+
+    for (u32 i = 0; i < ts->page_count; i++)
+    {
+        texture_page_t *page = &ts->pages[i];
+        gl_state_delete_texture(page->id);
+        if (page->packers)
+        {
+            FREE(page->packers, sizeof(atlas_packer_t) * page->layer_count,
+                 MEM_RENDER);
+        }
+    }
+    for (u32 i = 0; i < TEXTURE_SAMPLER_COUNT; i++)
+        gl_state_delete_sampler(ts->samplers[i]);
+    stream_buffer_destroy(&ts->upload);
+
+    mutex_destroy(&ts->lock);
+    cond_destroy(&ts->wake);
+
+    FREE(ts->textures, sizeof(texture_t) * TEX_SYS_MAX_TEXTURES, MEM_RENDER);
+    FREE(ts->requests, sizeof(texture_handle_t) * TEX_SYS_MAX_TEXTURES,
+         MEM_RENDER);
+    FREE(ts->decoded, sizeof(texture_decoded_t) * TEX_SYS_MAX_TEXTURES,
+         MEM_RENDER);
+
+    memset(ts, 0, sizeof(texture_system_t));
+    g_ts = NULL;
+    LOG_INFO("Texture System Kill");
+}
+
+texture_handle_t texture_sys_load(texture_system_t *ts, const char *path,
+                                  texture_usage_t usage)
+{
+    u64 hash = hash_fnv1a_str(HASH_FNV1A_SEED, path);
+    for (u32 i = 0; i < ts->texture_count; i++)
+    {
+        const texture_t *tex = &ts->textures[i];
+        if (tex->path_hash == hash && strcmp(tex->path, path) == 0) return i;
+    }
+
+    if (ts->texture_count == TEX_SYS_MAX_TEXTURES)
+    {
+        LOG_ERROR("texture system: table full, %s not loaded", path);
+        return INVALID_32;
+    }
+    if (strlen(path) >= TEX_SYS_PATH_SIZE)
+    {
+        LOG_ERROR("texture system: path too long: %s", path);
+        return INVALID_32;
+    }
+
+    texture_handle_t handle = ts->texture_count++;
+    texture_t *tex = &ts->textures[handle];
+    memset(tex, 0, sizeof(texture_t));
+    tex->state = TEXTURE_LOADING;
+    tex->usage = usage;
+    tex->path_hash = hash;
+    snprintf(tex->path, sizeof(tex->path), "%s", path);
+    ts->in_flight++;
+
+    mutex_lock(&ts->lock);
+    u32 tail = (ts->request_head + ts->request_count) % TEX_SYS_MAX_TEXTURES;
+    ts->requests[tail] = handle;
+    ts->request_count++;
+    cond_signal(&ts->wake);
+    mutex_unlock(&ts->lock);
+
+    return handle;
+}
+
+// Class pages double in layers for each one of the same class, so a class
+// with a single texture doesn't pay for a full page
+static u32 class_page_layers(const texture_system_t *ts,
+                             const texture_file_t *image)
+{
+    u32 siblings = 0;
+    for (u32 i = 0; i < ts->page_count; i++)
+    {
+        const texture_page_t *page = &ts->pages[i];
+        if (!page->packers && page->format == image->format &&
+            page->width == image->width && page->height == image->height &&
+            page->levels == image->levels)
+            siblings++;
+    }
+
+    u32 layers = TEX_SYS_PAGE_LAYERS;
+    if (siblings < 16) layers = MIN(4u << siblings, layers);
+    layers = MIN(layers, ts->max_layers);
+
+    u64 bytes = texture_file_chain_size(image->format, image->width,
+                                        image->height, image->levels);
+    u64 fit = MAX(TEX_SYS_PAGE_BYTES / bytes, 1);
+    return (u32)MIN((u64)layers, fit);
+}
+
+// A free layer of a matching class page, or a new page. Needs the unpack
+// buffer bound.
+static b8 place_layer(texture_system_t *ts, const texture_file_t *image,
+                      texture_region_t *out)
+{
+    u32 found = INVALID_32;
+    for (u32 i = 0; i < ts->page_count && found == INVALID_32; i++)
+    {
+        const texture_page_t *page = &ts->pages[i];
+        if (!page->packers && page->format == image->format &&
+            page->width == image->width && page->height == image->height &&
+            page->levels == image->levels &&
+            page->layer_used < page->layer_count)
+            found = i;
+    }
+
+    if (found == INVALID_32)
+    {
+        u32 layers = class_page_layers(ts, image);
+        gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        found = create_page(ts, image->format, image->width, image->height,
+                            image->levels, layers, false);
+        gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, ts->upload.buffer);
+        if (found == INVALID_32) return false;
+    }
+
+    out->page = found;
+    out->layer = ts->pages[found].layer_used++;
+    out->uv_rect = vec4_create(0.0f, 0.0f, 1.0f, 1.0f);
+    return true;
+}
+
+// First atlas layer with room, or a new atlas page. x and y are where the
+// extruded image goes. Needs the unpack buffer bound.
+static b8 place_sprite(texture_system_t *ts, const texture_file_t *image,
+                       texture_region_t *out, u32 *x, u32 *y)
+{
+    u32 found = INVALID_32;
+    for (u32 i = 0; i < ts->page_count && found == INVALID_32; i++)
+    {
+        texture_page_t *page = &ts->pages[i];
+        for (u32 l = 0; page->packers && l < page->layer_count; l++)
+        {
+            if (atlas_packer_insert(&page->packers[l], image->width,
+                                    image->height, x, y))
+            {
+                found = i;
+                out->layer = l;
+                break;
+            }
+        }
+    }
+
+    if (found == INVALID_32)
+    {
+        u32 layers = MIN(TEX_SYS_ATLAS_LAYERS, ts->max_layers);
+        gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        found = create_page(ts, BC_FORMAT_NONE, TEX_SYS_ATLAS_SIZE,
+                            TEX_SYS_ATLAS_SIZE, 1, layers, true);
+        gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, ts->upload.buffer);
+        if (found == INVALID_32 ||
+            !atlas_packer_insert(&ts->pages[found].packers[0], image->width,
+                                 image->height, x, y))
+            return false;
+        out->layer = 0;
+    }
+
+    // the rect covers the sprite, not its border
+    u32 border = TEX_SYS_ATLAS_BORDER;
+    f32 inv = 1.0f / (f32)TEX_SYS_ATLAS_SIZE;
+    out->page = found;
+    out->uv_rect = vec4_create((f32)(*x + border) * inv,
+                               (f32)(*y + border) * inv,
+                               (f32)(image->width - border * 2) * inv,
+                               (f32)(image->height - border * 2) * inv);
+    ts->pages[found].layer_used = MAX(ts->pages[found].layer_used,
+                                      out->layer + 1);
+    return true;
+}
+
+// Needs the unpack buffer bound
+static void upload(texture_system_t *ts, texture_decoded_t *decoded)
+{
+    texture_t *tex = &ts->textures[decoded->handle];
+    texture_file_t *image = &decoded->image;
+    ts->in_flight--;
+    if (!image->data)
+    {
+        tex->state = TEXTURE_FAILED;
+        return;
+    }
+
+    texture_region_t region;
+    u32 x = 0, y = 0;
+    b8 placed = decoded->atlas ? place_sprite(ts, image, &region, &x, &y)
+                               : place_layer(ts, image, &region);
+    if (!placed)
+    {
+        LOG_WARN("texture: no page has room for %s", tex->path);
+        tex->state = TEXTURE_FAILED;
+        texture_file_free(image);
+        return;
+    }
+
+    u64 offset = 0;
+    void *dst = stream_buffer_alloc(&ts->upload, image->size, &offset);
+    if (dst)
+    {
+        memcpy(dst, image->data, image->size);
+        stream_buffer_flush(&ts->upload);
+    }
+    else
+    {
+        // bigger than a whole region, straight from client memory
+        gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    const u8 *base = dst ? (const u8 *)offset : image->data;
+
+    gl_state_bind_texture(0, GL_TEXTURE_2D_ARRAY, ts->pages[region.page].id);
+
+    GLenum format = g_gl_formats[image->format];
+    u32 width = image->width, height = image->height;
+    u64 level_offset = 0;
+    for (u32 level = 0; level < image->levels; level++)
+    {
+        u64 size = bc_image_size(image->format, width, height);
+        if (image->format == BC_FORMAT_NONE)
+        {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, (GLint)x,
+                            (GLint)y, (GLint)region.layer, (GLsizei)width,
+                            (GLsizei)height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                            base + level_offset);
+        }
+        else
+        {
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0,
+                                      0, (GLint)region.layer,
+                                      (GLsizei)width, (GLsizei)height, 1,
+                                      format, (GLsizei)size,
+                                      base + level_offset);
+        }
+        level_offset += size;
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+
+    if (!dst) gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, ts->upload.buffer);
+
+    u32 border = decoded->atlas ? TEX_SYS_ATLAS_BORDER * 2 : 0;
+    tex->region = region;
+    tex->width = image->width - border;
+    tex->height = image->height - border;
+    tex->format = image->format;
+    tex->state = TEXTURE_RESIDENT;
+    texture_file_free(image);
+}
+
+void texture_sys_update(texture_system_t *ts)
+{
+    if (ts->in_flight == 0) return;
+
+    stream_buffer_begin_frame(&ts->upload);
+    gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, ts->upload.buffer);
+
+    // always at least one image, so a huge one can't stall the queue
+    u64 uploaded = 0;
+    for (;;)
+    {
+        mutex_lock(&ts->lock);
+        b8 take = ts->decoded_count > 0;
+        texture_decoded_t decoded = {0};
+        if (take)
+        {
+            decoded = ts->decoded[ts->decoded_head];
+            take = uploaded == 0 ||
+                   uploaded + decoded.image.size <= TEX_SYS_UPLOAD_BUDGET;
+            uploaded += decoded.image.size;
+        }
+        if (take)
+        {
+            ts->decoded_head = (ts->decoded_head + 1) % TEX_SYS_MAX_TEXTURES;
+            ts->decoded_count--;
+        }
+        mutex_unlock(&ts->lock);
+
+        if (!take) break;
+        upload(ts, &decoded);
+    }
+
+    gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    stream_buffer_end_frame(&ts->upload);
+}
+
+const texture_t *texture_sys_get(const texture_system_t *ts,
+                                 texture_handle_t texture)
+{
+    if (texture >= ts->texture_count) return NULL;
+    return &ts->textures[texture];
+}
+
+texture_region_t texture_sys_region(const texture_system_t *ts,
+                                    texture_handle_t texture)
+{
+    texture_region_t region = {
+        .page = TEX_SYS_PLACEHOLDER_PAGE,
+        .layer = 0,
+        .uv_rect = vec4_create(0.0f, 0.0f, 1.0f, 1.0f),
+    };
+    if (texture >= ts->texture_count) return region;
+
+    const texture_t *tex = &ts->textures[texture];
+    if (tex->state == TEXTURE_RESIDENT) return tex->region;
+    region.layer = 1; // checkerboard
+    return region;
+}
+
+void texture_sys_bind_page(texture_system_t *ts, u32 page, u32 unit,
+                           texture_sampler_t sampler)
+{
+    if (page >= ts->page_count) page = TEX_SYS_PLACEHOLDER_PAGE;
+    gl_state_bind_texture(unit, GL_TEXTURE_2D_ARRAY, ts->pages[page].id);
+    gl_state_bind_sampler(unit, ts->samplers[sampler]);
+}
+
+void texture_sys_bind(texture_system_t *ts, texture_handle_t texture,
+                      u32 unit, texture_sampler_t sampler)
+{
+    texture_sys_bind_page(ts, texture_sys_region(ts, texture).page, unit,
+                          sampler);
+}
+
+texture_system_t *get_texture_system(void) { return g_ts; }
@@ -0,0 +1,182 @@
+#ifndef TEXTURE_SYSTEM_H
+#define TEXTURE_SYSTEM_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/math/math_types.h"
+#include "engine/core/memory/arena.h"
+#include "engine/platform/thread.h"
+#include "engine/rendering/stream_buffer.h"
+#include "engine/resource/atlas_packer.h"
+#include "engine/resource/bc_encode.h"
+#include "engine/resource/texture_file.h"
+
+/*
+ * Textures load in the background. texture_sys_load queues the file for a
+ * pool of workers that read and decode it with stb_image, filter the mip
+ * chain on the CPU in linear space and block compress it into the best
+ * format the driver takes for the texture's usage; the main thread picks
+ * finished chains up in texture_sys_update and copies them through a ring
+ * of pixel unpack buffers, so the upload only queues a GPU copy. Each
+ * update uploads at most TEX_SYS_UPLOAD_BUDGET bytes.
+ *
+ * Compressed chains are cooked once into TEX_SYS_CACHE_DIR as .ktex files
+ * and reused while the source bytes stay the same. Without the S3TC/BPTC
+ * extensions textures fall back to RGBA8.
+ *
+ * Nothing gets a texture object of its own. Textures of the same format,
+ * size and mip count become layers of a shared GL_TEXTURE_2D_ARRAY page,
+ * and sprites are packed into the layers of atlas pages with a one pixel
+ * extruded border and no mips. A texture is addressed by its region: the
+ * page to bind, the layer and the rect of the layer it covers. Draws that
+ * carry the layer and rect per instance sample any texture of a page
+ * without rebinding, so they batch like untextured ones. Until a texture is
+ * resident its region is a checkerboard in the placeholder page, page 0,
+ * whose layer 0 is white for draws without a texture.
+ */
+
+#define TEX_SYS_MAX_TEXTURES 1024
+#define TEX_SYS_MAX_WORKERS 4
+#define TEX_SYS_PATH_SIZE 128
+#define TEX_SYS_UPLOAD_BUDGET (8 * 1024 * 1024) // bytes per update
+#define TEX_SYS_CACHE_DIR "texture_cache"
+#define TEX_SYS_QUALITY BC_QUALITY_NORMAL
+#define TEX_SYS_MAX_PAGES 64
+#define TEX_SYS_PAGE_LAYERS 64 // most layers in one page
+#define TEX_SYS_PAGE_BYTES (64 * 1024 * 1024) // unless one layer is bigger
+#define TEX_SYS_ATLAS_SIZE 1024
+#define TEX_SYS_ATLAS_LAYERS 4
+#define TEX_SYS_ATLAS_BORDER 1
+#define TEX_SYS_ATLAS_MAX_SPRITE 256 // bigger sprites load like COLOR
+#define TEX_SYS_PLACEHOLDER_PAGE 0
+
+typedef u32 texture_handle_t; // INVALID_32 for none
+
+typedef enum {
+    TEXTURE_LOADING,
+    TEXTURE_RESIDENT,
+    TEXTURE_FAILED, // keeps the placeholder
+} texture_state_t;
+
+// Picks the compressed format, and how the mips are filtered
+typedef enum {
+    TEXTURE_USAGE_COLOR,  // sRGB color, BC7, else BC1 or BC3 with alpha
+    TEXTURE_USAGE_NORMAL, // tangent space, BC5 keeps xy, rebuild z
+    TEXTURE_USAGE_MASK,   // single channel in red, BC4
+    TEXTURE_USAGE_SPRITE, // UI and sprites, RGBA8 in an atlas, no mips
+    TEXTURE_USAGE_COUNT
+} texture_usage_t;
+
+typedef enum {
+    TEXTURE_SAMPLER_LINEAR_REPEAT, // trilinear
+    TEXTURE_SAMPLER_LINEAR_CLAMP,
+    TEXTURE_SAMPLER_NEAREST_CLAMP,
+    TEXTURE_SAMPLER_COUNT
+} texture_sampler_t;
+
+// What a draw needs to sample a texture: uv' = uv_rect.xy + uv *
+// uv_rect.zw in layer of page
+typedef struct {
+    u32 page;
+    u32 layer;
+    vec4 uv_rect;
+} texture_region_t;
+
+typedef struct {
+    texture_region_t region; // valid once resident
+    u32 width;
+    u32 height;
+    texture_state_t state;
+    texture_usage_t usage;
+    bc_format_t format; // what was uploaded, valid once resident
+    u64 path_hash;
+    char path[TEX_SYS_PATH_SIZE];
+} texture_t;
+
+// One GL_TEXTURE_2D_ARRAY. Class pages hold whole textures of one format,
+// size and mip count, one per layer. Atlas pages hold sprites, packed per
+// layer.
+typedef struct {
+    u32 id;
+    bc_format_t format;
+    u32 width;
+    u32 height;
+    u32 levels;
+    u32 layer_count; // storage allocated up front
+    u32 layer_used;  // class pages hand out layers in order, never back
+    atlas_packer_t *packers; // layer_count of them on atlas pages, else NULL
+} texture_page_t;
+
+// Decoded by a worker, waiting for the main thread
+typedef struct {
+    texture_handle_t handle;
+    texture_file_t image; // data is NULL when the load failed
+    b8 atlas; // extruded by TEX_SYS_ATLAS_BORDER, goes into an atlas page
+} texture_decoded_t;
+
+typedef struct {
+    arena_alloc_t *arena;
+
+    texture_t *textures;
+    u32 texture_count;
+    u32 in_flight; // loaded but not resident or failed yet
+
+    texture_page_t pages[TEX_SYS_MAX_PAGES];
+    u32 page_count;
+    u32 max_layers; // GL_MAX_ARRAY_TEXTURE_LAYERS
+    u32 samplers[TEXTURE_SAMPLER_COUNT];
+
+    // read only once the workers run
+    u32 formats;    // 1 << bc_format_t the driver can sample
+    u32 hw_threads; // split between the workers encoding at once
+    b8 cache;
+    stream_buffer_t upload; // GL_PIXEL_UNPACK_BUFFER
+
+    // shared with the workers, under lock
+    thread_t workers[TEX_SYS_MAX_WORKERS];
+    u32 worker_count;
+    u32 busy; // workers decoding a request
+    mutex_t lock;
+    cond_t wake;
+    b8 quit;
+
+    // rings of TEX_SYS_MAX_TEXTURES, a texture is queued at most once
+    texture_handle_t *requests;
+    u32 request_head;
+    u32 request_count;
+    texture_decoded_t *decoded;
+    u32 decoded_head;
+    u32 decoded_count;
+} texture_system_t;
+
+texture_system_t *texture_sys_init(arena_alloc_t *arena);
+
+// Stops the workers, drops whatever is still loading
+void texture_sys_kill(texture_system_t *ts);
+
+// Returns right away. The same path gives the same handle, the usage of
+// the first load sticks. INVALID_32 when the table is full.
+texture_handle_t texture_sys_load(texture_system_t *ts, const char *path,
+                                  texture_usage_t usage);
+
+// Uploads decoded images within the budget, once per frame
+void texture_sys_update(texture_system_t *ts);
+
+const texture_t *texture_sys_get(const texture_system_t *ts,
+                                 texture_handle_t texture);
+
+// The placeholder checkerboard while loading or failed, white for
+// INVALID_32
+texture_region_t texture_sys_region(const texture_system_t *ts,
+                                    texture_handle_t texture);
+
+// Binds page as a sampler2DArray
+void texture_sys_bind_page(texture_system_t *ts, u32 page, u32 unit,
+                           texture_sampler_t sampler);
+
+// Binds the texture's page, see texture_sys_region for the layer and rect
+void texture_sys_bind(texture_system_t *ts, texture_handle_t texture,
+                      u32 unit, texture_sampler_t sampler);
+
+texture_system_t *get_texture_system(void);
+
+#endif // TEXTURE_SYSTEM_H
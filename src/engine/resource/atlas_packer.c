@@ -0,0 +1,111 @@
+#include "atlas_packer.h"
+
+// std
+#include <string.h>
+
+void atlas_packer_init(atlas_packer_t *p, u32 width, u32 height)
+{
+    p->width = width;
+    p->height = height;
+    p->node_count = 1;
+    p->used_area = 0;
+    p->nodes[0] = (atlas_node_t){.x = 0, .y = 0, .width = width};
+}
+
+// Lowest y a width x height rectangle can sit at with its left edge on
+// node index, INVALID_32 if it runs off the right or the top
+static u32 fit(const atlas_packer_t *p, u32 index, u32 width, u32 height)
+{
+    u32 x = p->nodes[index].x;
+    if (x + width > p->width) return INVALID_32;
+
+    u32 y = 0;
+    u32 covered = 0;
+    for (u32 i = index; covered < width; i++)
+    {
+        // the segments span the whole width, so this can't run out
+        y = MAX(y, p->nodes[i].y);
+        if (y + height > p->height) return INVALID_32;
+        covered += p->nodes[i].width;
+    }
+    return y;
+}
+
+b8 atlas_packer_insert(atlas_packer_t *p, u32 width, u32 height, u32 *out_x,
+                       u32 *out_y)
+{
+    if (width == 0 || height == 0) return false;
+    // a placement adds at most one segment
+    if (p->node_count == ATLAS_MAX_NODES) return false;
+
+    u32 best = INVALID_32;
+    u32 best_top = INVALID_32;
+    u32 best_width = INVALID_32;
+    u32 best_y = 0;
+    for (u32 i = 0; i < p->node_count; i++)
+    {
+        u32 y = fit(p, i, width, height);
+        if (y == INVALID_32) continue;
+
+        u32 top = y + height;
+        if (top < best_top ||
+            (top == best_top && p->nodes[i].width < best_width))
+        {
+            best = i;
+            best_top = top;
+            best_width = p->nodes[i].width;
+            best_y = y;
+        }
+    }
+    if (best == INVALID_32) return false;
+
+    u32 x = p->nodes[best].x;
+    memmove(&p->nodes[best + 1], &p->nodes[best],
+            sizeof(atlas_node_t) * (p->node_count - best));
+    p->nodes[best] = (atlas_node_t){.x = x, .y = best_top, .width = width};
+    p->node_count++;
+
+    // trim or drop the segments now under the new one
+    u32 right = x + width;
+    u32 i = best + 1;
+    while (i < p->node_count && p->nodes[i].x < right)
+    {
+        atlas_node_t *n = &p->nodes[i];
+        u32 end = n->x + n->width;
+        if (end > right)
+        {
+            n->width = end - right;
+            n->x = right;
+            break;
+        }
+        memmove(n, n + 1, sizeof(atlas_node_t) * (p->node_count - i - 1));
+        p->node_count--;
+    }
+
+    // neighbours at the same height become one segment
+    for (i = 0; i + 1 < p->node_count;)
+    {
+        if (p->nodes[i].y == p->nodes[i + 1].y)
+        {
+            p->nodes[i].width += p->nodes[i + 1].width;
+            memmove(&p->nodes[i + 1], &p->nodes[i + 2],
+                    sizeof(atlas_node_t) * (p->node_count - i - 2));
+            p->node_count--;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    p->used_area += (u64)width * height;
+    *out_x = x;
+    *out_y = best_y;
+    return true;
+}
+
+f32 atlas_packer_occupancy(const atlas_packer_t *p)
+{
+    u64 area = (u64)p->width * p->height;
+    return area ? (f32)p->used_area / (f32)area : 0.0f;
+}
@@ -0,0 +1,40 @@
+#ifndef ATLAS_PACKER_H
+#define ATLAS_PACKER_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * Skyline bottom-left rectangle packer for one atlas layer. The skyline is
+ * the top edge of everything placed so far, stored as horizontal segments
+ * left to right. A rectangle goes where its bottom ends up lowest, ties go
+ * to the narrower segment so wide gaps stay open for wide rectangles. Space
+ * under an overhang is lost, which is fine for sprites loaded in no
+ * particular order. Nothing is ever removed.
+ */
+
+#define ATLAS_MAX_NODES 256
+
+typedef struct {
+    u32 x;
+    u32 y; // top of the skyline over [x, x + width)
+    u32 width;
+} atlas_node_t;
+
+typedef struct {
+    u32 width;
+    u32 height;
+    u32 node_count;
+    u64 used_area;
+    atlas_node_t nodes[ATLAS_MAX_NODES];
+} atlas_packer_t;
+
+void atlas_packer_init(atlas_packer_t *p, u32 width, u32 height);
+
+// false when it doesn't fit, the packer is unchanged then
+b8 atlas_packer_insert(atlas_packer_t *p, u32 width, u32 height, u32 *out_x,
+                       u32 *out_y);
+
+// Placed area over the whole area, 0..1
+f32 atlas_packer_occupancy(const atlas_packer_t *p);
+
+#endif // ATLAS_PACKER_H
@@ -0,0 +1,97 @@
+#include "atlas_packer_test.h"
+#include "engine/core/test.h"
+#include "engine/resource/atlas_packer.h"
+
+// std
+#include <string.h>
+
+// The skyline covers [0, width) left to right without gaps
+static b8 skyline_valid(const atlas_packer_t *p)
+{
+    u32 x = 0;
+    for (u32 i = 0; i < p->node_count; i++)
+    {
+        if (p->nodes[i].x != x || p->nodes[i].y > p->height) return false;
+        x += p->nodes[i].width;
+    }
+    return x == p->width;
+}
+
+#define ATLAS_TEST_SIZE 256
+
+b8 test_atlas_packer(void)
+{
+    b8 all_passed = true;
+    static atlas_packer_t p, before;
+
+    // 16 squares tile 64x64 exactly, the 17th is refused
+    atlas_packer_init(&p, 64, 64);
+    u32 x = 0, y = 0, tiles = 0;
+    while (atlas_packer_insert(&p, 16, 16, &x, &y)) tiles++;
+    all_passed &= expect_u64(tiles, 16, "atlas exact tiles");
+    all_passed &= expect_true(atlas_packer_occupancy(&p) == 1.0f,
+                              "atlas full occupancy");
+    all_passed &= expect_true(!atlas_packer_insert(&p, 0, 4, &x, &y),
+                              "atlas zero size refused");
+
+    // random sizes: every rect inside, none overlapping, a refused insert
+    // leaves the packer as it was
+    static u8 covered[ATLAS_TEST_SIZE * ATLAS_TEST_SIZE];
+    memset(covered, 0, sizeof(covered));
+    atlas_packer_init(&p, ATLAS_TEST_SIZE, ATLAS_TEST_SIZE);
+
+    u32 seed = 777, refused = 0;
+    u64 area = 0;
+    b8 inside = true, disjoint = true, unchanged = true, skyline = true;
+    for (u32 i = 0; i < 400; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        u32 w = 4 + (seed >> 8) % 37;
+        u32 h = 4 + (seed >> 20) % 37;
+
+        before = p;
+        if (!atlas_packer_insert(&p, w, h, &x, &y))
+        {
+            unchanged &= memcmp(&p, &before, sizeof(p)) == 0;
+            refused++;
+            continue;
+        }
+
+        area += (u64)w * h;
+        if (x + w > ATLAS_TEST_SIZE || y + h > ATLAS_TEST_SIZE)
+        {
+            inside = false;
+            continue;
+        }
+        for (u32 row = y; row < y + h; row++)
+        {
+            for (u32 col = x; col < x + w; col++)
+            {
+                disjoint &= !covered[row * ATLAS_TEST_SIZE + col];
+                covered[row * ATLAS_TEST_SIZE + col] = 1;
+            }
+        }
+        skyline &= skyline_valid(&p);
+    }
+
+    all_passed &= expect_true(inside, "atlas rects inside");
+    all_passed &= expect_true(disjoint, "atlas no overlap");
+    all_passed &= expect_true(skyline, "atlas skyline");
+    all_passed &= expect_true(unchanged,
+                              "atlas refused insert changes nothing");
+    all_passed &= expect_true(refused > 0, "atlas fills up");
+    all_passed &= expect_u64(p.used_area, area, "atlas used area");
+    all_passed &= expect_true(atlas_packer_occupancy(&p) > 0.75f,
+                              "atlas occupancy over 75%");
+
+    return all_passed;
+}
+
+b8 atlas_packer_run_tests(void)
+{
+    printf("\n=== RUN ATLAS PACKER TEST ===\n");
+
+    b8 all_passed = true;
+    RUN_TEST(test_atlas_packer);
+    return all_passed;
+}
@@ -0,0 +1,10 @@
+#ifndef ATLAS_PACKER_TEST_H
+#define ATLAS_PACKER_TEST_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+b8 atlas_packer_run_tests(void);
+
+b8 test_atlas_packer(void);
+
+#endif // ATLAS_PACKER_TEST_H
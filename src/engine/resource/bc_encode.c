@@ -0,0 +1,687 @@
+#include "bc_encode.h"
+#include "engine/core/math/maths.h"
+#include "engine/platform/thread.h"
+
+// std
+#include <float.h>
+#include <string.h>
+
+#define BC_MAX_THREADS 32
+
+static INL u32 squared(i32 v) { return (u32)(v * v); }
+
+static u32 refine_passes(bc_quality_t quality)
+{
+    if (quality == BC_QUALITY_FAST) return 0;
+    return quality == BC_QUALITY_NORMAL ? 1 : 8;
+}
+
+/*************************
+ * Line fit
+ *************************/
+// Principal axis of the points by power iteration on their covariance,
+// false when they are all the same
+static b8 principal_axis(const f32 *points, u32 count, u32 dim, f32 *mean,
+                         f32 *axis)
+{
+    f32 cov[4][4] = {{0}};
+    for (u32 c = 0; c < dim; c++)
+    {
+        mean[c] = 0.0f;
+        for (u32 i = 0; i < count; i++) mean[c] += points[i * dim + c];
+        mean[c] /= (f32)count;
+    }
+
+    for (u32 i = 0; i < count; i++)
+    {
+        f32 d[4];
+        for (u32 c = 0; c < dim; c++) d[c] = points[i * dim + c] - mean[c];
+        for (u32 a = 0; a < dim; a++)
+            for (u32 b = 0; b < dim; b++) cov[a][b] += d[a] * d[b];
+    }
+
+    // start from the widest channel's row, it is rarely orthogonal
+    u32 widest = 0;
+    for (u32 c = 1; c < dim; c++)
+        if (cov[c][c] > cov[widest][widest]) widest = c;
+    if (cov[widest][widest] < 1e-3f) return false;
+    for (u32 c = 0; c < dim; c++) axis[c] = cov[widest][c];
+
+    for (u32 iter = 0; iter < 8; iter++)
+    {
+        f32 next[4] = {0}, largest = 0.0f;
+        for (u32 a = 0; a < dim; a++)
+        {
+            for (u32 b = 0; b < dim; b++) next[a] += cov[a][b] * axis[b];
+            largest = MAX(largest, m_abs(next[a]));
+        }
+        if (largest < 1e-12f) return false;
+        for (u32 c = 0; c < dim; c++) axis[c] = next[c] / largest;
+    }
+
+    f32 length = 0.0f;
+    for (u32 c = 0; c < dim; c++) length += axis[c] * axis[c];
+    length = m_sqrt(length);
+    for (u32 c = 0; c < dim; c++) axis[c] /= length;
+    return true;
+}
+
+// Bounding box corners on the diagonal the points run along: channels
+// that fall while the widest one rises get their ends swapped
+static void box_diagonal(const f32 *points, u32 count, u32 dim, f32 *e0,
+                         f32 *e1)
+{
+    u32 widest = 0;
+    for (u32 c = 0; c < dim; c++)
+    {
+        e0[c] = FLT_MAX;
+        e1[c] = -FLT_MAX;
+        for (u32 i = 0; i < count; i++)
+        {
+            e0[c] = MIN(e0[c], points[i * dim + c]);
+            e1[c] = MAX(e1[c], points[i * dim + c]);
+        }
+        if (e1[c] - e0[c] > e1[widest] - e0[widest]) widest = c;
+    }
+
+    f32 mid_w = (e0[widest] + e1[widest]) * 0.5f;
+    for (u32 c = 0; c < dim; c++)
+    {
+        f32 mid = (e0[c] + e1[c]) * 0.5f, cov = 0.0f;
+        for (u32 i = 0; i < count; i++)
+        {
+            cov += (points[i * dim + widest] - mid_w) *
+                   (points[i * dim + c] - mid);
+        }
+        if (cov < 0.0f)
+        {
+            f32 t = e0[c];
+            e0[c] = e1[c];
+            e1[c] = t;
+        }
+    }
+}
+
+// First guess for the endpoints: the bounding box diagonal when fast,
+// otherwise the extent along the principal axis. Pulled in by inset of
+// the span, the extremes land closer to a palette entry that way.
+static void fit_line(const f32 *points, u32 count, u32 dim,
+                     bc_quality_t quality, f32 inset, f32 *e0, f32 *e1)
+{
+    f32 mean[4], axis[4];
+    if (quality == BC_QUALITY_FAST ||
+        !principal_axis(points, count, dim, mean, axis))
+    {
+        box_diagonal(points, count, dim, e0, e1);
+    }
+    else
+    {
+        f32 tmin = FLT_MAX, tmax = -FLT_MAX;
+        for (u32 i = 0; i < count; i++)
+        {
+            f32 t = 0.0f;
+            for (u32 c = 0; c < dim; c++)
+                t += (points[i * dim + c] - mean[c]) * axis[c];
+            tmin = MIN(tmin, t);
+            tmax = MAX(tmax, t);
+        }
+        for (u32 c = 0; c < dim; c++)
+        {
+            e0[c] = mean[c] + axis[c] * tmin;
+            e1[c] = mean[c] + axis[c] * tmax;
+        }
+    }
+
+    for (u32 c = 0; c < dim; c++)
+    {
+        f32 d = (e1[c] - e0[c]) * inset;
+        e0[c] += d;
+        e1[c] -= d;
+    }
+}
+
+// Least squares endpoints for fixed weights, pixel i is
+// weights[i] * e0 + (1 - weights[i]) * e1. Skips pixels with weight < 0.
+static b8 refine_line(const u8 *px, const f32 weights[16], u32 dim, f32 *e0,
+                      f32 *e1)
+{
+    f32 aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    f32 ap[4] = {0}, bp[4] = {0};
+    for (u32 i = 0; i < 16; i++)
+    {
+        f32 a = weights[i];
+        if (a < 0.0f) continue;
+        f32 b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (u32 c = 0; c < dim; c++)
+        {
+            ap[c] += a * (f32)px[i * 4 + c];
+            bp[c] += b * (f32)px[i * 4 + c];
+        }
+    }
+
+    f32 det = aa * bb - ab * ab;
+    if (m_abs(det) < 1e-6f) return false;
+    for (u32 c = 0; c < dim; c++)
+    {
+        e0[c] = CLAMP((ap[c] * bb - bp[c] * ab) / det, 0.0f, 255.0f);
+        e1[c] = CLAMP((bp[c] * aa - ap[c] * ab) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+/*************************
+ * BC1 color
+ *************************/
+static u16 pack_565(const f32 c[3])
+{
+    i32 r = (i32)(c[0] * 31.0f / 255.0f + 0.5f);
+    i32 g = (i32)(c[1] * 63.0f / 255.0f + 0.5f);
+    i32 b = (i32)(c[2] * 31.0f / 255.0f + 0.5f);
+    r = CLAMP(r, 0, 31);
+    g = CLAMP(g, 0, 63);
+    b = CLAMP(b, 0, 31);
+    return (u16)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(u16 c, i32 out[3])
+{
+    i32 r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+// three is the 3 color mode, index 3 is transparent black there. The 4
+// color palette is built as if c0 > c1, swapping fixes the order later.
+static u32 color_assign(const u8 *px, u16 mask, u16 c0, u16 c1, b8 three,
+                        u8 idx[16])
+{
+    i32 pal[4][3];
+    unpack_565(c0, pal[0]);
+    unpack_565(c1, pal[1]);
+    for (u32 c = 0; c < 3; c++)
+    {
+        if (three)
+        {
+            pal[2][c] = (pal[0][c] + pal[1][c]) / 2;
+            pal[3][c] = 0;
+        }
+        else
+        {
+            pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+            pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+        }
+    }
+
+    u32 count = three ? 3 : 4;
+    u32 error = 0;
+    for (u32 i = 0; i < 16; i++)
+    {
+        if (!(mask & (1u << i)))
+        {
+            idx[i] = 3;
+            continue;
+        }
+
+        const u8 *p = px + i * 4;
+        u32 best = 0xFFFFFFFFu;
+        for (u32 k = 0; k < count; k++)
+        {
+            u32 e = squared(p[0] - pal[k][0]) + squared(p[1] - pal[k][1]) +
+                    squared(p[2] - pal[k][2]);
+            if (e < best)
+            {
+                best = e;
+                idx[i] = (u8)k;
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+// allow_three lets pixels with alpha < 128 go transparent through the 3
+// color mode, BC3's color half is always read as 4 color
+static void encode_color(const u8 *px, bc_quality_t quality, b8 allow_three,
+                         u8 *out)
+{
+    u16 mask = 0;
+    f32 points[16 * 3];
+    u32 count = 0;
+    for (u32 i = 0; i < 16; i++)
+    {
+        if (allow_three && px[i * 4 + 3] < 128) continue;
+        mask |= (u16)(1u << i);
+        for (u32 c = 0; c < 3; c++) points[count * 3 + c] = px[i * 4 + c];
+        count++;
+    }
+    b8 three = mask != 0xFFFF;
+
+    u16 c0 = 0, c1 = 0;
+    u8 idx[16];
+    memset(idx, 3, sizeof(idx));
+    if (count > 0)
+    {
+        f32 e0[3], e1[3];
+        fit_line(points, count, 3, quality, 1.0f / 16.0f, e0, e1);
+
+        static const f32 w4[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        static const f32 w3[4] = {1.0f, 0.0f, 0.5f, -1.0f};
+        const f32 *w = three ? w3 : w4;
+
+        u32 best = 0xFFFFFFFFu;
+        u32 passes = refine_passes(quality);
+        for (u32 pass = 0; pass <= passes; pass++)
+        {
+            u16 q0 = pack_565(e0), q1 = pack_565(e1);
+            u8 try_idx[16];
+            u32 error = color_assign(px, mask, q0, q1, three, try_idx);
+            if (error >= best) break;
+
+            best = error;
+            c0 = q0;
+            c1 = q1;
+            memcpy(idx, try_idx, sizeof(idx));
+            if (error == 0) break;
+
+            f32 weights[16];
+            for (u32 i = 0; i < 16; i++) weights[i] = w[idx[i]];
+            if (!refine_line(px, weights, 3, e0, e1)) break;
+        }
+    }
+
+    // 4 color mode needs c0 > c1, 3 color mode c0 <= c1
+    b8 swap = three ? c0 > c1 : c0 < c1;
+    if (swap)
+    {
+        u16 t = c0;
+        c0 = c1;
+        c1 = t;
+        for (u32 i = 0; i < 16; i++)
+            if (idx[i] < 2 || !three) idx[i] ^= 1;
+    }
+    // equal endpoints read as 3 color, keep away from index 3
+    if (!three && c0 == c1) memset(idx, 0, sizeof(idx));
+
+    u32 bits = 0;
+    for (u32 i = 0; i < 16; i++) bits |= (u32)idx[i] << (i * 2);
+    out[0] = (u8)c0;
+    out[1] = (u8)(c0 >> 8);
+    out[2] = (u8)c1;
+    out[3] = (u8)(c1 >> 8);
+    for (u32 b = 0; b < 4; b++) out[4 + b] = (u8)(bits >> (b * 8));
+}
+
+/*************************
+ * BC4 single channel
+ *************************/
+typedef struct {
+    u8 a0, a1;
+    u8 idx[16];
+    u32 error;
+} alpha_fit_t;
+
+// a0 > a1 interpolates 6 values between them, otherwise 4 plus 0 and 255
+static void alpha_try(const u8 v[16], u8 a0, u8 a1, alpha_fit_t *best)
+{
+    i32 pal[8] = {a0, a1};
+    if (a0 > a1)
+    {
+        for (i32 k = 1; k <= 6; k++)
+            pal[k + 1] = ((7 - k) * a0 + k * a1 + 3) / 7;
+    }
+    else
+    {
+        for (i32 k = 1; k <= 4; k++)
+            pal[k + 1] = ((5 - k) * a0 + k * a1 + 2) / 5;
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+
+    alpha_fit_t fit = {.a0 = a0, .a1 = a1};
+    for (u32 i = 0; i < 16; i++)
+    {
+        u32 nearest = 0xFFFFFFFFu;
+        for (u32 k = 0; k < 8; k++)
+        {
+            u32 e = squared(v[i] - pal[k]);
+            if (e < nearest)
+            {
+                nearest = e;
+                fit.idx[i] = (u8)k;
+            }
+        }
+        fit.error += nearest;
+    }
+    if (fit.error < best->error) *best = fit;
+}
+
+static void encode_alpha(const u8 v[16], bc_quality_t quality, u8 *out)
+{
+    // lo/hi over everything, inner_* without the 0 and 255 the 6 value
+    // mode gets for free
+    u8 lo = 255, hi = 0, inner_lo = 255, inner_hi = 0;
+    for (u32 i = 0; i < 16; i++)
+    {
+        lo = MIN(lo, v[i]);
+        hi = MAX(hi, v[i]);
+        if (v[i] != 0 && v[i] != 255)
+        {
+            inner_lo = MIN(inner_lo, v[i]);
+            inner_hi = MAX(inner_hi, v[i]);
+        }
+    }
+    if (inner_lo > inner_hi) inner_lo = inner_hi = 0;
+
+    alpha_fit_t best = {.error = 0xFFFFFFFFu};
+    alpha_try(v, hi, lo, &best);
+    if (quality != BC_QUALITY_FAST && best.error > 0)
+        alpha_try(v, inner_lo, inner_hi, &best);
+
+    // pulling the ends in can beat a palette stretched by one outlier
+    if (quality == BC_QUALITY_HIGH && best.error > 0)
+    {
+        for (i32 d0 = 0; d0 < 4; d0++)
+        {
+            for (i32 d1 = 0; d1 < 4; d1++)
+            {
+                if (hi - d1 > lo + d0)
+                    alpha_try(v, (u8)(hi - d1), (u8)(lo + d0), &best);
+                if (inner_lo + d0 <= inner_hi - d1)
+                    alpha_try(v, (u8)(inner_lo + d0), (u8)(inner_hi - d1),
+                              &best);
+            }
+        }
+    }
+
+    u64 bits = 0;
+    for (u32 i = 0; i < 16; i++) bits |= (u64)best.idx[i] << (i * 3);
+    out[0] = best.a0;
+    out[1] = best.a1;
+    for (u32 b = 0; b < 6; b++) out[2 + b] = (u8)(bits >> (b * 8));
+}
+
+static void encode_channel(const u8 *px, u32 channel, bc_quality_t quality,
+                           u8 *out)
+{
+    u8 v[16];
+    for (u32 i = 0; i < 16; i++) v[i] = px[i * 4 + channel];
+    encode_alpha(v, quality, out);
+}
+
+/*************************
+ * BC7 mode 6
+ *************************/
+static const u8 g_bc7_weights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                     34, 38, 43, 47, 51, 55, 60, 64};
+
+typedef struct {
+    u8 e[2][4]; // 8 bit endpoints, the low bit is the shared p-bit
+    u8 idx[16];
+    u32 error;
+} bc7_fit_t;
+
+static void bc7_quantize(const f32 e[4], u32 p, u8 out[4])
+{
+    for (u32 c = 0; c < 4; c++)
+    {
+        i32 q = (i32)((e[c] - (f32)p) * 0.5f + 0.5f);
+        q = CLAMP(q, 0, 127);
+        out[c] = (u8)(q * 2 + (i32)p);
+    }
+}
+
+static u32 bc7_quantize_error(const f32 e[4], u32 p)
+{
+    u8 q[4];
+    bc7_quantize(e, p, q);
+    f32 error = 0.0f;
+    for (u32 c = 0; c < 4; c++) error += (q[c] - e[c]) * (q[c] - e[c]);
+    return (u32)error;
+}
+
+static void bc7_assign(const u8 *px, u32 p0, u32 p1, const f32 e0[4],
+                       const f32 e1[4], bc7_fit_t *best)
+{
+    bc7_fit_t fit = {0};
+    bc7_quantize(e0, p0, fit.e[0]);
+    bc7_quantize(e1, p1, fit.e[1]);
+
+    i32 pal[16][4];
+    for (u32 k = 0; k < 16; k++)
+    {
+        i32 w = g_bc7_weights[k];
+        for (u32 c = 0; c < 4; c++)
+            pal[k][c] = ((64 - w) * fit.e[0][c] + w * fit.e[1][c] + 32) >> 6;
+    }
+
+    for (u32 i = 0; i < 16; i++)
+    {
+        const u8 *p = px + i * 4;
+        u32 nearest = 0xFFFFFFFFu;
+        for (u32 k = 0; k < 16; k++)
+        {
+            u32 e = squared(p[0] - pal[k][0]) + squared(p[1] - pal[k][1]) +
+                    squared(p[2] - pal[k][2]) + squared(p[3] - pal[k][3]);
+            if (e < nearest)
+            {
+                nearest = e;
+                fit.idx[i] = (u8)k;
+            }
+        }
+        fit.error += nearest;
+        if (fit.error >= best->error) return;
+    }
+    *best = fit;
+}
+
+// Each endpoint takes the p-bit that rounds it closer, HIGH tries all 4
+static void bc7_try(const u8 *px, const f32 e0[4], const f32 e1[4],
+                    bc_quality_t quality, bc7_fit_t *best)
+{
+    if (quality == BC_QUALITY_HIGH)
+    {
+        for (u32 p = 0; p < 4; p++)
+            bc7_assign(px, p & 1, p >> 1, e0, e1, best);
+        return;
+    }
+    u32 p0 = bc7_quantize_error(e0, 1) < bc7_quantize_error(e0, 0);
+    u32 p1 = bc7_quantize_error(e1, 1) < bc7_quantize_error(e1, 0);
+    bc7_assign(px, p0, p1, e0, e1, best);
+}
+
+static INL void put_bits(u8 *out, u32 *pos, u32 value, u32 count)
+{
+    for (u32 i = 0; i < count; i++, (*pos)++)
+        if ((value >> i) & 1) out[*pos >> 3] |= (u8)(1u << (*pos & 7));
+}
+
+static void encode_bc7(const u8 *px, bc_quality_t quality, u8 *out)
+{
+    f32 points[64];
+    for (u32 i = 0; i < 64; i++) points[i] = px[i];
+
+    f32 e0[4], e1[4];
+    fit_line(points, 16, 4, quality, 1.0f / 32.0f, e0, e1);
+
+    bc7_fit_t best = {.error = 0xFFFFFFFFu};
+    u32 passes = refine_passes(quality);
+    for (u32 pass = 0; pass <= passes; pass++)
+    {
+        u32 before = best.error;
+        bc7_try(px, e0, e1, quality, &best);
+        if (best.error >= before || best.error == 0) break;
+
+        f32 weights[16];
+        for (u32 i = 0; i < 16; i++)
+            weights[i] = 1.0f - (f32)g_bc7_weights[best.idx[i]] / 64.0f;
+        if (!refine_line(px, weights, 4, e0, e1)) break;
+    }
+
+    // pixel 0 stores 3 index bits, the top one is implied 0
+    if (best.idx[0] >= 8)
+    {
+        for (u32 c = 0; c < 4; c++)
+        {
+            u8 t = best.e[0][c];
+            best.e[0][c] = best.e[1][c];
+            best.e[1][c] = t;
+        }
+        for (u32 i = 0; i < 16; i++) best.idx[i] = (u8)(15 - best.idx[i]);
+    }
+
+    memset(out, 0, 16);
+    u32 pos = 0;
+    put_bits(out, &pos, 1u << 6, 7);
+    for (u32 c = 0; c < 4; c++)
+    {
+        put_bits(out, &pos, best.e[0][c] >> 1, 7);
+        put_bits(out, &pos, best.e[1][c] >> 1, 7);
+    }
+    put_bits(out, &pos, best.e[0][0] & 1, 1);
+    put_bits(out, &pos, best.e[1][0] & 1, 1);
+    put_bits(out, &pos, best.idx[0], 3);
+    for (u32 i = 1; i < 16; i++) put_bits(out, &pos, best.idx[i], 4);
+}
+
+/*************************
+ * API
+ *************************/
+u32 bc_block_size(bc_format_t format)
+{
+    switch (format)
+    {
+    case BC_FORMAT_BC1:
+    case BC_FORMAT_BC4:
+        return 8;
+    case BC_FORMAT_BC3:
+    case BC_FORMAT_BC5:
+    case BC_FORMAT_BC7:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+u64 bc_image_size(bc_format_t format, u32 width, u32 height)
+{
+    if (format == BC_FORMAT_NONE) return (u64)width * height * 4;
+    u64 blocks = (u64)((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * bc_block_size(format);
+}
+
+const char *bc_format_name(bc_format_t format)
+{
+    static const char *names[BC_FORMAT_COUNT] = {"RGBA8", "BC1", "BC3",
+                                                 "BC4",   "BC5", "BC7"};
+    return format < BC_FORMAT_COUNT ? names[format] : "unknown";
+}
+
+void bc_encode_block(bc_format_t format, bc_quality_t quality,
+                     const u8 block[64], u8 *out)
+{
+    switch (format)
+    {
+    case BC_FORMAT_BC1:
+        encode_color(block, quality, true, out);
+        break;
+    case BC_FORMAT_BC3:
+        encode_channel(block, 3, quality, out);
+        encode_color(block, quality, false, out + 8);
+        break;
+    case BC_FORMAT_BC4:
+        encode_channel(block, 0, quality, out);
+        break;
+    case BC_FORMAT_BC5:
+        encode_channel(block, 0, quality, out);
+        encode_channel(block, 1, quality, out + 8);
+        break;
+    case BC_FORMAT_BC7:
+        encode_bc7(block, quality, out);
+        break;
+    default:
+        ASSERT(false, "not a block format");
+        break;
+    }
+}
+
+typedef struct {
+    bc_format_t format;
+    bc_quality_t quality;
+    u8 *dst;
+    const u8 *src;
+    u32 width;
+    u32 height;
+    u32 row_begin; // block rows
+    u32 row_end;
+} bc_job_t;
+
+static void encode_rows(void *arg)
+{
+    const bc_job_t *job = arg;
+    u32 blocks_x = (job->width + 3) / 4;
+    u32 size = bc_block_size(job->format);
+
+    u8 block[64];
+    for (u32 by = job->row_begin; by < job->row_end; by++)
+    {
+        for (u32 bx = 0; bx < blocks_x; bx++)
+        {
+            for (u32 y = 0; y < 4; y++)
+            {
+                u32 sy = MIN(by * 4 + y, job->height - 1);
+                for (u32 x = 0; x < 4; x++)
+                {
+                    u32 sx = MIN(bx * 4 + x, job->width - 1);
+                    memcpy(block + (y * 4 + x) * 4,
+                           job->src + ((u64)sy * job->width + sx) * 4, 4);
+                }
+            }
+            bc_encode_block(job->format, job->quality, block,
+                            job->dst + ((u64)by * blocks_x + bx) * size);
+        }
+    }
+}
+
+void bc_encode_image(bc_format_t format, bc_quality_t quality, u8 *dst,
+                     const u8 *src, u32 width, u32 height, u32 thread_count)
+{
+    if (format == BC_FORMAT_NONE)
+    {
+        memcpy(dst, src, (u64)width * height * 4);
+        return;
+    }
+
+    u32 rows = (height + 3) / 4;
+    u32 count = CLAMP(thread_count, 1, MIN(rows, BC_MAX_THREADS));
+
+    bc_job_t jobs[BC_MAX_THREADS];
+    thread_t threads[BC_MAX_THREADS];
+    b8 started[BC_MAX_THREADS] = {0};
+    for (u32 i = 0; i < count; i++)
+    {
+        jobs[i] = (bc_job_t){
+            .format = format,
+            .quality = quality,
+            .dst = dst,
+            .src = src,
+            .width = width,
+            .height = height,
+            .row_begin = (u32)((u64)rows * i / count),
+            .row_end = (u32)((u64)rows * (i + 1) / count),
+        };
+    }
+
+    // a thread that fails to start has its share done inline
+    for (u32 i = 1; i < count; i++)
+    {
+        started[i] = thread_create(&threads[i], encode_rows, &jobs[i]);
+        if (!started[i]) encode_rows(&jobs[i]);
+    }
+    encode_rows(&jobs[0]);
+    for (u32 i = 1; i < count; i++)
+        if (started[i]) thread_join(&threads[i]);
+}
@@ -0,0 +1,53 @@
+#ifndef BC_ENCODE_H
+#define BC_ENCODE_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * CPU block compression of RGBA8 images into the GPU formats, 4x4 pixel
+ * blocks of 8 or 16 bytes. Reentrant and GL free like image_ops, so load
+ * workers can call it. Partial edge blocks repeat the last row/column.
+ *
+ * BC1 is RGB with 1 bit alpha, BC3 adds an interpolated alpha block, BC4
+ * is one channel (red) and BC5 two (red, green) for normal maps. BC7 only
+ * emits mode 6 (one subset, RGBA, 16 levels): a single endpoint line per
+ * block, well above BC1/BC3 on smooth content, below a full BC7 search on
+ * blocks with several distinct colors.
+ */
+
+typedef enum {
+    BC_FORMAT_NONE, // uncompressed RGBA8
+    BC_FORMAT_BC1,
+    BC_FORMAT_BC3,
+    BC_FORMAT_BC4,
+    BC_FORMAT_BC5,
+    BC_FORMAT_BC7,
+    BC_FORMAT_COUNT
+} bc_format_t;
+
+typedef enum {
+    BC_QUALITY_FAST,   // bounding box endpoints, no refinement
+    BC_QUALITY_NORMAL, // principal axis endpoints, one refinement pass
+    BC_QUALITY_HIGH,   // refined until it stops improving, wider searches
+    BC_QUALITY_COUNT
+} bc_quality_t;
+
+// Bytes per 4x4 block, 0 for BC_FORMAT_NONE
+u32 bc_block_size(bc_format_t format);
+
+// Bytes for one image (one mip level), RGBA8 size for BC_FORMAT_NONE
+u64 bc_image_size(bc_format_t format, u32 width, u32 height);
+
+// block is 16 RGBA8 pixels, row major
+void bc_encode_block(bc_format_t format, bc_quality_t quality,
+                     const u8 block[64], u8 *out);
+
+// Splits the block rows over thread_count threads, the calling thread
+// takes one share. thread_count 0 or 1 encodes inline.
+void bc_encode_image(bc_format_t format, bc_quality_t quality, u8 *dst,
+                     const u8 *src, u32 width, u32 height,
+                     u32 thread_count);
+
+const char *bc_format_name(bc_format_t format);
+
+#endif // BC_ENCODE_H
@@ -0,0 +1,273 @@
+#include "bc_encode_test.h"
+#include "engine/core/test.h"
+#include "engine/resource/bc_encode.h"
+
+// std
+#include <string.h>
+
+// Reference BCn decoders straight from the format spec, independent of
+// the encoder's own palette code. Each writes 16 RGBA8 pixels.
+static void decode_bc_color(const u8 *in, b8 four_only, u8 out[64])
+{
+    u16 c[2] = {(u16)(in[0] | in[1] << 8), (u16)(in[2] | in[3] << 8)};
+    i32 pal[4][4];
+    for (u32 e = 0; e < 2; e++)
+    {
+        i32 r = (c[e] >> 11) & 31, g = (c[e] >> 5) & 63, b = c[e] & 31;
+        pal[e][0] = (r << 3) | (r >> 2);
+        pal[e][1] = (g << 2) | (g >> 4);
+        pal[e][2] = (b << 3) | (b >> 2);
+        pal[e][3] = 255;
+    }
+    b8 four = four_only || c[0] > c[1];
+    for (u32 k = 0; k < 3; k++)
+    {
+        pal[2][k] = four ? (2 * pal[0][k] + pal[1][k]) / 3
+                         : (pal[0][k] + pal[1][k]) / 2;
+        pal[3][k] = four ? (pal[0][k] + 2 * pal[1][k]) / 3 : 0;
+    }
+    pal[2][3] = 255;
+    pal[3][3] = four ? 255 : 0;
+
+    u32 bits = (u32)in[4] | (u32)in[5] << 8 | (u32)in[6] << 16 |
+               (u32)in[7] << 24;
+    for (u32 i = 0; i < 16; i++)
+    {
+        u32 k = (bits >> (i * 2)) & 3;
+        for (u32 ch = 0; ch < 4; ch++) out[i * 4 + ch] = (u8)pal[k][ch];
+    }
+}
+
+static void decode_bc_channel(const u8 *in, u32 channel, u8 out[64])
+{
+    i32 a0 = in[0], a1 = in[1];
+    i32 pal[8] = {a0, a1};
+    for (i32 k = 1; k <= 6; k++)
+    {
+        if (a0 > a1)
+            pal[k + 1] = ((7 - k) * a0 + k * a1 + 3) / 7;
+        else if (k <= 4)
+            pal[k + 1] = ((5 - k) * a0 + k * a1 + 2) / 5;
+    }
+    if (a0 <= a1)
+    {
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+
+    u64 bits = 0;
+    for (u32 b = 0; b < 6; b++) bits |= (u64)in[2 + b] << (b * 8);
+    for (u32 i = 0; i < 16; i++)
+        out[i * 4 + channel] = (u8)pal[(bits >> (i * 3)) & 7];
+}
+
+static u32 get_bits(const u8 *in, u32 *pos, u32 count)
+{
+    u32 v = 0;
+    for (u32 i = 0; i < count; i++, (*pos)++)
+        v |= (u32)((in[*pos >> 3] >> (*pos & 7)) & 1) << i;
+    return v;
+}
+
+// Mode 6 only, anything else decodes to magenta so it fails the test
+static void decode_bc7(const u8 *in, u8 out[64])
+{
+    static const i32 weights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                    34, 38, 43, 47, 51, 55, 60, 64};
+    u32 pos = 0;
+    if (get_bits(in, &pos, 7) != 1u << 6)
+    {
+        for (u32 i = 0; i < 16; i++)
+        {
+            out[i * 4 + 0] = out[i * 4 + 2] = out[i * 4 + 3] = 255;
+            out[i * 4 + 1] = 0;
+        }
+        return;
+    }
+
+    i32 e[2][4];
+    for (u32 c = 0; c < 4; c++)
+    {
+        e[0][c] = (i32)get_bits(in, &pos, 7) << 1;
+        e[1][c] = (i32)get_bits(in, &pos, 7) << 1;
+    }
+    i32 p0 = (i32)get_bits(in, &pos, 1), p1 = (i32)get_bits(in, &pos, 1);
+    for (u32 c = 0; c < 4; c++)
+    {
+        e[0][c] |= p0;
+        e[1][c] |= p1;
+    }
+    for (u32 i = 0; i < 16; i++)
+    {
+        i32 w = weights[get_bits(in, &pos, i == 0 ? 3 : 4)];
+        for (u32 c = 0; c < 4; c++)
+        {
+            i32 v = ((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6;
+            out[i * 4 + c] = (u8)v;
+        }
+    }
+}
+
+static void decode_bc_block(bc_format_t format, const u8 *in, u8 out[64])
+{
+    memset(out, 0, 64);
+    switch (format)
+    {
+    case BC_FORMAT_BC1:
+        decode_bc_color(in, false, out);
+        break;
+    case BC_FORMAT_BC3:
+        decode_bc_color(in + 8, true, out);
+        decode_bc_channel(in, 3, out);
+        break;
+    case BC_FORMAT_BC4:
+        decode_bc_channel(in, 0, out);
+        break;
+    case BC_FORMAT_BC5:
+        decode_bc_channel(in, 0, out);
+        decode_bc_channel(in + 8, 1, out);
+        break;
+    case BC_FORMAT_BC7:
+        decode_bc7(in, out);
+        break;
+    default:
+        break;
+    }
+}
+
+// 10x6 so the right and bottom blocks are partial. Every channel is a
+// ramp along x + y, a line in color space that one endpoint pair fits
+// tightly. Alpha crosses 128 inside blocks for BC1's 1 bit alpha.
+#define BC_TEST_W 10
+#define BC_TEST_H 6
+
+static void fill_ramp(u8 *src, u32 width, u32 height)
+{
+    for (u32 y = 0; y < height; y++)
+    {
+        for (u32 x = 0; x < width; x++)
+        {
+            u8 *p = src + (y * width + x) * 4;
+            u32 t = x + y;
+            p[0] = (u8)(40 + t * 12);
+            p[1] = (u8)(200 - t * 10);
+            p[2] = (u8)(90 + t * 6);
+            p[3] = (u8)(t * 18);
+        }
+    }
+}
+
+b8 test_bc_round_trip(void)
+{
+    b8 all_passed = true;
+    static u8 src[BC_TEST_W * BC_TEST_H * 4];
+    fill_ramp(src, BC_TEST_W, BC_TEST_H);
+
+    // largest channel error per format over the channels it keeps, a bit
+    // over half a palette step for this ramp: 4 levels for BC1/BC3 color,
+    // 8 for BC4/BC5, 16 for BC7
+    static const u32 bounds[BC_FORMAT_COUNT] = {0, 14, 14, 6, 6, 6};
+    static const u8 channels[BC_FORMAT_COUNT] = {0, 3, 4, 1, 2, 4};
+    static u8 encoded[BC_TEST_W * BC_TEST_H * 4];
+    u32 blocks_x = (BC_TEST_W + 3) / 4, blocks_y = (BC_TEST_H + 3) / 4;
+
+    for (u32 f = BC_FORMAT_BC1; f < BC_FORMAT_COUNT; f++)
+    {
+        bc_format_t format = (bc_format_t)f;
+        u32 size = bc_block_size(format);
+        all_passed &= expect_u64(bc_image_size(format, BC_TEST_W,
+                                               BC_TEST_H),
+                                 blocks_x * blocks_y * size,
+                                 "bc_image_size");
+
+        for (u32 q = 0; q < BC_QUALITY_COUNT; q++)
+        {
+            bc_quality_t quality = (bc_quality_t)q;
+            bc_encode_image(format, quality, encoded, src, BC_TEST_W,
+                            BC_TEST_H, 1);
+
+            u32 max_error = 0;
+            b8 alpha_ok = true;
+            for (u32 b = 0; b < blocks_x * blocks_y; b++)
+            {
+                u8 block[64];
+                decode_bc_block(format, encoded + b * size, block);
+                u32 bx = b % blocks_x * 4, by = b / blocks_x * 4;
+                for (u32 i = 0; i < 16; i++)
+                {
+                    u32 x = bx + i % 4, y = by + i / 4;
+                    if (x >= BC_TEST_W || y >= BC_TEST_H) continue;
+                    const u8 *want = src + (y * BC_TEST_W + x) * 4;
+                    const u8 *got = block + i * 4;
+                    // BC1 drops the color of transparent pixels
+                    u32 count = channels[f];
+                    if (format == BC_FORMAT_BC1 && want[3] < 128) count = 0;
+                    for (u32 c = 0; c < count; c++)
+                    {
+                        i32 d = (i32)want[c] - (i32)got[c];
+                        max_error = MAX(max_error, (u32)(d < 0 ? -d : d));
+                    }
+                    if (format == BC_FORMAT_BC1)
+                        alpha_ok &= got[3] == (want[3] < 128 ? 0 : 255);
+                }
+            }
+
+            if (max_error > bounds[f] || !alpha_ok)
+            {
+                printf("  %s quality %u: max error %u, bound %u%s\n",
+                       bc_format_name(format), q, max_error, bounds[f],
+                       alpha_ok ? "" : ", wrong 1 bit alpha");
+                all_passed = false;
+            }
+        }
+    }
+
+    return all_passed;
+}
+
+// Rows of blocks split between threads must come out the same as one
+// thread encoding them all, with more threads than block rows too
+#define BC_THREAD_W 36
+#define BC_THREAD_H 22
+#define BC_THREAD_MAX 8
+
+b8 test_bc_threaded_encode(void)
+{
+    b8 all_passed = true;
+    static u8 src[BC_THREAD_W * BC_THREAD_H * 4];
+    static u8 single[BC_THREAD_W * BC_THREAD_H * 4];
+    static u8 threaded[BC_THREAD_W * BC_THREAD_H * 4];
+    fill_ramp(src, BC_THREAD_W, BC_THREAD_H);
+
+    for (u32 f = BC_FORMAT_BC1; f < BC_FORMAT_COUNT; f++)
+    {
+        bc_format_t format = (bc_format_t)f;
+        u64 size = bc_image_size(format, BC_THREAD_W, BC_THREAD_H);
+        bc_encode_image(format, BC_QUALITY_FAST, single, src, BC_THREAD_W,
+                        BC_THREAD_H, 1);
+        for (u32 threads = 2; threads <= BC_THREAD_MAX; threads++)
+        {
+            memset(threaded, 0, size);
+            bc_encode_image(format, BC_QUALITY_FAST, threaded, src,
+                            BC_THREAD_W, BC_THREAD_H, threads);
+            if (memcmp(single, threaded, size) != 0)
+            {
+                printf("  %s: %u threads differ from one\n",
+                       bc_format_name(format), threads);
+                all_passed = false;
+            }
+        }
+    }
+
+    return all_passed;
+}
+
+b8 bc_encode_run_tests(void)
+{
+    printf("\n=== RUN BC ENCODE TEST ===\n");
+
+    b8 all_passed = true;
+    RUN_TEST(test_bc_round_trip);
+    RUN_TEST(test_bc_threaded_encode);
+    return all_passed;
+}
@@ -0,0 +1,11 @@
+#ifndef BC_ENCODE_TEST_H
+#define BC_ENCODE_TEST_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+b8 bc_encode_run_tests(void);
+
+b8 test_bc_round_trip(void);
+b8 test_bc_threaded_encode(void);
+
+#endif // BC_ENCODE_TEST_H
@@ -0,0 +1,856 @@
+#include "image_ops.h"
+#include "engine/core/math/maths.h"
+#include "engine/core/memory/memory.h"
+
+// std
+#include <string.h>
+
+#define SRGB_ENCODE_SIZE 4096
+#define KAISER_TAPS 8
+#define KAISER_ALPHA 4.0f
+
+static f32 g_srgb_to_linear[256];
+static u8 g_linear_to_srgb[SRGB_ENCODE_SIZE];
+static f32 g_kaiser[KAISER_TAPS];
+static b8 g_tables_ready = false;
+
+// Exact for t in [0, 255 * 255]
+static INL u8 div255(u32 t)
+{
+    t += 128;
+    return (u8)((t + (t >> 8)) >> 8);
+}
+
+static INL u8 encode_srgb(f32 linear)
+{
+    i32 i = (i32)(linear * (SRGB_ENCODE_SIZE - 1) + 0.5f);
+    return g_linear_to_srgb[CLAMP(i, 0, SRGB_ENCODE_SIZE - 1)];
+}
+
+static INL u8 encode_unorm(f32 v)
+{
+    i32 i = (i32)(v * 255.0f + 0.5f);
+    i = CLAMP(i, 0, 255);
+    return (u8)i;
+}
+
+// Zeroth order modified Bessel function, the series converges fast
+static f32 bessel_i0(f32 x)
+{
+    f32 sum = 1.0f, term = 1.0f;
+    for (u32 k = 1; k < 32; k++)
+    {
+        f32 t = x / (2.0f * (f32)k);
+        term *= t * t;
+        sum += term;
+    }
+    return sum;
+}
+
+static void build_tables(void)
+{
+    for (u32 i = 0; i < 256; i++)
+    {
+        f32 s = (f32)i / 255.0f;
+        g_srgb_to_linear[i] = s <= 0.04045f
+                                  ? s / 12.92f
+                                  : m_pow((s + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for (u32 i = 0; i < SRGB_ENCODE_SIZE; i++)
+    {
+        f32 l = (f32)i / (SRGB_ENCODE_SIZE - 1);
+        f32 s = l <= 0.0031308f ? l * 12.92f
+                                : 1.055f * m_pow(l, 1.0f / 2.4f) - 0.055f;
+        g_linear_to_srgb[i] = encode_unorm(s);
+    }
+
+    // taps sit at -3.5 .. 3.5 source pixels from the output center, sinc
+    // cut at half the source rate, windowed over 4 pixels
+    f32 sum = 0.0f;
+    for (u32 k = 0; k < KAISER_TAPS; k++)
+    {
+        f32 d = (f32)k - 3.5f;
+        f32 x = d * 0.5f;
+        f32 sinc = m_sin(M_PI * x) / (M_PI * x);
+        f32 r = d / 4.0f;
+        f32 window = bessel_i0(KAISER_ALPHA * m_sqrt(1.0f - r * r)) /
+                     bessel_i0(KAISER_ALPHA);
+        g_kaiser[k] = sinc * window;
+        sum += g_kaiser[k];
+    }
+    for (u32 k = 0; k < KAISER_TAPS; k++) g_kaiser[k] /= sum;
+
+    g_tables_ready = true;
+}
+
+/*************************
+ * SCALAR
+ *************************/
+static void premultiply_scalar(u8 *pixels, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        u8 *p = pixels + i * 4;
+        p[0] = div255((u32)p[0] * p[3]);
+        p[1] = div255((u32)p[1] * p[3]);
+        p[2] = div255((u32)p[2] * p[3]);
+    }
+}
+
+static void swizzle_scalar(u8 *dst, const u8 *src, u32 count,
+                           const u8 order[4])
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        const u8 *s = src + i * 4;
+        u8 p[4] = {s[order[0]], s[order[1]], s[order[2]], s[order[3]]};
+        memcpy(dst + i * 4, p, 4);
+    }
+}
+
+static void to_rgb565_scalar(u16 *dst, const u8 *src, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        const u8 *p = src + i * 4;
+        dst[i] = (u16)((div255(p[0] * 31u) << 11) |
+                       (div255(p[1] * 63u) << 5) | div255(p[2] * 31u));
+    }
+}
+
+static void to_rgba4444_scalar(u16 *dst, const u8 *src, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        const u8 *p = src + i * 4;
+        dst[i] = (u16)((div255(p[0] * 15u) << 12) |
+                       (div255(p[1] * 15u) << 8) |
+                       (div255(p[2] * 15u) << 4) | div255(p[3] * 15u));
+    }
+}
+
+static void renormalize_scalar(u8 *pixels, u32 count)
+{
+    const f32 scale = 2.0f / 255.0f;
+    for (u32 i = 0; i < count; i++)
+    {
+        u8 *p = pixels + i * 4;
+        f32 x = (f32)p[0] * scale - 1.0f;
+        f32 y = (f32)p[1] * scale - 1.0f;
+        f32 z = (f32)p[2] * scale - 1.0f;
+
+        f32 len2 = x * x + y * y + z * z;
+        if (len2 > 1e-4f)
+        {
+            f32 inv = 1.0f / m_sqrt(len2);
+            x *= inv;
+            y *= inv;
+            z *= inv;
+        }
+        else
+        {
+            x = y = 0.0f;
+            z = 1.0f;
+        }
+
+        p[0] = (u8)(i32)((x * 0.5f + 0.5f) * 255.0f + 0.5f);
+        p[1] = (u8)(i32)((y * 0.5f + 0.5f) * 255.0f + 0.5f);
+        p[2] = (u8)(i32)((z * 0.5f + 0.5f) * 255.0f + 0.5f);
+    }
+}
+
+static void box_pixel_scalar(u8 *dst, const u8 *p00, const u8 *p01,
+                             const u8 *p10, const u8 *p11, b8 srgb)
+{
+    for (u32 c = 0; c < 3; c++)
+    {
+        if (srgb)
+        {
+            f32 sum = g_srgb_to_linear[p00[c]] + g_srgb_to_linear[p01[c]] +
+                      g_srgb_to_linear[p10[c]] + g_srgb_to_linear[p11[c]];
+            dst[c] = encode_srgb(sum * 0.25f);
+        }
+        else
+            dst[c] = (u8)(((u32)p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2);
+    }
+    dst[3] = (u8)(((u32)p00[3] + p01[3] + p10[3] + p11[3] + 2) >> 2);
+}
+
+static void downsample_box_scalar(u8 *dst, const u8 *src, u32 width,
+                                  u32 height, b8 srgb)
+{
+    u32 dw = MAX(width / 2, 1), dh = MAX(height / 2, 1);
+    for (u32 y = 0; y < dh; y++)
+    {
+        const u8 *r0 = src + (u64)MIN(y * 2, height - 1) * width * 4;
+        const u8 *r1 = src + (u64)MIN(y * 2 + 1, height - 1) * width * 4;
+        for (u32 x = 0; x < dw; x++)
+        {
+            u32 x0 = MIN(x * 2, width - 1) * 4;
+            u32 x1 = MIN(x * 2 + 1, width - 1) * 4;
+            box_pixel_scalar(dst + ((u64)y * dw + x) * 4, r0 + x0, r0 + x1,
+                             r1 + x0, r1 + x1, srgb);
+        }
+    }
+}
+
+#if MATH_DISPATCH
+/*************************
+ * SSE2
+ *************************/
+// (t + 128 + ((t + 128) >> 8)) >> 8 on u16 lanes, t <= 255 * 255
+static INL __m128i div255_epu16(__m128i t)
+{
+    t = _mm_add_epi16(t, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void premultiply_sse2(u8 *pixels, u32 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    // alpha lanes multiply by 255, so div255 gives alpha back
+    const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i full = _mm_set1_epi16(255);
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(pixels + i * 4));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+        __m128i alo = _mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3));
+        alo = _mm_shufflehi_epi16(alo, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i ahi = _mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3));
+        ahi = _mm_shufflehi_epi16(ahi, _MM_SHUFFLE(3, 3, 3, 3));
+        alo = _mm_or_si128(_mm_andnot_si128(alpha_lanes, alo),
+                           _mm_and_si128(alpha_lanes, full));
+        ahi = _mm_or_si128(_mm_andnot_si128(alpha_lanes, ahi),
+                           _mm_and_si128(alpha_lanes, full));
+
+        lo = div255_epu16(_mm_mullo_epi16(lo, alo));
+        hi = div255_epu16(_mm_mullo_epi16(hi, ahi));
+        _mm_storeu_si128((__m128i *)(pixels + i * 4),
+                         _mm_packus_epi16(lo, hi));
+    }
+    premultiply_scalar(pixels + i * 4, count - i);
+}
+
+// No pshufb in SSE2, each channel is shifted into place
+static void swizzle_sse2(u8 *dst, const u8 *src, u32 count,
+                         const u8 order[4])
+{
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    __m128i from[4], to[4];
+    for (u32 c = 0; c < 4; c++)
+    {
+        from[c] = _mm_cvtsi32_si128((i32)order[c] * 8);
+        to[c] = _mm_cvtsi32_si128((i32)c * 8);
+    }
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        __m128i out = _mm_setzero_si128();
+        for (u32 c = 0; c < 4; c++)
+        {
+            __m128i ch = _mm_and_si128(_mm_srl_epi32(v, from[c]), byte);
+            out = _mm_or_si128(out, _mm_sll_epi32(ch, to[c]));
+        }
+        _mm_storeu_si128((__m128i *)(dst + i * 4), out);
+    }
+    swizzle_scalar(dst + i * 4, src + i * 4, count - i, order);
+}
+
+// 8 pixels to one channel per u16 lane
+static INL __m128i channel_epu16(__m128i a, __m128i b, i32 shift)
+{
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    __m128i sa = _mm_and_si128(_mm_srl_epi32(a, _mm_cvtsi32_si128(shift)),
+                               byte);
+    __m128i sb = _mm_and_si128(_mm_srl_epi32(b, _mm_cvtsi32_si128(shift)),
+                               byte);
+    return _mm_packs_epi32(sa, sb);
+}
+
+static INL __m128i quantize_epu16(__m128i ch, i16 max)
+{
+    return div255_epu16(_mm_mullo_epi16(ch, _mm_set1_epi16(max)));
+}
+
+static void to_rgb565_sse2(u16 *dst, const u8 *src, u32 count)
+{
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i * 4 + 16));
+        __m128i r = quantize_epu16(channel_epu16(a, b, 0), 31);
+        __m128i g = quantize_epu16(channel_epu16(a, b, 8), 63);
+        __m128i bl = quantize_epu16(channel_epu16(a, b, 16), 31);
+
+        __m128i out = _mm_or_si128(_mm_slli_epi16(r, 11),
+                                   _mm_or_si128(_mm_slli_epi16(g, 5), bl));
+        _mm_storeu_si128((__m128i *)(dst + i), out);
+    }
+    to_rgb565_scalar(dst + i, src + i * 4, count - i);
+}
+
+static void to_rgba4444_sse2(u16 *dst, const u8 *src, u32 count)
+{
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i * 4 + 16));
+        __m128i r = quantize_epu16(channel_epu16(a, b, 0), 15);
+        __m128i g = quantize_epu16(channel_epu16(a, b, 8), 15);
+        __m128i bl = quantize_epu16(channel_epu16(a, b, 16), 15);
+        __m128i al = quantize_epu16(channel_epu16(a, b, 24), 15);
+
+        __m128i out = _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi16(r, 12), _mm_slli_epi16(g, 8)),
+            _mm_or_si128(_mm_slli_epi16(bl, 4), al));
+        _mm_storeu_si128((__m128i *)(dst + i), out);
+    }
+    to_rgba4444_scalar(dst + i, src + i * 4, count - i);
+}
+
+static INL __m128 decode_snorm_x4(__m128i v, i32 shift)
+{
+    __m128i ch = _mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(shift)),
+                               _mm_set1_epi32(0xFF));
+    return _mm_sub_ps(
+        _mm_mul_ps(_mm_cvtepi32_ps(ch), _mm_set1_ps(2.0f / 255.0f)),
+        _mm_set1_ps(1.0f));
+}
+
+static void renormalize_sse2(u8 *pixels, u32 count)
+{
+    const __m128i alpha = _mm_set1_epi32((i32)0xFF000000);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 unorm = _mm_set1_ps(255.0f);
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(pixels + i * 4));
+        __m128 x = decode_snorm_x4(v, 0);
+        __m128 y = decode_snorm_x4(v, 8);
+        __m128 z = decode_snorm_x4(v, 16);
+
+        __m128 len2 = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 valid = _mm_cmpgt_ps(len2, _mm_set1_ps(1e-4f));
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+        x = _mm_and_ps(valid, _mm_mul_ps(x, inv));
+        y = _mm_and_ps(valid, _mm_mul_ps(y, inv));
+        z = _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(z, inv)),
+                      _mm_andnot_ps(valid, one));
+
+        // (n * 0.5 + 0.5) * 255 + 0.5, truncated
+        __m128i ex = _mm_cvttps_epi32(_mm_add_ps(
+            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(x, half), half), unorm), half));
+        __m128i ey = _mm_cvttps_epi32(_mm_add_ps(
+            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(y, half), half), unorm), half));
+        __m128i ez = _mm_cvttps_epi32(_mm_add_ps(
+            _mm_mul_ps(_mm_add_ps(_mm_mul_ps(z, half), half), unorm), half));
+
+        __m128i out = _mm_or_si128(
+            _mm_or_si128(ex, _mm_slli_epi32(ey, 8)),
+            _mm_or_si128(_mm_slli_epi32(ez, 16), _mm_and_si128(v, alpha)));
+        _mm_storeu_si128((__m128i *)(pixels + i * 4), out);
+    }
+    renormalize_scalar(pixels + i * 4, count - i);
+}
+
+static INL __m128 load_srgb(const u8 *p)
+{
+    return _mm_set_ps((f32)p[3], g_srgb_to_linear[p[2]],
+                      g_srgb_to_linear[p[1]], g_srgb_to_linear[p[0]]);
+}
+
+// Two output pixels from two full source rows, plain average
+static INL void box_pair_unorm(u8 *dst, const u8 *r0, const u8 *r1)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = _mm_loadu_si128((const __m128i *)r0);
+    __m128i b = _mm_loadu_si128((const __m128i *)r1);
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                               _mm_unpacklo_epi8(b, zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                               _mm_unpackhi_epi8(b, zero));
+    lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+    __m128i sum = _mm_unpacklo_epi64(lo, hi);
+    sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+    _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(sum, sum));
+}
+
+static void downsample_box_sse2(u8 *dst, const u8 *src, u32 width,
+                                u32 height, b8 srgb)
+{
+    u32 dw = MAX(width / 2, 1), dh = MAX(height / 2, 1);
+    const __m128 quarter = _mm_set1_ps(0.25f);
+
+    for (u32 y = 0; y < dh; y++)
+    {
+        const u8 *r0 = src + (u64)MIN(y * 2, height - 1) * width * 4;
+        const u8 *r1 = src + (u64)MIN(y * 2 + 1, height - 1) * width * 4;
+        u8 *out = dst + (u64)y * dw * 4;
+
+        // output pixels whose 2x2 footprint is inside the row
+        u32 full = width / 2;
+        u32 x = 0;
+        if (!srgb)
+        {
+            for (; x + 2 <= full; x += 2)
+                box_pair_unorm(out + x * 4, r0 + x * 8, r1 + x * 8);
+        }
+        else
+        {
+            for (; x < full; x++)
+            {
+                const u8 *a = r0 + x * 8, *b = r1 + x * 8;
+                __m128 sum = _mm_add_ps(
+                    _mm_add_ps(load_srgb(a), load_srgb(a + 4)),
+                    _mm_add_ps(load_srgb(b), load_srgb(b + 4)));
+                ALIGN(16) f32 avg[4];
+                _mm_store_ps(avg, _mm_mul_ps(sum, quarter));
+                out[x * 4 + 0] = encode_srgb(avg[0]);
+                out[x * 4 + 1] = encode_srgb(avg[1]);
+                out[x * 4 + 2] = encode_srgb(avg[2]);
+                out[x * 4 + 3] = (u8)(i32)(avg[3] + 0.5f);
+            }
+        }
+
+        for (; x < dw; x++)
+        {
+            u32 x0 = MIN(x * 2, width - 1) * 4;
+            u32 x1 = MIN(x * 2 + 1, width - 1) * 4;
+            box_pixel_scalar(out + x * 4, r0 + x0, r0 + x1, r1 + x0,
+                             r1 + x1, srgb);
+        }
+    }
+}
+
+/*************************
+ * AVX2
+ *************************/
+MATH_TARGET("avx2")
+static INL __m256i div255_epu16_x16(__m256i t)
+{
+    t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)),
+                             8);
+}
+
+MATH_TARGET("avx2")
+static void premultiply_avx2(u8 *pixels, u32 count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(255);
+    // per 128 bit lane: bytes of the alpha u16 of both pixels
+    const __m256i broadcast = _mm256_setr_epi8(
+        6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15, 6, 7, 6, 7,
+        6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(pixels + i * 4));
+        __m256i lo = _mm256_unpacklo_epi8(v, zero);
+        __m256i hi = _mm256_unpackhi_epi8(v, zero);
+
+        __m256i alo = _mm256_blend_epi16(_mm256_shuffle_epi8(lo, broadcast),
+                                         full, 0x88);
+        __m256i ahi = _mm256_blend_epi16(_mm256_shuffle_epi8(hi, broadcast),
+                                         full, 0x88);
+
+        lo = div255_epu16_x16(_mm256_mullo_epi16(lo, alo));
+        hi = div255_epu16_x16(_mm256_mullo_epi16(hi, ahi));
+        _mm256_storeu_si256((__m256i *)(pixels + i * 4),
+                            _mm256_packus_epi16(lo, hi));
+    }
+    premultiply_sse2(pixels + i * 4, count - i);
+}
+
+MATH_TARGET("avx2")
+static void swizzle_avx2(u8 *dst, const u8 *src, u32 count,
+                         const u8 order[4])
+{
+    ALIGN(32) u8 mask[32];
+    for (u32 b = 0; b < 32; b++)
+        mask[b] = (u8)((b % 16) / 4 * 4 + order[b % 4]);
+    __m256i shuffle = _mm256_load_si256((const __m256i *)mask);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        _mm256_storeu_si256((__m256i *)(dst + i * 4),
+                            _mm256_shuffle_epi8(v, shuffle));
+    }
+    swizzle_sse2(dst + i * 4, src + i * 4, count - i, order);
+}
+
+// 16 pixels to one channel per u16 lane, in pixel order
+MATH_TARGET("avx2")
+static INL __m256i channel_epu16_x16(__m256i a, __m256i b, i32 shift)
+{
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    __m128i count = _mm_cvtsi32_si128(shift);
+    __m256i sa = _mm256_and_si256(_mm256_srl_epi32(a, count), byte);
+    __m256i sb = _mm256_and_si256(_mm256_srl_epi32(b, count), byte);
+    // packs works per 128 bit lane, put the quarters back in order
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(sa, sb),
+                                    _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+MATH_TARGET("avx2")
+static INL __m256i quantize_epu16_x16(__m256i ch, i16 max)
+{
+    return div255_epu16_x16(_mm256_mullo_epi16(ch, _mm256_set1_epi16(max)));
+}
+
+MATH_TARGET("avx2")
+static void to_rgb565_avx2(u16 *dst, const u8 *src, u32 count)
+{
+    u32 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i * 4 + 32));
+        __m256i r = quantize_epu16_x16(channel_epu16_x16(a, b, 0), 31);
+        __m256i g = quantize_epu16_x16(channel_epu16_x16(a, b, 8), 63);
+        __m256i bl = quantize_epu16_x16(channel_epu16_x16(a, b, 16), 31);
+
+        __m256i out = _mm256_or_si256(
+            _mm256_slli_epi16(r, 11),
+            _mm256_or_si256(_mm256_slli_epi16(g, 5), bl));
+        _mm256_storeu_si256((__m256i *)(dst + i), out);
+    }
+    to_rgb565_sse2(dst + i, src + i * 4, count - i);
+}
+
+MATH_TARGET("avx2")
+static void to_rgba4444_avx2(u16 *dst, const u8 *src, u32 count)
+{
+    u32 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i * 4 + 32));
+        __m256i r = quantize_epu16_x16(channel_epu16_x16(a, b, 0), 15);
+        __m256i g = quantize_epu16_x16(channel_epu16_x16(a, b, 8), 15);
+        __m256i bl = quantize_epu16_x16(channel_epu16_x16(a, b, 16), 15);
+        __m256i al = quantize_epu16_x16(channel_epu16_x16(a, b, 24), 15);
+
+        __m256i out = _mm256_or_si256(
+            _mm256_or_si256(_mm256_slli_epi16(r, 12), _mm256_slli_epi16(g, 8)),
+            _mm256_or_si256(_mm256_slli_epi16(bl, 4), al));
+        _mm256_storeu_si256((__m256i *)(dst + i), out);
+    }
+    to_rgba4444_sse2(dst + i, src + i * 4, count - i);
+}
+
+// Same operation order as the SSE2 and scalar versions, no FMA, so every
+// level produces the same bytes
+MATH_TARGET("avx2")
+static INL __m256 decode_snorm_x8(__m256i v, i32 shift)
+{
+    __m128i count = _mm_cvtsi32_si128(shift);
+    __m256i ch =
+        _mm256_and_si256(_mm256_srl_epi32(v, count), _mm256_set1_epi32(0xFF));
+    return _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(ch),
+                                       _mm256_set1_ps(2.0f / 255.0f)),
+                         _mm256_set1_ps(1.0f));
+}
+
+MATH_TARGET("avx2")
+static INL __m256i encode_snorm_x8(__m256 n)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    return _mm256_cvttps_epi32(_mm256_add_ps(
+        _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(n, half), half),
+                      _mm256_set1_ps(255.0f)),
+        half));
+}
+
+MATH_TARGET("avx2")
+static void renormalize_avx2(u8 *pixels, u32 count)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i alpha = _mm256_set1_epi32((i32)0xFF000000);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(pixels + i * 4));
+        __m256 x = decode_snorm_x8(v, 0);
+        __m256 y = decode_snorm_x8(v, 8);
+        __m256 z = decode_snorm_x8(v, 16);
+
+        __m256 len2 = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+            _mm256_mul_ps(z, z));
+        __m256 valid =
+            _mm256_cmp_ps(len2, _mm256_set1_ps(1e-4f), _CMP_GT_OQ);
+        __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+        x = _mm256_and_ps(valid, _mm256_mul_ps(x, inv));
+        y = _mm256_and_ps(valid, _mm256_mul_ps(y, inv));
+        z = _mm256_blendv_ps(one, _mm256_mul_ps(z, inv), valid);
+
+        __m256i out = _mm256_or_si256(
+            _mm256_or_si256(encode_snorm_x8(x),
+                            _mm256_slli_epi32(encode_snorm_x8(y), 8)),
+            _mm256_or_si256(_mm256_slli_epi32(encode_snorm_x8(z), 16),
+                            _mm256_and_si256(v, alpha)));
+        _mm256_storeu_si256((__m256i *)(pixels + i * 4), out);
+    }
+    renormalize_sse2(pixels + i * 4, count - i);
+}
+
+image_kernels_t g_image_kernels = {
+    .level = MATH_SIMD_SSE2,
+    .premultiply = premultiply_sse2,
+    .swizzle = swizzle_sse2,
+    .to_rgb565 = to_rgb565_sse2,
+    .to_rgba4444 = to_rgba4444_sse2,
+    .renormalize = renormalize_sse2,
+    .downsample_box = downsample_box_sse2,
+};
+#else
+image_kernels_t g_image_kernels = {
+    .level = MATH_SIMD_SCALAR,
+    .premultiply = premultiply_scalar,
+    .swizzle = swizzle_scalar,
+    .to_rgb565 = to_rgb565_scalar,
+    .to_rgba4444 = to_rgba4444_scalar,
+    .renormalize = renormalize_scalar,
+    .downsample_box = downsample_box_scalar,
+};
+#endif // MATH_DISPATCH
+
+math_simd_t image_ops_select(math_simd_t level)
+{
+    math_simd_t max = math_simd_supported();
+    if (level > max) level = max;
+
+    image_kernels_t k = {
+        .level = level,
+        .premultiply = premultiply_scalar,
+        .swizzle = swizzle_scalar,
+        .to_rgb565 = to_rgb565_scalar,
+        .to_rgba4444 = to_rgba4444_scalar,
+        .renormalize = renormalize_scalar,
+        .downsample_box = downsample_box_scalar,
+    };
+
+#if MATH_DISPATCH
+    if (level >= MATH_SIMD_SSE2)
+    {
+        k.premultiply = premultiply_sse2;
+        k.swizzle = swizzle_sse2;
+        k.to_rgb565 = to_rgb565_sse2;
+        k.to_rgba4444 = to_rgba4444_sse2;
+        k.renormalize = renormalize_sse2;
+        k.downsample_box = downsample_box_sse2;
+    }
+    // MATH_SIMD_FMA is the AVX2 level
+    if (level >= MATH_SIMD_FMA)
+    {
+        k.premultiply = premultiply_avx2;
+        k.swizzle = swizzle_avx2;
+        k.to_rgb565 = to_rgb565_avx2;
+        k.to_rgba4444 = to_rgba4444_avx2;
+        k.renormalize = renormalize_avx2;
+    }
+#endif
+
+    g_image_kernels = k;
+    return level;
+}
+
+void image_ops_init(void)
+{
+    build_tables();
+    math_simd_t level = image_ops_select(math_simd_level());
+    LOG_INFO("Image ops: %s", math_simd_name(level));
+}
+
+/*************************
+ * Downsampling
+ *************************/
+// 4 channels at once, dst += w * src
+static INL void madd4(f32 *dst, f32 w, const f32 *src)
+{
+#if MATH_SSE
+    _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst),
+                                  _mm_mul_ps(_mm_set1_ps(w),
+                                             _mm_loadu_ps(src))));
+#else
+    for (u32 c = 0; c < 4; c++) dst[c] += w * src[c];
+#endif
+}
+
+// Separable, both passes in linear float. The negative lobes can
+// overshoot, encoding clamps.
+static void downsample_kaiser(u8 *dst, const u8 *src, u32 width, u32 height,
+                              b8 srgb)
+{
+    u32 dw = MAX(width / 2, 1), dh = MAX(height / 2, 1);
+    u64 src_size = (u64)width * height * 4 * sizeof(f32);
+    u64 tmp_size = (u64)dw * height * 4 * sizeof(f32);
+    f32 *lin = ALLOC(src_size, MEM_RESOURCE);
+    f32 *tmp = ALLOC(tmp_size, MEM_RESOURCE);
+    if (!lin || !tmp)
+    {
+        LOG_ERROR("image ops: out of memory, box filter instead");
+        if (lin) FREE(lin, src_size, MEM_RESOURCE);
+        if (tmp) FREE(tmp, tmp_size, MEM_RESOURCE);
+        g_image_kernels.downsample_box(dst, src, width, height, srgb);
+        return;
+    }
+
+    for (u64 i = 0; i < (u64)width * height; i++)
+    {
+        const u8 *p = src + i * 4;
+        for (u32 c = 0; c < 3; c++)
+            lin[i * 4 + c] =
+                srgb ? g_srgb_to_linear[p[c]] : (f32)p[c] / 255.0f;
+        lin[i * 4 + 3] = (f32)p[3] / 255.0f;
+    }
+
+    // ALLOC zeroes, both passes accumulate into it
+    for (u32 y = 0; y < height; y++)
+    {
+        const f32 *row = lin + (u64)y * width * 4;
+        for (u32 x = 0; x < dw; x++)
+        {
+            f32 *out = tmp + ((u64)y * dw + x) * 4;
+            for (u32 k = 0; k < KAISER_TAPS; k++)
+            {
+                i32 sx = (i32)(x * 2 + k) - 3;
+                sx = CLAMP(sx, 0, (i32)width - 1);
+                madd4(out, g_kaiser[k], row + (u64)sx * 4);
+            }
+        }
+    }
+
+    for (u32 y = 0; y < dh; y++)
+    {
+        for (u32 x = 0; x < dw; x++)
+        {
+            f32 acc[4] = {0};
+            for (u32 k = 0; k < KAISER_TAPS; k++)
+            {
+                i32 sy = (i32)(y * 2 + k) - 3;
+                sy = CLAMP(sy, 0, (i32)height - 1);
+                madd4(acc, g_kaiser[k], tmp + ((u64)sy * dw + x) * 4);
+            }
+
+            u8 *p = dst + ((u64)y * dw + x) * 4;
+            for (u32 c = 0; c < 3; c++)
+                p[c] = srgb ? encode_srgb(acc[c]) : encode_unorm(acc[c]);
+            p[3] = encode_unorm(acc[3]);
+        }
+    }
+
+    FREE(lin, src_size, MEM_RESOURCE);
+    FREE(tmp, tmp_size, MEM_RESOURCE);
+}
+
+void image_downsample(u8 *dst, const u8 *src, u32 width, u32 height,
+                      image_filter_t filter, b8 srgb)
+{
+    ASSERT(g_tables_ready, "image_ops_init not called");
+    if (filter == IMAGE_FILTER_KAISER)
+        downsample_kaiser(dst, src, width, height, srgb);
+    else
+        g_image_kernels.downsample_box(dst, src, width, height, srgb);
+}
+
+u32 image_mip_count(u32 width, u32 height)
+{
+    u32 count = 1;
+    while (width > 1 || height > 1)
+    {
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+        count++;
+    }
+    return count;
+}
+
+u64 image_mip_chain_size(u32 width, u32 height)
+{
+    u64 size = 0;
+    u32 levels = image_mip_count(width, height);
+    for (u32 i = 0; i < levels; i++)
+    {
+        size += (u64)width * height * 4;
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+    return size;
+}
+
+void image_build_mips(u8 *chain, u32 width, u32 height,
+                      image_filter_t filter, b8 srgb)
+{
+    u32 levels = image_mip_count(width, height);
+    u8 *level = chain;
+    for (u32 i = 1; i < levels; i++)
+    {
+        u8 *next = level + (u64)width * height * 4;
+        image_downsample(next, level, width, height, filter, srgb);
+        level = next;
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+}
+
+void image_extrude(u8 *dst, const u8 *src, u32 width, u32 height,
+                   u32 border)
+{
+    u32 dst_width = width + border * 2;
+    u32 dst_height = height + border * 2;
+    for (u32 y = 0; y < dst_height; y++)
+    {
+        u32 sy = y < border ? 0 : MIN(y - border, height - 1);
+        const u32 *row = (const u32 *)src + (u64)sy * width;
+        u32 *out = (u32 *)dst + (u64)y * dst_width;
+
+        for (u32 x = 0; x < border; x++)
+        {
+            out[x] = row[0];
+            out[border + width + x] = row[width - 1];
+        }
+        memcpy(out + border, row, (u64)width * 4);
+    }
+}
+
+u32 image_diff(const u8 *a, const u8 *b, u32 count, u32 tolerance,
+               u32 *out_max_error)
+{
+    u32 mismatched = 0;
+    u32 max_error = 0;
+    for (u32 i = 0; i < count; i++)
+    {
+        u32 error = 0;
+        for (u32 c = 0; c < 4; c++)
+        {
+            i32 d = (i32)a[i * 4 + c] - (i32)b[i * 4 + c];
+            error = MAX(error, (u32)(d < 0 ? -d : d));
+        }
+        if (error > tolerance) mismatched++;
+        max_error = MAX(max_error, error);
+    }
+    if (out_max_error) *out_max_error = max_error;
+    return mismatched;
+}
@@ -0,0 +1,98 @@
+#ifndef IMAGE_OPS_H
+#define IMAGE_OPS_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/core/math/math_dispatch.h"
+
+/*
+ * CPU kernels over tightly packed RGBA8 images, the layout read_image_file
+ * returns. Meant for load threads and offline cooking: everything is
+ * reentrant and touches no GL. Per pixel conversions have scalar, SSE2
+ * and AVX2 variants picked at runtime like the math batch kernels; the
+ * downsamplers work on one float4 pixel at a time and stop at SSE2.
+ *
+ * sRGB data is filtered in linear space, alpha is always linear.
+ */
+
+typedef enum {
+    IMAGE_FILTER_BOX,    // 2x2 average
+    IMAGE_FILTER_KAISER, // 8 tap Kaiser windowed sinc, keeps more detail
+} image_filter_t;
+
+typedef struct {
+    math_simd_t level;
+    void (*premultiply)(u8 *pixels, u32 count);
+    void (*swizzle)(u8 *dst, const u8 *src, u32 count, const u8 order[4]);
+    void (*to_rgb565)(u16 *dst, const u8 *src, u32 count);
+    void (*to_rgba4444)(u16 *dst, const u8 *src, u32 count);
+    void (*renormalize)(u8 *pixels, u32 count);
+    void (*downsample_box)(u8 *dst, const u8 *src, u32 width, u32 height,
+                           b8 srgb);
+} image_kernels_t;
+
+extern image_kernels_t g_image_kernels;
+
+// Builds the sRGB tables and picks kernels for the math dispatch level.
+// Call once at startup, after math_dispatch_init and before any worker.
+void image_ops_init(void);
+
+// Clamped like math_dispatch_select, returns the level in use
+math_simd_t image_ops_select(math_simd_t level);
+
+// rgb *= a, rounded. In place.
+INL void image_premultiply(u8 *pixels, u32 count)
+{
+    g_image_kernels.premultiply(pixels, count);
+}
+
+// dst channel c = src channel order[c], {2, 1, 0, 3} turns RGBA into
+// BGRA. dst may be src.
+INL void image_swizzle(u8 *dst, const u8 *src, u32 count, const u8 order[4])
+{
+    g_image_kernels.swizzle(dst, src, count, order);
+}
+
+// GL_UNSIGNED_SHORT_5_6_5 order, rounded, alpha dropped
+INL void image_to_rgb565(u16 *dst, const u8 *src, u32 count)
+{
+    g_image_kernels.to_rgb565(dst, src, count);
+}
+
+// GL_UNSIGNED_SHORT_4_4_4_4 order, rounded
+INL void image_to_rgba4444(u16 *dst, const u8 *src, u32 count)
+{
+    g_image_kernels.to_rgba4444(dst, src, count);
+}
+
+// Tangent space normals in rgb back to unit length, alpha kept. Vectors
+// shorter than one 8 bit step (127, 127, 127) become +Z.
+INL void image_renormalize(u8 *pixels, u32 count)
+{
+    g_image_kernels.renormalize(pixels, count);
+}
+
+// dst is MAX(width / 2, 1) x MAX(height / 2, 1), odd edges are clamped
+void image_downsample(u8 *dst, const u8 *src, u32 width, u32 height,
+                      image_filter_t filter, b8 srgb);
+
+// Levels down to 1x1
+u32 image_mip_count(u32 width, u32 height);
+
+// Bytes for the whole chain, level 0 included
+u64 image_mip_chain_size(u32 width, u32 height);
+
+// chain starts with level 0, the smaller levels are written after it
+void image_build_mips(u8 *chain, u32 width, u32 height,
+                      image_filter_t filter, b8 srgb);
+
+// dst is (width + 2 * border) x (height + 2 * border) with the edge pixels
+// repeated outwards, so filtering at an atlas rect's edge stays inside it
+void image_extrude(u8 *dst, const u8 *src, u32 width, u32 height,
+                   u32 border);
+
+// Pixels with any channel of a and b further apart than tolerance, for
+// golden image tests. The largest difference goes in *out_max_error.
+u32 image_diff(const u8 *a, const u8 *b, u32 count, u32 tolerance,
+               u32 *out_max_error);
+
+#endif // IMAGE_OPS_H
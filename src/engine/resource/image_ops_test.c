@@ -0,0 +1,132 @@
+#include "image_ops_test.h"
+#include "engine/core/math/math_dispatch.h"
+#include "engine/core/test.h"
+#include "engine/resource/image_ops.h"
+
+// std
+#include <string.h>
+
+b8 test_image_diff(void)
+{
+    b8 all_passed = true;
+    u8 a[16 * 4], b[16 * 4];
+    for (u32 i = 0; i < 16 * 4; i++)
+    {
+        a[i] = b[i] = (u8)(i * 13);
+    }
+
+    u32 max_error = 0;
+    all_passed &= expect_u64(image_diff(a, b, 16, 0, &max_error), 0,
+                             "image_diff identical");
+    all_passed &= expect_u64(max_error, 0, "max error zero");
+
+    // pixel 3 is off by 2 in red, pixel 9 by 40 in alpha, in both directions
+    b[3 * 4 + 0] = (u8)(a[3 * 4 + 0] + 2);
+    b[9 * 4 + 3] = (u8)(a[9 * 4 + 3] - 40);
+    all_passed &= expect_u64(image_diff(a, b, 16, 0, &max_error), 2,
+                             "image_diff exact");
+    all_passed &= expect_u64(max_error, 40, "max error");
+    all_passed &= expect_u64(image_diff(b, a, 16, 2, NULL), 1,
+                             "image_diff tolerance");
+    all_passed &= expect_u64(image_diff(a, b, 16, 40, NULL), 0,
+                             "image_diff tolerance at max");
+
+    return all_passed;
+}
+
+// Every per pixel kernel and the box downsampler, on odd sizes so both the
+// vector loops and their scalar tails run
+#define KERNEL_W 13
+#define KERNEL_H 7
+#define KERNEL_COUNT (KERNEL_W * KERNEL_H)
+
+typedef struct {
+    u8 premultiplied[KERNEL_COUNT * 4];
+    u8 swizzled[KERNEL_COUNT * 4];
+    u16 rgb565[KERNEL_COUNT];
+    u16 rgba4444[KERNEL_COUNT];
+    u8 normals[KERNEL_COUNT * 4];
+    u8 box[(KERNEL_W / 2) * (KERNEL_H / 2) * 4];
+    u8 box_srgb[(KERNEL_W / 2) * (KERNEL_H / 2) * 4];
+} kernel_output_t;
+
+static void run_image_kernels(kernel_output_t *out, const u8 *src)
+{
+    static const u8 bgra[4] = {2, 1, 0, 3};
+    memcpy(out->premultiplied, src, sizeof(out->premultiplied));
+    image_premultiply(out->premultiplied, KERNEL_COUNT);
+    image_swizzle(out->swizzled, src, KERNEL_COUNT, bgra);
+    image_to_rgb565(out->rgb565, src, KERNEL_COUNT);
+    image_to_rgba4444(out->rgba4444, src, KERNEL_COUNT);
+    memcpy(out->normals, src, sizeof(out->normals));
+    image_renormalize(out->normals, KERNEL_COUNT);
+    image_downsample(out->box, src, KERNEL_W, KERNEL_H, IMAGE_FILTER_BOX,
+                     false);
+    image_downsample(out->box_srgb, src, KERNEL_W, KERNEL_H,
+                     IMAGE_FILTER_BOX, true);
+}
+
+b8 test_image_kernels(void)
+{
+    b8 all_passed = true;
+    image_ops_init();
+
+    u8 src[KERNEL_COUNT * 4];
+    u32 seed = 12345;
+    for (u32 i = 0; i < KERNEL_COUNT * 4; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        src[i] = (u8)(seed >> 24);
+    }
+    // known values in pixel 0, a zero length normal in pixel 1
+    src[0] = 255, src[1] = 128, src[2] = 0, src[3] = 128;
+    src[4] = 127, src[5] = 127, src[6] = 127, src[7] = 50;
+
+    math_simd_t saved = math_simd_level();
+    static kernel_output_t reference, out;
+    image_ops_select(MATH_SIMD_SCALAR);
+    run_image_kernels(&reference, src);
+
+    const u8 *p = reference.premultiplied;
+    all_passed &= expect_u64(p[0], 128, "premultiply r");
+    all_passed &= expect_u64(p[1], 64, "premultiply g");
+    all_passed &= expect_u64(p[3], 128, "premultiply keeps a");
+    all_passed &= expect_u64(reference.swizzled[2], 255, "swizzle bgra");
+    all_passed &= expect_u64(reference.rgb565[0], 0xF800 | (32 << 5),
+                             "rgb565");
+    all_passed &= expect_u64(reference.rgba4444[0], 0xF808, "rgba4444");
+    all_passed &= expect_u64(reference.normals[6], 255,
+                             "renormalize zero length is +z");
+    all_passed &= expect_u64(image_mip_count(KERNEL_W, KERNEL_H), 4,
+                             "image_mip_count");
+
+    // every variant must match the scalar kernels byte for byte
+    math_simd_t max = math_simd_supported();
+    for (u32 level = MATH_SIMD_SSE2; level <= (u32)max; level++)
+    {
+        math_simd_t used = image_ops_select((math_simd_t)level);
+        run_image_kernels(&out, src);
+        if (memcmp(&out, &reference, sizeof(out)) != 0)
+        {
+            const u8 *a = (const u8 *)&out, *b = (const u8 *)&reference;
+            u32 at = 0;
+            while (a[at] == b[at]) at++;
+            printf("  image kernels at %s differ at byte %u\n",
+                   math_simd_name(used), at);
+            all_passed = false;
+        }
+    }
+    image_ops_select(saved);
+
+    return all_passed;
+}
+
+b8 image_ops_run_tests(void)
+{
+    printf("\n=== RUN IMAGE OPS TEST ===\n");
+
+    b8 all_passed = true;
+    RUN_TEST(test_image_diff);
+    RUN_TEST(test_image_kernels);
+    return all_passed;
+}
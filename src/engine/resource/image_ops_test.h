@@ -0,0 +1,11 @@
+#ifndef IMAGE_OPS_TEST_H
+#define IMAGE_OPS_TEST_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+b8 image_ops_run_tests(void);
+
+b8 test_image_diff(void);
+b8 test_image_kernels(void);
+
+#endif // IMAGE_OPS_TEST_H
@@ -0,0 +1,345 @@
+#include "png_writer.h"
+#include "engine/core/memory/memory.h"
+#include "engine/platform/filesystem.h"
+
+// std
+#include <string.h>
+
+#define PNG_HASH_BITS 15
+#define PNG_WINDOW 32768
+#define PNG_MIN_MATCH 3
+#define PNG_MAX_MATCH 258
+#define PNG_FILTERS 5 // none, sub, up, average, paeth
+
+static const u16 g_length_base[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const u8 g_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                      1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                      4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const u16 g_distance_base[30] = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+    33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const u8 g_distance_extra[30] = {0, 0, 0,  0,  1,  1,  2,  2,
+                                        3, 3, 4,  4,  5,  5,  6,  6,
+                                        7, 7, 8,  8,  9,  9,  10, 10,
+                                        11, 11, 12, 12, 13, 13};
+
+// Deflate packs bits from the least significant end of each byte
+typedef struct {
+    u8 *out;
+    u64 pos;
+    u64 bits;
+    u32 count;
+} bit_writer_t;
+
+static void put_bits(bit_writer_t *bw, u32 value, u32 count)
+{
+    bw->bits |= (u64)value << bw->count;
+    bw->count += count;
+    while (bw->count >= 8)
+    {
+        bw->out[bw->pos++] = (u8)bw->bits;
+        bw->bits >>= 8;
+        bw->count -= 8;
+    }
+}
+
+// Huffman codes go most significant bit first
+static void put_code(bit_writer_t *bw, u32 code, u32 length)
+{
+    u32 reversed = 0;
+    for (u32 i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    put_bits(bw, reversed, length);
+}
+
+// Fixed literal/length code of RFC 1951 3.2.6
+static void put_symbol(bit_writer_t *bw, u32 symbol)
+{
+    if (symbol < 144) put_code(bw, 0x30 + symbol, 8);
+    else if (symbol < 256) put_code(bw, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) put_code(bw, symbol - 256, 7);
+    else put_code(bw, 0xC0 + symbol - 280, 8);
+}
+
+static void put_match(bit_writer_t *bw, u32 length, u32 distance)
+{
+    u32 code = 28;
+    while (g_length_base[code] > length) code--;
+    put_symbol(bw, 257 + code);
+    put_bits(bw, length - g_length_base[code], g_length_extra[code]);
+
+    code = 29;
+    while (g_distance_base[code] > distance) code--;
+    put_code(bw, code, 5);
+    put_bits(bw, distance - g_distance_base[code], g_distance_extra[code]);
+}
+
+static u32 hash3(const u8 *p)
+{
+    u32 v = (u32)p[0] << 16 | (u32)p[1] << 8 | p[2];
+    return (v * 2654435761u) >> (32 - PNG_HASH_BITS);
+}
+
+// One final fixed Huffman block. table holds 1 << PNG_HASH_BITS entries.
+static void deflate_fixed(bit_writer_t *bw, const u8 *data, u64 size,
+                          u32 *table)
+{
+    memset(table, 0xFF, sizeof(u32) << PNG_HASH_BITS);
+    put_bits(bw, 1, 1); // last block
+    put_bits(bw, 1, 2); // fixed codes
+
+    u64 i = 0;
+    while (i < size)
+    {
+        u32 length = 0;
+        u32 distance = 0;
+        if (i + PNG_MIN_MATCH <= size)
+        {
+            u32 h = hash3(data + i);
+            u32 candidate = table[h];
+            table[h] = (u32)i;
+            if (candidate != INVALID_32 && i - candidate <= PNG_WINDOW)
+            {
+                u64 limit = MIN(size - i, PNG_MAX_MATCH);
+                while (length < limit &&
+                       data[candidate + length] == data[i + length])
+                    length++;
+                if (length >= PNG_MIN_MATCH) distance = (u32)(i - candidate);
+                else length = 0;
+            }
+        }
+
+        if (length == 0)
+        {
+            put_symbol(bw, data[i]);
+            i++;
+            continue;
+        }
+
+        put_match(bw, length, distance);
+        // positions inside the match can still start later ones
+        for (u64 j = i + 1; j < i + length && j + PNG_MIN_MATCH <= size; j++)
+            table[hash3(data + j)] = (u32)j;
+        i += length;
+    }
+
+    put_symbol(bw, 256); // end of block
+    if (bw->count) put_bits(bw, 0, 8 - bw->count);
+}
+
+static u8 paeth(u8 a, u8 b, u8 c)
+{
+    i32 p = (i32)a + b - c;
+    i32 pa = p > a ? p - a : a - p;
+    i32 pb = p > b ? p - b : b - p;
+    i32 pc = p > c ? p - c : c - p;
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// prev is all zero on the first row, as is everything left of the image
+static void filter_row(u8 *dst, const u8 *row, const u8 *prev, u64 size,
+                       u32 bpp, u32 filter)
+{
+    // the first pixel has no left neighbour, paeth picks up then
+    for (u64 i = 0; i < bpp; i++)
+    {
+        u8 predict = 0;
+        if (filter == 2 || filter == 4) predict = prev[i];
+        else if (filter == 3) predict = prev[i] / 2;
+        dst[i] = (u8)(row[i] - predict);
+    }
+
+    switch (filter)
+    {
+    case 0: memcpy(dst + bpp, row + bpp, size - bpp); break;
+    case 1:
+        for (u64 i = bpp; i < size; i++) dst[i] = (u8)(row[i] - row[i - bpp]);
+        break;
+    case 2:
+        for (u64 i = bpp; i < size; i++) dst[i] = (u8)(row[i] - prev[i]);
+        break;
+    case 3:
+        for (u64 i = bpp; i < size; i++)
+            dst[i] = (u8)(row[i] - (((u32)row[i - bpp] + prev[i]) >> 1));
+        break;
+    default:
+        for (u64 i = bpp; i < size; i++)
+        {
+            dst[i] =
+                (u8)(row[i] - paeth(row[i - bpp], prev[i], prev[i - bpp]));
+        }
+        break;
+    }
+}
+
+static void put_be32(u8 *dst, u32 v)
+{
+    dst[0] = (u8)(v >> 24);
+    dst[1] = (u8)(v >> 16);
+    dst[2] = (u8)(v >> 8);
+    dst[3] = (u8)v;
+}
+
+static u32 crc32(const u32 table[256], const u8 *data, u64 size)
+{
+    u32 crc = 0xFFFFFFFFu;
+    for (u64 i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static u32 adler32(const u8 *data, u64 size)
+{
+    u32 a = 1;
+    u32 b = 0;
+    while (size)
+    {
+        // the largest run that can't overflow b before the modulo
+        u64 run = MIN(size, 5552);
+        for (u64 i = 0; i < run; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += run;
+        size -= run;
+    }
+    return b << 16 | a;
+}
+
+// Length, type, data and crc of one chunk at out + *pos
+static void put_chunk(u8 *out, u64 *pos, const char *type, const u8 *data,
+                      u32 size, const u32 crc_table[256])
+{
+    put_be32(out + *pos, size);
+    memcpy(out + *pos + 4, type, 4);
+    if (size) memcpy(out + *pos + 8, data, size);
+    u32 crc = crc32(crc_table, out + *pos + 4, size + 4);
+    put_be32(out + *pos + 8 + size, crc);
+    *pos += 12 + size;
+}
+
+u8 *png_encode(const u8 *pixels, u32 width, u32 height, u32 channels,
+               b8 flip_y, u64 *out_size, u64 *out_alloc)
+{
+    *out_size = 0;
+    *out_alloc = 0;
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4))
+        return NULL;
+
+    u64 row_size = (u64)width * channels;
+    u64 filtered_size = (row_size + 1) * height;
+    // a fixed Huffman match costs at most 31 bits for 3 bytes, the rest
+    // covers the zlib wrapper and the chunks
+    u64 alloc = filtered_size + filtered_size / 2 + 1024;
+    u64 table_size = sizeof(u32) << PNG_HASH_BITS;
+
+    u8 *filtered = ALLOC(filtered_size, MEM_RESOURCE);
+    u8 *scratch = ALLOC(row_size * 2, MEM_RESOURCE); // and a zero row
+    u32 *table = ALLOC(table_size, MEM_RESOURCE);
+    u8 *out = ALLOC(alloc, MEM_RESOURCE);
+    if (!filtered || !scratch || !table || !out)
+    {
+        if (filtered) FREE(filtered, filtered_size, MEM_RESOURCE);
+        if (scratch) FREE(scratch, row_size * 2, MEM_RESOURCE);
+        if (table) FREE(table, table_size, MEM_RESOURCE);
+        if (out) FREE(out, alloc, MEM_RESOURCE);
+        return NULL;
+    }
+
+    const u8 *prev = scratch + row_size; // ALLOC zeroes it
+    for (u32 y = 0; y < height; y++)
+    {
+        const u8 *row = pixels + (flip_y ? height - 1 - y : y) * row_size;
+        u8 *dst = filtered + y * (row_size + 1);
+        u64 best = (u64)-1;
+        for (u32 f = 0; f < PNG_FILTERS; f++)
+        {
+            filter_row(scratch, row, prev, row_size, channels, f);
+            u64 cost = 0;
+            for (u64 i = 0; i < row_size; i++)
+            {
+                i32 r = (i32)(signed char)scratch[i];
+                cost += (u64)(r < 0 ? -r : r);
+            }
+            if (cost < best)
+            {
+                best = cost;
+                dst[0] = (u8)f;
+                memcpy(dst + 1, scratch, row_size);
+            }
+        }
+        prev = row;
+    }
+
+    u32 crc_table[256];
+    for (u32 n = 0; n < 256; n++)
+    {
+        u32 c = n;
+        for (u32 k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+
+    static const u8 signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    memcpy(out, signature, sizeof(signature));
+    u64 pos = sizeof(signature);
+
+    u8 header[13] = {0};
+    put_be32(header, width);
+    put_be32(header + 4, height);
+    header[8] = 8;                      // bits per channel
+    header[9] = channels == 4 ? 6 : 2; // RGBA or RGB
+    put_chunk(out, &pos, "IHDR", header, sizeof(header), crc_table);
+
+    // one IDAT, its length is known once the stream is written
+    u64 idat = pos;
+    memcpy(out + idat + 4, "IDAT", 4);
+    pos += 8;
+    out[pos++] = 0x78; // deflate, 32K window
+    out[pos++] = 0x01; // no dictionary, check bits
+    bit_writer_t bw = {.out = out, .pos = pos};
+    deflate_fixed(&bw, filtered, filtered_size, table);
+    pos = bw.pos;
+    put_be32(out + pos, adler32(filtered, filtered_size));
+    pos += 4;
+    u32 idat_size = (u32)(pos - idat - 8);
+    put_be32(out + idat, idat_size);
+    put_be32(out + pos, crc32(crc_table, out + idat + 4, idat_size + 4));
+    pos += 4;
+
+    put_chunk(out, &pos, "IEND", NULL, 0, crc_table);
+
+    FREE(filtered, filtered_size, MEM_RESOURCE);
+    FREE(scratch, row_size * 2, MEM_RESOURCE);
+    FREE(table, table_size, MEM_RESOURCE);
+    *out_size = pos;
+    *out_alloc = alloc;
+    return out;
+}
+
+b8 png_write(const char *path, const u8 *pixels, u32 width, u32 height,
+             u32 channels, b8 flip_y)
+{
+    u64 size = 0;
+    u64 alloc = 0;
+    u8 *png =
+        png_encode(pixels, width, height, channels, flip_y, &size, &alloc);
+    if (!png) return false;
+
+    file_t file;
+    b8 ok = file_open(path, WRITE_BINARY, &file);
+    if (ok)
+    {
+        ok = file_write_binary(&file, png, size);
+        file_close(&file);
+    }
+    FREE(png, alloc, MEM_RESOURCE);
+    return ok;
+}
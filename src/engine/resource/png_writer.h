@@ -0,0 +1,26 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+/*
+ * Minimal PNG encoder for 8 bit RGB and RGBA images, reentrant and GL
+ * free so it can run on a worker. Every row gets the filter with the
+ * smallest sum of absolute residuals, the usual heuristic, and the result
+ * is deflated in one fixed Huffman block with a single probe LZ77 hash
+ * matcher. Files come out bigger than zlib -9 would make them but the
+ * encode is fast, and stb_image and every other reader decode them.
+ */
+
+// Encodes width x height tightly packed pixels of channels 3 or 4 bytes.
+// Rows go top down, or bottom up as glReadPixels returns them with flip_y.
+// The result is a MEM_RESOURCE block of *out_alloc bytes, *out_size of
+// them used. NULL when out of memory.
+u8 *png_encode(const u8 *pixels, u32 width, u32 height, u32 channels,
+               b8 flip_y, u64 *out_size, u64 *out_alloc);
+
+// png_encode into path, relative to the asset directory
+b8 png_write(const char *path, const u8 *pixels, u32 width, u32 height,
+             u32 channels, b8 flip_y);
+
+#endif // PNG_WRITER_H
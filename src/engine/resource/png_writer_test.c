@@ -0,0 +1,207 @@
+#include "png_writer_test.h"
+#include "deps/stb_image/stb_image.h"
+#include "engine/core/memory/memory.h"
+#include "engine/core/test.h"
+#include "engine/resource/png_writer.h"
+
+// std
+#include <string.h>
+
+static u32 read_be32(const u8 *p)
+{
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+// Bit at a time, nothing shared with the encoder's tables
+static u32 slow_crc32(const u8 *data, u64 size)
+{
+    u32 crc = 0xFFFFFFFFu;
+    for (u64 i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (u32 k = 0; k < 8; k++)
+            crc = crc & 1 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static u32 slow_adler32(const u8 *data, u64 size)
+{
+    u32 a = 1;
+    u32 b = 0;
+    for (u64 i = 0; i < size; i++)
+    {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return b << 16 | a;
+}
+
+// stb_image skips the chunk crcs and the zlib adler, so check them here:
+// every chunk crc, then the adler of the inflated IDAT stream
+static b8 check_sums(const u8 *png, u64 size, const char *name)
+{
+    b8 all_passed = true;
+    u64 pos = 8;
+    const u8 *idat = NULL;
+    u32 idat_size = 0;
+    while (pos + 12 <= size)
+    {
+        u32 length = read_be32(png + pos);
+        if (pos + 12 + length > size) break;
+        u32 stored = read_be32(png + pos + 8 + length);
+        if (slow_crc32(png + pos + 4, length + 4) != stored)
+        {
+            printf("  %s: bad crc on %.4s\n", name, png + pos + 4);
+            all_passed = false;
+        }
+        if (memcmp(png + pos + 4, "IDAT", 4) == 0)
+        {
+            idat = png + pos + 8;
+            idat_size = length;
+        }
+        pos += 12 + length;
+    }
+    all_passed &= expect_u64(pos, size, "png chunks fill the file");
+    if (!idat || idat_size < 6) return expect_true(false, "png has IDAT");
+
+    int inflated_size = 0;
+    char *inflated = stbi_zlib_decode_malloc((const char *)idat,
+                                             (int)idat_size, &inflated_size);
+    if (!inflated) return expect_true(false, "png IDAT inflates");
+    all_passed &= expect_u64(slow_adler32((const u8 *)inflated,
+                                          (u64)inflated_size),
+                             read_be32(idat + idat_size - 4), "png adler32");
+    stbi_image_free(inflated);
+    return all_passed;
+}
+
+// Encodes, decodes with stb_image and compares every byte, rows flipped
+// back when the encoder flipped them
+static b8 round_trip(const u8 *pixels, u32 width, u32 height, u32 channels,
+                     b8 flip_y, const char *name)
+{
+    u64 size = 0, alloc = 0;
+    u8 *png = png_encode(pixels, width, height, channels, flip_y, &size,
+                         &alloc);
+    if (!png) return expect_true(false, name);
+
+    b8 all_passed = check_sums(png, size, name);
+    int w = 0, h = 0, n = 0;
+    u8 *decoded = stbi_load_from_memory(png, (int)size, &w, &h, &n,
+                                        (int)channels);
+    if (!decoded)
+    {
+        printf("  %s: stb_image can't decode it\n", name);
+        FREE(png, alloc, MEM_RESOURCE);
+        return false;
+    }
+
+    all_passed &= expect_u64((u64)w, width, name);
+    all_passed &= expect_u64((u64)h, height, name);
+    all_passed &= expect_u64((u64)n, channels, name);
+    u64 row_size = (u64)width * channels;
+    for (u32 y = 0; y < height && w == (int)width && h == (int)height; y++)
+    {
+        const u8 *want = pixels + (flip_y ? height - 1 - y : y) * row_size;
+        if (memcmp(decoded + y * row_size, want, row_size) != 0)
+        {
+            printf("  %s: row %u differs\n", name, y);
+            all_passed = false;
+            break;
+        }
+    }
+
+    stbi_image_free(decoded);
+    FREE(png, alloc, MEM_RESOURCE);
+    return all_passed;
+}
+
+// 8200 RGBA pixels is a 32801 byte row, past the 32K window, and repeats
+// every 8192 pixels so matches reach back the full window. 2731 RGB
+// pixels is an 8194 byte filtered row, neither a run of 258 byte matches
+// nor of the adler's 5552 bytes, and the image is past a stored block's
+// 65535 bytes.
+#define PNG_TEST_WIDE 8200
+#define PNG_TEST_PERIOD 8192
+#define PNG_TEST_ODD 2731
+
+b8 test_png_round_trip(void)
+{
+    b8 all_passed = true;
+    u64 bytes = (u64)PNG_TEST_WIDE * 3 * 4;
+    u8 *src = ALLOC(bytes, MEM_RESOURCE);
+    u8 *noise = ALLOC(bytes, MEM_RESOURCE);
+    if (!src || !noise)
+    {
+        if (src) FREE(src, bytes, MEM_RESOURCE);
+        if (noise) FREE(noise, bytes, MEM_RESOURCE);
+        return false;
+    }
+    u32 seed = 4242;
+    for (u64 i = 0; i < bytes; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        noise[i] = (u8)(seed >> 24);
+    }
+
+    // stb flips everything it loads when the texture system asked it to
+    stbi_set_flip_vertically_on_load(false);
+
+    // noise is all literals, odd sizes in both formats
+    all_passed &= round_trip(noise, 13, 7, 3, false, "rgb noise 13x7");
+    all_passed &= round_trip(noise, 13, 7, 3, true, "rgb noise flipped");
+    all_passed &= round_trip(noise, 37, 11, 4, false, "rgba noise 37x11");
+    all_passed &= round_trip(noise, 1, 1, 4, true, "rgba 1x1");
+
+    // a gradient the filters predict, flipped
+    for (u32 y = 0; y < 45; y++)
+    {
+        for (u32 x = 0; x < 61; x++)
+        {
+            u8 *p = src + (y * 61 + x) * 4;
+            p[0] = (u8)(x * 4), p[1] = (u8)(y * 5);
+            p[2] = (u8)(x + y), p[3] = (u8)(255 - x);
+        }
+    }
+    all_passed &= round_trip(src, 61, 45, 4, true, "rgba gradient flipped");
+
+    // one color, long runs of maximum length matches
+    memset(src, 77, 160 * 150 * 4);
+    all_passed &= round_trip(src, 160, 150, 4, false, "rgba solid");
+
+    // short repeating pixels, matches that run across row boundaries
+    for (u64 i = 0; i < (u64)PNG_TEST_ODD * 9 * 3; i++)
+        src[i] = noise[i % 21];
+    all_passed &= round_trip(src, PNG_TEST_ODD, 9, 3, false, "rgb odd wide");
+    all_passed &= round_trip(src, PNG_TEST_ODD, 9, 3, true,
+                             "rgb odd wide flipped");
+
+    // noise repeating at the window size
+    for (u64 i = 0; i < bytes; i++)
+        src[i] = noise[i % ((u64)PNG_TEST_PERIOD * 4)];
+    all_passed &= round_trip(src, PNG_TEST_WIDE, 3, 4, false,
+                             "rgba window wide");
+
+    // only 3 and 4 channels are encoded
+    u64 size = 0, alloc = 0;
+    all_passed &= expect_true(!png_encode(src, 4, 4, 2, false, &size,
+                                          &alloc),
+                              "png refuses 2 channels");
+    all_passed &= expect_true(!png_encode(src, 0, 4, 4, false, &size,
+                                          &alloc),
+                              "png refuses zero width");
+
+    FREE(src, bytes, MEM_RESOURCE);
+    FREE(noise, bytes, MEM_RESOURCE);
+    return all_passed;
+}
+
+b8 png_writer_run_tests(void)
+{
+    printf("\n=== RUN PNG WRITER TEST ===\n");
+
+    b8 all_passed = true;
+    RUN_TEST(test_png_round_trip);
+    return all_passed;
+}
@@ -0,0 +1,10 @@
+#ifndef PNG_WRITER_TEST_H
+#define PNG_WRITER_TEST_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+
+b8 png_writer_run_tests(void);
+
+b8 test_png_round_trip(void);
+
+#endif // PNG_WRITER_TEST_H
@@ -0,0 +1,119 @@
+#include "texture_file.h"
+#include "engine/core/memory/memory.h"
+#include "engine/platform/filesystem.h"
+
+// std
+#include <string.h>
+
+#define TEXTURE_FILE_MAGIC 0x5845544Bu // "KTEX"
+#define TEXTURE_FILE_VERSION 1u
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 format;
+    u32 width;
+    u32 height;
+    u32 levels;
+    u64 source_hash;
+    u64 size;
+} texture_file_header_t;
+
+u64 texture_file_chain_size(bc_format_t format, u32 width, u32 height,
+                            u32 levels)
+{
+    u64 size = 0;
+    for (u32 i = 0; i < levels; i++)
+    {
+        size += bc_image_size(format, width, height);
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+    return size;
+}
+
+b8 texture_file_read(const char *path, texture_file_t *out)
+{
+    memset(out, 0, sizeof(texture_file_t));
+    if (!file_exist_relative(path)) return false;
+
+    file_t file;
+    if (!file_open(path, READ_BINARY, &file)) return false;
+
+    u64 size = 0;
+    u8 *blob = NULL;
+    b8 ok = file_size(&file, &size) && size > sizeof(texture_file_header_t);
+    if (ok)
+    {
+        blob = ALLOC(size, MEM_RESOURCE);
+        u64 read = 0;
+        ok = blob && file_read_all_binary(&file, blob, &read) && read == size;
+    }
+    file_close(&file);
+
+    texture_file_header_t header;
+    if (ok)
+    {
+        memcpy(&header, blob, sizeof(header));
+        ok = header.magic == TEXTURE_FILE_MAGIC &&
+             header.version == TEXTURE_FILE_VERSION &&
+             header.format > BC_FORMAT_NONE &&
+             header.format < BC_FORMAT_COUNT && header.width > 0 &&
+             header.height > 0 && header.levels > 0 &&
+             header.levels <= TEXTURE_FILE_MAX_LEVELS &&
+             header.size == size - sizeof(header) &&
+             header.size == texture_file_chain_size(header.format,
+                                                    header.width,
+                                                    header.height,
+                                                    header.levels);
+    }
+
+    if (!ok)
+    {
+        if (blob) FREE(blob, size, MEM_RESOURCE);
+        LOG_WARN("texture file: %s is not a valid " TEXTURE_FILE_EXT, path);
+        return false;
+    }
+
+    // level data to the front, one allocation to hand around
+    memmove(blob, blob + sizeof(header), header.size);
+    out->format = (bc_format_t)header.format;
+    out->width = header.width;
+    out->height = header.height;
+    out->levels = header.levels;
+    out->source_hash = header.source_hash;
+    out->data = blob;
+    out->size = header.size;
+    out->alloc_size = size;
+    return true;
+}
+
+b8 texture_file_write(const char *path, const texture_file_t *file)
+{
+    texture_file_header_t header = {
+        .magic = TEXTURE_FILE_MAGIC,
+        .version = TEXTURE_FILE_VERSION,
+        .format = file->format,
+        .width = file->width,
+        .height = file->height,
+        .levels = file->levels,
+        .source_hash = file->source_hash,
+        .size = file->size,
+    };
+
+    file_t handle;
+    if (!file_open(path, WRITE_BINARY, &handle)) return false;
+    b8 ok = file_write_binary(&handle, &header, sizeof(header)) &&
+            file_write_binary(&handle, file->data, file->size);
+    file_close(&handle);
+    if (!ok) LOG_WARN("texture file: failed to write %s", path);
+    return ok;
+}
+
+void texture_file_free(texture_file_t *file)
+{
+    FREE(file->data, file->alloc_size, MEM_RESOURCE);
+    file->data = NULL;
+    file->size = 0;
+    file->alloc_size = 0;
+}
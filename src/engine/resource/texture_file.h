@@ -0,0 +1,39 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include "engine/core/define.h" // IWYU pragma: keep
+#include "engine/resource/bc_encode.h"
+
+/*
+ * Cooked texture container (.ktex): a small header followed by every mip
+ * level back to back, level 0 first, each bc_image_size bytes. The data is
+ * ready for glCompressedTexImage2D (or glTexImage2D for BC_FORMAT_NONE).
+ * source_hash ties the file to the image it was cooked from.
+ */
+
+#define TEXTURE_FILE_EXT ".ktex"
+#define TEXTURE_FILE_MAX_LEVELS 16
+
+typedef struct {
+    bc_format_t format;
+    u32 width; // level 0
+    u32 height;
+    u32 levels;
+    u64 source_hash;
+    u8 *data;
+    u64 size;       // bytes of level data
+    u64 alloc_size; // for FREE, may be larger than size
+} texture_file_t;
+
+// Bytes for levels mips starting at width x height
+u64 texture_file_chain_size(bc_format_t format, u32 width, u32 height,
+                            u32 levels);
+
+// false when the file is missing, truncated or from another version
+b8 texture_file_read(const char *path, texture_file_t *out);
+
+b8 texture_file_write(const char *path, const texture_file_t *file);
+
+void texture_file_free(texture_file_t *file);
+
+#endif // TEXTURE_FILE_H
@@ -0,0 +1,36 @@
+#include "engine/core/math/math_dispatch.h"
+#include "engine/core/math/math_test.h"
+#include "engine/core/memory/memory.h"
+#include "engine/core/memory/offset_alloc_test.h"
+#include "engine/rendering/render_queue_test.h"
+#include "engine/resource/atlas_packer_test.h"
+#include "engine/resource/bc_encode_test.h"
+#include "engine/resource/image_ops_test.h"
+#include "engine/resource/png_writer_test.h"
+
+// std
+#include <stdio.h>
+
+// `make test`, every CPU suite in turn. Exits non zero when any failed.
+int main(void)
+{
+    if (!memory_sys_init(64 * 1024 * 1024))
+    {
+        LOG_ERROR("tests: failed to init the memory system");
+        return 1;
+    }
+    math_dispatch_init();
+
+    b8 all_passed = true;
+    all_passed &= math_run_all_tests();
+    all_passed &= render_queue_run_tests();
+    all_passed &= image_ops_run_tests();
+    all_passed &= bc_encode_run_tests();
+    all_passed &= offset_alloc_run_tests();
+    all_passed &= atlas_packer_run_tests();
+    all_passed &= png_writer_run_tests();
+
+    printf("\n%s\n", all_passed ? "ALL SUITES PASSED" : "SOME SUITES FAILED");
+    memory_sys_kill(); // reports anything a test leaked
+    return all_passed ? 0 : 1;
+}